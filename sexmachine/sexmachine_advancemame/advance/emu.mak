@@ -447,7 +447,6 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/osd/hscript.o \
 	$(OBJ)/advance/osd/safequit.o \
 	$(OBJ)/advance/osd/fileio.o \
-	$(OBJ)/advance/osd/fuzzy.o \
 	$(OBJ)/advance/blit/blit.o \
 	$(OBJ)/advance/blit/hq2x.o \
 	$(OBJ)/advance/blit/hq2x3.o \
@@ -473,6 +472,7 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/lib/rgb.o \
 	$(OBJ)/advance/lib/conf.o \
 	$(OBJ)/advance/lib/incstr.o \
+	$(OBJ)/advance/lib/fuzzy.o \
 	$(OBJ)/advance/lib/fz.o \
 	$(OBJ)/advance/lib/font.o \
 	$(OBJ)/advance/lib/fontdef.o \
@@ -95,6 +95,7 @@
 #include "file.h"
 #include "font.h"
 #include "fontdef.h"
+#include "fuzzy.h"
 #include "fz.h"
 #include "generate.h"
 #include "gtf.h"
@@ -110,8 +110,39 @@ static char* glob_subst(const char* format, char* own_s)
 	}
 }
 
+/**
+ * Hash of a string.
+ */
+static unsigned string_hash(const char* s)
+{
+	unsigned h = 2166136261U;
+
+	while (*s) {
+		h ^= (unsigned char)*s;
+		h *= 16777619U;
+		++s;
+	}
+
+	return h;
+}
+
+/**
+ * Hash of a value.
+ */
+static inline unsigned value_hash(unsigned section_hash, const struct adv_conf_option_struct* option)
+{
+	return section_hash * 31 + option->hash;
+}
+
 static void option_insert(adv_conf* context, struct adv_conf_option_struct* option)
 {
+	unsigned bucket;
+
+	option->hash = string_hash(option->tag);
+	bucket = option->hash % CONF_OPTION_HASH_MAX;
+	option->hash_next = context->option_hash_map[bucket];
+	context->option_hash_map[bucket] = option;
+
 	if (context->option_list) {
 		option->pred = context->option_list->pred;
 		option->next = context->option_list;
@@ -132,6 +163,8 @@ static struct adv_conf_option_struct* option_alloc(void)
 
 	option->tag = 0;
 	option->type = -1; /* invalid value */
+	option->best_value = 0;
+	option->best_generation = 0;
 
 	return option;
 }
@@ -154,14 +187,15 @@ static void option_free(struct adv_conf_option_struct* option)
 
 static struct adv_conf_option_struct* option_search_tag(adv_conf* context, const char* tag)
 {
-	if (context->option_list) {
-		struct adv_conf_option_struct* option = context->option_list;
-		do {
-			if (strcmp(option->tag, tag) == 0)
-				return option;
-			option = option->next;
-		} while (option != context->option_list);
+	unsigned hash = string_hash(tag);
+	struct adv_conf_option_struct* option = context->option_hash_map[hash % CONF_OPTION_HASH_MAX];
+
+	while (option) {
+		if (option->hash == hash && strcmp(option->tag, tag) == 0)
+			return option;
+		option = option->hash_next;
 	}
+
 	return 0;
 }
 
@@ -311,8 +345,52 @@ static void value_free(struct adv_conf_value_struct* value)
 	free(value);
 }
 
+/**
+ * Insert a value in the hash.
+ * The value is inserted at the end of the bucket, to keep the same order of the list.
+ */
+static void value_hash_insert(adv_conf* context, struct adv_conf_value_struct* value)
+{
+	struct adv_conf_value_struct** bucket;
+
+	value->hash = value_hash(string_hash(value->section), value->option);
+	bucket = &context->value_hash_map[value->hash % CONF_VALUE_HASH_MAX];
+
+	if (*bucket) {
+		value->hash_pred = (*bucket)->hash_pred;
+		value->hash_next = *bucket;
+		value->hash_pred->hash_next = value;
+		value->hash_next->hash_pred = value;
+	} else {
+		*bucket = value;
+		value->hash_next = value;
+		value->hash_pred = value;
+	}
+
+	++context->generation;
+}
+
+static void value_hash_remove(adv_conf* context, struct adv_conf_value_struct* value)
+{
+	struct adv_conf_value_struct** bucket = &context->value_hash_map[value->hash % CONF_VALUE_HASH_MAX];
+
+	if (*bucket == value) {
+		*bucket = value->hash_next;
+	}
+	if (*bucket == value) {
+		*bucket = 0;
+	} else {
+		value->hash_next->hash_pred = value->hash_pred;
+		value->hash_pred->hash_next = value->hash_next;
+	}
+
+	++context->generation;
+}
+
 static void value_insert(adv_conf* context, struct adv_conf_value_struct* value)
 {
+	value_hash_insert(context, value);
+
 	if (context->value_list) {
 		value->pred = context->value_list->pred;
 		value->next = context->value_list;
@@ -365,6 +443,8 @@ static void value_insert_sort(adv_conf* context, struct adv_conf_value_struct* v
 
 static void value_remove(adv_conf* context, struct adv_conf_value_struct* value)
 {
+	value_hash_remove(context, value);
+
 	if (context->value_list == value) {
 		context->value_list = value->next;
 	}
@@ -380,21 +460,25 @@ static void value_remove(adv_conf* context, struct adv_conf_value_struct* value)
 	value_free(value);
 }
 
-static struct adv_conf_value_struct* value_searchbest_sectiontag(adv_conf* context, const char* section, const char* tag)
+static struct adv_conf_value_struct* value_searchbest_optionsection(adv_conf* context, struct adv_conf_option_struct* option, unsigned section_hash, const char* section)
 {
-	if (context->value_list) {
+	unsigned hash = value_hash(section_hash, option);
+	struct adv_conf_value_struct* head = context->value_hash_map[hash % CONF_VALUE_HASH_MAX];
+
+	if (head) {
 		struct adv_conf_value_struct* best_value = 0;
-		struct adv_conf_value_struct* value = context->value_list;
+		struct adv_conf_value_struct* value = head;
 
 		do {
-			if (strcmp(value->section, section) == 0
-				&& strcmp(value->option->tag, tag) == 0) {
+			if (value->hash == hash
+				&& value->option == option
+				&& strcmp(value->section, section) == 0) {
 				if (!best_value || best_value->input->priority < value->input->priority) {
 					best_value = value;
 				}
 			}
-			value = value->next;
-		} while (value != context->value_list);
+			value = value->hash_next;
+		} while (value != head);
 
 		return best_value;
 	}
@@ -402,19 +486,40 @@ static struct adv_conf_value_struct* value_searchbest_sectiontag(adv_conf* conte
 	return 0;
 }
 
+static struct adv_conf_value_struct* value_searchbest_sectiontag(adv_conf* context, const char* section, const char* tag)
+{
+	struct adv_conf_option_struct* option = option_search_tag(context, tag);
+
+	if (!option)
+		return 0;
+
+	return value_searchbest_optionsection(context, option, string_hash(section), section);
+}
+
 static struct adv_conf_value_struct* value_search_inputsectiontag(adv_conf* context, struct adv_conf_input_struct* input, const char* section, const char* tag)
 {
-	if (context->value_list) {
-		struct adv_conf_value_struct* value = context->value_list;
+	struct adv_conf_option_struct* option = option_search_tag(context, tag);
+	struct adv_conf_value_struct* head;
+	unsigned hash;
+
+	if (!option)
+		return 0;
+
+	hash = value_hash(string_hash(section), option);
+	head = context->value_hash_map[hash % CONF_VALUE_HASH_MAX];
+
+	if (head) {
+		struct adv_conf_value_struct* value = head;
 
 		do {
-			if (value->input == input
-				&& strcmp(value->section, section) == 0
-				&& strcmp(value->option->tag, tag) == 0) {
+			if (value->hash == hash
+				&& value->input == input
+				&& value->option == option
+				&& strcmp(value->section, section) == 0) {
 				return value;
 			}
-			value = value->next;
-		} while (value != context->value_list);
+			value = value->hash_next;
+		} while (value != head);
 	}
 
 	return 0;
@@ -422,11 +527,15 @@ static struct adv_conf_value_struct* value_search_inputsectiontag(adv_conf* cont
 
 static struct adv_conf_value_struct* value_searchbest_tag(adv_conf* context, const char** section_map, unsigned section_mac, const char* tag)
 {
+	struct adv_conf_option_struct* option = option_search_tag(context, tag);
 	unsigned i;
 
+	if (!option)
+		return 0;
+
 	for (i = 0; i < section_mac; ++i) {
 		struct adv_conf_value_struct* value;
-		value = value_searchbest_sectiontag(context, section_map[i], tag);
+		value = value_searchbest_optionsection(context, option, string_hash(section_map[i]), section_map[i]);
 		if (value)
 			return value;
 	}
@@ -434,11 +543,49 @@ static struct adv_conf_value_struct* value_searchbest_tag(adv_conf* context, con
 	return 0;
 }
 
+/**
+ * Search a value in the sections set with conf_section_set().
+ * The result is kept in the option until a value is inserted or removed,
+ * or the sections change.
+ */
+static struct adv_conf_value_struct* value_searchbest_default(adv_conf* context, const char* tag)
+{
+	struct adv_conf_option_struct* option;
+	struct adv_conf_value_struct* value;
+	target_clock_t start;
+	unsigned i;
+
+	start = target_clock();
+
+	++context->lookup_counter;
+
+	option = option_search_tag(context, tag);
+	if (!option) {
+		value = 0;
+	} else if (option->best_generation == context->generation) {
+		++context->lookup_cached_counter;
+		value = option->best_value;
+	} else {
+		value = 0;
+		for (i = 0; i < context->section_mac && !value; ++i)
+			value = value_searchbest_optionsection(context, option, context->section_hash[i], context->section_map[i]);
+
+		option->best_value = value;
+		option->best_generation = context->generation;
+	}
+
+	context->lookup_time += (target_clock() - start) / (double)TARGET_CLOCKS_PER_SEC;
+
+	return value;
+}
+
 static struct adv_conf_value_struct* value_searchbest_from(adv_conf* context, struct adv_conf_value_struct* like_value)
 {
-	struct adv_conf_value_struct* value = like_value->next;
+	struct adv_conf_value_struct* head = context->value_hash_map[like_value->hash % CONF_VALUE_HASH_MAX];
+	struct adv_conf_value_struct* value = like_value->hash_next;
 
-	while (value != context->value_list) {
+	/* the bucket has the same order of the list */
+	while (value != head) {
 
 		if (value->option == like_value->option
 			&& value->input == like_value->input
@@ -446,7 +593,7 @@ static struct adv_conf_value_struct* value_searchbest_from(adv_conf* context, st
 			return value;
 		}
 
-		value = value->next;
+		value = value->hash_next;
 	}
 
 	return 0;
@@ -468,8 +615,17 @@ adv_conf* conf_init(void)
 	context->input_list = 0;
 	context->value_list = 0;
 
+	memset(context->option_hash_map, 0, sizeof(context->option_hash_map));
+	memset(context->value_hash_map, 0, sizeof(context->value_hash_map));
+
 	context->section_mac = 0;
 	context->section_map = 0;
+	context->section_hash = 0;
+
+	context->generation = 1;
+	context->lookup_counter = 0;
+	context->lookup_cached_counter = 0;
+	context->lookup_time = 0;
 
 	context->is_modified = 0;
 
@@ -486,6 +642,8 @@ void conf_done(adv_conf* context)
 {
 	unsigned i;
 
+	log_std(("conf: %u searches, %u cached, %g [ms]\n", context->lookup_counter, context->lookup_cached_counter, context->lookup_time * 1000));
+
 	if (context->value_list) {
 		struct adv_conf_value_struct* value = context->value_list;
 		do {
@@ -516,6 +674,7 @@ void conf_done(adv_conf* context)
 	for (i = 0; i < context->section_mac; ++i)
 		free(context->section_map[i]);
 	free(context->section_map);
+	free(context->section_hash);
 
 	free(context);
 }
@@ -1656,8 +1815,12 @@ adv_error conf_input_file_load_adv(adv_conf* context, int priority, const char*
 	input_insert(context, input);
 
 	if (is_file_in_exist) {
+		target_clock_t start = target_clock();
+
 		if (input_load(context, input, multi_line, error, error_context) != 0)
 			return -1;
+
+		log_std(("conf: load %s in %g [ms]\n", file_in, (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC));
 	}
 
 	return 0;
@@ -1815,6 +1978,65 @@ adv_error conf_input_args_load(adv_conf* context, int priority, const char* sect
 	return 0;
 }
 
+/**
+ * Remove all the inputs with the specified priority.
+ * All the values loaded from these inputs are removed. The removed values
+ * don't mark the configuration as modified because they are never saved.
+ * It's used to load again the command line arguments and the include files.
+ * \param context Configuration context to use.
+ * \param priority Priority of the inputs to remove.
+ */
+void conf_input_remove(adv_conf* context, int priority)
+{
+	adv_bool is_modified = context->is_modified;
+
+	if (context->value_list) {
+		struct adv_conf_value_struct* value = context->value_list;
+		unsigned count = 0;
+		do {
+			++count;
+			value = value->next;
+		} while (value != context->value_list);
+
+		/* the list head may change at every remove */
+		while (count) {
+			struct adv_conf_value_struct* value_next = value->next;
+			if (value->input->priority == priority)
+				value_remove(context, value);
+			value = value_next;
+			--count;
+		}
+	}
+
+	if (context->input_list) {
+		struct adv_conf_input_struct* input = context->input_list;
+		unsigned count = 0;
+		do {
+			++count;
+			input = input->next;
+		} while (input != context->input_list);
+
+		while (count) {
+			struct adv_conf_input_struct* input_next = input->next;
+			if (input->priority == priority) {
+				if (context->input_list == input)
+					context->input_list = input->next;
+				if (context->input_list == input) {
+					context->input_list = 0;
+				} else {
+					input->next->pred = input->pred;
+					input->pred->next = input->next;
+				}
+				input_free(input);
+			}
+			input = input_next;
+			--count;
+		}
+	}
+
+	context->is_modified = is_modified;
+}
+
 /***************************************************************************/
 /* Save */
 
@@ -2169,11 +2391,18 @@ void conf_section_set(adv_conf* context, const char** section_map, unsigned sect
 	for (i = 0; i < context->section_mac; ++i)
 		free(context->section_map[i]);
 	free(context->section_map);
+	free(context->section_hash);
 
 	context->section_mac = section_mac;
 	context->section_map = malloc(context->section_mac * sizeof(char*));
-	for (i = 0; i < context->section_mac; ++i)
+	context->section_hash = malloc(context->section_mac * sizeof(unsigned));
+	for (i = 0; i < context->section_mac; ++i) {
 		context->section_map[i] = strdup(section_map[i]);
+		context->section_hash[i] = string_hash(section_map[i]);
+	}
+
+	/* invalidate the previous searches */
+	++context->generation;
 }
 
 #ifdef NDEBUG
@@ -2222,7 +2451,7 @@ static void assert_option_def(adv_conf* context, const char* tag, enum adv_conf_
  */
 adv_bool conf_bool_get_default(adv_conf* context, const char* tag)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_bool, 1);
 
@@ -2246,7 +2475,7 @@ adv_bool conf_bool_get_default(adv_conf* context, const char* tag)
  */
 adv_error conf_bool_get(adv_conf* context, const char* tag, adv_bool* result)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_bool, 0);
 
@@ -2294,7 +2523,7 @@ adv_error conf_bool_section_get(adv_conf* context, const char* section, const ch
  */
 adv_bool conf_int_get_default(adv_conf* context, const char* tag)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_int, 1);
 
@@ -2318,7 +2547,7 @@ adv_bool conf_int_get_default(adv_conf* context, const char* tag)
  */
 adv_error conf_int_get(adv_conf* context, const char* tag, int* result)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_int, 0);
 
@@ -2366,7 +2595,7 @@ adv_error conf_int_section_get(adv_conf* context, const char* section, const cha
  */
 double conf_float_get_default(adv_conf* context, const char* tag)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_float, 1);
 
@@ -2390,7 +2619,7 @@ double conf_float_get_default(adv_conf* context, const char* tag)
  */
 adv_error conf_float_get(adv_conf* context, const char* tag, double* result)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_float, 0);
 
@@ -2414,7 +2643,7 @@ adv_error conf_float_get(adv_conf* context, const char* tag, double* result)
  */
 const char* conf_string_get_default(adv_conf* context, const char* tag)
 {
-	struct adv_conf_value_struct* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	struct adv_conf_value_struct* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_string, 1);
 
@@ -2438,7 +2667,7 @@ const char* conf_string_get_default(adv_conf* context, const char* tag)
  */
 adv_error conf_string_get(adv_conf* context, const char* tag, const char** result)
 {
-	adv_conf_value* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	adv_conf_value* value = value_searchbest_default(context, tag);
 
 	assert_option_def(context, tag, conf_type_string, 0);
 
@@ -2462,7 +2691,7 @@ adv_error conf_string_get(adv_conf* context, const char* tag, const char** resul
  */
 adv_conf_value* conf_value_get(adv_conf* context, const char* tag)
 {
-	adv_conf_value* value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	adv_conf_value* value = value_searchbest_default(context, tag);
 
 	return value;
 }
@@ -2554,7 +2783,7 @@ adv_error conf_string_section_get(adv_conf* context, const char* section, const
 void conf_iterator_begin(adv_conf_iterator* i, adv_conf* context, const char* tag)
 {
 	i->context = context;
-	i->value = value_searchbest_tag(context, (const char**)context->section_map, context->section_mac, tag);
+	i->value = value_searchbest_default(context, tag);
 }
 
 /**
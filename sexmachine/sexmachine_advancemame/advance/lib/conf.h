@@ -110,6 +110,12 @@ struct adv_conf_option_struct {
 		} base_string;
 	} data;
 
+	unsigned hash; /**< Hash of the tag. */
+	struct adv_conf_option_struct* hash_next; /**< Next entry on the hash bucket. */
+
+	struct adv_conf_value_struct* best_value; /**< Value found by the last search in the current sections. */
+	unsigned best_generation; /**< Generation of the configuration of the last search. */
+
 	struct adv_conf_option_struct* pred; /**< Pred entry on the list. */
 	struct adv_conf_option_struct* next; /**< Next entry on the list. */
 };
@@ -154,10 +160,17 @@ typedef struct adv_conf_value_struct {
 		int enum_int_value;
 	} data;
 
+	unsigned hash; /**< Hash of the section and of the option. */
+	struct adv_conf_value_struct* hash_pred; /**< Pred entry on the hash bucket. */
+	struct adv_conf_value_struct* hash_next; /**< Next entry on the hash bucket. */
+
 	struct adv_conf_value_struct* pred; /**< Pred entry on the list. */
 	struct adv_conf_value_struct* next; /**< Next entry on the list. */
 } adv_conf_value;
 
+#define CONF_OPTION_HASH_MAX 512 /**< Number of buckets of the option hash. */
+#define CONF_VALUE_HASH_MAX 4096 /**< Number of buckets of the value hash. */
+
 /**
  * Configuration context.
  * This struct contains the status of the configuration system.
@@ -167,9 +180,18 @@ typedef struct adv_conf_struct {
 	struct adv_conf_input_struct* input_list; /**< List of input. */
 	struct adv_conf_value_struct* value_list; /**< List of value. */
 
+	struct adv_conf_option_struct* option_hash_map[CONF_OPTION_HASH_MAX]; /**< Hash of the options by tag. */
+	struct adv_conf_value_struct* value_hash_map[CONF_VALUE_HASH_MAX]; /**< Hash of the values by section and option. */
+
 	char** section_map; /**< Vector of section to search. [heap] */
+	unsigned* section_hash; /**< Hash of the sections to search. [heap] */
 	unsigned section_mac; /**< Size of the vector of sections */
 
+	unsigned generation; /**< Generation of the values and sections, changed at every insert and remove. */
+	unsigned lookup_counter; /**< Number of value searches. */
+	unsigned lookup_cached_counter; /**< Number of value searches resolved from the previous search. */
+	double lookup_time; /**< Time spent in the value searches in seconds. */
+
 	adv_bool is_modified; /**< If the configuration need to be saved */
 } adv_conf;
 
@@ -227,6 +249,7 @@ typedef struct adv_conf_conv_struct {
 adv_error conf_input_file_load(adv_conf* context, int priority, const char* file, conf_error_callback* error, void* error_context);
 adv_error conf_input_file_load_adv(adv_conf* context, int priority, const char* file_in, const char* file_out, adv_bool ignore_unknown, adv_bool multi_line, const adv_conf_conv* conv_map, unsigned conv_mac, conf_error_callback* error, void* error_context);
 adv_error conf_input_args_load(adv_conf* context, int priority, const char* section, int* argc, char* argv[], conf_error_callback* error, void* error_context);
+void conf_input_remove(adv_conf* context, int priority);
 
 #define conf_size(v) sizeof(v) / sizeof(v[0])
 #define conf_enum(v) v, sizeof(v) / sizeof(v[0])
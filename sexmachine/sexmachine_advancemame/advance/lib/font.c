@@ -1122,6 +1122,88 @@ void adv_font_put_string_trasp(adv_font* font, adv_bitmap* dst, int x, int y, co
 	}
 }
 
+/**
+ * Allocate a font strip.
+ * All the chars are drawn once with the specified color map.
+ * \param font Font to use. It must be kept allocated until the strip is freed.
+ * \param bytes_per_pixel Bytes per pixel of the bitmaps where the strip is drawn.
+ * \param map Map of 256 colors to use for the different alpha values.
+ * \return The strip, or 0 on error.
+ */
+adv_font_strip* adv_font_strip_alloc(adv_font* font, unsigned bytes_per_pixel, const adv_pixel* map)
+{
+	adv_font_strip* strip;
+	unsigned size_x;
+	unsigned size_y;
+	unsigned i;
+
+	strip = malloc(sizeof(adv_font_strip));
+	if (!strip)
+		return 0;
+
+	size_x = 0;
+	size_y = 0;
+	for (i = 0; i < ADV_FONT_MAX; ++i) {
+		strip->offset[i] = size_x;
+		size_x += adv_font_sizex_char(font, i);
+		if (size_y < adv_font_sizey_char(font, i))
+			size_y = adv_font_sizey_char(font, i);
+	}
+
+	strip->font = font;
+	strip->bitmap = adv_bitmap_alloc(size_x, size_y, bytes_per_pixel);
+	if (!strip->bitmap) {
+		free(strip);
+		return 0;
+	}
+
+	for (i = 0; i < ADV_FONT_MAX; ++i) {
+		if (font->data[i] && font->data[i]->size_x)
+			adv_font_put_char_map(font, strip->bitmap, strip->offset[i], 0, i, map);
+	}
+
+	return strip;
+}
+
+/**
+ * Free a font strip.
+ */
+void adv_font_strip_free(adv_font_strip* strip)
+{
+	if (strip) {
+		adv_bitmap_free(strip->bitmap);
+		free(strip);
+	}
+}
+
+/**
+ * Draw a string in a bitmap using a font strip.
+ * Every char is a straight copy of the strip.
+ * \param strip Strip to use.
+ * \param dst Destination bitmap. It must have the same bytes per pixel of the strip.
+ * \param x,y Destination position.
+ * \param begin,end String to draw.
+ */
+void adv_font_put_string_strip(adv_font_strip* strip, adv_bitmap* dst, int x, int y, const char* begin, const char* end)
+{
+	unsigned dp = dst->bytes_per_pixel;
+
+	assert(dp == strip->bitmap->bytes_per_pixel);
+
+	while (begin != end) {
+		unsigned c = (unsigned char)*begin;
+		unsigned size_x = adv_font_sizex_char(strip->font, c);
+		unsigned size_y = adv_font_sizey_char(strip->font, c);
+		unsigned cy;
+
+		for (cy = 0; cy < size_y; ++cy)
+			memcpy(adv_bitmap_pixel(dst, x, y + cy), adv_bitmap_pixel(strip->bitmap, strip->offset[c], cy), size_x * dp);
+
+		x += size_x;
+		++begin;
+	}
+}
+
 /**
  * Scale a font by an integer factor.
  */
@@ -59,6 +59,17 @@ typedef struct adv_font_struct {
 	adv_bitmap* data[ADV_FONT_MAX]; /**< A bitmap for every ASCII char. */
 } adv_font;
 
+/**
+ * Font strip.
+ * All the chars of a font already drawn with their final colors in a
+ * single bitmap, side by side.
+ */
+typedef struct adv_font_strip_struct {
+	adv_font* font; /**< Font used to draw the strip. */
+	adv_bitmap* bitmap; /**< Bitmap with all the chars. */
+	unsigned offset[ADV_FONT_MAX]; /**< X position of every char in the bitmap. */
+} adv_font_strip;
+
 /** \addtogroup Font */
 /*@{*/
 
@@ -86,6 +97,10 @@ void adv_font_put_string_map(adv_font* font, adv_bitmap* dst, int x, int y, cons
 void adv_font_put_char_trasp(adv_font* font, adv_bitmap* dst, int x, int y, char c, unsigned color_front);
 void adv_font_put_string_trasp(adv_font* font, adv_bitmap* dst, int x, int y, const char* begin, const char* end, unsigned color_front);
 
+adv_font_strip* adv_font_strip_alloc(adv_font* font, unsigned bytes_per_pixel, const adv_pixel* map);
+void adv_font_strip_free(adv_font_strip* strip);
+void adv_font_put_string_strip(adv_font_strip* strip, adv_bitmap* dst, int x, int y, const char* begin, const char* end);
+
 /*@}*/
 
 #ifdef __cplusplus
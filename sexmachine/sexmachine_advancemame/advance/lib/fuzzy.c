@@ -0,0 +1,600 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002, 2003 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#include "portable.h"
+
+#include "fuzzy.h"
+
+/**
+ * Check if "a" is a ordered subset of "b".
+ * \param a - sub string
+ * \param b - long string
+ * \param upper_limit - maximum value returned
+ * \param almostone - almost one char of the "a" string was processed
+ * \param penality - current penality for a skipped "b" char
+ * \return the FUZZY match, lower is better
+ */
+static int fuzzy_internal(const char* a, const char* b, int* bs, int upper_limit, int almostone, int penality)
+{
+	if (upper_limit <= 0) {
+		return upper_limit;
+	} else if (!*a) {
+		return 0;
+	} else if (!*b) {
+		return strlen(a) * FUZZY_UNIT_A;
+	} else if (*a == *b) {
+		int missing = fuzzy_internal(a + 1, b + 1, bs + 1, upper_limit, 1, *bs != 0);
+		if (almostone && penality)
+			missing += FUZZY_UNIT_B;
+		return missing;
+	} else {
+		int missing_skip;
+		int missing_next = fuzzy_internal(a, b + 1, bs + 1, upper_limit, almostone, 1);
+		if (missing_next < upper_limit)
+			upper_limit = missing_next;
+		missing_skip = FUZZY_UNIT_A + fuzzy_internal(a + 1, b, bs, upper_limit - FUZZY_UNIT_A, almostone, penality);
+		if (missing_skip < missing_next)
+			return missing_skip;
+		else
+			return missing_next;
+	}
+}
+
+/**
+ * Check if "a" is a ordered subset of "b"
+ * Examples: "A string", "B string" -> penality
+ * "123", "xxx1xxx23xxx" -> 1*UNIT_B
+ * "123", "xxx1xxx2xxxxx3xxx" -> 2*UNIT_B
+ * "123", "xxx1xxx2xxxxx" -> 1*UNIT_B+1*UNIT_A
+ * "123", "xxx1xxx3xxxxx" -> 1*UNIT_B+1*UNIT_A
+ * "123", "xxx1xxx" -> 2*UNIT_A
+ * In case of multiple match the function returns the minimum penality value.
+ * \param a Sub string.
+ * \param b Long string.
+ * \param upper_limit Maximum value returned.
+ * \return The penality value as sums of ::FUZZY_UNIT_A and ::FUZZY_UNIT_B. Lower means less differences.
+ */
+int fuzzy(const char* a, const char* b, int upper_limit)
+{
+	char B[256];
+	char A[256];
+	char AA[256];
+	char BB[256];
+	int BBS[256 + 1]; /* counter of the skipped B char */
+	int skip;
+	char* aa;
+	char* bb;
+	int* bbs;
+	unsigned i;
+
+	/* convert in upper case */
+	aa = A;
+	for (i = 0; i < sizeof(A) - 1; ++i)
+		*aa++ = toupper(a[i]);
+	*aa = 0;
+	bb = B;
+	for (i = 0; i < sizeof(B) - 1 && b[i] != '(' && b[i] != '['; ++i) /* remove some string part */
+		*bb++ = toupper(b[i]);
+	*bb = 0;
+
+	/* remove unused char */
+	skip = 0;
+	a = A;
+	aa = AA;
+	while (*a) {
+		if (strchr(B, *a))
+			*aa++ = *a;
+		else
+			skip += FUZZY_UNIT_A;
+		++a;
+	}
+	*aa = 0;
+	b = B;
+	bb = BB;
+	bbs = BBS;
+	*bbs = 0;
+	while (*b) {
+		if (strchr(A, *b)) {
+			*bb++ = *b;
+			++bbs;
+			*bbs = 0;
+		} else {
+			*bbs = 1;
+		}
+		++b;
+	}
+	*bb = 0;
+
+	return skip + fuzzy_internal(AA, BB, BBS + 1, upper_limit - skip, 0, 0);
+}
+
+
+/***************************************************************************/
+/* Index */
+
+/** Number of different trigrams of the chars 'A'-'Z' and '0'-'9'. */
+#define FUZZY_TRIGRAM_MAX (37 * 37 * 37)
+
+/**
+ * Map a char of a trigram.
+ * \return From 1 to 36, or 0 if the char isn't used in the trigrams.
+ */
+static unsigned fuzzy_trigram_char(char c)
+{
+	c = toupper(c);
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A' + 1;
+	if (c >= '0' && c <= '9')
+		return c - '0' + 27;
+	return 0;
+}
+
+/**
+ * Compute the key of a string.
+ * The key is in upper case and contains only letters and digits.
+ * \param cut Stop at the same chars ignored by fuzzy().
+ */
+static char* fuzzy_key(const char* s, adv_bool cut)
+{
+	char* key = malloc(strlen(s) + 1);
+	char* k = key;
+
+	while (*s && (!cut || (*s != '(' && *s != '['))) {
+		if (isalnum((unsigned char)*s))
+			*k++ = toupper(*s);
+		++s;
+	}
+	*k = 0;
+
+	return key;
+}
+
+/**
+ * Compute the set of chars of a string compared by fuzzy().
+ * Different chars may share the same bit.
+ */
+static uint64 fuzzy_mask(const char* s, adv_bool cut)
+{
+	uint64 mask = 0;
+
+	while (*s && (!cut || (*s != '(' && *s != '['))) {
+		mask |= (uint64)1 << (toupper(*s) & 63);
+		++s;
+	}
+
+	return mask;
+}
+
+/**
+ * Allocate a fuzzy index.
+ */
+adv_fuzzy* fuzzy_alloc(void)
+{
+	adv_fuzzy* context = malloc(sizeof(adv_fuzzy));
+
+	context->entry_map = 0;
+	context->entry_mac = 0;
+	context->entry_max = 0;
+	context->is_built = 0;
+	context->hash_map = 0;
+	context->hash_max = 0;
+	context->trigram_start = 0;
+	context->trigram_list = 0;
+	context->name_order = 0;
+	context->desc_order = 0;
+
+	return context;
+}
+
+static void fuzzy_invalidate(adv_fuzzy* context)
+{
+	free(context->hash_map);
+	free(context->trigram_start);
+	free(context->trigram_list);
+	free(context->name_order);
+	free(context->desc_order);
+	context->hash_map = 0;
+	context->trigram_start = 0;
+	context->trigram_list = 0;
+	context->name_order = 0;
+	context->desc_order = 0;
+	context->is_built = 0;
+}
+
+/**
+ * Free a fuzzy index.
+ */
+void fuzzy_free(adv_fuzzy* context)
+{
+	unsigned i;
+
+	if (!context)
+		return;
+
+	fuzzy_invalidate(context);
+
+	for (i = 0; i < context->entry_mac; ++i) {
+		free(context->entry_map[i].name);
+		free(context->entry_map[i].desc);
+		free(context->entry_map[i].name_key);
+		free(context->entry_map[i].desc_key);
+	}
+	free(context->entry_map);
+	free(context);
+}
+
+/**
+ * Insert an entry in the fuzzy index.
+ * The entries are numbered from 0 in insertion order.
+ * \param name Name of the entry. It's used for the exact search.
+ * \param desc Description of the entry.
+ */
+void fuzzy_insert(adv_fuzzy* context, const char* name, const char* desc)
+{
+	adv_fuzzy_entry* entry;
+
+	if (context->entry_mac == context->entry_max) {
+		context->entry_max = context->entry_max ? context->entry_max * 2 : 256;
+		context->entry_map = realloc(context->entry_map, context->entry_max * sizeof(adv_fuzzy_entry));
+	}
+
+	entry = &context->entry_map[context->entry_mac++];
+
+	entry->name = strdup(name);
+	entry->desc = strdup(desc);
+	entry->name_key = fuzzy_key(name, 0);
+	entry->desc_key = fuzzy_key(desc, 0);
+	entry->name_mask = fuzzy_mask(name, 1);
+	entry->desc_mask = fuzzy_mask(desc, 1);
+
+	if (context->is_built)
+		fuzzy_invalidate(context);
+}
+
+static unsigned fuzzy_hash(const char* s)
+{
+	unsigned h = 2166136261U;
+
+	while (*s) {
+		h ^= (unsigned char)*s;
+		h *= 16777619U;
+		++s;
+	}
+
+	return h;
+}
+
+/**
+ * Add the trigrams of a string in the index.
+ * \param last Last entry added for every trigram, to add an entry only one time.
+ * \param fill If the trigram list is filled, otherwise the trigrams are only counted.
+ */
+static void fuzzy_trigram_add(adv_fuzzy* context, const char* s, unsigned index, unsigned* last, adv_bool fill)
+{
+	char* key = fuzzy_key(s, 1);
+	unsigned i;
+
+	for (i = 0; key[i] && key[i + 1] && key[i + 2]; ++i) {
+		unsigned t = fuzzy_trigram_char(key[i]) * 37 * 37 + fuzzy_trigram_char(key[i + 1]) * 37 + fuzzy_trigram_char(key[i + 2]);
+		if (last[t] == index + 1)
+			continue;
+		last[t] = index + 1;
+		if (fill)
+			context->trigram_list[context->trigram_start[t + 1]++] = index;
+		else
+			++context->trigram_start[t + 1];
+	}
+
+	free(key);
+}
+
+struct fuzzy_sort {
+	const char* key;
+	unsigned index;
+};
+
+static int fuzzy_sort_cmp(const void* a, const void* b)
+{
+	const struct fuzzy_sort* A = (const struct fuzzy_sort*)a;
+	const struct fuzzy_sort* B = (const struct fuzzy_sort*)b;
+	int r = strcmp(A->key, B->key);
+	if (r)
+		return r;
+	if (A->index < B->index)
+		return -1;
+	if (A->index > B->index)
+		return 1;
+	return 0;
+}
+
+static unsigned* fuzzy_order(adv_fuzzy* context, adv_bool desc)
+{
+	struct fuzzy_sort* sort_map;
+	unsigned* order;
+	unsigned i;
+
+	sort_map = malloc((context->entry_mac + 1) * sizeof(struct fuzzy_sort));
+	order = malloc((context->entry_mac + 1) * sizeof(unsigned));
+
+	for (i = 0; i < context->entry_mac; ++i) {
+		sort_map[i].key = desc ? context->entry_map[i].desc_key : context->entry_map[i].name_key;
+		sort_map[i].index = i;
+	}
+
+	qsort(sort_map, context->entry_mac, sizeof(struct fuzzy_sort), fuzzy_sort_cmp);
+
+	for (i = 0; i < context->entry_mac; ++i)
+		order[i] = sort_map[i].index;
+
+	free(sort_map);
+
+	return order;
+}
+
+/**
+ * Build all the indexes.
+ */
+static void fuzzy_build(adv_fuzzy* context)
+{
+	unsigned* last;
+	unsigned i;
+	unsigned pass;
+
+	if (context->is_built)
+		return;
+
+	/* exact hash of the names */
+	context->hash_max = 16;
+	while (context->hash_max < context->entry_mac * 2)
+		context->hash_max *= 2;
+	context->hash_map = malloc(context->hash_max * sizeof(int));
+	for (i = 0; i < context->hash_max; ++i)
+		context->hash_map[i] = -1;
+	for (i = 0; i < context->entry_mac; ++i) {
+		unsigned h = fuzzy_hash(context->entry_map[i].name) & (context->hash_max - 1);
+		while (context->hash_map[h] >= 0)
+			h = (h + 1) & (context->hash_max - 1);
+		context->hash_map[h] = i;
+	}
+
+	/* trigrams, the first pass counts and the second fills */
+	context->trigram_start = calloc(FUZZY_TRIGRAM_MAX + 1, sizeof(unsigned));
+	last = malloc(FUZZY_TRIGRAM_MAX * sizeof(unsigned));
+	for (pass = 0; pass < 2; ++pass) {
+		if (pass == 1) {
+			for (i = 0; i < FUZZY_TRIGRAM_MAX; ++i)
+				context->trigram_start[i + 1] += context->trigram_start[i];
+			context->trigram_list = malloc((context->trigram_start[FUZZY_TRIGRAM_MAX] + 1) * sizeof(unsigned));
+			/* shift to use the start of the next trigram as insertion point */
+			memmove(context->trigram_start + 1, context->trigram_start, FUZZY_TRIGRAM_MAX * sizeof(unsigned));
+			context->trigram_start[0] = 0;
+		}
+		memset(last, 0, FUZZY_TRIGRAM_MAX * sizeof(unsigned));
+		for (i = 0; i < context->entry_mac; ++i) {
+			fuzzy_trigram_add(context, context->entry_map[i].name, i, last, pass == 1);
+			fuzzy_trigram_add(context, context->entry_map[i].desc, i, last, pass == 1);
+		}
+	}
+	free(last);
+
+	/* sorted keys for the prefix search */
+	context->name_order = fuzzy_order(context, 0);
+	context->desc_order = fuzzy_order(context, 1);
+
+	context->is_built = 1;
+}
+
+/**
+ * Search an entry with the exact name.
+ * \return The index of the entry, or -1 if missing.
+ */
+int fuzzy_find(adv_fuzzy* context, const char* name)
+{
+	unsigned h;
+
+	fuzzy_build(context);
+
+	h = fuzzy_hash(name) & (context->hash_max - 1);
+	while (context->hash_map[h] >= 0) {
+		if (strcmp(context->entry_map[context->hash_map[h]].name, name) == 0)
+			return context->hash_map[h];
+		h = (h + 1) & (context->hash_max - 1);
+	}
+
+	return -1;
+}
+
+static int fuzzy_match_cmp(const void* a, const void* b)
+{
+	const adv_fuzzy_match* A = (const adv_fuzzy_match*)a;
+	const adv_fuzzy_match* B = (const adv_fuzzy_match*)b;
+	if (A->value < B->value)
+		return -1;
+	if (A->value > B->value)
+		return 1;
+	if (A->index < B->index)
+		return -1;
+	if (A->index > B->index)
+		return 1;
+	return 0;
+}
+
+/**
+ * Search the entries similar at the specified name.
+ * The name is compared with ::fuzzy() with both the name and the description
+ * of the entries. The entries sharing more trigrams with the name are compared
+ * first to reduce early the limit, and the entries missing too many chars
+ * of the name are skipped without comparing them.
+ * \param name Name to search.
+ * \param limit Max penality. It's reduced at the best penality found plus 3 ::FUZZY_UNIT_A.
+ * \param match_map Where to put the result, sorted by penality.
+ * \param match_max Size of the result vector.
+ * \return Number of entries found.
+ */
+unsigned fuzzy_search(adv_fuzzy* context, const char* name, int limit, adv_fuzzy_match* match_map, unsigned match_max)
+{
+	adv_fuzzy_match* vote_map;
+	adv_fuzzy_match* result_map;
+	unsigned vote_mac;
+	unsigned result_mac;
+	unsigned i;
+	unsigned count;
+	char* key;
+
+	fuzzy_build(context);
+
+	if (!context->entry_mac)
+		return 0;
+
+	vote_map = malloc(context->entry_mac * sizeof(adv_fuzzy_match));
+	result_map = malloc(context->entry_mac * sizeof(adv_fuzzy_match));
+
+	/* count the shared trigrams, the value is negative to sort in decreasing order */
+	for (i = 0; i < context->entry_mac; ++i) {
+		vote_map[i].index = i;
+		vote_map[i].value = 0;
+	}
+	key = fuzzy_key(name, 1);
+	for (i = 0; key[i] && key[i + 1] && key[i + 2]; ++i) {
+		unsigned t = fuzzy_trigram_char(key[i]) * 37 * 37 + fuzzy_trigram_char(key[i + 1]) * 37 + fuzzy_trigram_char(key[i + 2]);
+		unsigned j;
+		for (j = context->trigram_start[t]; j < context->trigram_start[t + 1]; ++j)
+			--vote_map[context->trigram_list[j]].value;
+	}
+	free(key);
+	vote_mac = context->entry_mac;
+	qsort(vote_map, vote_mac, sizeof(adv_fuzzy_match), fuzzy_match_cmp);
+
+	result_mac = 0;
+	for (i = 0; i < vote_mac; ++i) {
+		adv_fuzzy_entry* entry = &context->entry_map[vote_map[i].index];
+		int missing_short;
+		int missing_long;
+		int fuzzy_short;
+		int fuzzy_long;
+		int value;
+		const char* a;
+
+		/* the chars of the name missing in the entry are a lower bound of the penality */
+		missing_short = 0;
+		missing_long = 0;
+		for (a = name; *a; ++a) {
+			uint64 bit = (uint64)1 << (toupper(*a) & 63);
+			if ((entry->name_mask & bit) == 0)
+				missing_short += FUZZY_UNIT_A;
+			if ((entry->desc_mask & bit) == 0)
+				missing_long += FUZZY_UNIT_A;
+		}
+
+		if (missing_short >= limit && missing_long >= limit)
+			continue;
+
+		fuzzy_short = missing_short < limit ? fuzzy(name, entry->name, limit) : limit;
+		fuzzy_long = missing_long < limit ? fuzzy(name, entry->desc, limit) : limit;
+		value = fuzzy_short < fuzzy_long ? fuzzy_short : fuzzy_long;
+
+		if (limit > value + 3 * FUZZY_UNIT_A)
+			limit = value + 3 * FUZZY_UNIT_A; /* limit the error range */
+
+		result_map[result_mac].index = vote_map[i].index;
+		result_map[result_mac].value = value;
+		++result_mac;
+	}
+
+	qsort(result_map, result_mac, sizeof(adv_fuzzy_match), fuzzy_match_cmp);
+
+	count = 0;
+	while (count < result_mac && count < match_max && result_map[count].value < limit) {
+		match_map[count] = result_map[count];
+		++count;
+	}
+
+	free(vote_map);
+	free(result_map);
+
+	return count;
+}
+
+/**
+ * Search the first entry starting with the specified prefix.
+ * The compare ignores the case and all the chars that are not letters or digits.
+ * \param prefix Prefix to search. It must contain only letters and digits.
+ * \param desc Search the description instead of the name.
+ * \return The lower index of the entries found, or -1 if none.
+ */
+int fuzzy_prefix(adv_fuzzy* context, const char* prefix, adv_bool desc)
+{
+	char* key;
+	unsigned* order;
+	unsigned l;
+	unsigned lower;
+	unsigned upper;
+	int best;
+
+	fuzzy_build(context);
+
+	key = fuzzy_key(prefix, 0);
+	l = strlen(key);
+	if (!l) {
+		/* nothing to search */
+		free(key);
+		return -1;
+	}
+
+	order = desc ? context->desc_order : context->name_order;
+
+	/* first key not less than the prefix */
+	lower = 0;
+	upper = context->entry_mac;
+	while (lower < upper) {
+		unsigned middle = lower + (upper - lower) / 2;
+		const char* k = desc ? context->entry_map[order[middle]].desc_key : context->entry_map[order[middle]].name_key;
+		if (strcmp(k, key) < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	/* all the keys with the prefix follow */
+	best = -1;
+	while (lower < context->entry_mac) {
+		unsigned index = order[lower];
+		const char* k = desc ? context->entry_map[index].desc_key : context->entry_map[index].name_key;
+		if (strncmp(k, key, l) != 0)
+			break;
+		if (best < 0 || index < best)
+			best = index;
+		++lower;
+	}
+
+	free(key);
+
+	return best;
+}
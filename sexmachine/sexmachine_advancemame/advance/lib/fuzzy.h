@@ -0,0 +1,112 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002, 2003 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+/** \file
+ * Fuzzy compare of names.
+ */
+
+#ifndef __FUZZY_H
+#define __FUZZY_H
+
+#include "extra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Penality for a single char missing in the A string used in the ::fuzzy() function.
+ */
+#define FUZZY_UNIT_A 2
+
+/**
+ * Penality for a sequence missing in the B string used in the ::fuzzy() function.
+ * The start and the end don't count.
+ */
+#define FUZZY_UNIT_B 1
+
+/**
+ * Entry of the fuzzy index.
+ */
+typedef struct adv_fuzzy_entry_struct {
+	char* name; /**< Name. [heap] */
+	char* desc; /**< Description. [heap] */
+	char* name_key; /**< Name in upper case without separators. [heap] */
+	char* desc_key; /**< Description in upper case without separators. [heap] */
+	uint64 name_mask; /**< Set of the chars compared in the name. */
+	uint64 desc_mask; /**< Set of the chars compared in the description. */
+} adv_fuzzy_entry;
+
+/**
+ * Result of fuzzy_search().
+ */
+typedef struct adv_fuzzy_match_struct {
+	unsigned index; /**< Index of the entry. */
+	int value; /**< Penality of the match. */
+} adv_fuzzy_match;
+
+/**
+ * Fuzzy index.
+ * Index of names and descriptions built at the first search.
+ */
+typedef struct adv_fuzzy_struct {
+	adv_fuzzy_entry* entry_map; /**< Vector of entries. [heap] */
+	unsigned entry_mac; /**< Number of entries. */
+	unsigned entry_max; /**< Allocated entries. */
+
+	adv_bool is_built; /**< If the indexes are updated. */
+	int* hash_map; /**< Open addressing hash of the names. [heap] */
+	unsigned hash_max; /**< Size of the hash, a power of 2. */
+	unsigned* trigram_start; /**< Start in trigram_list of every trigram. [heap] */
+	unsigned* trigram_list; /**< Entries containing every trigram. [heap] */
+	unsigned* name_order; /**< Entries sorted by name key. [heap] */
+	unsigned* desc_order; /**< Entries sorted by description key. [heap] */
+} adv_fuzzy;
+
+/** \addtogroup Fuzzy */
+/*@{*/
+
+int fuzzy(const char* a, const char* b, int upper_limit);
+
+adv_fuzzy* fuzzy_alloc(void);
+void fuzzy_free(adv_fuzzy* context);
+void fuzzy_insert(adv_fuzzy* context, const char* name, const char* desc);
+int fuzzy_find(adv_fuzzy* context, const char* name);
+unsigned fuzzy_search(adv_fuzzy* context, const char* name, int limit, adv_fuzzy_match* match_map, unsigned match_max);
+int fuzzy_prefix(adv_fuzzy* context, const char* prefix, adv_bool desc);
+
+/*@}*/
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
+
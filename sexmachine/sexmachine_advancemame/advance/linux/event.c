@@ -35,6 +35,11 @@
 
 #include <linux/input.h>
 
+#ifdef USE_SMP
+#include <pthread.h>
+#include <sys/epoll.h>
+#endif
+
 #ifndef BTN_PLAY
 #define BTN_PLAY 0x13f /* missing in kernel 4.19 but used by joystick */
 #endif
@@ -2370,3 +2375,462 @@ unsigned event_locate(struct event_location* event_map, unsigned event_max, cons
 	return event_mac;
 }
 
+
+/***************************************************************************/
+/* Service */
+
+#ifdef USE_SMP
+
+#define EVENT_SERVICE_MAX 64 /**< Max number of handles watched. */
+
+struct event_service_item {
+	int f; /**< Handle. -1 if the slot is free. */
+	unsigned generation; /**< Generation of the slot. Used to discard notifications of removed handles. */
+	event_service_handler* handler;
+	void* arg;
+};
+
+struct event_service_context {
+	adv_bool active; /**< If the thread is running. */
+	adv_bool stop_flag; /**< Request to stop the thread. */
+	int epoll_f; /**< Handle of the epoll. */
+	int wake_map[2]; /**< Pipe used to wake up the thread. */
+	pthread_t thread;
+	unsigned mac; /**< Number of handles watched. */
+	struct event_service_item map[EVENT_SERVICE_MAX];
+	unsigned wakeup_counter; /**< Number of wake up of the thread. */
+};
+
+static struct event_service_context event_service;
+static pthread_mutex_t event_service_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* event_service_thread(void* arg)
+{
+	struct epoll_event ev_map[EVENT_SERVICE_MAX];
+	adv_bool stop;
+
+	(void)arg;
+
+	do {
+		int n;
+		int i;
+
+		n = epoll_wait(event_service.epoll_f, ev_map, EVENT_SERVICE_MAX, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			log_std(("ERROR:event: epoll_wait() failed, errno %d (%s)\n", errno, strerror(errno)));
+			break;
+		}
+
+		pthread_mutex_lock(&event_service_mutex);
+
+		++event_service.wakeup_counter;
+
+		for (i = 0; i < n; ++i) {
+			unsigned index = ev_map[i].data.u64 & 0xFFFFFFFF;
+			unsigned generation = ev_map[i].data.u64 >> 32;
+			struct event_service_item* item;
+
+			/* the wake up pipe */
+			if (index >= EVENT_SERVICE_MAX)
+				continue;
+
+			item = &event_service.map[index];
+
+			/* skip removed handles */
+			if (item->f < 0 || item->generation != generation)
+				continue;
+
+			if (item->handler(item->f, item->arg) != 0) {
+				/* stop to watch it, it's removed later by the owner */
+				epoll_ctl(event_service.epoll_f, EPOLL_CTL_DEL, item->f, 0);
+			}
+		}
+
+		stop = event_service.stop_flag;
+
+		pthread_mutex_unlock(&event_service_mutex);
+	} while (!stop);
+
+	return 0;
+}
+
+static adv_error event_service_start(void)
+{
+	struct epoll_event ev;
+
+	event_service.epoll_f = epoll_create(EVENT_SERVICE_MAX);
+	if (event_service.epoll_f < 0) {
+		log_std(("ERROR:event: epoll_create() failed, errno %d (%s)\n", errno, strerror(errno)));
+		goto err;
+	}
+
+	if (pipe(event_service.wake_map) != 0) {
+		log_std(("ERROR:event: pipe() failed, errno %d (%s)\n", errno, strerror(errno)));
+		goto err_epoll;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u64 = EVENT_SERVICE_MAX;
+	if (epoll_ctl(event_service.epoll_f, EPOLL_CTL_ADD, event_service.wake_map[0], &ev) != 0) {
+		log_std(("ERROR:event: epoll_ctl() failed, errno %d (%s)\n", errno, strerror(errno)));
+		goto err_pipe;
+	}
+
+	event_service.stop_flag = 0;
+	event_service.wakeup_counter = 0;
+
+	if (pthread_create(&event_service.thread, 0, event_service_thread, 0) != 0) {
+		log_std(("ERROR:event: pthread_create() failed\n"));
+		goto err_pipe;
+	}
+
+	event_service.active = 1;
+
+	log_std(("event: service started\n"));
+
+	return 0;
+
+err_pipe:
+	close(event_service.wake_map[0]);
+	close(event_service.wake_map[1]);
+err_epoll:
+	close(event_service.epoll_f);
+err:
+	return -1;
+}
+
+static void event_service_stop(void)
+{
+	char c = 0;
+
+	pthread_mutex_lock(&event_service_mutex);
+	event_service.stop_flag = 1;
+	pthread_mutex_unlock(&event_service_mutex);
+
+	if (write(event_service.wake_map[1], &c, 1) != 1) {
+		log_std(("ERROR:event: write() failed, errno %d (%s)\n", errno, strerror(errno)));
+	}
+
+	pthread_join(event_service.thread, 0);
+
+	close(event_service.wake_map[0]);
+	close(event_service.wake_map[1]);
+	close(event_service.epoll_f);
+
+	event_service.active = 0;
+
+	log_std(("event: service stopped after %u wake up\n", event_service.wakeup_counter));
+}
+
+/**
+ * Watch a handle with the input service.
+ * The service thread is started with the first handle.
+ * \param f Handle to watch.
+ * \param urgent Watch the urgent data, like the edges of the sysfs GPIO, instead of the input data.
+ * \param handler Function called when the handle is ready.
+ * \param arg Argument for the handler.
+ * \return 0 on success. On error the handle must be read directly.
+ */
+adv_error event_service_insert(int f, adv_bool urgent, event_service_handler* handler, void* arg)
+{
+	struct epoll_event ev;
+	struct event_service_item* item;
+	unsigned i;
+
+	if (!event_service.active) {
+		unsigned j;
+
+		for (j = 0; j < EVENT_SERVICE_MAX; ++j)
+			event_service.map[j].f = -1;
+		event_service.mac = 0;
+
+		if (event_service_start() != 0)
+			return -1;
+	}
+
+	pthread_mutex_lock(&event_service_mutex);
+
+	for (i = 0; i < EVENT_SERVICE_MAX; ++i)
+		if (event_service.map[i].f < 0)
+			break;
+	if (i == EVENT_SERVICE_MAX) {
+		log_std(("ERROR:event: too many handles in the service\n"));
+		goto err_unlock;
+	}
+
+	item = &event_service.map[i];
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = urgent ? EPOLLPRI | EPOLLERR : EPOLLIN;
+	ev.data.u64 = i | (uint64_t)(item->generation + 1) << 32;
+	if (epoll_ctl(event_service.epoll_f, EPOLL_CTL_ADD, f, &ev) != 0) {
+		log_std(("ERROR:event: epoll_ctl() failed, errno %d (%s)\n", errno, strerror(errno)));
+		goto err_unlock;
+	}
+
+	item->f = f;
+	item->generation += 1;
+	item->handler = handler;
+	item->arg = arg;
+	++event_service.mac;
+
+	pthread_mutex_unlock(&event_service_mutex);
+
+	return 0;
+
+err_unlock:
+	pthread_mutex_unlock(&event_service_mutex);
+	if (!event_service.mac)
+		event_service_stop();
+	return -1;
+}
+
+/**
+ * Stop to watch a handle.
+ * The service thread is stopped with the last handle.
+ * After the call the handler of the handle is no more called.
+ */
+void event_service_remove(int f)
+{
+	unsigned i;
+	adv_bool stop;
+
+	if (!event_service.active)
+		return;
+
+	pthread_mutex_lock(&event_service_mutex);
+
+	for (i = 0; i < EVENT_SERVICE_MAX; ++i) {
+		if (event_service.map[i].f == f) {
+			/* it may be already removed if the handler failed */
+			epoll_ctl(event_service.epoll_f, EPOLL_CTL_DEL, f, 0);
+			event_service.map[i].f = -1;
+			--event_service.mac;
+			break;
+		}
+	}
+
+	stop = event_service.mac == 0;
+
+	pthread_mutex_unlock(&event_service_mutex);
+
+	if (stop)
+		event_service_stop();
+}
+
+void event_service_lock(void)
+{
+	pthread_mutex_lock(&event_service_mutex);
+}
+
+void event_service_unlock(void)
+{
+	pthread_mutex_unlock(&event_service_mutex);
+}
+
+#else
+
+adv_error event_service_insert(int f, adv_bool urgent, event_service_handler* handler, void* arg)
+{
+	return -1;
+}
+
+void event_service_remove(int f)
+{
+}
+
+void event_service_lock(void)
+{
+}
+
+void event_service_unlock(void)
+{
+}
+
+#endif
+
+/***************************************************************************/
+/* Queue */
+
+#define EVENT_QUEUE_MAX 256 /**< Max number of events stored between two poll. */
+
+struct event_queue {
+	int f; /**< Handle of the device. */
+	adv_bool service_flag; /**< If the device is read by the input service. */
+	adv_error error; /**< Error reading the device. */
+	unsigned back; /**< Buffer written. The other is read by the poll. */
+	unsigned mac[2]; /**< Number of events in the buffers. */
+	unsigned pos; /**< Read position in the read buffer. */
+	struct input_event map[2][EVENT_QUEUE_MAX];
+	unsigned event_counter; /**< Number of events read. */
+	unsigned overflow_counter; /**< Number of events lost. */
+	double latency_sum; /**< Sum of the latency from the kernel timestamp to the poll. */
+	double latency_max; /**< Max latency. */
+};
+
+/**
+ * Read all the pending events of the device.
+ */
+static adv_error event_queue_fill(struct event_queue* queue, unsigned buffer)
+{
+	while (1) {
+		struct input_event discard_map[16];
+		struct input_event* map;
+		unsigned free;
+		int size;
+
+		free = EVENT_QUEUE_MAX - queue->mac[buffer];
+		if (free) {
+			map = queue->map[buffer] + queue->mac[buffer];
+		} else {
+			/* the poll is too late, drop the oldest events */
+			map = discard_map;
+			free = sizeof(discard_map) / sizeof(discard_map[0]);
+		}
+
+		size = read(queue->f, map, free * sizeof(struct input_event));
+
+		if (size == -1 && errno == EAGAIN) {
+			/* normal exit if data is missing */
+			return 0;
+		}
+
+		if (size <= 0 || size % sizeof(struct input_event) != 0) {
+			log_std(("ERROR:event: invalid read size %d on the event interface, errno %d (%s)\n", size, errno, strerror(errno)));
+			return -1;
+		}
+
+		if (map == discard_map) {
+			/* keep the newest events, a lost key release would leave the key pressed */
+			unsigned count = size / sizeof(struct input_event);
+			struct input_event* back = queue->map[buffer];
+
+			memmove(back, back + count, (EVENT_QUEUE_MAX - count) * sizeof(struct input_event));
+			memcpy(back + EVENT_QUEUE_MAX - count, discard_map, count * sizeof(struct input_event));
+			queue->overflow_counter += count;
+		} else {
+			queue->mac[buffer] += size / sizeof(struct input_event);
+		}
+
+		/* a partial read means that no other event is pending */
+		if (size < free * sizeof(struct input_event))
+			return 0;
+	}
+}
+
+static adv_error event_queue_handler(int f, void* arg)
+{
+	struct event_queue* queue = arg;
+
+	if (event_queue_fill(queue, queue->back) != 0) {
+		queue->error = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+struct event_queue* event_queue_alloc(int f)
+{
+	struct event_queue* queue = malloc(sizeof(struct event_queue));
+
+	queue->f = f;
+	queue->error = 0;
+	queue->back = 0;
+	queue->mac[0] = 0;
+	queue->mac[1] = 0;
+	queue->pos = 0;
+	queue->event_counter = 0;
+	queue->overflow_counter = 0;
+	queue->latency_sum = 0;
+	queue->latency_max = 0;
+
+	queue->service_flag = event_service_insert(f, 0, event_queue_handler, queue) == 0;
+
+	return queue;
+}
+
+void event_queue_free(struct event_queue* queue)
+{
+	if (queue->service_flag)
+		event_service_remove(queue->f);
+
+	if (queue->event_counter) {
+		log_std(("event: queue %d, events %u, lost %u, latency avg %g, max %g [ms]\n", queue->f, queue->event_counter, queue->overflow_counter, queue->latency_sum * 1000 / queue->event_counter, queue->latency_max * 1000));
+	}
+
+	free(queue);
+}
+
+/**
+ * Get the events arrived from the previous poll.
+ * The events are read with event_queue_read().
+ * \return 0 on success, or -1 if the device has an error.
+ */
+adv_error event_queue_poll(struct event_queue* queue)
+{
+	adv_error error;
+	unsigned front;
+	unsigned i;
+
+	if (queue->service_flag) {
+		/* swap the buffers */
+		event_service_lock();
+		front = queue->back;
+		queue->back ^= 1;
+		queue->mac[queue->back] = 0;
+		error = queue->error;
+		event_service_unlock();
+	} else {
+		front = queue->back ^ 1;
+		queue->mac[front] = 0;
+		error = event_queue_fill(queue, front);
+	}
+
+	queue->pos = 0;
+
+	/* latency from the kernel timestamp */
+	if (queue->mac[front]) {
+		struct timeval now;
+
+		gettimeofday(&now, 0);
+
+		for (i = 0; i < queue->mac[front]; ++i) {
+			struct input_event* e = &queue->map[front][i];
+			double latency = (now.tv_sec - e->time.tv_sec) + (now.tv_usec - e->time.tv_usec) / 1E6;
+			queue->latency_sum += latency;
+			if (latency > queue->latency_max)
+				queue->latency_max = latency;
+		}
+
+		queue->event_counter += queue->mac[front];
+	}
+
+	return error;
+}
+
+/**
+ * Read the next event got by the last poll.
+ * \return 1 if an event is read, 0 if no more events.
+ */
+adv_bool event_queue_read(struct event_queue* queue, int* type, int* code, int* value)
+{
+	unsigned front = queue->back ^ 1;
+	struct input_event* e;
+
+	if (queue->pos >= queue->mac[front])
+		return 0;
+
+	e = &queue->map[front][queue->pos++];
+
+	log_debug(("event: read time %ld.%06ld, type %d, code %d, value %d\n", e->time.tv_sec, e->time.tv_usec, e->type, e->code, e->value));
+
+	*type = e->type;
+	*code = e->code;
+	*value = e->value;
+
+	return 1;
+}
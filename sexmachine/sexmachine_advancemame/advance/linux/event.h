@@ -55,6 +55,31 @@ struct event_location {
 
 unsigned event_locate(struct event_location* event_map, unsigned event_max, const char* prefix, adv_bool* eaccess);
 
+/**
+ * Handler called by the input service when a handle is ready.
+ * It's called in the service thread with the service lock taken.
+ * \return If not 0 the handle is no more watched.
+ */
+typedef adv_error event_service_handler(int f, void* arg);
+
+adv_error event_service_insert(int f, adv_bool urgent, event_service_handler* handler, void* arg);
+void event_service_remove(int f);
+void event_service_lock(void);
+void event_service_unlock(void);
+
+/**
+ * Queue of events of a device.
+ * If the input service is available, the events are read by the service thread
+ * in the back buffer, and the poll swaps the buffers. Otherwise the poll
+ * reads directly all the pending events.
+ */
+struct event_queue;
+
+struct event_queue* event_queue_alloc(int f);
+void event_queue_free(struct event_queue* queue);
+adv_error event_queue_poll(struct event_queue* queue);
+adv_bool event_queue_read(struct event_queue* queue, int* type, int* code, int* value);
+
 static inline adv_bool event_test_bit(unsigned bit, unsigned char* evtype_bitmask)
 {
 	return (evtype_bitmask[bit / 8] & (1 << (bit % 8))) != 0;
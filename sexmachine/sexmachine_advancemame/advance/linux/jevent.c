@@ -114,6 +114,7 @@ struct joystick_rel_context {
 
 struct joystick_item_context {
 	int f;
+	struct event_queue* queue; /**< Events of the device. */
 	char desc[DEVICE_NAME_MAX];
 	unsigned vendor;
 	unsigned product;
@@ -820,6 +821,8 @@ adv_error joystickb_event_init(int joystickb_id)
 			continue;
 		}
 
+		item->queue = event_queue_alloc(f);
+
 		++event_state.mac;
 	}
 
@@ -840,8 +843,10 @@ void joystickb_event_done(void)
 
 	log_std(("josytickb:event: joystickb_event_done()\n"));
 
-	for (i = 0; i < event_state.mac; ++i)
+	for (i = 0; i < event_state.mac; ++i) {
+		event_queue_free(event_state.map[i].queue);
 		event_close(event_state.map[i].f);
+	}
 	event_state.mac = 0;
 }
 
@@ -1096,7 +1101,10 @@ int joystickb_event_poll(void)
 	for (i = 0; i < event_state.mac; ++i) {
 		struct joystick_item_context* item = event_state.map + i;
 		int ret;
-		while ((ret = event_read(item->f, &type, &code, &value)) == 1) {
+
+		ret = event_queue_poll(item->queue);
+
+		while (event_queue_read(item->queue, &type, &code, &value)) {
 
 			if (type == EV_KEY) {
 				unsigned j;
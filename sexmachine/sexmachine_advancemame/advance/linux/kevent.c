@@ -60,6 +60,7 @@
 
 struct keyboard_item_context {
 	int fe; /**< Handle of the event interface. */
+	struct event_queue* queue; /**< Events of the device. */
 	unsigned vendor;
 	unsigned product;
 	unsigned version;
@@ -709,6 +710,149 @@ static adv_device DEVICE[] = {
 	{ 0, 0, 0 }
 };
 
+// [SEXMACHINE] Gun triggers and serial read by the input service
+//
+// The triggers are read with the edge interrupts of the sysfs GPIO,
+// so a short pull is not lost between two polls. If the sysfs GPIO
+// isn't available, they are polled with digitalRead().
+//
+// The serial frames with the hit position are read by the service
+// and then got by getSerialData() without waiting the data.
+
+#define GUN_MAX 2
+#define GUN_DEBOUNCE (TARGET_CLOCKS_PER_SEC / 50) /**< Min time between two triggers. */
+
+struct gun_context {
+	unsigned pin; /**< GPIO of the trigger. */
+	int f; /**< Handle of the sysfs GPIO value. -1 if polled. */
+	adv_bool pending; /**< Trigger not yet processed by the poll. */
+	target_clock_t last; /**< Time of the last trigger. */
+};
+
+static struct gun_context GUN[GUN_MAX] = {
+	{ 27, -1, 0, 0 },
+	{ 22, -1, 0, 0 }
+};
+
+static adv_bool gun_serial_flag; /**< If the serial is read by the service. */
+
+static adv_error gun_sysfs_set(const char* file, const char* value)
+{
+	int f;
+	int l = strlen(value);
+
+	f = open(file, O_WRONLY);
+	if (f == -1)
+		return -1;
+
+	if (write(f, value, l) != l) {
+		close(f);
+		return -1;
+	}
+
+	close(f);
+	return 0;
+}
+
+static adv_error gun_handler(int f, void* arg)
+{
+	struct gun_context* gun = arg;
+	target_clock_t now;
+	char c;
+
+	/* read the value to clear the edge */
+	if (lseek(f, 0, SEEK_SET) != 0 || read(f, &c, 1) != 1)
+		return -1;
+
+	/* the edge is only the falling one */
+	now = target_clock();
+	if (now - gun->last >= GUN_DEBOUNCE) {
+		gun->last = now;
+		gun->pending = 1;
+	}
+
+	return 0;
+}
+
+static adv_error gun_serial_handler(int f, void* arg)
+{
+	return readSerialData();
+}
+
+static void gun_init(void)
+{
+	unsigned i;
+
+	for (i = 0; i < GUN_MAX; ++i) {
+		struct gun_context* gun = &GUN[i];
+		char file[64];
+		char value[16];
+		char c;
+
+		gun->f = -1;
+		gun->pending = 0;
+		gun->last = 0;
+
+		snprintf(value, sizeof(value), "%u", gun->pin);
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/value", gun->pin);
+		if (access(file, F_OK) != 0)
+			gun_sysfs_set("/sys/class/gpio/export", value);
+
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/edge", gun->pin);
+		if (gun_sysfs_set(file, "falling") != 0) {
+			log_std(("keyb:event: gun GPIO%u edge not available, polled\n", gun->pin));
+			continue;
+		}
+
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/value", gun->pin);
+		gun->f = open(file, O_RDONLY);
+		if (gun->f == -1)
+			continue;
+
+		/* clear the initial edge */
+		if (read(gun->f, &c, 1) != 1
+			|| event_service_insert(gun->f, 1, gun_handler, gun) != 0) {
+			log_std(("keyb:event: gun GPIO%u not in the input service, polled\n", gun->pin));
+			close(gun->f);
+			gun->f = -1;
+			continue;
+		}
+
+		log_std(("keyb:event: gun GPIO%u in the input service\n", gun->pin));
+	}
+
+	gun_serial_flag = getSerialFd() >= 0
+		&& event_service_insert(getSerialFd(), 0, gun_serial_handler, 0) == 0;
+	if (gun_serial_flag)
+		setSerialAsync(1);
+}
+
+static void gun_done(void)
+{
+	unsigned i;
+
+	if (gun_serial_flag) {
+		event_service_remove(getSerialFd());
+		setSerialAsync(0);
+		gun_serial_flag = 0;
+	}
+
+	for (i = 0; i < GUN_MAX; ++i) {
+		struct gun_context* gun = &GUN[i];
+		char file[64];
+
+		if (gun->f == -1)
+			continue;
+
+		event_service_remove(gun->f);
+		close(gun->f);
+		gun->f = -1;
+
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/edge", gun->pin);
+		gun_sysfs_set(file, "none");
+	}
+}
+
 static void keyb_event_clear(void)
 {
 	unsigned i, j;
@@ -822,6 +966,8 @@ adv_error keyb_event_init(int keyb_id, adv_bool disable_special)
 		item->version = map[i].version;
 		item->bus = map[i].bus;
 
+		item->queue = event_queue_alloc(f);
+
 		++event_state.mac;
 	}
 
@@ -835,6 +981,8 @@ adv_error keyb_event_init(int keyb_id, adv_bool disable_special)
 
 	event_state.disable_special_flag = disable_special;
 
+	gun_init();
+
 	return 0;
 }
 
@@ -844,8 +992,12 @@ void keyb_event_done(void)
 
 	log_std(("keyb:event: keyb_event_done()\n"));
 
-	for (i = 0; i < event_state.mac; ++i)
+	gun_done();
+
+	for (i = 0; i < event_state.mac; ++i) {
+		event_queue_free(event_state.map[i].queue);
 		event_close(event_state.map[i].fe);
+	}
 
 	event_state.mac = 0;
 }
@@ -1215,32 +1367,52 @@ int keyb_event_poll(void)
 	log_debug(("keyb:event: keyb_event_poll()\n"));
 
 	// [SEXMACHINE] Gun Trigger processing
+	adv_bool trigger1 = 0;
+	adv_bool trigger2 = 0;
 
+	event_service_lock();
+	if (GUN[0].f != -1) {
+		trigger1 = GUN[0].pending;
+		GUN[0].pending = 0;
+	}
+	if (GUN[1].f != -1) {
+		trigger2 = GUN[1].pending;
+		GUN[1].pending = 0;
+	}
+	event_service_unlock();
 
-	int actualTrigger = digitalRead(27);
-	if(actualTrigger != lastTrigger1){
-		lastTrigger1 = actualTrigger;
-		if(actualTrigger == LOW){
-			if(sexmachine_debug) printf("*******************************************************************\n");
-			if(sexmachine_debug) printf("[SEXMACHINE] Gun1 triggered!\n");
-			gunTriggered = 1;
-			activeGun = 1;
-			setSerialGun(0x01);
+	if (GUN[0].f == -1) {
+		int actualTrigger = digitalRead(27);
+		if(actualTrigger != lastTrigger1){
+			lastTrigger1 = actualTrigger;
+			trigger1 = actualTrigger == LOW;
 		}
 	}
 
-	actualTrigger = digitalRead(22);
-	if(actualTrigger != lastTrigger2){
-		lastTrigger2 = actualTrigger;
-		if(actualTrigger == LOW){
-			if(sexmachine_debug) printf("*******************************************************************\n");
-			if(sexmachine_debug) printf("[SEXMACHINE] Gun2 triggered!\n");
-			gunTriggered = 1;
-			activeGun = 2;
-			setSerialGun(0x02);
+	if (GUN[1].f == -1) {
+		int actualTrigger = digitalRead(22);
+		if(actualTrigger != lastTrigger2){
+			lastTrigger2 = actualTrigger;
+			trigger2 = actualTrigger == LOW;
 		}
 	}
 
+	if(trigger1){
+		if(sexmachine_debug) printf("*******************************************************************\n");
+		if(sexmachine_debug) printf("[SEXMACHINE] Gun1 triggered!\n");
+		gunTriggered = 1;
+		activeGun = 1;
+		setSerialGun(0x01);
+	}
+
+	if(trigger2){
+		if(sexmachine_debug) printf("*******************************************************************\n");
+		if(sexmachine_debug) printf("[SEXMACHINE] Gun2 triggered!\n");
+		gunTriggered = 1;
+		activeGun = 2;
+		setSerialGun(0x02);
+	}
+
 	if(gunShot == 1){
 		if(activeGun == 1) event_state.map[0].state[KEY_LEFTCTRL] = 1;
 		if(activeGun == 2) event_state.map[0].state[KEY_S] = 1;
@@ -1256,7 +1428,10 @@ int keyb_event_poll(void)
 	for (i = 0; i < event_state.mac; ++i) {
 		struct keyboard_item_context* item = event_state.map + i;
 		int ret;
-		while ((ret = event_read(item->fe, &type, &code, &value)) == 1) {
+
+		ret = event_queue_poll(item->queue);
+
+		while (event_queue_read(item->queue, &type, &code, &value)) {
 			if (type == EV_KEY) {
 				if (code < KEY_MAX)
 					item->state[code] = value != 0;
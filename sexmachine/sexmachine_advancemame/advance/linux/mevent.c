@@ -70,6 +70,7 @@ struct mouse_button_context {
 
 struct mouse_item_context {
 	int f;
+	struct event_queue* queue; /**< Events of the device. */
 	unsigned vendor;
 	unsigned product;
 	unsigned version;
@@ -263,6 +264,8 @@ adv_error mouseb_event_init(int mouseb_id)
 		item->version = map[i].version;
 		item->bus = map[i].bus;
 
+		item->queue = event_queue_alloc(f);
+
 		++event_state.mac;
 	}
 
@@ -283,8 +286,10 @@ void mouseb_event_done(void)
 
 	log_std(("mouseb:event: mouseb_event_done()\n"));
 
-	for (i = 0; i < event_state.mac; ++i)
+	for (i = 0; i < event_state.mac; ++i) {
+		event_queue_free(event_state.map[i].queue);
 		event_close(event_state.map[i].f);
+	}
 	event_state.mac = 0;
 }
 
@@ -379,7 +384,10 @@ int mouseb_event_poll(void)
 	for (i = 0; i < event_state.mac; ++i) {
 		struct mouse_item_context* item = event_state.map + i;
 		int ret;
-		while ((ret = event_read(item->f, &type, &code, &value)) == 1) {
+
+		ret = event_queue_poll(item->queue);
+
+		while (event_queue_read(item->queue, &type, &code, &value)) {
 			if (type == EV_KEY) {
 				unsigned j;
 				for (j = 0; j < item->button_mac; ++j) {
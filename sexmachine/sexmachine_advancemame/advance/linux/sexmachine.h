@@ -2,6 +2,9 @@ extern int sexmachine_debug;
 
 int getSerialData(int verbose);
 int setSerialGun(int num);
+int getSerialFd(void);
+int readSerialData(void);
+void setSerialAsync(int enable);
 long MAP(long x, long in_min, long in_max, long out_min, long out_max);
 
 extern char serial_buffer[100];
@@ -42,5 +45,6 @@ extern int game_min_x;
 extern int game_min_y;
 extern int tune_x;
 extern int tune_y;
+extern int game_runahead;
 
 void sexmachine_minmax();
@@ -89,6 +89,10 @@
 #include "interface/vmcs_host/vc_tvservice.h"
 #endif
 
+#ifdef USE_SMP
+#include <pthread.h>
+#endif
+
 // [SEXMACHINE] Vars & Funcs...
 int gunTriggered = 0;
 int gunX   = 0;
@@ -169,6 +173,118 @@ int setSerialGun(const unsigned char num){
 	if(sexmachine_debug) printf("[SEXMACHINE] Setting active gun...\t\tResult: %d\n",r);
 }
 
+// Serial frames read by the input service. When enabled, the service
+// calls readSerialData() when data is available and getSerialData()
+// only waits for a frame already parsed.
+#ifdef USE_SMP
+#define SERIAL_FRAME_MAX 4
+static pthread_mutex_t serial_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serial_cond = PTHREAD_COND_INITIALIZER;
+static int serial_async = 0;
+static int serial_in_frame = 0;
+static int serial_partial_mac = 0;
+static char serial_partial[sizeof(serial_buffer)];
+static int serial_frame_mac = 0;
+static char serial_frame_map[SERIAL_FRAME_MAX][sizeof(serial_buffer)];
+#endif
+
+int getSerialFd(void){
+  return serial_connected;
+}
+
+void setSerialAsync(int enable){
+#ifdef USE_SMP
+  pthread_mutex_lock(&serial_mutex);
+  serial_async = enable;
+  serial_in_frame = 0;
+  serial_partial_mac = 0;
+  serial_frame_mac = 0;
+  pthread_mutex_unlock(&serial_mutex);
+  if(sexmachine_debug) printf("[SEXMACHINE] Serial:\t\t\t%s\n", enable ? "read by the input service" : "read directly");
+#endif
+}
+
+int readSerialData(void){
+#ifdef USE_SMP
+  char data[64];
+  int r, i;
+
+  r = read(serial_connected, data, sizeof(data));
+  if(r == -1 && (errno == EAGAIN || errno == EINTR)) return 0;
+  if(r <= 0){
+    // the service stops watching the serial, read it directly again
+    pthread_mutex_lock(&serial_mutex);
+    serial_async = 0;
+    pthread_cond_signal(&serial_cond);
+    pthread_mutex_unlock(&serial_mutex);
+    if(sexmachine_debug) printf("[SEXMACHINE] Serial:			read error, read directly\n");
+    return -1;
+  }
+
+  pthread_mutex_lock(&serial_mutex);
+  for(i=0;i<r;++i){
+    if(!serial_in_frame){
+      // wait the frame start
+      if(data[i] == 0x3d){
+        serial_in_frame = 1;
+        serial_partial_mac = 0;
+      }
+    }else if(data[i] != 0x21){
+      if(serial_partial_mac < (int)sizeof(serial_partial) - 1)
+        serial_partial[serial_partial_mac++] = data[i];
+    }else{
+      // frame end, drop the oldest if full
+      serial_partial[serial_partial_mac] = 0;
+      if(serial_frame_mac == SERIAL_FRAME_MAX){
+        memmove(serial_frame_map[0], serial_frame_map[1], (SERIAL_FRAME_MAX - 1) * sizeof(serial_frame_map[0]));
+        --serial_frame_mac;
+      }
+      memcpy(serial_frame_map[serial_frame_mac++], serial_partial, sizeof(serial_partial));
+      serial_in_frame = 0;
+      pthread_cond_signal(&serial_cond);
+    }
+  }
+  pthread_mutex_unlock(&serial_mutex);
+#endif
+  return 0;
+}
+
+#ifdef USE_SMP
+static int getSerialDataAsync(int verbose){
+  struct timespec ts;
+  int r = 0;
+
+  if(verbose) printf("[SEXMACHINE] Waiting for data...\n");
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_nsec += 20000000;
+  if(ts.tv_nsec >= 1000000000){
+    ++ts.tv_sec;
+    ts.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&serial_mutex);
+  while(serial_frame_mac == 0 && serial_async){
+    if(pthread_cond_timedwait(&serial_cond, &serial_mutex, &ts) != 0)
+      break;
+  }
+  if(serial_frame_mac > 0){
+    memcpy(serial_buffer, serial_frame_map[0], sizeof(serial_buffer));
+    memmove(serial_frame_map[0], serial_frame_map[1], (SERIAL_FRAME_MAX - 1) * sizeof(serial_frame_map[0]));
+    --serial_frame_mac;
+    r = 1;
+  }
+  pthread_mutex_unlock(&serial_mutex);
+
+  if(verbose){
+    if(r) printf("[SEXMACHINE] Data received:\t\t%s\n",serial_buffer);
+    else printf("[SEXMACHINE] Serial:\t\t\tno data...\n");
+  }
+
+  return r;
+}
+#endif
+
 int getSerialData(int verbose){
 
   fd_set set;
@@ -178,6 +294,10 @@ int getSerialData(int verbose){
   char rect[1];
   int nread;
 
+#ifdef USE_SMP
+  if(serial_async) return getSerialDataAsync(verbose);
+#endif
+
   if(verbose) printf("[SEXMACHINE] Waiting for data...\n");
 
   FD_ZERO(&set); /* clear the set */
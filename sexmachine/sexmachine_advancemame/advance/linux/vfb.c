@@ -72,6 +72,7 @@ int game_min_x = 0;
 int game_min_y = 0;
 int tune_x = 0;
 int tune_y = 0;
+int game_runahead = 0;
 char game_name[50];
 int bytes_per_scanline = 0;
 long frame_draw_duration = 0;
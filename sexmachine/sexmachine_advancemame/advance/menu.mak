@@ -22,6 +22,7 @@ MENUOBJS += \
 	$(MENUOBJ)/menu/crc.o \
 	$(MENUOBJ)/menu/emulator.o \
 	$(MENUOBJ)/menu/emuxml.o \
+	$(MENUOBJ)/menu/gamedb.o \
 	$(MENUOBJ)/menu/game.o \
 	$(MENUOBJ)/menu/mconfig.o \
 	$(MENUOBJ)/menu/menu.o \
@@ -56,6 +57,7 @@ MENUOBJS += \
 	$(MENUOBJ)/lib/joy.o \
 	$(MENUOBJ)/lib/mouse.o \
 	$(MENUOBJ)/lib/incstr.o \
+	$(MENUOBJ)/lib/fuzzy.o \
 	$(MENUOBJ)/lib/videoio.o \
 	$(MENUOBJ)/lib/update.o \
 	$(MENUOBJ)/lib/generate.o \
@@ -134,6 +136,10 @@ MENUOBJS += \
 	$(MENUOBJ)/linux/file.o \
 	$(MENUOBJ)/linux/target.o \
 	$(MENUOBJ)/linux/os.o
+ifeq ($(CONF_LIB_PTHREAD),yes)
+MENUCFLAGS += -D_REENTRANT -DUSE_SMP
+MENULIBS += -lpthread
+endif
 ifeq ($(CONF_LIB_SVGALIB),yes)
 MENUCFLAGS += \
 	-DUSE_VIDEO_SVGALIB \
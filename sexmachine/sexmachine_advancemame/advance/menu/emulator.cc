@@ -27,12 +27,18 @@
 #include "menu.h"
 #include "game.h"
 #include "mconfig.h"
+#include "gamedb.h"
 
 #include "advance.h"
 
 #include <fstream>
 #include <sstream>
 
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
 using namespace std;
 
 //---------------------------------------------------------------------------
@@ -336,7 +342,12 @@ bool emulator::run_process(time_t& duration, const string& dir, int argc, const
 
 	start = time(0);
 
-	int r = target_spawn(argv[0], argv);
+	bool result;
+	if (!run_server(argc, argv, ignore_error || resume_error, result)) {
+		int r = target_spawn(argv[0], argv);
+
+		result = spawn_check(r, ignore_error || resume_error);
+	}
 
 	stop = time(0);
 
@@ -345,8 +356,6 @@ bool emulator::run_process(time_t& duration, const string& dir, int argc, const
 	else
 		duration = 0;
 
-	bool result = spawn_check(r, ignore_error || resume_error);
-
 	if (resume_error)
 		result = true;
 
@@ -360,6 +369,175 @@ bool emulator::run_process(time_t& duration, const string& dir, int argc, const
 	return result;
 }
 
+#if HAVE_SYS_SOCKET_H
+/**
+ * Connect at the emulator server.
+ * \return The socket, or -1 if the server isn't running.
+ */
+static int server_connect(const string& path)
+{
+	struct sockaddr_un addr;
+
+	if (path.length() >= sizeof(addr.sun_path))
+		return -1;
+
+	int f = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (f < 0)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path.c_str());
+
+	if (connect(f, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+		close(f);
+		return -1;
+	}
+
+	return f;
+}
+
+/**
+ * Start the emulator server in background.
+ * The server is detached from the menu, and it remains running after
+ * the menu exits.
+ */
+static bool server_start(const char* exe, const string& path)
+{
+	pid_t pid = fork();
+	if (pid == -1)
+		return false;
+
+	if (pid == 0) {
+		// fork again to not leave a zombie when the server exits
+		if (fork() == 0) {
+			setsid();
+			execl(exe, exe, "-server", path.c_str(), (char*)0);
+		}
+		_exit(127);
+	}
+
+	waitpid(pid, 0, 0);
+
+	return true;
+}
+
+static bool server_write(int f, const string& s)
+{
+	const char* buffer = s.c_str();
+	unsigned size = s.length();
+
+	while (size) {
+		ssize_t r = write(f, buffer, size);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return false;
+		buffer += r;
+		size -= r;
+	}
+
+	return true;
+}
+
+static bool server_read(int f, string& s)
+{
+	s.erase();
+
+	while (true) {
+		char c;
+		ssize_t r = read(f, &c, 1);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return false;
+		if (c == '\n')
+			return true;
+		s += c;
+	}
+}
+#endif
+
+/**
+ * Run the game with the resident emulator server.
+ * The server is started at the first use. It's used only if the
+ * `emulator_server' option is set for the emulator.
+ * \param result Result of the game run.
+ * \return If the server was used. If false, the emulator has to be run as process.
+ */
+bool emulator::run_server(int argc, const char** argv, bool ignore_error, bool& result) const
+{
+#if HAVE_SYS_SOCKET_H
+	if (user_server_path.length() == 0)
+		return false;
+
+	target_clock_t launch = target_clock();
+
+	int f = server_connect(user_server_path);
+	if (f < 0) {
+		log_std(("menu: server start '%s' '%s'\n", argv[0], user_server_path.c_str()));
+
+		if (!server_start(argv[0], user_server_path)) {
+			log_std(("ERROR:menu: server start failed\n"));
+			return false;
+		}
+
+		// wait at most 10 seconds for the server socket
+		for (unsigned i = 0; i < 100 && f < 0; ++i) {
+			target_usleep(100000);
+			f = server_connect(user_server_path);
+		}
+
+		if (f < 0) {
+			log_std(("ERROR:menu: server '%s' not available\n", user_server_path.c_str()));
+			return false;
+		}
+	}
+
+	ostringstream request;
+	request << "run\t" << launch;
+	for (int i = 1; i < argc; ++i)
+		request << "\t" << argv[i];
+
+	log_std(("menu: server request '%s'\n", request.str().c_str()));
+
+	if (!server_write(f, request.str() + "\n")) {
+		log_std(("ERROR:menu: server request failed\n"));
+		close(f);
+		return false;
+	}
+
+	// wait the end of the game
+	string reply;
+	bool done = server_read(f, reply);
+
+	close(f);
+
+	int r;
+	long long delay;
+	if (!done || sscanf(reply.c_str(), "done %d %lld", &r, &delay) != 2) {
+		if (!ignore_error)
+			target_err("Error server '%s' terminated during the game.\n", user_server_path.c_str());
+		result = false;
+		return true;
+	}
+
+	log_std(("menu: server first frame %g [ms] after the launch\n", delay * 1000.0 / TARGET_CLOCKS_PER_SEC));
+
+	if (r != 0) {
+		if (!ignore_error)
+			target_err("Error game exited with status %d.\n", r);
+		result = false;
+	} else {
+		result = true;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
 unsigned emulator::compile(const game& g, const char** argv, unsigned argc, const string& list, unsigned orientation) const
 {
 	int pos = 0;
@@ -714,6 +892,17 @@ bool mame_info::update_xml()
 bool mame_info::load_game_xml(game_set& gar)
 {
 	string xml_file = path_abs(path_import(file_config_file_home((user_name_get() + ".xml").c_str())), dir_cwd());
+	string db_file = path_abs(path_import(file_config_file_home((user_name_get() + ".gdb").c_str())), dir_cwd());
+	target_clock_t start = target_clock();
+	gamedb_key key;
+	bool has_key;
+
+	// use the binary database if it was built from the same information file
+	has_key = gamedb_key_get(key, xml_file);
+	if (has_key && gamedb_load(db_file, key, this, gar)) {
+		log_std(("menu: loaded '%s' from the database in %g [ms]\n", user_name_get().c_str(), (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC));
+		return true;
+	}
 
 	ifstream f(cpath_export(xml_file), ios::in | ios::binary);
 	if (!f) {
@@ -728,6 +917,12 @@ bool mame_info::load_game_xml(game_set& gar)
 	}
 	f.close();
 
+	log_std(("menu: loaded '%s' from the information file in %g [ms]\n", user_name_get().c_str(), (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC));
+
+	// a failure only means that the information file is parsed again the next time
+	if (has_key)
+		gamedb_save(db_file, key, this, gar);
+
 	return true;
 }
 
@@ -71,6 +71,7 @@ protected:
 	std::string user_marquee_path;
 	std::string user_title_path;
 	std::string user_rom_filter;
+	std::string user_server_path; // socket of the resident emulator server (in OS format)
 
 	// final version = user + emulator config (in UNIVERSAL format)
 	std::string config_rom_path;
@@ -93,6 +94,7 @@ protected:
 	void load_dirlist(game_set& gar, const std::string& dirlist, const std::string& filterlist, bool quiet);
 
 	bool run_process(time_t& duration, const std::string& dir, int argc, const char** argv, bool ignore_error) const;
+	bool run_server(int argc, const char** argv, bool ignore_error, bool& result) const;
 	unsigned compile(const game& g, const char** argv, unsigned argc, const std::string& list, unsigned orientation) const;
 
 	bool validate_config_file(const std::string& file) const;
@@ -148,6 +150,8 @@ public:
 	const std::string& user_title_path_get() const { return user_title_path; }
 	void user_rom_filter_set(const std::string& A) { user_rom_filter = A; }
 	const std::string& user_rom_filter_get() const { return user_rom_filter; }
+	void user_server_path_set(const std::string& A) { user_server_path = A; }
+	const std::string& user_server_path_get() const { return user_server_path; }
 
 	// from the emulator.cfg
 	const std::string& software_path_get() const { return emu_software_path; }
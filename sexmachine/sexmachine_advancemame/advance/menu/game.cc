@@ -96,15 +96,19 @@ game::~game()
 {
 }
 
+unsigned game::generation = 0;
+
 void game::name_set(const std::string& A)
 {
 	name = A;
+	++generation;
 }
 
 void game::auto_description_set(const std::string& A) const
 {
 	if (!is_user_description_set()) {
 		description = A;
+		++generation;
 	}
 }
 
@@ -118,6 +122,7 @@ void game::manufacturer_set(const std::string& s)
 {
 	// clear previous value
 	manufacturer.erase();
+	++generation;
 
 	// allocate the whole size to speedup
 	manufacturer.reserve(s.length());
@@ -199,8 +204,10 @@ string game::name_without_emulator_get() const
 
 void game::auto_group_set(const category* A) const
 {
-	if (!is_user_group_set())
+	if (!is_user_group_set()) {
 		group = A;
+		++generation;
+	}
 }
 
 void game::user_group_set(const category* A) const
@@ -208,12 +215,15 @@ void game::user_group_set(const category* A) const
 	if (!A->undefined_get())
 		flag |= flag_user_group_set;
 	group = A;
+	++generation;
 }
 
 void game::auto_type_set(const category* A) const
 {
-	if (!is_user_type_set())
+	if (!is_user_type_set()) {
 		type = A;
+		++generation;
+	}
 }
 
 void game::user_type_set(const category* A) const
@@ -221,6 +231,7 @@ void game::user_type_set(const category* A) const
 	if (!A->undefined_get())
 		flag |= flag_user_type_set;
 	type = A;
+	++generation;
 }
 
 const category* game::group_derived_get() const
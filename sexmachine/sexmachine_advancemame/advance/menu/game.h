@@ -138,6 +138,8 @@ class game {
 
 	emulator* emu;
 
+	static unsigned generation; ///< Changed at every update of the information used to sort the games.
+
 	bool preview_find_down(resource& path, const resource& (game::*preview_get)() const, const std::string& exclude) const;
 	bool preview_find_up(resource& path, const resource& (game::*preview_get)() const, const std::string& exclude) const;
 
@@ -149,6 +151,12 @@ public:
 
 	static const unsigned flag_first = 0x10000;
 
+	/**
+	 * Get the generation of the sort information of all the games.
+	 * If it's unchanged, any previous sort of the games is still valid.
+	 */
+	static unsigned generation_get() { return generation; }
+
 	void flag_set(bool value, unsigned mask) const
 	{
 		if (value)
@@ -171,11 +179,11 @@ public:
 
 	void auto_description_set(const std::string& A) const;
 	bool is_user_description_set() const { return flag_get(flag_user_description_set); }
-	void user_description_set(const std::string& A) const { flag |= flag_user_description_set; description = A; }
+	void user_description_set(const std::string& A) const { flag |= flag_user_description_set; description = A; ++generation; }
 	const std::string& description_get() const { return description; }
 	std::string description_tree_get() const;
 
-	void auto_info_set(const std::string& A) const { info = A; }
+	void auto_info_set(const std::string& A) const { info = A; ++generation; }
 	const std::string& info_get() const { return info; }
 
 	bool is_user_group_set() const { return flag_get(flag_user_group_set); }
@@ -192,36 +200,36 @@ public:
 	play_t play_get() const { return play; }
 	void play_best_set(play_t A) const { play_best = A; }
 	play_t play_best_get() const { return play_best; }
-	void year_set(const std::string& A) { year = A; }
+	void year_set(const std::string& A) { year = A; ++generation; }
 	const std::string& year_get() const { return year; }
 	void manufacturer_set(const std::string& A);
 	const std::string& manufacturer_get() const { return manufacturer; }
 	void software_path_set(const std::string& A) const { software_path = A; }
 	const std::string& software_path_get() const { return software_path; }
-	void software_set(bool A) { flag_set(A, flag_software); }
+	void software_set(bool A) { flag_set(A, flag_software); ++generation; }
 	bool software_get() const { return flag_get(flag_software); }
 	void filled_set(bool A) const { flag_set(A, flag_filled); }
 	bool filled_get() const { return flag_get(flag_filled); }
-	void time_set(unsigned A) const { flag |= flag_time_set; time = A; }
+	void time_set(unsigned A) const { flag |= flag_time_set; time = A; ++generation; }
 	bool is_time_set() const { return flag_get(flag_time_set); }
 
 	unsigned time_get() const { return time; }
 	unsigned time_tree_get() const;
-	void session_set(unsigned A) const { flag |= flag_session_set; session = A; }
+	void session_set(unsigned A) const { flag |= flag_session_set; session = A; ++generation; }
 	bool is_session_set() const { return flag_get(flag_session_set); }
 	unsigned session_tree_get() const;
 	unsigned session_get() const { return session; }
-	void size_set(unsigned Asize) const { size = Asize; }
+	void size_set(unsigned Asize) const { size = Asize; ++generation; }
 	unsigned size_get() const { return size; }
-	void sizex_set(unsigned A) { sizex = A; }
+	void sizex_set(unsigned A) { sizex = A; ++generation; }
 	unsigned sizex_get() const { return sizex; }
-	void sizey_set(unsigned A) { sizey = A; }
+	void sizey_set(unsigned A) { sizey = A; ++generation; }
 	unsigned sizey_get() const { return sizey; }
 	void aspectx_set(unsigned A) { aspectx = A; }
 	unsigned aspectx_get() const { return aspectx; }
 	void aspecty_set(unsigned A) { aspecty = A; }
 	unsigned aspecty_get() const { return aspecty; }
-	void emulator_set(emulator* A) { emu = A; }
+	void emulator_set(emulator* A) { emu = A; ++generation; }
 	emulator* emulator_get() const { return emu; }
 
 	void preview_snap_set(const resource& A) const { snap_path = A; }
@@ -256,7 +264,7 @@ public:
 
 	bool preview_find(resource& path, const resource& (game::*preview_get)() const) const;
 
-	void parent_set(const game* A) const { parent = A; }
+	void parent_set(const game* A) const { parent = A; ++generation; }
 	unsigned clone_get() const { return clone_bag.size(); }
 
 	void rom_zip_set_insert(const std::string& Afile) const;
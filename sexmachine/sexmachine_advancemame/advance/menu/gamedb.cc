@@ -0,0 +1,426 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002, 2003, 2004, 2008 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "portable.h"
+
+#include "gamedb.h"
+#include "emulator.h"
+
+#include "advance.h"
+
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <map>
+#include <vector>
+
+using namespace std;
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/****************************************************************************/
+/* Format */
+
+/*
+ * The database is a single file in the native byte order:
+ *
+ *   header
+ *   game records, sorted by name
+ *   device records
+ *   extension records
+ *   string pool, every string terminated by 0
+ *
+ * All the references are 32 bit offsets, strings are offsets in the pool.
+ * The file is only a cache of the information file, if something doesn't
+ * match it's simply regenerated.
+ */
+
+#define GAMEDB_MAGIC 0x42444741 /* AGDB */
+#define GAMEDB_VERSION 1
+#define GAMEDB_ORDER 0x01020304
+
+/**
+ * Flags of the game stored in the database.
+ */
+#define GAMEDB_FLAG_MASK (emulator::flag_derived_vector | emulator::flag_derived_vertical | emulator::flag_derived_resource)
+
+struct gamedb_header {
+	unsigned magic;
+	unsigned version;
+	unsigned order;
+	unsigned record_size; ///< Size of the game record, to detect a different layout.
+	unsigned key_mtime_lo;
+	unsigned key_mtime_hi;
+	unsigned key_size_lo;
+	unsigned key_size_hi;
+	unsigned game_count;
+	unsigned game_offset;
+	unsigned device_count;
+	unsigned device_offset;
+	unsigned ext_count;
+	unsigned ext_offset;
+	unsigned pool_size;
+	unsigned pool_offset;
+};
+
+struct gamedb_game {
+	unsigned name;
+	unsigned description;
+	unsigned year;
+	unsigned manufacturer;
+	unsigned cloneof;
+	unsigned romof;
+	unsigned flag;
+	unsigned play;
+	unsigned size;
+	unsigned sizex;
+	unsigned sizey;
+	unsigned aspectx;
+	unsigned aspecty;
+	unsigned device_first;
+	unsigned device_count;
+};
+
+struct gamedb_device {
+	unsigned name;
+	unsigned ext_first;
+	unsigned ext_count;
+};
+
+bool gamedb_key_get(gamedb_key& key, const string& info_file)
+{
+	struct stat st;
+
+	if (stat(cpath_export(info_file), &st) != 0)
+		return false;
+
+	key.mtime = st.st_mtime;
+	key.size = st.st_size;
+
+	return true;
+}
+
+/****************************************************************************/
+/* Save */
+
+class gamedb_pool {
+	map<string, unsigned> index;
+	string data;
+public:
+	unsigned insert(const string& s);
+	const string& data_get() const { return data; }
+};
+
+unsigned gamedb_pool::insert(const string& s)
+{
+	map<string, unsigned>::iterator i = index.find(s);
+	if (i != index.end())
+		return i->second;
+
+	unsigned offset = data.size();
+	data.append(s.c_str(), s.length() + 1);
+	index.insert(i, pair<string, unsigned>(s, offset));
+
+	return offset;
+}
+
+bool gamedb_save(const string& file, const gamedb_key& key, emulator* emu, const game_set& gar)
+{
+	gamedb_pool pool;
+	vector<gamedb_game> game_bag;
+	vector<gamedb_device> device_bag;
+	vector<unsigned> ext_bag;
+
+	for (game_set::const_iterator i = gar.begin(); i != gar.end(); ++i) {
+		if (i->emulator_get() != emu)
+			continue;
+
+		gamedb_game g;
+
+		g.name = pool.insert(i->name_get());
+		g.description = pool.insert(i->description_get());
+		g.year = pool.insert(i->year_get());
+		g.manufacturer = pool.insert(i->manufacturer_get());
+		g.cloneof = pool.insert(i->cloneof_get());
+		g.romof = pool.insert(i->romof_get());
+		g.flag = 0;
+		if (i->flag_get(emulator::flag_derived_vector))
+			g.flag |= emulator::flag_derived_vector;
+		if (i->flag_get(emulator::flag_derived_vertical))
+			g.flag |= emulator::flag_derived_vertical;
+		if (i->flag_get(emulator::flag_derived_resource))
+			g.flag |= emulator::flag_derived_resource;
+		g.play = i->play_get();
+		g.size = i->size_get();
+		g.sizex = i->sizex_get();
+		g.sizey = i->sizey_get();
+		g.aspectx = i->aspectx_get();
+		g.aspecty = i->aspecty_get();
+		g.device_first = device_bag.size();
+		g.device_count = i->machinedevice_bag_get().size();
+
+		for (machinedevice_container::const_iterator j = i->machinedevice_bag_get().begin(); j != i->machinedevice_bag_get().end(); ++j) {
+			gamedb_device d;
+
+			d.name = pool.insert(j->name);
+			d.ext_first = ext_bag.size();
+			d.ext_count = j->ext_bag.size();
+
+			for (machinedevice_ext_container::const_iterator k = j->ext_bag.begin(); k != j->ext_bag.end(); ++k)
+				ext_bag.push_back(pool.insert(*k));
+
+			device_bag.push_back(d);
+		}
+
+		game_bag.push_back(g);
+	}
+
+	gamedb_header h;
+
+	h.magic = GAMEDB_MAGIC;
+	h.version = GAMEDB_VERSION;
+	h.order = GAMEDB_ORDER;
+	h.record_size = sizeof(gamedb_game);
+	h.key_mtime_lo = key.mtime & 0xFFFFFFFF;
+	h.key_mtime_hi = key.mtime >> 32;
+	h.key_size_lo = key.size & 0xFFFFFFFF;
+	h.key_size_hi = key.size >> 32;
+	h.game_count = game_bag.size();
+	h.game_offset = sizeof(gamedb_header);
+	h.device_count = device_bag.size();
+	h.device_offset = h.game_offset + h.game_count * sizeof(gamedb_game);
+	h.ext_count = ext_bag.size();
+	h.ext_offset = h.device_offset + h.device_count * sizeof(gamedb_device);
+	h.pool_size = pool.data_get().size();
+	h.pool_offset = h.ext_offset + h.ext_count * sizeof(unsigned);
+
+	// write in a temporary file to never leave a partial database
+	string tmp_file = file + ".tmp";
+
+	FILE* f = fopen(cpath_export(tmp_file), "wb");
+	if (!f) {
+		log_std(("gamedb: error opening file %s\n", cpath_export(tmp_file)));
+		return false;
+	}
+
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+	if (ok && h.game_count)
+		ok = fwrite(&game_bag[0], sizeof(gamedb_game), h.game_count, f) == h.game_count;
+	if (ok && h.device_count)
+		ok = fwrite(&device_bag[0], sizeof(gamedb_device), h.device_count, f) == h.device_count;
+	if (ok && h.ext_count)
+		ok = fwrite(&ext_bag[0], sizeof(unsigned), h.ext_count, f) == h.ext_count;
+	if (ok && h.pool_size)
+		ok = fwrite(pool.data_get().data(), h.pool_size, 1, f) == 1;
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (ok) {
+		if (rename(cpath_export(tmp_file), cpath_export(file)) != 0) {
+			// some systems don't replace an existing file
+			remove(cpath_export(file));
+			ok = rename(cpath_export(tmp_file), cpath_export(file)) == 0;
+		}
+	}
+
+	if (!ok) {
+		log_std(("gamedb: error writing file %s\n", cpath_export(file)));
+		remove(cpath_export(tmp_file));
+		return false;
+	}
+
+	log_std(("gamedb: saved %d games, %d devices, %d bytes of strings in %s\n", h.game_count, h.device_count, h.pool_size, cpath_export(file)));
+
+	return true;
+}
+
+/****************************************************************************/
+/* Load */
+
+/**
+ * Check that a table is completely inside the file.
+ */
+static bool gamedb_range(unsigned offset, unsigned count, unsigned size, unsigned file_size)
+{
+	if (offset > file_size)
+		return false;
+	if (size != 0 && count > (file_size - offset) / size)
+		return false;
+	return true;
+}
+
+static bool gamedb_validate(const unsigned char* data, unsigned data_size, const gamedb_key& key)
+{
+	if (data_size < sizeof(gamedb_header))
+		return false;
+
+	const gamedb_header* h = (const gamedb_header*)data;
+
+	if (h->magic != GAMEDB_MAGIC || h->version != GAMEDB_VERSION || h->order != GAMEDB_ORDER || h->record_size != sizeof(gamedb_game))
+		return false;
+
+	if (h->key_mtime_lo != (key.mtime & 0xFFFFFFFF) || h->key_mtime_hi != (key.mtime >> 32)
+		|| h->key_size_lo != (key.size & 0xFFFFFFFF) || h->key_size_hi != (key.size >> 32))
+		return false;
+
+	if (!gamedb_range(h->game_offset, h->game_count, sizeof(gamedb_game), data_size)
+		|| !gamedb_range(h->device_offset, h->device_count, sizeof(gamedb_device), data_size)
+		|| !gamedb_range(h->ext_offset, h->ext_count, sizeof(unsigned), data_size)
+		|| !gamedb_range(h->pool_offset, h->pool_size, 1, data_size))
+		return false;
+
+	// the tables are read in place, they must be aligned
+	if (h->game_offset % sizeof(unsigned) != 0 || h->device_offset % sizeof(unsigned) != 0 || h->ext_offset % sizeof(unsigned) != 0)
+		return false;
+
+	// the pool must end with a terminator, so any offset inside it is a valid string
+	if (h->pool_size == 0 || data[h->pool_offset + h->pool_size - 1] != 0)
+		return false;
+
+	const gamedb_game* game_map = (const gamedb_game*)(data + h->game_offset);
+	const gamedb_device* device_map = (const gamedb_device*)(data + h->device_offset);
+	const unsigned* ext_map = (const unsigned*)(data + h->ext_offset);
+
+	for (unsigned i = 0; i < h->game_count; ++i) {
+		const gamedb_game* g = game_map + i;
+		if (g->name >= h->pool_size || g->description >= h->pool_size || g->year >= h->pool_size
+			|| g->manufacturer >= h->pool_size || g->cloneof >= h->pool_size || g->romof >= h->pool_size)
+			return false;
+		if (g->play > play_preliminary)
+			return false;
+		if (g->device_first > h->device_count || g->device_count > h->device_count - g->device_first)
+			return false;
+	}
+
+	for (unsigned i = 0; i < h->device_count; ++i) {
+		const gamedb_device* d = device_map + i;
+		if (d->name >= h->pool_size)
+			return false;
+		if (d->ext_first > h->ext_count || d->ext_count > h->ext_count - d->ext_first)
+			return false;
+	}
+
+	for (unsigned i = 0; i < h->ext_count; ++i) {
+		if (ext_map[i] >= h->pool_size)
+			return false;
+	}
+
+	return true;
+}
+
+static void gamedb_insert(const unsigned char* data, emulator* emu, game_set& gar)
+{
+	const gamedb_header* h = (const gamedb_header*)data;
+	const gamedb_game* game_map = (const gamedb_game*)(data + h->game_offset);
+	const gamedb_device* device_map = (const gamedb_device*)(data + h->device_offset);
+	const unsigned* ext_map = (const unsigned*)(data + h->ext_offset);
+	const char* pool = (const char*)(data + h->pool_offset);
+
+	// the records are sorted by name, so every game is inserted after the previous one
+	game_set::iterator hint = gar.begin();
+
+	for (unsigned i = 0; i < h->game_count; ++i) {
+		const gamedb_game* r = game_map + i;
+		game g;
+
+		g.emulator_set(emu);
+		g.name_set(pool + r->name);
+		g.auto_description_set(pool + r->description);
+		g.year_set(pool + r->year);
+		g.manufacturer_set(pool + r->manufacturer);
+		g.cloneof_set(pool + r->cloneof);
+		g.romof_set(pool + r->romof);
+		g.flag_set(true, r->flag & GAMEDB_FLAG_MASK);
+		g.play_set((play_t)r->play);
+		g.size_set(r->size);
+		g.sizex_set(r->sizex);
+		g.sizey_set(r->sizey);
+		g.aspectx_set(r->aspectx);
+		g.aspecty_set(r->aspecty);
+
+		for (unsigned j = 0; j < r->device_count; ++j) {
+			const gamedb_device* d = device_map + r->device_first + j;
+			machinedevice m;
+
+			m.name = pool + d->name;
+			for (unsigned k = 0; k < d->ext_count; ++k)
+				m.ext_bag.insert(m.ext_bag.end(), pool + ext_map[d->ext_first + k]);
+
+			g.machinedevice_bag_get().insert(g.machinedevice_bag_get().end(), m);
+		}
+
+		hint = gar.insert(hint, g);
+	}
+}
+
+bool gamedb_load(const string& file, const gamedb_key& key, emulator* emu, game_set& gar)
+{
+	struct stat st;
+	int f;
+
+	f = open(cpath_export(file), O_RDONLY | O_BINARY);
+	if (f == -1)
+		return false;
+
+	if (fstat(f, &st) != 0 || st.st_size < (off_t)sizeof(gamedb_header) || st.st_size > 0x7FFFFFFF) {
+		close(f);
+		return false;
+	}
+
+	unsigned data_size = st.st_size;
+	const unsigned char* data;
+
+#if HAVE_SYS_MMAN_H
+	void* map = mmap(0, data_size, PROT_READ, MAP_PRIVATE, f, 0);
+	close(f);
+	if (map == MAP_FAILED) {
+		log_std(("gamedb: error mapping file %s\n", cpath_export(file)));
+		return false;
+	}
+	data = (const unsigned char*)map;
+#else
+	unsigned char* buffer = (unsigned char*)malloc(data_size);
+	if (!buffer || read(f, buffer, data_size) != (int)data_size) {
+		free(buffer);
+		close(f);
+		return false;
+	}
+	close(f);
+	data = buffer;
+#endif
+
+	bool ok = gamedb_validate(data, data_size, key);
+	if (ok)
+		gamedb_insert(data, emu, gar);
+	else
+		log_std(("gamedb: invalid or stale file %s\n", cpath_export(file)));
+
+#if HAVE_SYS_MMAN_H
+	munmap(map, data_size);
+#else
+	free(buffer);
+#endif
+
+	return ok;
+}
+
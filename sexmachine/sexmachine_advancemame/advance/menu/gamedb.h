@@ -0,0 +1,53 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002, 2003, 2004, 2008 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __GAMEDB_H
+#define __GAMEDB_H
+
+#include "game.h"
+
+#include <string>
+
+/**
+ * Identity of the information file from which a game database was built.
+ * If the information file changes the database is rebuilt.
+ */
+struct gamedb_key {
+	unsigned long long mtime; ///< Modification time of the information file.
+	unsigned long long size; ///< Size of the information file.
+};
+
+bool gamedb_key_get(gamedb_key& key, const std::string& info_file);
+
+/**
+ * Load the games of an emulator from a binary database.
+ * The file is mapped in memory and fully validated before inserting any game.
+ * \return false if the database is missing, stale or corrupt.
+ */
+bool gamedb_load(const std::string& file, const gamedb_key& key, emulator* emu, game_set& gar);
+
+/**
+ * Save the games of an emulator in a binary database.
+ * Only the information read from the emulator is stored.
+ */
+bool gamedb_save(const std::string& file, const gamedb_key& key, emulator* emu, const game_set& gar);
+
+#endif
+
@@ -256,6 +256,7 @@ void config_state::conf_register(adv_conf* config_context)
 	conf_string_register_multi(config_context, "emulator_titles");
 	conf_string_register_multi(config_context, "emulator_include");
 	conf_string_register_multi(config_context, "emulator_attrib");
+	conf_string_register_multi(config_context, "emulator_server");
 	conf_string_register_multi(config_context, "group");
 	conf_string_register_multi(config_context, "type");
 	conf_string_register_multi(config_context, "group_include");
@@ -1004,6 +1005,8 @@ bool config_state::load(adv_conf* config_context, bool opt_verbose)
 		return false;
 	if (!config_load_iterator_emu_set(config_context, "emulator_titles", emu, &emulator::user_title_path_set))
 		return false;
+	if (!config_load_iterator_emu_set(config_context, "emulator_server", emu, &emulator::user_server_path_set))
+		return false;
 
 	for (pemulator_container::iterator i = emu.begin(); i != emu.end(); ++i) {
 		if (!(*i)->config_get().load(config_context, config_normalize((*i)->user_name_get())))
@@ -28,6 +28,7 @@
 #include "conf.h"
 
 #include <list>
+#include <vector>
 
 #define ADV_COPY \
 	"AdvanceMENU - Copyright (C) 1999-2018 by Andrea Mazzoleni\n"
@@ -66,80 +67,8 @@ enum listsort_t {
 	sort_by_emulator
 };
 
-inline bool sort_by_root_name_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_leveldesc_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_name_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_manufacturer_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_manufacturer_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_year_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_year_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_res_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_res_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_time_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_time_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_smart_time_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_smart_time_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_session_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_session_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_timepersession_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_timepersession_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_group_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_group_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_type_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_type_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_size_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_size_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_info_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_info_less, pgame_by_desc_less, pgame_by_name_less);
-}
-
-inline bool sort_by_emulator_func(const game* A, const game* B)
-{
-	return pgame_combine_less(A, B, pgame_by_emulator_less, pgame_by_leveldesc_less, pgame_by_desc_less);
-}
-
-
-typedef bool (*pgame_sort_func)(const game*, const game*);
-
-typedef std::set<const game*, pgame_sort_func> pgame_sort_set;
+/// Games selected and sorted for the menu.
+typedef std::vector<const game*> pgame_sort_vector;
 
 /// Type of mode.
 enum listmode_t {
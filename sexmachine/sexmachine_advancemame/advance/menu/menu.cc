@@ -30,6 +30,7 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <map>
 
 using namespace std;
 
@@ -499,21 +500,22 @@ void draw_menu_scroll(int x, int y, int dx, int dy, int pos, int delta, int max)
 // ------------------------------------------------------------------------
 // Menu utility
 
-bool menu_fast_compare(const string& game, const string& fast)
+// Index of the menu entries for the quick search.
+// The entries have the same position of the menu.
+static adv_fuzzy* menu_fast_index(const menu_array& gc)
 {
-	unsigned igame = 0;
-	unsigned ifast = 0;
-	while (igame < game.length() && ifast < fast.length()) {
-		while (igame < game.length() && !isalnum(game[igame]))
-			++igame;
-		if (igame < game.length()) {
-			if (toupper(game[igame]) != toupper(fast[ifast]))
-				return false;
-			++igame;
-			++ifast;
-		}
-	}
-	return ifast == fast.length();
+	adv_fuzzy* index = fuzzy_alloc();
+
+	for (menu_array::const_iterator i = gc.begin(); i != gc.end(); ++i) {
+		if ((*i)->has_game()) {
+			const game& g = (*i)->game_get().clone_best_get();
+			fuzzy_insert(index, g.name_without_emulator_get().c_str(), (*i)->desc_get().c_str());
+		} else {
+			fuzzy_insert(index, "", (*i)->desc_get().c_str());
+		}
+	}
+
+	return index;
 }
 
 //--------------------------------------------------------------------------
@@ -659,6 +661,33 @@ void backdrop_index_set(unsigned pos, menu_array& gc, unsigned back_pos, listpre
 	backdrop_game_set(effective_game, back_pos, preview, current, highlight, clip, rs);
 }
 
+/**
+ * Number of games, or rows of games, around the visible ones with the preview decoded in advance.
+ */
+#define BACKDROP_PREFETCH 2
+
+void backdrop_index_prefetch(int pos, menu_array& gc, unsigned back_pos, listpreview_t preview, config_state& rs)
+{
+	if (pos < 0 || pos >= gc.size() || !gc[pos]->has_game())
+		return;
+
+	const game* effective_game = &gc[pos]->game_get().clone_best_get();
+	resource backdrop_res;
+	unsigned aspectx;
+	unsigned aspecty;
+
+	if (preview == preview_snap || preview == preview_title) {
+		aspectx = effective_game->aspectx_get();
+		aspecty = effective_game->aspecty_get();
+	} else {
+		aspectx = 0;
+		aspecty = 0;
+	}
+
+	if (backdrop_find_preview_default(backdrop_res, aspectx, aspecty, preview, effective_game, rs))
+		int_backdrop_prefetch(back_pos, backdrop_res, aspectx, aspecty);
+}
+
 //--------------------------------------------------------------------------
 // Menu run
 
@@ -1252,6 +1281,9 @@ static int run_menu_user(config_state& rs, bool flipxy, menu_array& gc, sort_ite
 	// text position
 	struct cell_t* int_map = new cell_t[coln * rown];
 
+	// quick search index, built at the first search
+	adv_fuzzy* fast_index = 0;
+
 	// size of the text cell
 	int cell_dx = (win_dx - space_x * (coln - 1)) / coln;
 	int cell_dy = (win_dy - space_y * (rown - 1)) / rown;
@@ -1614,6 +1646,23 @@ static int run_menu_user(config_state& rs, bool flipxy, menu_array& gc, sort_ite
 						backdrop_index_set(pos_base + i, gc, i, effective_preview, current, current, current, rs);
 				}
 			}
+
+			// decode in background the previews of the games that scrolling shows next,
+			// in the cell where they are going to appear
+			int_backdrop_prefetch_clear();
+			if (backdrop_mac == 1) {
+				for (int i = 1; i <= BACKDROP_PREFETCH; ++i) {
+					backdrop_index_prefetch(pos_base + pos_rel + i, gc, 0, effective_preview, rs);
+					backdrop_index_prefetch(pos_base + pos_rel - i, gc, 0, effective_preview, rs);
+				}
+			} else if (backdrop_mac > 1) {
+				for (int r = 0; r < BACKDROP_PREFETCH; ++r) {
+					for (int i = 0; i < coln; ++i) {
+						backdrop_index_prefetch(pos_base + coln * (rown + r) + i, gc, coln * (rown - 1) + i, effective_preview, rs);
+						backdrop_index_prefetch(pos_base - coln * (r + 1) + i, gc, i, effective_preview, rs);
+					}
+				}
+			}
 		}
 		if (box)
 			int_box(box_x, box_y, box_dx, box_dy, 1, COLOR_MENU_BACKDROP.foreground);
@@ -1680,24 +1729,13 @@ static int run_menu_user(config_state& rs, bool flipxy, menu_array& gc, sort_ite
 		default:
 			if (key > 32 && key < 128 && isalnum(key)) {
 				oldfast.insert(oldfast.length(), 1, (char)key);
-				menu_array::const_iterator i;
-				for (i = gc.begin(); i != gc.end(); ++i) {
-					if (menu_fast_compare((*i)->desc_get(), oldfast)) {
-						break;
-					}
-				}
-				if (i == gc.end()) {
-					for (i = gc.begin(); i != gc.end(); ++i) {
-						if ((*i)->has_game()) {
-							const game& g = (*i)->game_get().clone_best_get();
-							if (menu_fast_compare(g.name_without_emulator_get(), oldfast)) {
-								break;
-							}
-						}
-					}
-				}
-				if (i != gc.end()) {
-					int pos = i - gc.begin();
+				if (!fast_index)
+					fast_index = menu_fast_index(gc);
+				// first search the description, and then the name
+				int pos = fuzzy_prefix(fast_index, oldfast.c_str(), 1);
+				if (pos < 0)
+					pos = fuzzy_prefix(fast_index, oldfast.c_str(), 0);
+				if (pos >= 0) {
 					menu_pos(pos, pos_base, pos_rel, pos_rel_max, pos_base_upper, coln, gc.size());
 					rs.fast = oldfast;
 				}
@@ -1778,6 +1816,8 @@ static int run_menu_user(config_state& rs, bool flipxy, menu_array& gc, sort_ite
 	delete [] backdrop_map;
 	delete [] backdrop_map_bis;
 
+	fuzzy_free(fast_index);
+
 	if (backdrop_mac > 0) {
 		int_backdrop_done();
 	}
@@ -1939,7 +1979,309 @@ int run_menu_idle_off()
 	return key;
 }
 
-int run_menu_sort(config_state& rs, const pgame_sort_set& gss, sort_item_func* category_func, bool flipxy, bool silent, string over_msg)
+// ------------------------------------------------------------------------
+// Sort
+
+/**
+ * Game with the precomputed sort key.
+ */
+struct sort_entry {
+	unsigned long long key;
+	const game* g;
+};
+
+/**
+ * Stable LSD radix sort by key.
+ * The passes on bytes equal in all the keys are skipped.
+ */
+static void sort_radix(vector<sort_entry>& bag)
+{
+	if (bag.size() < 2)
+		return;
+
+	vector<sort_entry> tmp(bag.size());
+	unsigned count[256];
+
+	for (unsigned shift = 0; shift < 64; shift += 8) {
+		for (unsigned i = 0; i < 256; ++i)
+			count[i] = 0;
+
+		for (vector<sort_entry>::const_iterator i = bag.begin(); i != bag.end(); ++i)
+			++count[(i->key >> shift) & 0xFF];
+
+		// nothing to do if all the keys have the same byte
+		if (count[(bag[0].key >> shift) & 0xFF] == bag.size())
+			continue;
+
+		unsigned pos = 0;
+		for (unsigned i = 0; i < 256; ++i) {
+			unsigned c = count[i];
+			count[i] = pos;
+			pos += c;
+		}
+
+		for (vector<sort_entry>::const_iterator i = bag.begin(); i != bag.end(); ++i)
+			tmp[count[(i->key >> shift) & 0xFF]++] = *i;
+
+		bag.swap(tmp);
+	}
+}
+
+/**
+ * Return a string that compares with the plain string compare as case_less().
+ */
+static string sort_collate(const string& s)
+{
+	string r(s.length(), 0);
+
+	for (unsigned i = 0; i < s.length(); ++i) {
+		char c = toupper(s[i]);
+		// case_less() compares signed chars
+		r[i] = c ^ 0x80;
+	}
+
+	return r;
+}
+
+template<class T>
+struct sort_rank_less {
+	const vector<T>& key;
+
+	sort_rank_less(const vector<T>& Akey) : key(Akey) { }
+
+	bool operator()(unsigned A, unsigned B) const
+	{
+		return key[A] < key[B];
+	}
+};
+
+/**
+ * Compute the rank of every key, equal keys get the same rank.
+ */
+template<class T>
+static unsigned sort_rank(const vector<T>& key, vector<unsigned>& rank)
+{
+	vector<unsigned> index(key.size());
+	unsigned r = 0;
+
+	for (unsigned i = 0; i < key.size(); ++i)
+		index[i] = i;
+
+	sort(index.begin(), index.end(), sort_rank_less<T>(key));
+
+	rank.resize(key.size());
+	for (unsigned i = 0; i < index.size(); ++i) {
+		if (i != 0 && key[index[i - 1]] < key[index[i]])
+			++r;
+		rank[index[i]] = r;
+	}
+
+	return r + 1;
+}
+
+/**
+ * Rank of the games as pgame_by_leveldesc_less().
+ * The key of every game is the list of descriptions from the root parent.
+ */
+static void sort_rank_level(const vector<const game*>& bag, const vector<unsigned>& desc_rank, vector<unsigned>& rank)
+{
+	const unsigned stack_max = 16;
+	map<const game*, unsigned> index;
+	vector<vector<unsigned> > level(bag.size());
+
+	for (unsigned i = 0; i < bag.size(); ++i)
+		index[bag[i]] = i;
+
+	for (unsigned i = 0; i < bag.size(); ++i) {
+		vector<unsigned>& k = level[i];
+		const game* g = bag[i];
+		while (g != 0 && k.size() < stack_max) {
+			unsigned j = index[g];
+			// software first, and after by description
+			k.insert(k.begin(), (g->software_get() ? 0 : 0x80000000) | desc_rank[j]);
+			g = g->parent_get();
+		}
+	}
+
+	sort_rank(level, rank);
+}
+
+static unsigned sort_time(const game* g)
+{
+	if (g->emulator_get()->tree_get())
+		return g->time_tree_get();
+	else
+		return g->time_get();
+}
+
+static unsigned sort_session(const game* g)
+{
+	if (g->emulator_get()->tree_get())
+		return g->session_tree_get();
+	else
+		return g->session_get();
+}
+
+/**
+ * Sort all the games.
+ * The key of every game is computed only once, with the same order of the
+ * pgame_by_*_less() functions, and the ties are broken by the name.
+ */
+static void sort_build(pgame_sort_vector& order, const game_set& gar, listsort_t sort_mode)
+{
+	vector<const game*> bag;
+	vector<string> str;
+	vector<unsigned> desc_rank;
+	vector<unsigned> primary;
+	vector<unsigned> secondary;
+	unsigned n;
+
+	// the game_set is sorted by name
+	bag.reserve(gar.size());
+	for (game_set::const_iterator i = gar.begin(); i != gar.end(); ++i)
+		bag.push_back(&*i);
+	n = bag.size();
+
+	// the description is used by all the sort
+	str.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+		str[i] = sort_collate(bag[i]->description_get());
+	sort_rank(str, desc_rank);
+
+	primary.resize(n, 0);
+	secondary = desc_rank;
+
+	switch (sort_mode) {
+	case sort_by_name:
+		break;
+	case sort_by_root_name:
+		sort_rank_level(bag, desc_rank, primary);
+		break;
+	case sort_by_emulator: {
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = bag[i]->emulator_get()->user_name_get();
+		unsigned max = sort_rank(str, primary);
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = max - 1 - primary[i]; // descending
+		sort_rank_level(bag, desc_rank, secondary);
+		break;
+	}
+	case sort_by_manufacturer:
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = sort_collate(bag[i]->manufacturer_get());
+		sort_rank(str, primary);
+		break;
+	case sort_by_year: {
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = bag[i]->year_get();
+		unsigned max = sort_rank(str, primary);
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = max - 1 - primary[i]; // descending
+		break;
+	}
+	case sort_by_res:
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = min(bag[i]->sizex_get(), 0xFFFFU) << 16 | min(bag[i]->sizey_get(), 0xFFFFU);
+		break;
+	case sort_by_time:
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = ~sort_time(bag[i]);
+		break;
+	case sort_by_smart_time:
+		for (unsigned i = 0; i < n; ++i) {
+			unsigned v = sort_time(bag[i]);
+			if (v < 30 * 60)
+				v = 0;
+			primary[i] = ~v;
+		}
+		break;
+	case sort_by_session:
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = ~sort_session(bag[i]);
+		break;
+	case sort_by_timepersession:
+		for (unsigned i = 0; i < n; ++i) {
+			unsigned c = sort_session(bag[i]);
+			primary[i] = ~(c ? sort_time(bag[i]) / c : 0);
+		}
+		break;
+	case sort_by_group:
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = sort_collate(bag[i]->group_derived_get()->name_get());
+		sort_rank(str, primary);
+		break;
+	case sort_by_type:
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = sort_collate(bag[i]->type_derived_get()->name_get());
+		sort_rank(str, primary);
+		break;
+	case sort_by_size:
+		for (unsigned i = 0; i < n; ++i)
+			primary[i] = ~bag[i]->size_get();
+		break;
+	case sort_by_info:
+		for (unsigned i = 0; i < n; ++i)
+			str[i] = bag[i]->info_get();
+		sort_rank(str, primary);
+		break;
+	}
+
+	vector<sort_entry> entry(n);
+	for (unsigned i = 0; i < n; ++i) {
+		entry[i].key = (unsigned long long)primary[i] << 32 | secondary[i];
+		entry[i].g = bag[i];
+	}
+
+	sort_radix(entry);
+
+	order.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+		order[i] = entry[i].g;
+}
+
+/**
+ * All the games sorted with the last sort mode.
+ * It's reused until something used by the sort changes, and a change of the
+ * filters only needs a linear scan of it.
+ */
+static pgame_sort_vector sort_cache_bag;
+static bool sort_cache_valid = false;
+static listsort_t sort_cache_sort;
+static unsigned sort_cache_size;
+static unsigned sort_cache_generation;
+static string sort_cache_tree;
+
+static const pgame_sort_vector& sort_cache_get(config_state& rs)
+{
+	// the time and session sort depend on the clone state of the emulators
+	string tree;
+	for (pemulator_container::iterator i = rs.emu.begin(); i != rs.emu.end(); ++i)
+		tree += (*i)->tree_get() ? '1' : '0';
+
+	if (!sort_cache_valid
+		|| sort_cache_sort != rs.sort_get()
+		|| sort_cache_size != rs.gar.size()
+		|| sort_cache_generation != game::generation_get()
+		|| sort_cache_tree != tree) {
+		target_clock_t start = target_clock();
+
+		sort_build(sort_cache_bag, rs.gar, rs.sort_get());
+
+		sort_cache_valid = true;
+		sort_cache_sort = rs.sort_get();
+		sort_cache_size = rs.gar.size();
+		sort_cache_generation = game::generation_get();
+		sort_cache_tree = tree;
+
+		log_std(("menu: sorted %d games in %g [ms]\n", (unsigned)sort_cache_bag.size(), (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC));
+	} else {
+		log_std(("menu: sort reused\n"));
+	}
+
+	return sort_cache_bag;
+}
+
+int run_menu_sort(config_state& rs, const pgame_sort_vector& gss, sort_item_func* category_func, bool flipxy, bool silent, string over_msg)
 {
 	menu_array gc;
 
@@ -1948,13 +2290,13 @@ int run_menu_sort(config_state& rs, const pgame_sort_set& gss, sort_item_func* c
 	bool list_mode = rs.mode_get() == mode_list || rs.mode_get() == mode_list_mixed;
 	if (!list_mode || rs.sort_get() == sort_by_name || rs.sort_get() == sort_by_time || rs.sort_get() == sort_by_smart_time || rs.sort_get() == sort_by_size || rs.sort_get() == sort_by_session || rs.sort_get() == sort_by_timepersession) {
 		gc.reserve(gss.size());
-		for (pgame_sort_set::const_iterator i = gss.begin(); i != gss.end(); ++i) {
+		for (pgame_sort_vector::const_iterator i = gss.begin(); i != gss.end(); ++i) {
 			gc.insert(gc.end(), new menu_entry(*i, 0));
 		}
 	} else if (rs.sort_get() == sort_by_emulator) {
 		string category = "dummy";
 		gc.reserve(gss.size() + 16);
-		for (pgame_sort_set::const_iterator i = gss.begin(); i != gss.end(); ++i) {
+		for (pgame_sort_vector::const_iterator i = gss.begin(); i != gss.end(); ++i) {
 			string new_category = category_func(**i);
 			if (new_category != category) {
 				category = new_category;
@@ -1971,7 +2313,7 @@ int run_menu_sort(config_state& rs, const pgame_sort_set& gss, sort_item_func* c
 		}
 	} else if (rs.sort_get() == sort_by_root_name) {
 		gc.reserve(gss.size());
-		for (pgame_sort_set::const_iterator i = gss.begin(); i != gss.end(); ++i) {
+		for (pgame_sort_vector::const_iterator i = gss.begin(); i != gss.end(); ++i) {
 			unsigned ident = 0;
 			if ((*i)->parent_get()) {
 				if ((*i)->software_get())
@@ -1984,7 +2326,7 @@ int run_menu_sort(config_state& rs, const pgame_sort_set& gss, sort_item_func* c
 	} else {
 		string category = "dummy";
 		gc.reserve(gss.size() + 256);
-		for (pgame_sort_set::const_iterator i = gss.begin(); i != gss.end(); ++i) {
+		for (pgame_sort_vector::const_iterator i = gss.begin(); i != gss.end(); ++i) {
 			string new_category = category_func(**i);
 			if (new_category != category) {
 				category = new_category;
@@ -2112,67 +2454,52 @@ void run_runinfo(config_state& rs)
 
 int run_menu(config_state& rs, bool flipxy, bool silent)
 {
-	pgame_sort_set* psc;
 	sort_item_func* category_func;
 
 	log_std(("menu: sort begin\n"));
 
-	// setup the sorted container
+	// setup the category
 	switch (rs.sort_get()) {
 	case sort_by_root_name:
-		psc = new pgame_sort_set(sort_by_root_name_func);
 		category_func = sort_item_root_name;
 		break;
 	case sort_by_name:
-		psc = new pgame_sort_set(sort_by_name_func);
 		category_func = sort_item_name;
 		break;
 	case sort_by_manufacturer:
-		psc = new pgame_sort_set(sort_by_manufacturer_func);
 		category_func = sort_item_manufacturer;
 		break;
 	case sort_by_year:
-		psc = new pgame_sort_set(sort_by_year_func);
 		category_func = sort_item_year;
 		break;
 	case sort_by_time:
-		psc = new pgame_sort_set(sort_by_time_func);
 		category_func = sort_item_time;
 		break;
 	case sort_by_smart_time:
-		psc = new pgame_sort_set(sort_by_smart_time_func);
 		category_func = sort_item_smart_time;
 		break;
 	case sort_by_session:
-		psc = new pgame_sort_set(sort_by_session_func);
 		category_func = sort_item_session;
 		break;
 	case sort_by_group:
-		psc = new pgame_sort_set(sort_by_group_func);
 		category_func = sort_item_group;
 		break;
 	case sort_by_type:
-		psc = new pgame_sort_set(sort_by_type_func);
 		category_func = sort_item_type;
 		break;
 	case sort_by_size:
-		psc = new pgame_sort_set(sort_by_size_func);
 		category_func = sort_item_size;
 		break;
 	case sort_by_res:
-		psc = new pgame_sort_set(sort_by_res_func);
 		category_func = sort_item_res;
 		break;
 	case sort_by_info:
-		psc = new pgame_sort_set(sort_by_info_func);
 		category_func = sort_item_info;
 		break;
 	case sort_by_timepersession:
-		psc = new pgame_sort_set(sort_by_timepersession_func);
 		category_func = sort_item_timepersession;
 		break;
 	case sort_by_emulator:
-		psc = new pgame_sort_set(sort_by_emulator_func);
 		category_func = sort_item_emulator;
 		break;
 	default:
@@ -2242,8 +2569,16 @@ int run_menu(config_state& rs, bool flipxy, bool silent)
 	// recompute the preview mask
 	rs.preview_mask = 0;
 
-	// select and sort
-	for (game_set::const_iterator i = rs.gar.begin(); i != rs.gar.end(); ++i) {
+	// sort all the games, or reuse the previous sort
+	const pgame_sort_vector& order = sort_cache_get(rs);
+
+	pgame_sort_vector gss;
+	gss.reserve(order.size());
+
+	// select
+	for (pgame_sort_vector::const_iterator j = order.begin(); j != order.end(); ++j) {
+		const game* i = *j;
+
 		// emulator
 		if (!i->emulator_get()->state_get())
 			continue;
@@ -2268,7 +2603,7 @@ int run_menu(config_state& rs, bool flipxy, bool silent)
 
 		has_filter = true;
 
-		psc->insert(&*i);
+		gss.push_back(i);
 
 		// update the preview mask
 		if (i->preview_snap_get().is_valid() || i->preview_clip_get().is_valid())
@@ -2326,7 +2661,7 @@ int run_menu(config_state& rs, bool flipxy, bool silent)
 	int key = 0;
 
 	while (!done) {
-		key = run_menu_sort(rs, *psc, category_func, flipxy, silent, empty_msg);
+		key = run_menu_sort(rs, gss, category_func, flipxy, silent, empty_msg);
 
 		// don't replay the sound and clip
 		silent = true;
@@ -2401,8 +2736,6 @@ int run_menu(config_state& rs, bool flipxy, bool silent)
 		}
 	}
 
-	delete psc;
-
 	return key;
 }
 
@@ -35,6 +35,10 @@
 #include <deque>
 #include <cmath>
 
+#ifdef USE_SMP
+#include <pthread.h>
+#endif
+
 using namespace std;
 
 // -------------------------------------------------------------------------
@@ -1044,6 +1048,32 @@ void int_clear_overlay(void)
 	overlay_text = "";
 }
 
+// -------------------------------------------------------------------------
+// Blit lock
+
+#ifdef USE_SMP
+static pthread_mutex_t int_blit_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// The blit pipeline allocates its buffers from a single global stack,
+// so it can be used only by one thread at time.
+// Take this lock in any function using a video pipeline.
+class blit_lock {
+public:
+	blit_lock()
+	{
+#ifdef USE_SMP
+		pthread_mutex_lock(&int_blit_mutex);
+#endif
+	}
+	~blit_lock()
+	{
+#ifdef USE_SMP
+		pthread_mutex_unlock(&int_blit_mutex);
+#endif
+	}
+};
+
 // -------------------------------------------------------------------------
 // Cell Position
 
@@ -1061,7 +1091,7 @@ public:
 	int real_dx;
 	int real_dy;
 
-	void compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand);
+	void compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand) const;
 	void draw_backdrop(const adv_bitmap* map, const adv_color_rgb& background);
 	void draw_clip(const adv_bitmap* map, adv_color_rgb* rgb_map, unsigned rgb_max, unsigned aspectx, unsigned aspecty, double aspect_expand, const adv_color_rgb& background, bool clear, int resizeeffect);
 	void clear(const adv_color_rgb& background);
@@ -1071,6 +1101,8 @@ public:
 
 void cell_pos_t::redraw()
 {
+	blit_lock lock;
+
 	video_write_lock();
 
 	video_stretch_direct(real_x, real_y, real_dx, real_dy, video_foreground_buffer + real_y * video_buffer_line_size + real_x * video_bytes_per_pixel(), real_dx, real_dy, video_buffer_line_size, video_bytes_per_pixel(), video_color_def(), 0);
@@ -1078,7 +1110,7 @@ void cell_pos_t::redraw()
 	video_write_unlock(real_x, real_y, real_dx, real_dy, 0);
 }
 
-void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand)
+void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand) const
 {
 	if (int_orientation & ADV_ORIENTATION_FLIP_XY) {
 		unsigned t = aspectx;
@@ -1106,9 +1138,9 @@ void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitm
 		*rx = static_cast<unsigned>(real_dy * aspectx * aspect_expand / aspecty);
 		*ry = real_dy;
 	}
-	if (*rx > real_dx)
+	if (*rx > static_cast<unsigned>(real_dx))
 		*rx = real_dx;
-	if (*ry > real_dy)
+	if (*ry > static_cast<unsigned>(real_dy))
 		*ry = real_dy;
 }
 
@@ -1152,6 +1184,8 @@ void cell_pos_t::clear(const adv_color_rgb& background)
 
 void cell_pos_t::draw_clip(const adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned rgb_max, unsigned aspectx, unsigned aspecty, double aspect_expand, const adv_color_rgb& background, bool clear, int resizeeffect)
 {
+	blit_lock lock;
+
 	adv_pixel pixel = video_pixel_get(background.red, background.green, background.blue);
 
 	// source range and steps
@@ -1348,36 +1382,41 @@ void cell_pos_t::border(int width, const adv_color_rgb& color)
 // Backdrop (already orientation corrected)
 class backdrop_data {
 	adv_bitmap* map;
+	bool done; ///< The image was already decoded, also if with an error.
 	resource res;
 	unsigned target_dx;
 	unsigned target_dy;
 	unsigned aspectx;
 	unsigned aspecty;
 
-	void icon_apply(adv_bitmap* bitmap, adv_bitmap* bitmap_mask, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
-	adv_bitmap* image_load(const resource& res, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
-	adv_bitmap* adapt(adv_bitmap* bitmap, adv_color_rgb* rgb, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect);
+	static void icon_apply(adv_bitmap* bitmap, adv_bitmap* bitmap_mask, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
+	static adv_bitmap* image_load(const resource& res, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
+	static adv_bitmap* adapt(adv_bitmap* bitmap, adv_color_rgb* rgb, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect);
 
 public:
 	backdrop_data(const resource& Ares, unsigned Atarget_dx, unsigned Atarget_dy, unsigned Aaspectx, unsigned Aaspecty);
 	~backdrop_data();
 
 	bool is_active() const { return map != 0; }
+	bool is_done() const { return done; }
 	const resource& res_get() const { return res; }
 	const adv_bitmap* bitmap_get() const { return map; }
+	void bitmap_set(adv_bitmap* Amap);
 
 	unsigned target_dx_get() const { return target_dx; }
 	unsigned target_dy_get() const { return target_dy; }
 	unsigned aspectx_get() const { return aspectx; }
 	unsigned aspecty_get() const { return aspecty; }
 
-	void load(struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect);
+	static adv_bitmap* decode(const resource& res, const struct cell_pos_t* cell, const adv_color_rgb& background, unsigned aspectx, unsigned aspecty, double aspect_expand, int resizeeffect);
+	void load(const struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect);
 };
 
 backdrop_data::backdrop_data(const resource& Ares, unsigned Atarget_dx, unsigned Atarget_dy, unsigned Aaspectx, unsigned Aaspecty)
 	: res(Ares), target_dx(Atarget_dx), target_dy(Atarget_dy), aspectx(Aaspectx), aspecty(Aaspecty)
 {
 	map = 0;
+	done = false;
 }
 
 backdrop_data::~backdrop_data()
@@ -1532,6 +1571,8 @@ adv_bitmap* backdrop_data::image_load(const resource& res, adv_color_rgb* rgb, u
 
 adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect)
 {
+	blit_lock lock;
+
 	// source range and steps
 	unsigned char* ptr = bitmap->ptr;
 	int dw = bitmap->bytes_per_scanline;
@@ -1670,17 +1711,24 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 	return raw;
 }
 
-void backdrop_data::load(struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+void backdrop_data::bitmap_set(adv_bitmap* Amap)
 {
 	if (map)
-		return; // already loaded
+		adv_bitmap_free(map);
+	map = Amap;
+	done = true;
+}
 
+// Load and resize an image, it doesn't use any state of the interface
+// and it's also called by the decoder threads
+adv_bitmap* backdrop_data::decode(const resource& res, const struct cell_pos_t* cell, const adv_color_rgb& background, unsigned aspectx, unsigned aspecty, double aspect_expand, int resizeeffect)
+{
 	adv_color_rgb rgb[256];
 	unsigned rgb_max;
 
-	adv_bitmap* bitmap = image_load(res_get(), rgb, &rgb_max, background);
+	adv_bitmap* bitmap = image_load(res, rgb, &rgb_max, background);
 	if (!bitmap)
-		return;
+		return 0;
 
 	// compute the size of the bitmap
 	unsigned dst_dx;
@@ -1692,18 +1740,29 @@ void backdrop_data::load(struct cell_pos_t* cell, const adv_color_rgb& backgroun
 
 	adv_bitmap_free(bitmap);
 
-	if (!scaled_bitmap)
-		return;
+	return scaled_bitmap;
+}
 
-	map = scaled_bitmap;
+void backdrop_data::load(const struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+{
+	if (done)
+		return; // already loaded
+
+	bitmap_set(decode(res_get(), cell, background, aspectx, aspecty, aspect_expand, resizeeffect));
 }
 
 // -------------------------------------------------------------------------
 // Backdrop Cache
 
+// Max memory used by the images in the cache
+#define BACKDROP_CACHE_SIZE (16 * 1024 * 1024)
+
 class backdrop_cache {
 	unsigned max;
+	unsigned size; ///< Memory used by the images in the cache.
 	list<backdrop_data*> bag;
+
+	static unsigned size_of(const backdrop_data* data);
 public:
 	backdrop_cache(unsigned Amax);
 	~backdrop_cache();
@@ -1711,11 +1770,20 @@ public:
 	void reduce();
 	void free(backdrop_data* data);
 	backdrop_data* alloc(const resource& res, unsigned dx, unsigned dy, unsigned aspectx, unsigned aspecty);
+	bool has(const resource& res, unsigned dx, unsigned dy) const;
 };
 
 backdrop_cache::backdrop_cache(unsigned Amax)
 {
 	max = Amax;
+	size = 0;
+}
+
+unsigned backdrop_cache::size_of(const backdrop_data* data)
+{
+	const adv_bitmap* map = data->bitmap_get();
+
+	return map->size_y * map->bytes_per_scanline;
 }
 
 backdrop_cache::~backdrop_cache()
@@ -1727,11 +1795,12 @@ backdrop_cache::~backdrop_cache()
 // Reduce the size of the cache
 void backdrop_cache::reduce()
 {
-	// limit the cache size
-	while (bag.size() > max) {
+	// limit the cache size, but keep at least the last image inserted
+	while (bag.size() > max || (bag.size() > 1 && size > BACKDROP_CACHE_SIZE)) {
 		list<backdrop_data*>::iterator i = bag.end();
 		--i;
 		backdrop_data* data = *i;
+		size -= size_of(data);
 		bag.erase(i);
 		delete data;
 	}
@@ -1744,6 +1813,7 @@ void backdrop_cache::free(backdrop_data* data)
 		if (data->is_active()) {
 			// insert the image in the cache
 			bag.insert(bag.begin(), data);
+			size += size_of(data);
 		} else {
 			delete data;
 		}
@@ -1763,6 +1833,7 @@ backdrop_data* backdrop_cache::alloc(const resource& res, unsigned dx, unsigned
 
 			// remove from the cache
 			bag.erase(i);
+			size -= size_of(data);
 
 			return data;
 		}
@@ -1771,6 +1842,257 @@ backdrop_data* backdrop_cache::alloc(const resource& res, unsigned dx, unsigned
 	return new backdrop_data(res, dx, dy, aspectx, aspecty);
 }
 
+bool backdrop_cache::has(const resource& res, unsigned dx, unsigned dy) const
+{
+	for (list<backdrop_data*>::const_iterator i = bag.begin(); i != bag.end(); ++i) {
+		if ((*i)->res_get() == res
+			&& dx == (*i)->target_dx_get()
+			&& dy == (*i)->target_dy_get())
+			return true;
+	}
+
+	return false;
+}
+
+// -------------------------------------------------------------------------
+// Backdrop Decoder
+
+#ifdef USE_SMP
+
+// Number of decoding threads
+#define BACKDROP_DECODER_THREAD 2
+
+enum backdrop_job_state {
+	job_wait, ///< In the queue.
+	job_run, ///< Decoding.
+	job_ready ///< Decoded, also if with an error.
+};
+
+// Request of decoding of a backdrop image
+struct backdrop_job {
+	resource res;
+	unsigned dx; ///< Size of the cell, with the resource is the key of the cache.
+	unsigned dy;
+	unsigned aspectx;
+	unsigned aspecty;
+	cell_pos_t pos; ///< Position of the cell, used to compute the size of the image.
+	adv_color_rgb background;
+	double aspect_expand;
+	int resizeeffect;
+	bool prefetch; ///< Requested for a game not yet visible.
+	backdrop_job_state state;
+	adv_bitmap* map; ///< Decoded image, 0 on error.
+};
+
+// Thread pool decoding and resizing the backdrop images.
+// The queue is ordered by priority, the images of the visible cells are
+// inserted at the front, the prefetched ones at the back.
+class backdrop_decoder {
+	list<backdrop_job*> bag;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_t thread_map[BACKDROP_DECODER_THREAD];
+	unsigned thread_mac;
+	bool stop;
+
+	static void* thread_entry(void* arg);
+	void thread_run();
+	list<backdrop_job*>::iterator find(const resource& res, unsigned dx, unsigned dy);
+
+public:
+	backdrop_decoder();
+	~backdrop_decoder();
+
+	bool is_active() const { return thread_mac != 0; }
+	bool request(const backdrop_job& req, adv_bitmap** map);
+	void prefetch(const backdrop_job& req);
+	void prefetch_clear();
+	backdrop_job* collect();
+};
+
+backdrop_decoder::backdrop_decoder()
+{
+	stop = false;
+	thread_mac = 0;
+
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+
+	while (thread_mac < BACKDROP_DECODER_THREAD) {
+		if (pthread_create(&thread_map[thread_mac], 0, thread_entry, this) != 0) {
+			log_std(("ERROR:text: pthread_create() failed\n"));
+			break;
+		}
+		++thread_mac;
+	}
+
+	log_std(("text: backdrop decoder with %d threads\n", thread_mac));
+}
+
+backdrop_decoder::~backdrop_decoder()
+{
+	pthread_mutex_lock(&mutex);
+	stop = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	for (unsigned i = 0; i < thread_mac; ++i)
+		pthread_join(thread_map[i], 0);
+
+	for (list<backdrop_job*>::iterator i = bag.begin(); i != bag.end(); ++i) {
+		if ((*i)->map)
+			adv_bitmap_free((*i)->map);
+		delete *i;
+	}
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+void* backdrop_decoder::thread_entry(void* arg)
+{
+	static_cast<backdrop_decoder*>(arg)->thread_run();
+	return 0;
+}
+
+void backdrop_decoder::thread_run()
+{
+	pthread_mutex_lock(&mutex);
+
+	while (!stop) {
+		backdrop_job* job = 0;
+
+		for (list<backdrop_job*>::iterator i = bag.begin(); i != bag.end(); ++i) {
+			if ((*i)->state == job_wait) {
+				job = *i;
+				break;
+			}
+		}
+
+		if (!job) {
+			pthread_cond_wait(&cond, &mutex);
+			continue;
+		}
+
+		// the job is not removed from the queue while running
+		job->state = job_run;
+
+		pthread_mutex_unlock(&mutex);
+
+		adv_bitmap* map = backdrop_data::decode(job->res, &job->pos, job->background, job->aspectx, job->aspecty, job->aspect_expand, job->resizeeffect);
+
+		pthread_mutex_lock(&mutex);
+
+		job->map = map;
+		job->state = job_ready;
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+// Search a job, called with the mutex locked
+list<backdrop_job*>::iterator backdrop_decoder::find(const resource& res, unsigned dx, unsigned dy)
+{
+	for (list<backdrop_job*>::iterator i = bag.begin(); i != bag.end(); ++i) {
+		if ((*i)->res == res && (*i)->dx == dx && (*i)->dy == dy)
+			return i;
+	}
+
+	return bag.end();
+}
+
+// Request the image of a visible cell.
+// Return true if the decoding is completed, and set the result in *map.
+bool backdrop_decoder::request(const backdrop_job& req, adv_bitmap** map)
+{
+	bool ready = false;
+
+	pthread_mutex_lock(&mutex);
+
+	list<backdrop_job*>::iterator i = find(req.res, req.dx, req.dy);
+	if (i == bag.end()) {
+		backdrop_job* job = new backdrop_job(req);
+		job->prefetch = false;
+		job->state = job_wait;
+		job->map = 0;
+		bag.insert(bag.begin(), job);
+		pthread_cond_signal(&cond);
+	} else if ((*i)->state == job_ready) {
+		backdrop_job* job = *i;
+		bag.erase(i);
+		*map = job->map;
+		delete job;
+		ready = true;
+	} else if ((*i)->state == job_wait) {
+		// a prefetch is now needed, move it at the front
+		backdrop_job* job = *i;
+		bag.erase(i);
+		job->prefetch = false;
+		bag.insert(bag.begin(), job);
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return ready;
+}
+
+// Request the image of a game that may be visible soon
+void backdrop_decoder::prefetch(const backdrop_job& req)
+{
+	pthread_mutex_lock(&mutex);
+
+	if (find(req.res, req.dx, req.dy) == bag.end()) {
+		backdrop_job* job = new backdrop_job(req);
+		job->prefetch = true;
+		job->state = job_wait;
+		job->map = 0;
+		bag.insert(bag.end(), job);
+		pthread_cond_signal(&cond);
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+// Remove the prefetches not yet started, they refer at the previous position of the cursor
+void backdrop_decoder::prefetch_clear()
+{
+	pthread_mutex_lock(&mutex);
+
+	list<backdrop_job*>::iterator i = bag.begin();
+	while (i != bag.end()) {
+		if ((*i)->prefetch && (*i)->state == job_wait) {
+			delete *i;
+			i = bag.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+// Extract one completed job, or 0 if none
+backdrop_job* backdrop_decoder::collect()
+{
+	backdrop_job* job = 0;
+
+	pthread_mutex_lock(&mutex);
+
+	for (list<backdrop_job*>::iterator i = bag.begin(); i != bag.end(); ++i) {
+		if ((*i)->state == job_ready) {
+			job = *i;
+			bag.erase(i);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return job;
+}
+
+#endif
+
 // -------------------------------------------------------------------------
 // Clip
 
@@ -2033,6 +2355,9 @@ struct cell_t {
 class cell_manager {
 	class backdrop_cache* int_backdrop_cache;
 	class clip_cache* int_clip_cache;
+#ifdef USE_SMP
+	class backdrop_decoder* int_decoder; ///< Background decoder, 0 if the images are decoded synchronously.
+#endif
 
 	unsigned backdrop_mac;
 
@@ -2058,6 +2383,11 @@ class cell_manager {
 
 	unsigned idle_iterator;
 
+#ifdef USE_SMP
+	void backdrop_job_init(backdrop_job& job, int index, const resource& res, unsigned aspectx, unsigned aspecty);
+	void backdrop_collect();
+#endif
+
 public:
 	cell_manager(const int_color& Abackdrop_missing_color, const int_color& Abackdrop_box_color, unsigned Amac, unsigned Ainc, unsigned outline, unsigned cursor, double expand_factor, bool Amulticlip, int Aresizeeffect);
 	~cell_manager();
@@ -2073,6 +2403,8 @@ public:
 	void backdrop_box();
 	bool is_box_flashing();
 	void backdrop_redraw_all();
+	void backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty);
+	void backdrop_prefetch_clear();
 
 	void clip_set(int index, const resource& res, unsigned aspectx, unsigned aspecty, bool restart);
 	void clip_clear(int index);
@@ -2117,10 +2449,28 @@ cell_manager::cell_manager(const int_color& Abackdrop_missing_color, const int_c
 	}
 
 	idle_iterator = 0;
+
+#ifdef USE_SMP
+	// if requested, wait the backdrops decoding them in the main thread
+	int_decoder = 0;
+	if (!int_wait_for_backdrop) {
+		int_decoder = new backdrop_decoder();
+		if (!int_decoder->is_active()) {
+			delete int_decoder;
+			int_decoder = 0;
+		}
+	}
+#endif
 }
 
 cell_manager::~cell_manager()
 {
+#ifdef USE_SMP
+	// stop the threads before freeing anything
+	delete int_decoder;
+	int_decoder = 0;
+#endif
+
 	for (int i = 0; i < backdrop_mac; ++i) {
 		if (backdrop_map[i].data)
 			delete backdrop_map[i].data;
@@ -2265,9 +2615,24 @@ void cell_manager::backdrop_update(int index)
 
 	assert(index >= 0 && index < backdrop_mac);
 
-	if (back->data) {
+	if (back->data && !back->data->is_done()) {
+#ifdef USE_SMP
+		if (int_decoder) {
+			backdrop_job job;
+			adv_bitmap* map;
+
+			backdrop_job_init(job, index, back->data->res_get(), back->data->aspectx_get(), back->data->aspecty_get());
+
+			// if not ready, the placeholder is drawn and the image is set later by backdrop_collect()
+			if (int_decoder->request(job, &map))
+				back->data->bitmap_set(map);
+		} else if (!fast_exit_handler()) {
+			back->data->load(&back->pos, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect);
+		}
+#else
 		if (!fast_exit_handler())
 			back->data->load(&back->pos, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect);
+#endif
 	}
 
 	if (back->redraw) {
@@ -2289,6 +2654,100 @@ void cell_manager::backdrop_update(int index)
 	}
 }
 
+#ifdef USE_SMP
+void cell_manager::backdrop_job_init(backdrop_job& job, int index, const resource& res, unsigned aspectx, unsigned aspecty)
+{
+	struct cell_t* back = backdrop_map + index;
+
+	job.res = res;
+	job.dx = back->pos.dx;
+	job.dy = back->pos.dy;
+	job.aspectx = aspectx;
+	job.aspecty = aspecty;
+	job.pos = back->pos;
+	job.background = backdrop_missing_color.background;
+	job.aspect_expand = backdrop_expand_factor;
+	job.resizeeffect = resizeeffect;
+}
+
+// Move the images decoded in background to the cells waiting for them, or to the cache
+void cell_manager::backdrop_collect()
+{
+	backdrop_job* job;
+
+	while ((job = int_decoder->collect()) != 0) {
+		bool taken = false;
+
+		for (unsigned i = 0; i < backdrop_mac && !taken; ++i) {
+			struct cell_t* back = backdrop_map + i;
+
+			if (back->data
+				&& !back->data->is_done()
+				&& back->data->res_get() == job->res
+				&& back->data->target_dx_get() == job->dx
+				&& back->data->target_dy_get() == job->dy) {
+				back->data->bitmap_set(job->map);
+				taken = true;
+
+				// draw it now, unless a clip is playing over it
+				if (back->redraw && !(back->cdata && back->cdata->is_active())) {
+					backdrop_update(i);
+					back->pos.redraw();
+				}
+			}
+		}
+
+		if (!taken && job->map) {
+			backdrop_data* data = new backdrop_data(job->res, job->dx, job->dy, job->aspectx, job->aspecty);
+			data->bitmap_set(job->map);
+			int_backdrop_cache->free(data);
+		}
+
+		delete job;
+	}
+
+	int_backdrop_cache->reduce();
+}
+#endif
+
+// Decode in background an image that may be shown soon in the cell
+void cell_manager::backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty)
+{
+	assert(index >= 0 && static_cast<unsigned>(index) < backdrop_mac);
+
+#ifdef USE_SMP
+	if (!int_decoder)
+		return;
+
+	struct cell_t* back = backdrop_map + index;
+
+	if (int_backdrop_cache->has(res, back->pos.dx, back->pos.dy))
+		return;
+
+	for (unsigned i = 0; i < backdrop_mac; ++i) {
+		if (backdrop_map[i].data
+			&& backdrop_map[i].data->res_get() == res
+			&& backdrop_map[i].data->target_dx_get() == static_cast<unsigned>(back->pos.dx)
+			&& backdrop_map[i].data->target_dy_get() == static_cast<unsigned>(back->pos.dy))
+			return;
+	}
+
+	backdrop_job job;
+
+	backdrop_job_init(job, index, res, aspectx, aspecty);
+
+	int_decoder->prefetch(job);
+#endif
+}
+
+void cell_manager::backdrop_prefetch_clear()
+{
+#ifdef USE_SMP
+	if (int_decoder)
+		int_decoder->prefetch_clear();
+#endif
+}
+
 void cell_manager::reduce()
 {
 	if (int_backdrop_cache)
@@ -2339,6 +2798,11 @@ bool cell_manager::idle()
 {
 	bool late = false;
 
+#ifdef USE_SMP
+	if (int_decoder)
+		backdrop_collect();
+#endif
+
 	if (multiclip) {
 		int highlight_index = -1;
 
@@ -2500,6 +2964,16 @@ void int_backdrop_clear(int index, bool highlight)
 	int_cell->backdrop_clear(index, highlight);
 }
 
+void int_backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty)
+{
+	int_cell->backdrop_prefetch(index, res, aspectx, aspecty);
+}
+
+void int_backdrop_prefetch_clear()
+{
+	int_cell->backdrop_prefetch_clear();
+}
+
 void int_clip_set(int index, const resource& res, unsigned aspectx, unsigned aspecty, bool restart)
 {
 	int_cell->clip_set(index, res, aspectx, aspecty, restart);
@@ -2927,6 +3401,7 @@ void int_image_buffer(adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned rgb_m
 {
 	struct video_pipeline_struct pipeline;
 	unsigned combine = VIDEO_COMBINE_X_MEAN | VIDEO_COMBINE_Y_MEAN;
+	blit_lock lock;
 
 	video_pipeline_init(&pipeline);
 
@@ -2963,6 +3438,7 @@ void int_image_direct(adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned rgb_m
 {
 	struct video_pipeline_struct pipeline;
 	unsigned combine = VIDEO_COMBINE_X_MEAN | VIDEO_COMBINE_Y_MEAN;
+	blit_lock lock;
 
 	video_pipeline_init(&pipeline);
 
@@ -96,6 +96,8 @@ void int_backdrop_pos(int index, int x, int y, int dx, int dy);
 void int_backdrop_set(int index, const resource& res, bool highlight, unsigned aspectx, unsigned aspecty);
 void int_backdrop_clear(int index, bool highlight);
 void int_backdrop_redraw_all();
+void int_backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty);
+void int_backdrop_prefetch_clear();
 
 bool int_clip(const std::string& file, bool loop);
 void int_clip_set(int index, const resource& res, unsigned aspectx, unsigned aspecty, bool restart);
@@ -44,6 +44,9 @@
 #include <sys/time.h>
 #include <stdint.h>
 #include <errno.h>
+#ifdef USE_SMP
+#include <pthread.h>
+#endif
 
 #include "portable.h"
 #include "advance.h"
@@ -72,9 +75,13 @@
 #define DVG_RES_MAX              4095
 
 #define SAVE_TO_FILE             0
-#define SORT_VECTORS             0
 #define MAX_VECTORS              0x10000
 
+// Spatial index used to sort the vectors, 64x64 cells of 64x64 points
+#define GRID_SHIFT               6
+#define GRID_CELL                (1 << GRID_SHIFT)
+#define GRID_SIZE                ((DVG_RES_MAX + 1) >> GRID_SHIFT)
+
 // Defining region codes 
 #define LEFT                     0x1
 #define RIGHT                    0x2
@@ -86,7 +93,6 @@
 #define GAME_WARRIOR             2
 
 typedef struct vec_t {
-    struct vec_t *next;
     int32_t       x0;
     int32_t       y0;
     int32_t       x1;
@@ -136,6 +142,32 @@ static uint32_t  s_out_vec_cnt;
 static char      s_json_buf[512];
 static int       s_json_length;
 static uint32_t  s_vertical_display;
+static uint32_t  s_sort_vectors;
+static uint32_t  *s_grid_start;
+static uint32_t  *s_grid_end;
+static uint32_t  *s_grid_entry;
+static uint8_t   *s_vec_used;
+static uint8_t   *s_cmd_buf_map[2];
+static uint32_t  s_cmd_buf_index;
+#ifdef USE_SMP
+// Writer thread of the serial stream.  A command buffer is written while
+// the next one is filled.
+static pthread_t       s_writer_id;
+static pthread_mutex_t s_writer_mutex;
+static pthread_cond_t  s_writer_cond;
+static uint32_t        s_writer_active;
+static uint32_t        s_writer_stop;
+static uint8_t         *s_writer_buf;
+static uint32_t        s_writer_size;
+static int             s_writer_result;
+#endif
+// Statistics
+static uint32_t        s_stat_frame;
+static uint64_t        s_stat_vec;
+static uint32_t        s_stat_vec_max;
+static target_clock_t  s_stat_sort_time;
+static target_clock_t  s_stat_write_time;
+static target_clock_t  s_stat_wait_time;
 
 
 static game_info_t s_games[] = {
@@ -281,51 +313,148 @@ uint32_t line_clip(int32_t *pX1, int32_t *pY1, int32_t *pX2, int32_t *pY2)
 }  
 
 
+//
+// Return the grid cell of a coordinate.
+//
+static int32_t grid_coord(int32_t v)
+{
+    v >>= GRID_SHIFT;
+    if (v < 0) {
+        v = 0;
+    }
+    else if (v >= GRID_SIZE) {
+        v = GRID_SIZE - 1;
+    }
+    return v;
+}
+
+//
+// Insert both the end points of all the input vectors in the grid.
+// Every entry is the vector index shifted by one, with the lower bit
+// set for the second end point.
+//
+static void grid_build()
+{
+    uint32_t i, c, c0, c1;
+
+    memset(s_grid_start, 0, (GRID_SIZE * GRID_SIZE + 1) * sizeof(uint32_t));
+    for (i = 0; i < s_in_vec_cnt; i++) {
+        c0 = grid_coord(s_in_vec_list[i].y0) * GRID_SIZE + grid_coord(s_in_vec_list[i].x0);
+        c1 = grid_coord(s_in_vec_list[i].y1) * GRID_SIZE + grid_coord(s_in_vec_list[i].x1);
+        s_grid_start[c0 + 1]++;
+        s_grid_start[c1 + 1]++;
+    }
+    for (c = 0; c < GRID_SIZE * GRID_SIZE; c++) {
+        s_grid_start[c + 1] += s_grid_start[c];
+    }
+    // Use the end of the cells as insertion point
+    memcpy(s_grid_end, s_grid_start, GRID_SIZE * GRID_SIZE * sizeof(uint32_t));
+    for (i = 0; i < s_in_vec_cnt; i++) {
+        c0 = grid_coord(s_in_vec_list[i].y0) * GRID_SIZE + grid_coord(s_in_vec_list[i].x0);
+        c1 = grid_coord(s_in_vec_list[i].y1) * GRID_SIZE + grid_coord(s_in_vec_list[i].x1);
+        s_grid_entry[s_grid_end[c0]++] = i << 1;
+        s_grid_entry[s_grid_end[c1]++] = (i << 1) | 1;
+    }
+    memset(s_vec_used, 0, s_in_vec_cnt);
+}
+
+//
+// Search the nearest end point in a grid cell.  The entries of the
+// vectors already used are removed from the cell.
+//
+static void grid_scan(uint32_t c, int32_t x, int32_t y, int32_t *best, int64_t *best_d2)
+{
+    uint32_t *e = s_grid_entry + s_grid_start[c];
+    uint32_t  n = s_grid_end[c] - s_grid_start[c];
+    uint32_t  i = 0;
+    uint32_t  k;
+    int64_t   dx, dy, d2;
+    vector_t *v;
+
+    while (i < n) {
+        k = e[i];
+        if (s_vec_used[k >> 1]) {
+            e[i] = e[--n];
+            continue;
+        }
+        v = &s_in_vec_list[k >> 1];
+        dx = ((k & 1) ? v->x1 : v->x0) - x;
+        dy = ((k & 1) ? v->y1 : v->y0) - y;
+        d2 = dx * dx + dy * dy;
+        // On equal distance prefer the first vector, and its first end point
+        if (d2 < *best_d2 || (d2 == *best_d2 && (int32_t)k < *best)) {
+            *best = k;
+            *best_d2 = d2;
+        }
+        i++;
+    }
+    s_grid_end[c] = s_grid_start[c] + n;
+}
+
+//
+// Search the nearest end point of the unused vectors.  The cells are
+// visited in growing rings around the point, and the search stops when
+// the next ring cannot contain a nearer end point.
+//
+static int32_t grid_nearest(int32_t x, int32_t y)
+{
+    int32_t cx, cy, gx, gy, r, step;
+    int32_t best = -1;
+    int64_t best_d2 = INT64_MAX;
+    int64_t bound;
+
+    cx = grid_coord(x);
+    cy = grid_coord(y);
+    for (r = 0; r < GRID_SIZE; r++) {
+        if (best >= 0 && r > 0) {
+            bound = (int64_t)(r - 1) * GRID_CELL;
+            if (best_d2 <= bound * bound) {
+                break;
+            }
+        }
+        for (gy = cy - r; gy <= cy + r; gy++) {
+            if (gy < 0 || gy >= GRID_SIZE) {
+                continue;
+            }
+            // Whole rows at the top and bottom of the ring, only the two sides otherwise
+            step = (r == 0 || gy == cy - r || gy == cy + r) ? 1 : 2 * r;
+            for (gx = cx - r; gx <= cx + r; gx += step) {
+                if (gx < 0 || gx >= GRID_SIZE) {
+                    continue;
+                }
+                grid_scan(gy * GRID_SIZE + gx, x, y, &best, &best_d2);
+            }
+        }
+    }
+    return best;
+}
+
 //
 // Sort, optimize and add vectors (and blank vectors) to the output vector list.
+// Every vector is the one with the nearest end point to the end of the
+// previous one, searched with the grid index.
 // 
 void sort_and_reconnect_vectors()
 {
-    int32_t  dmin;
     uint32_t reverse;
     int32_t  last_x = -1;
     int32_t  last_y = -1;
-    int32_t  x0, y0, x1, y1, dx0, dy0, dx1, dy1, d0, d1;
-    vector_t **min_v, *head, *s;
+    int32_t  x0, y0, x1, y1, k;
+    uint32_t i;
+    vector_t *s;
 
-    head = &s_in_vec_list[0];
     s_out_vec_cnt = 0;
 
-    while (head) {
-        min_v = &head;
-        reverse = 0;
-        dmin = INT32_MAX;
-	vector_t **v;
-        for (v = min_v; *v; v = &(*v)->next) {
-            dx0 = (*v)->x0 - last_x;
-            dy0 = (*v)->y0 - last_y;
-            dx1 = (*v)->x1 - last_x;
-            dy1 = (*v)->y1 - last_y;
-            d0 = (int32_t)sqrt((dx0 * dx0) + (dy0 * dy0));
-            d1 = (int32_t)sqrt((dx1 * dx1) + (dy1 * dy1));
-            if (d0 < dmin) {
-                min_v = v;
-                dmin = d0;
-                reverse = 0;
-            }
-            if (d1 < dmin) {
-                min_v = v;
-                dmin = d1;
-                reverse = 1;
-            }
-            if (dmin == 0) {
-                break;
-            }
-        }
-        s = *min_v;
-        if (!s) {
+    grid_build();
+
+    for (i = 0; i < s_in_vec_cnt; i++) {
+        k = grid_nearest(last_x, last_y);
+        if (k < 0) {
             break;
         }
+        s = &s_in_vec_list[k >> 1];
+        reverse = k & 1;
+        s_vec_used[k >> 1] = 1;
 
         x0 = reverse ? s->x1 : s->x0;
         y0 = reverse ? s->y1 : s->y0;
@@ -353,7 +482,6 @@ void sort_and_reconnect_vectors()
         s_out_vec_cnt++;
         last_x = x1;
         last_y = y1;
-        *min_v = s->next;
     }
 }
 
@@ -463,9 +591,6 @@ static void cmd_add_vec(int x, int y, int r, int g, int b)
         if (s_in_vec_cnt < MAX_VECTORS) {
             add = line_clip(&x0, &y0, &x1, &y1);
             if (add) {
-                if (s_in_vec_cnt) {
-                    s_in_vec_list[s_in_vec_cnt - 1].next = &s_in_vec_list[s_in_vec_cnt];
-                }
                 s_in_vec_list[s_in_vec_cnt].x0 = x0;
                 s_in_vec_list[s_in_vec_cnt].y0 = y0;
                 s_in_vec_list[s_in_vec_cnt].x1 = x1;
@@ -641,6 +766,141 @@ END:
    return result;
 }
 
+#ifdef USE_SMP
+//
+// Writer thread.  Write the command buffers posted by serial_post().
+//
+static void* serial_writer(void *arg)
+{
+    uint8_t        *buf;
+    uint32_t       size;
+    int            result;
+    target_clock_t start;
+
+    pthread_mutex_lock(&s_writer_mutex);
+    while (1) {
+        while (!s_writer_buf && !s_writer_stop) {
+            pthread_cond_wait(&s_writer_cond, &s_writer_mutex);
+        }
+        if (!s_writer_buf) {
+            break;
+        }
+        buf  = s_writer_buf;
+        size = s_writer_size;
+        pthread_mutex_unlock(&s_writer_mutex);
+
+        start  = target_clock();
+        result = serial_write(buf, size);
+
+        pthread_mutex_lock(&s_writer_mutex);
+        s_stat_write_time += target_clock() - start;
+        s_writer_result = result;
+        s_writer_buf = 0;
+        pthread_cond_broadcast(&s_writer_cond);
+    }
+    pthread_mutex_unlock(&s_writer_mutex);
+    return 0;
+}
+
+//
+// Wait until the writer thread has written the last posted buffer.
+// Return the result of the write.
+//
+static int serial_flush()
+{
+    int result = 0;
+    if (s_writer_active) {
+        pthread_mutex_lock(&s_writer_mutex);
+        while (s_writer_buf) {
+            pthread_cond_wait(&s_writer_cond, &s_writer_mutex);
+        }
+        result = s_writer_result;
+        pthread_mutex_unlock(&s_writer_mutex);
+    }
+    return result;
+}
+
+static void serial_writer_start()
+{
+    s_writer_stop   = 0;
+    s_writer_buf    = 0;
+    s_writer_result = 0;
+    if (pthread_mutex_init(&s_writer_mutex, NULL) != 0) {
+        log_std(("ERROR:dvg: error calling pthread_mutex_init()\n"));
+        return;
+    }
+    if (pthread_cond_init(&s_writer_cond, NULL) != 0) {
+        log_std(("ERROR:dvg: error calling pthread_cond_init()\n"));
+        pthread_mutex_destroy(&s_writer_mutex);
+        return;
+    }
+    if (pthread_create(&s_writer_id, NULL, serial_writer, NULL) != 0) {
+        log_std(("ERROR:dvg: error calling pthread_create()\n"));
+        pthread_cond_destroy(&s_writer_cond);
+        pthread_mutex_destroy(&s_writer_mutex);
+        return;
+    }
+    s_writer_active = 1;
+}
+
+static void serial_writer_stop()
+{
+    if (!s_writer_active) {
+        return;
+    }
+    pthread_mutex_lock(&s_writer_mutex);
+    s_writer_stop = 1;
+    pthread_cond_broadcast(&s_writer_cond);
+    pthread_mutex_unlock(&s_writer_mutex);
+    pthread_join(s_writer_id, NULL);
+    pthread_cond_destroy(&s_writer_cond);
+    pthread_mutex_destroy(&s_writer_mutex);
+    s_writer_active = 0;
+}
+#else
+static int serial_flush()
+{
+    return 0;
+}
+#endif
+
+//
+// Send a command buffer.  With the writer thread the buffer is only
+// queued, and the filling continues on the other command buffer.  If the
+// previous buffer is still being written, wait for it.
+//
+static int serial_post(uint8_t *buf, uint32_t size)
+{
+    int            result;
+    target_clock_t start;
+
+#ifdef USE_SMP
+    if (s_writer_active) {
+        start = target_clock();
+        pthread_mutex_lock(&s_writer_mutex);
+        while (s_writer_buf) {
+            pthread_cond_wait(&s_writer_cond, &s_writer_mutex);
+        }
+        // Report the errors of the previous buffer
+        result = s_writer_result < 0 ? s_writer_result : (int)size;
+        s_writer_buf  = buf;
+        s_writer_size = size;
+        pthread_cond_broadcast(&s_writer_cond);
+        pthread_mutex_unlock(&s_writer_mutex);
+        s_stat_wait_time += target_clock() - start;
+
+        s_cmd_buf_index ^= 1;
+        s_cmd_buf = s_cmd_buf_map[s_cmd_buf_index];
+        return result;
+    }
+#endif
+
+    start  = target_clock();
+    result = serial_write(buf, size);
+    s_stat_write_time += target_clock() - start;
+    return result;
+}
+
 //
 // Close the serial port.
 //
@@ -652,6 +912,11 @@ static int serial_close()
         log_std(("dvg: device already closed.\n"));                
         goto END;
     }
+    // Complete the pending writes
+    serial_flush();
+#ifdef USE_SMP
+    serial_writer_stop();
+#endif
     // Be gentle and indicate to USB-DVG that it is game over!
     cmd = (FLAG_EXIT << 29); 
     s_cmd_offs = 0;
@@ -679,19 +944,30 @@ static int serial_send()
 {
     int      result = -1;
     uint32_t cmd;
+    target_clock_t start, sort_time;
 
     if (s_serial_fd < 0) {
         log_std(("dvg: device not opened.\n"));            
         goto END;
     }
 
-    #if SORT_VECTORS
+    start = target_clock();
+    if (s_sort_vectors) {
         // USB-DVG has difficulties rendering sorted vectors.  The screen (especially text) wobbles.
         // I have yet to know why it does that.  Otherwise the algorithm works fine.
         sort_and_reconnect_vectors();
-    #else
+    }
+    else {
         reconnect_vectors();
-    #endif
+    }
+    sort_time = target_clock() - start;
+    s_stat_sort_time += sort_time;
+    s_stat_frame++;
+    s_stat_vec += s_out_vec_cnt;
+    if (s_out_vec_cnt > s_stat_vec_max) {
+        s_stat_vec_max = s_out_vec_cnt;
+    }
+    log_debug(("dvg: frame %u, %u vectors, sort %d [us]\n", s_stat_frame, s_out_vec_cnt, (int)(sort_time * 1000000 / TARGET_CLOCKS_PER_SEC)));
 
     uint32_t i;
     for (i = 0 ; i < s_out_vec_cnt ; i++) {
@@ -706,7 +982,7 @@ static int serial_send()
     s_cmd_buf[s_cmd_offs++] = cmd >>  8;
     s_cmd_buf[s_cmd_offs++] = cmd >>  0;     
 
-    result  = serial_write(s_cmd_buf, s_cmd_offs);
+    result  = serial_post(s_cmd_buf, s_cmd_offs);
 END:
     cmd_reset(0);
     return result;
@@ -1111,6 +1387,7 @@ static void get_dvg_info()
     cmd_buf[1] = cmd >> 16;
     cmd_buf[2] = cmd >> 8;
     cmd_buf[3] = cmd >> 0;
+    serial_flush();
     serial_write(cmd_buf, 4);
     result = serial_read(&cmd, sizeof(cmd));
     if (result < 0) goto END;
@@ -1171,16 +1448,28 @@ END:
 //
 // Init function
 //
-int dvg_init(const char *dvg_port, int dual_display)
+int dvg_init(const char *dvg_port, int dual_display, int sort_vectors)
 {
-    s_init = 1;
     s_dual_display = dual_display;
-    s_cmd_buf = (uint8_t *)malloc(CMD_BUF_SIZE * sizeof(uint8_t));
-    s_in_vec_list = (vector_t *)malloc(MAX_VECTORS * sizeof(vector_t));
-    s_out_vec_list = (vector_t *)malloc(MAX_VECTORS * sizeof(vector_t));
+    s_sort_vectors = sort_vectors;
+    if (!s_init) {
+        s_init = 1;
+        s_cmd_buf_map[0] = (uint8_t *)malloc(CMD_BUF_SIZE * sizeof(uint8_t));
+        s_cmd_buf_map[1] = (uint8_t *)malloc(CMD_BUF_SIZE * sizeof(uint8_t));
+        s_cmd_buf_index = 0;
+        s_cmd_buf = s_cmd_buf_map[0];
+        s_in_vec_list = (vector_t *)malloc(MAX_VECTORS * sizeof(vector_t));
+        // Every vector may need a blank vector before it
+        s_out_vec_list = (vector_t *)malloc(2 * MAX_VECTORS * sizeof(vector_t));
+        s_grid_start = (uint32_t *)malloc((GRID_SIZE * GRID_SIZE + 1) * sizeof(uint32_t));
+        s_grid_end = (uint32_t *)malloc(GRID_SIZE * GRID_SIZE * sizeof(uint32_t));
+        s_grid_entry = (uint32_t *)malloc(2 * MAX_VECTORS * sizeof(uint32_t));
+        s_vec_used = (uint8_t *)malloc(MAX_VECTORS * sizeof(uint8_t));
+    }
     strncpy(s_serial_dev, dvg_port, sizeof(s_serial_dev) - 1);
     s_serial_dev[sizeof(s_serial_dev) - 1] = 0;
     log_std(("dvg: port is %s\n", s_serial_dev));
+    log_std(("dvg: vector sort is %s\n", s_sort_vectors ? "on" : "off"));
     return 0;
 }
 
@@ -1192,7 +1481,17 @@ int dvg_open()
     if (s_init) {
         log_std(("dvg: dvg_open()\n"));    
         s_first_call = 1;
-        serial_open();
+        s_stat_frame = 0;
+        s_stat_vec = 0;
+        s_stat_vec_max = 0;
+        s_stat_sort_time = 0;
+        s_stat_write_time = 0;
+        s_stat_wait_time = 0;
+        if (serial_open() == 0) {
+#ifdef USE_SMP
+            serial_writer_start();
+#endif
+        }
         vector_register_aux_renderer(dvg_update);
     }
     return 0;
@@ -1206,6 +1505,13 @@ void dvg_close()
     if (s_init) {
         log_std(("dvg: dvg_close()\n"));        
         serial_close();   
+        if (s_stat_frame) {
+            log_std(("dvg: %u frames, %g vectors/frame, max %u vectors\n", s_stat_frame, (double)s_stat_vec / s_stat_frame, s_stat_vec_max));
+            log_std(("dvg: sort %g, write %g, wait %g [ms/frame]\n",
+                s_stat_sort_time * 1000.0 / TARGET_CLOCKS_PER_SEC / s_stat_frame,
+                s_stat_write_time * 1000.0 / TARGET_CLOCKS_PER_SEC / s_stat_frame,
+                s_stat_wait_time * 1000.0 / TARGET_CLOCKS_PER_SEC / s_stat_frame));
+        }
     } 
 }
 #endif
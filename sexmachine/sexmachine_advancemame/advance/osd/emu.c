@@ -40,6 +40,11 @@
 
 #include "advance.h"
 
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
 struct advance_context CONTEXT;
 
 /***************************************************************************/
@@ -63,46 +68,48 @@ void os_signal(int signum, void* info, void* context)
 /***************************************************************************/
 /* Select */
 
-struct game_fuzzy {
-	unsigned index;
-	unsigned fuzzy;
-};
+/**
+ * Index of the game names, built at the first use.
+ */
+static adv_fuzzy* game_index;
 
-static int game_fuzzy_cmp(const void* a, const void* b)
+static adv_fuzzy* game_index_get(void)
 {
-	const struct game_fuzzy* A = (const struct game_fuzzy*)a;
-	const struct game_fuzzy* B = (const struct game_fuzzy*)b;
-	if (A->fuzzy < B->fuzzy)
-		return -1;
-	if (A->fuzzy > B->fuzzy)
-		return 1;
-	return 0;
+	unsigned i;
+
+	if (!game_index) {
+		game_index = fuzzy_alloc();
+		for (i = 0; mame_game_at(i); ++i)
+			fuzzy_insert(game_index, mame_game_name(mame_game_at(i)), mame_game_description(mame_game_at(i)));
+	}
+
+	return game_index;
 }
 
+#define SELECT_SIMILAR_MAX 15
+
 static const mame_game* select_game(const char* gamename)
 {
-	int game_count = 0;
-	struct game_fuzzy* game_map;
+	adv_fuzzy_match game_map[SELECT_SIMILAR_MAX + 1];
+	unsigned game_mac;
 	unsigned i;
+	int index;
 	int limit;
 	unsigned print_count;
 
-	for (i = 0; mame_game_at(i); ++i) {
-		if (strcmp(gamename, mame_game_name(mame_game_at(i))) == 0) {
-			if(sexmachine_debug) printf("[SEXMACHINE] Selecting game %s...\n", gamename);
-			sprintf(game_name, "%s", gamename);
-			sexmachine_minmax();
-			if(game_max_x == 0){
-				if(sexmachine_debug) printf("[SEXMACHINE] Error, %s is not a lightgun game...\n", game_name);
-				exit(1);
-			}
-			return mame_game_at(i);
+	index = fuzzy_find(game_index_get(), gamename);
+	if (index >= 0) {
+		if(sexmachine_debug) printf("[SEXMACHINE] Selecting game %s...\n", gamename);
+		sprintf(game_name, "%s", gamename);
+		sexmachine_minmax();
+		if(game_max_x == 0){
+			if(sexmachine_debug) printf("[SEXMACHINE] Error, %s is not a lightgun game...\n", game_name);
+			target_err("Game \"%s\" isn't a lightgun game.\n", gamename);
+			return 0;
 		}
-		++game_count;
+		return mame_game_at(index);
 	}
 
-	game_map = malloc(game_count * sizeof(struct game_fuzzy));
-
 	target_err("Game \"%s\" isn't supported.\n", gamename);
 
 	limit = (strlen(gamename) / 3) * FUZZY_UNIT_A;
@@ -111,42 +118,29 @@ static const mame_game* select_game(const char* gamename)
 	if (limit > 7 * FUZZY_UNIT_A)
 		limit = 7 * FUZZY_UNIT_A;
 
-	for (i = 0; i < game_count; ++i) {
-		const mame_game* game = mame_game_at(i);
-		int fuzzy_short = fuzzy(gamename, mame_game_name(game), limit);
-		int fuzzy_long = fuzzy(gamename, mame_game_description(game), limit);
-		int fuzzy = fuzzy_short < fuzzy_long ? fuzzy_short : fuzzy_long;
-
-		if (limit > fuzzy + 3 * FUZZY_UNIT_A)
-			limit = fuzzy + 3 * FUZZY_UNIT_A; /* limit the error range */
-
-		game_map[i].index = i;
-		game_map[i].fuzzy = fuzzy;
-	}
-
-	qsort(game_map, game_count, sizeof(struct game_fuzzy), game_fuzzy_cmp);
+	/* one more to detect a too long list */
+	game_mac = fuzzy_search(game_index_get(), gamename, limit, game_map, SELECT_SIMILAR_MAX + 1);
 
 	print_count = 0;
-	while (print_count < game_count && game_map[print_count].fuzzy < limit) {
+	while (print_count < game_mac) {
 		unsigned k;
 		k = print_count;
-		while (k < game_count && game_map[print_count].fuzzy == game_map[k].fuzzy)
+		while (k < game_mac && game_map[print_count].value == game_map[k].value)
 			++k;
-		if (k >= 15) {
+		if (k >= SELECT_SIMILAR_MAX) {
 			break;
 		}
 		print_count = k;
 	}
 
-	if (print_count > 0 && print_count < 15) {
+	if (print_count > 0 && print_count < SELECT_SIMILAR_MAX) {
 		target_err("\nSimilar names are:\n");
-		for (i = 0; i < print_count && i < game_count; ++i) {
+		for (i = 0; i < print_count; ++i) {
 			const mame_game* game = mame_game_at(game_map[i].index);
 			target_err("%10s %s\n", mame_game_name(game), mame_game_description(game));
 		}
 	}
 
-	free(game_map);
 	return 0;
 }
 
@@ -242,6 +236,9 @@ static void help(void)
 	target_out("%slistbare       output the rom XML file removing info not required by\n                 frontends\n", slash);
 	target_out("%srecord FILE    record an .inp file\n", slash);
 	target_out("%splayback FILE  play an .inp file\n", slash);
+#if HAVE_SYS_SOCKET_H
+	target_out("%sserver SOCKET  stay resident and run the games requested on SOCKET\n", slash);
+#endif
 	target_out("%sversion        print the version\n", slash);
 	target_out("\n");
 #ifdef MESS
@@ -625,6 +622,15 @@ int osd_has_save_config(void)
 
 // [SEXMACHINE] Custom Game Configurations
 void sexmachine_minmax(){
+		// Reset the values of the previous game in server mode
+		game_min_x = 0;
+		game_max_x = 0;
+		game_min_y = 0;
+		game_max_y = 0;
+		tune_x = 0;
+		tune_y = 0;
+		game_runahead = 0;
+
 		if (strstr(game_name, "alien3") != NULL) {
 			game_min_x = 0;
 			game_max_x = 255;
@@ -717,6 +723,7 @@ void sexmachine_minmax(){
 			game_min_y = 0;
 			game_max_y = 255;
 			tune_y = -15;
+			game_runahead = 1;
 		} else if (strstr(game_name, "eggventr") != NULL) {
 			game_min_x = 0;
 			game_max_x = 255;
@@ -777,6 +784,7 @@ void sexmachine_minmax(){
 			game_max_x = 255;
 			game_min_y = 0;
 			game_max_y = 255;
+			game_runahead = 1;
 		} else if (strstr(game_name, "jpark") != NULL) {
 			game_min_x = 0;
 			game_max_x = 255;
@@ -959,11 +967,13 @@ void sexmachine_minmax(){
 			game_max_x = 255;
 			game_min_y = 0;
 			game_max_y = 255;
+			game_runahead = 1;
 		} else if (strstr(game_name, "vsgshoe") != NULL) {
 			game_min_x = 0;
 			game_max_x = 255;
 			game_min_y = 0;
 			game_max_y = 255;
+			game_runahead = 1;
 		} else if (strstr(game_name, "whodunit") != NULL) {
 			game_min_x = 0;
 			game_max_x = 255;
@@ -994,6 +1004,449 @@ void sexmachine_minmax(){
 }
 // [SEXMACHINE] Custom Game Configurations END
 
+/***************************************************************************/
+/* Game */
+
+/**
+ * Load the configuration of the selected game.
+ * The configuration sections are set for the game in option->game,
+ * and all the options are loaded in the contexts.
+ */
+static adv_error game_config_load(struct advance_context* context, struct mame_option* option)
+{
+	const char* section_map[32];
+	unsigned section_mac;
+	const mame_game* parent;
+	char buffer[128];
+	const char* control;
+	unsigned i;
+
+	/* set the used section */
+	section_mac = 0;
+	parent = option->game;
+	while (parent && section_mac < 8) {
+		const char* s;
+		s = mame_software_name(parent, context->cfg);
+		if (s && s[0]) {
+			section_map[section_mac++] = strdup(s);
+		}
+		parent = mame_game_parent(parent);
+	}
+	parent = option->game;
+	while (parent && section_mac < 8) {
+		const char* s;
+		s = mame_game_name(parent);
+		if (s && s[0]) {
+			section_map[section_mac++] = strdup(s);
+		}
+		parent = mame_game_parent(parent);
+	}
+	section_map[section_mac++] = strdup(mame_game_resolutionclock(option->game));
+	section_map[section_mac++] = strdup(mame_game_resolution(option->game));
+
+	// [SEXMACHINE]
+	char tmp[100];
+	sprintf(tmp, "%s", strdup(mame_game_resolution(option->game)));
+	sscanf(tmp, "%dx%d", &game_xres, &game_yres);
+	if(sexmachine_debug) printf("[SEXMACHINE] Original Resolution:\t%dx%d\n", game_xres, game_yres);
+
+	if ((mame_game_orientation(option->game) & OSD_ORIENTATION_SWAP_XY) != 0)
+		section_map[section_mac++] = strdup("vertical");
+	else
+		section_map[section_mac++] = strdup("horizontal");
+	control = mame_game_control(option->game);
+	if (control) {
+		section_map[section_mac++] = strdup(control);
+	}
+	snprintf(buffer, sizeof(buffer), "%dplayer", mame_game_players(option->game));
+	section_map[section_mac++] = strdup(buffer);
+	section_map[section_mac++] = strdup("");
+	conf_section_set(context->cfg, section_map, section_mac);
+	for (i = 0; i < section_mac; ++i) {
+		log_std(("emu: use configuration section '%s'\n", section_map[i]));
+		free((char*)section_map[i]);
+	}
+
+	/* setup the include configuration file */
+	/* it must be after the final conf_section_set() call */
+	/* the include files of a previous game are removed first */
+	conf_input_remove(context->cfg, 2);
+	if (include_load(context->cfg, 2, conf_string_get_default(context->cfg, "include"), 0, 1, STANDARD, sizeof(STANDARD) / sizeof(STANDARD[0]), error_callback, 0) != 0) {
+		return -1;
+	}
+
+	log_std(("emu: *_load()\n"));
+
+	/* load all the options */
+	if (mame_config_load(context->cfg, option) != 0)
+		return -1;
+	if (advance_global_config_load(&context->global, context->cfg) != 0)
+		return -1;
+	if (advance_video_config_load(&context->video, context->cfg, option) != 0)
+		return -1;
+	if (advance_sound_config_load(&context->sound, context->cfg, option) != 0)
+		return -1;
+	if (advance_input_config_load(&context->input, context->cfg) != 0)
+		return -1;
+	if (advance_ui_config_load(&context->ui, context->cfg, option) != 0)
+		return -1;
+	if (advance_record_config_load(&context->record, context->cfg) != 0)
+		return -1;
+	if (advance_fileio_config_load(&context->fileio, context->cfg, option) != 0)
+		return -1;
+	if (advance_safequit_config_load(&context->safequit, context->cfg) != 0)
+		return -1;
+	if (hardware_script_config_load(context->cfg) != 0)
+		return -1;
+
+	return 0;
+}
+
+/***************************************************************************/
+/* Server */
+
+#if HAVE_SYS_SOCKET_H
+
+/**
+ * Max size of a request.
+ */
+#define SERVER_REQUEST_MAX 4096
+
+/**
+ * Max number of arguments of a request.
+ */
+#define SERVER_ARG_MAX 128
+
+/**
+ * Priority of the arguments of the requests.
+ * It's the same of the server command line, under the host configuration file.
+ */
+#define SERVER_ARG_PRIORITY 3
+
+/**
+ * Copy of the server command line.
+ * The inputs at SERVER_ARG_PRIORITY are replaced at every request, so
+ * the command line is reloaded after the arguments of the request.
+ */
+static char* SERVER_CMD_ARGV[SERVER_ARG_MAX];
+static int SERVER_CMD_ARGC;
+
+/**
+ * Save the server command line before it's loaded in the configuration.
+ */
+static void server_save_args(int argc, char* argv[])
+{
+	int i;
+
+	if (argc > SERVER_ARG_MAX) {
+		log_std(("WARNING:emu:server: command line truncated at %d arguments\n", SERVER_ARG_MAX));
+		argc = SERVER_ARG_MAX;
+	}
+
+	for (i = 0; i < argc; ++i)
+		SERVER_CMD_ARGV[i] = argv[i];
+	SERVER_CMD_ARGC = argc;
+}
+
+/**
+ * Read a request terminated by a new line.
+ * The new line is removed.
+ */
+static adv_error server_read(int f, char* buffer, unsigned size)
+{
+	unsigned pos = 0;
+
+	while (pos + 1 < size) {
+		ssize_t r = read(f, buffer + pos, 1);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return -1;
+		if (buffer[pos] == '\n') {
+			buffer[pos] = 0;
+			return 0;
+		}
+		++pos;
+	}
+
+	return -1;
+}
+
+static void server_write(int f, const char* buffer)
+{
+	unsigned size = strlen(buffer);
+
+	while (size) {
+		ssize_t r = write(f, buffer, size);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0) {
+			log_std(("ERROR:emu:server: write failed, %s\n", strerror(errno)));
+			return;
+		}
+		buffer += r;
+		size -= r;
+	}
+}
+
+/**
+ * Split a request in tab separated arguments.
+ */
+static unsigned server_split(char* buffer, char** arg_map, unsigned arg_max)
+{
+	unsigned arg_mac = 0;
+
+	while (*buffer && arg_mac < arg_max) {
+		arg_map[arg_mac++] = buffer;
+		while (*buffer && *buffer != '\t')
+			++buffer;
+		if (*buffer)
+			*buffer++ = 0;
+	}
+
+	return arg_mac;
+}
+
+/**
+ * Run a game requested to the server.
+ * The OS and the video driver remain initialized between the games, only
+ * the game configuration and the state of the other drivers are reloaded.
+ * \param base Options of the server command line.
+ * \param video_active Set when the video driver is initialized.
+ */
+static int server_game(struct advance_context* context, const struct mame_option* base, int argc, char* argv[], adv_bool* video_active)
+{
+	struct mame_option option;
+	const char* section_map[1];
+	char* cmd_argv[SERVER_ARG_MAX];
+	int cmd_argc;
+	char* gamename;
+	int lang;
+	int i;
+	int r;
+
+	option = *base;
+
+	/* replace the arguments of the previous request */
+	conf_input_remove(context->cfg, SERVER_ARG_PRIORITY);
+	if (conf_input_args_load(context->cfg, SERVER_ARG_PRIORITY, "", &argc, argv, error_callback, 0) != 0)
+		return -1;
+
+	/* reload the server command line removed with them, at the same priority */
+	/* the values loaded first win, so the request overrides the command line */
+	cmd_argc = SERVER_CMD_ARGC;
+	for (i = 0; i < cmd_argc; ++i)
+		cmd_argv[i] = SERVER_CMD_ARGV[i];
+	if (conf_input_args_load(context->cfg, SERVER_ARG_PRIORITY, "", &cmd_argc, cmd_argv, error_callback, 0) != 0)
+		return -1;
+
+	gamename = 0;
+	for (i = 0; i < argc; ++i) {
+		if (target_option_extract(argv[i]) == 0 && !gamename) {
+			unsigned j;
+			gamename = argv[i];
+			for (j = 0; gamename[j]; ++j)
+				gamename[j] = tolower(gamename[j]);
+		} else {
+			log_std(("WARNING:emu:server: ignored argument '%s'\n", argv[i]));
+		}
+	}
+
+	if (!gamename) {
+		target_err("No game specified in the server request.\n");
+		return -1;
+	}
+
+	log_std(("emu:server: run '%s'\n", gamename));
+
+	section_map[0] = "";
+	conf_section_set(context->cfg, section_map, 1);
+
+	option.game = select_game(gamename);
+	if (option.game == 0)
+		return -1;
+
+	lang = conf_int_get_default(context->cfg, "misc_lang");
+
+	option.game = select_lang(lang, option.game);
+
+	if (game_config_load(context, &option) != 0)
+		return -1;
+
+	if (advance_global_inner_init(&context->global) != 0)
+		goto err;
+	if (!*video_active) {
+		if (advance_video_inner_init(&context->video, &option) != 0)
+			goto err_inner_global;
+		*video_active = 1;
+	} else {
+		/* the video driver is already open, only preconfigure the new game */
+		advance_video_mode_preinit(&context->video, &option);
+	}
+	if (advance_input_inner_init(&context->input, context->cfg) != 0)
+		goto err_inner_global;
+	if (advance_ui_inner_init(&context->ui, context->cfg) != 0)
+		goto err_inner_input;
+	if (advance_safequit_inner_init(&context->safequit, &option) != 0)
+		goto err_inner_ui;
+	if (hardware_script_inner_init() != 0)
+		goto err_inner_safequit;
+
+	r = mame_game_run(context, &option);
+
+	hardware_script_inner_done();
+	advance_safequit_inner_done(&context->safequit);
+	advance_ui_inner_done(&context->ui);
+	advance_input_inner_done(&context->input);
+	advance_global_inner_done(&context->global);
+
+	/* save the configuration after every game, the server may be killed */
+	if (context->global.config.autosave) {
+		if (access(file_config_file_home(ADV_NAME ".rc"), W_OK) == 0) {
+			conf_save(context->cfg, 0, context->global.config.quiet_flag, error_callback, 0);
+		} else {
+			log_std(("WARNING:emu: configuration file %s not writable\n", file_config_file_home(ADV_NAME ".rc")));
+		}
+	}
+
+	return r;
+
+err_inner_safequit:
+	advance_safequit_inner_done(&context->safequit);
+err_inner_ui:
+	advance_ui_inner_done(&context->ui);
+err_inner_input:
+	advance_input_inner_done(&context->input);
+err_inner_global:
+	advance_global_inner_done(&context->global);
+err:
+	return -1;
+}
+
+/**
+ * Run the emulator as a server of game requests.
+ * The requests are read from a local socket, one request for connection.
+ * The request "run\tCLOCK\tARGS..." runs a game with the specified command
+ * line arguments, and it's replied with "done RESULT DELAY" when the game
+ * exits. CLOCK is the target_clock() of the request, and DELAY is the time
+ * from the request to the first frame of the game.
+ * The request "quit" stops the server.
+ * \param base Options of the server command line.
+ * \param path Path of the socket.
+ */
+static adv_error server_run(struct advance_context* context, const struct mame_option* base, const char* path)
+{
+	struct sockaddr_un addr;
+	int s;
+	adv_bool video_active;
+	adv_bool quit;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		target_err("Server socket path '%s' is too long.\n", path);
+		return -1;
+	}
+
+	s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s < 0) {
+		target_err("Error creating the server socket, %s.\n", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	sncpy(addr.sun_path, sizeof(addr.sun_path), path);
+
+	/* remove the socket of a previous server */
+	unlink(path);
+
+	if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0
+		|| listen(s, 1) != 0) {
+		target_err("Error opening the server socket '%s', %s.\n", path, strerror(errno));
+		close(s);
+		return -1;
+	}
+
+	log_std(("emu: os_inner_init()\n"));
+
+	if (os_inner_init(ADV_TITLE) != 0) {
+		close(s);
+		unlink(path);
+		return -1;
+	}
+
+	log_std(("emu:server: listening on '%s'\n", path));
+
+	video_active = 0;
+	quit = 0;
+	while (!quit && !os_is_quit()) {
+		char request[SERVER_REQUEST_MAX];
+		char* arg_map[SERVER_ARG_MAX];
+		unsigned arg_mac;
+		char reply[64];
+		int c;
+
+		c = accept(s, 0, 0);
+		if (c < 0) {
+			if (errno == EINTR)
+				continue;
+			log_std(("ERROR:emu:server: accept failed, %s\n", strerror(errno)));
+			break;
+		}
+
+		if (server_read(c, request, sizeof(request)) != 0) {
+			log_std(("ERROR:emu:server: invalid request\n"));
+			close(c);
+			continue;
+		}
+
+		arg_mac = server_split(request, arg_map, SERVER_ARG_MAX);
+
+		if (arg_mac >= 1 && strcmp(arg_map[0], "quit") == 0) {
+			quit = 1;
+			snprintf(reply, sizeof(reply), "bye\n");
+		} else if (arg_mac >= 2 && strcmp(arg_map[0], "run") == 0) {
+			target_clock_t launch = strtoll(arg_map[1], 0, 10);
+			int r;
+
+			if (launch == 0)
+				launch = target_clock();
+
+			context->global.state.launch_clock = launch;
+			context->global.state.launch_delay = 0;
+
+			r = server_game(context, base, arg_mac - 2, arg_map + 2, &video_active);
+
+			context->global.state.launch_clock = 0;
+
+			log_std(("emu:server: game exited with %d\n", r));
+
+			snprintf(reply, sizeof(reply), "done %d %lld\n", r, (long long)context->global.state.launch_delay);
+		} else {
+			log_std(("ERROR:emu:server: unknown request '%s'\n", arg_mac >= 1 ? arg_map[0] : ""));
+			snprintf(reply, sizeof(reply), "error\n");
+		}
+
+		server_write(c, reply);
+		close(c);
+	}
+
+	log_std(("emu:server: stop\n"));
+
+	if (video_active)
+		advance_video_inner_done(&context->video);
+
+	log_std(("emu: os_inner_done()\n"));
+
+	os_inner_done();
+
+	close(s);
+	unlink(path);
+
+	return 0;
+}
+
+#endif
+
 /***************************************************************************/
 /* Main */
 
@@ -1012,13 +1465,10 @@ int os_main(int argc, char* argv[])
 	const char* opt_cfg;
 	char* opt_gamename;
 	int opt_version;
+	const char* opt_server;
 	struct advance_context* context = &CONTEXT;
-	const char* section_map[32];
-	unsigned section_mac;
-	const mame_game* parent;
-	char buffer[128];
+	const char* section_map[1];
 	char cfg_buffer[512];
-	const char* control;
 
 	opt_xml = 0;
 	opt_bare = 0;
@@ -1030,10 +1480,14 @@ int os_main(int argc, char* argv[])
 	opt_version = 0;
 	opt_help = 0;
 	opt_cfg = 0;
+	opt_server = 0;
 
 	memset(&option, 0, sizeof(option));
 	memset(&CONTEXT, 0, sizeof(CONTEXT));
 
+	/* measure the launch time from the process start */
+	context->global.state.launch_clock = target_clock();
+
 	if (thread_init() != 0) {
 		target_err("Error initializing the thread support.\n");
 		goto err;
@@ -1074,10 +1528,15 @@ int os_main(int argc, char* argv[])
 	if (hardware_script_init(context->cfg) != 0)
 		goto err_os;
 
+#if HAVE_SYS_SOCKET_H
+	server_save_args(argc, argv);
+#endif
+
 	if (conf_input_args_load(context->cfg, 3, "", &argc, argv, error_callback, 0) != 0)
 		goto err_os;
 
 	option.debug_flag = 0;
+	option.verbose_flag = 0;
 	for (i = 1; i < argc; ++i) {
 		if (target_option_compare(argv[i], "cfg")) {
 			opt_cfg = argv[i + 1];
@@ -1096,10 +1555,15 @@ int os_main(int argc, char* argv[])
 			opt_remove = 1;
 		} else if (target_option_compare(argv[i], "debug")) {
 			option.debug_flag = 1;
+		} else if (target_option_compare(argv[i], "verbose")) {
+			option.verbose_flag = 1;
 		} else if (target_option_compare(argv[i], "listxml")) {
 			opt_xml = 1;
 		} else if (target_option_compare(argv[i], "listbare")) {
 			opt_bare = 1;
+		} else if (target_option_compare(argv[i], "server") && i + 1 < argc && argv[i + 1][0] != '-') {
+			opt_server = argv[i + 1];
+			++i;
 		} else if (target_option_compare(argv[i], "record") && i + 1 < argc && argv[i + 1][0] != '-') {
 			if (strchr(argv[i + 1], '.') == 0)
 				snprintf(option.record_file_buffer, sizeof(option.record_file_buffer), "%s.inp", argv[i + 1]);
@@ -1238,6 +1702,27 @@ int os_main(int argc, char* argv[])
 	section_map[0] = "";
 	conf_section_set(context->cfg, section_map, 1);
 
+	if (opt_server) {
+#if HAVE_SYS_SOCKET_H
+		if (opt_gamename || option.playback_file_buffer[0] || option.record_file_buffer[0]) {
+			target_err("The server mode doesn't accept a game in the command line.\n");
+			goto err_os;
+		}
+
+		context->global.state.launch_clock = 0;
+
+		if (server_run(context, &option, opt_server) != 0)
+			goto err_os;
+
+		r = 0;
+
+		goto done_server;
+#else
+		target_err("The server mode isn't supported on this platform.\n");
+		goto err_os;
+#endif
+	}
+
 	if (!opt_gamename) {
 		if (!option.playback_file_buffer[0]) {
 			target_err("No game specified in the command line.\n");
@@ -1267,80 +1752,7 @@ int os_main(int argc, char* argv[])
 		option.game = select_lang(lang, option.game);
 	}
 
-	/* set the used section */
-	section_mac = 0;
-	parent = option.game;
-	while (parent && section_mac < 8) {
-		const char* s;
-		s = mame_software_name(parent, context->cfg);
-		if (s && s[0]) {
-			section_map[section_mac++] = strdup(s);
-		}
-		parent = mame_game_parent(parent);
-	}
-	parent = option.game;
-	while (parent && section_mac < 8) {
-		const char* s;
-		s = mame_game_name(parent);
-		if (s && s[0]) {
-			section_map[section_mac++] = strdup(s);
-		}
-		parent = mame_game_parent(parent);
-	}
-	section_map[section_mac++] = strdup(mame_game_resolutionclock(option.game));
-	section_map[section_mac++] = strdup(mame_game_resolution(option.game));
-
-	// [SEXMACHINE]
-	char tmp[100];
-	sprintf(tmp, "%s", strdup(mame_game_resolution(option.game)));
-	sscanf(tmp, "%dx%d", &game_xres, &game_yres);
-	if(sexmachine_debug) printf("[SEXMACHINE] Original Resolution:\t%dx%d\n", game_xres, game_yres);
-
-	if ((mame_game_orientation(option.game) & OSD_ORIENTATION_SWAP_XY) != 0)
-		section_map[section_mac++] = strdup("vertical");
-	else
-		section_map[section_mac++] = strdup("horizontal");
-	control = mame_game_control(option.game);
-	if (control) {
-		section_map[section_mac++] = strdup(control);
-	}
-	snprintf(buffer, sizeof(buffer), "%dplayer", mame_game_players(option.game));
-	section_map[section_mac++] = strdup(buffer);
-	section_map[section_mac++] = strdup("");
-	conf_section_set(context->cfg, section_map, section_mac);
-	for (i = 0; i < section_mac; ++i) {
-		log_std(("emu: use configuration section '%s'\n", section_map[i]));
-		free((char*)section_map[i]);
-	}
-
-	/* setup the include configuration file */
-	/* it must be after the final conf_section_set() call */
-	if (include_load(context->cfg, 2, conf_string_get_default(context->cfg, "include"), 0, 1, STANDARD, sizeof(STANDARD) / sizeof(STANDARD[0]), error_callback, 0) != 0) {
-		goto err_os;
-	}
-
-	log_std(("emu: *_load()\n"));
-
-	/* load all the options */
-	if (mame_config_load(context->cfg, &option) != 0)
-		goto err_os;
-	if (advance_global_config_load(&context->global, context->cfg) != 0)
-		goto err_os;
-	if (advance_video_config_load(&context->video, context->cfg, &option) != 0)
-		goto err_os;
-	if (advance_sound_config_load(&context->sound, context->cfg, &option) != 0)
-		goto err_os;
-	if (advance_input_config_load(&context->input, context->cfg) != 0)
-		goto err_os;
-	if (advance_ui_config_load(&context->ui, context->cfg, &option) != 0)
-		goto err_os;
-	if (advance_record_config_load(&context->record, context->cfg) != 0)
-		goto err_os;
-	if (advance_fileio_config_load(&context->fileio, context->cfg, &option) != 0)
-		goto err_os;
-	if (advance_safequit_config_load(&context->safequit, context->cfg) != 0)
-		goto err_os;
-	if (hardware_script_config_load(context->cfg) != 0)
+	if (game_config_load(context, &option) != 0)
 		goto err_os;
 
 	if (!context->global.config.quiet_flag) {
@@ -1387,6 +1799,7 @@ int os_main(int argc, char* argv[])
 
 	os_inner_done();
 
+done_server:
 	log_std(("emu: *_done()\n"));
 
 	hardware_script_done();
@@ -312,6 +312,48 @@ struct ui_color_set {
 	struct ui_color help_u; /**< Help unassigned foreground. */
 };
 
+#define UI_GLYPH_MAX 4 /**< Number of cached font strips. */
+
+/** User interface overlays. */
+/*@{*/
+#define UI_OVERLAY_MESSAGE 0
+#define UI_OVERLAY_HELP 1
+#define UI_OVERLAY_HELP_MESSAGE 2
+#define UI_OVERLAY_MENU 3
+#define UI_OVERLAY_OSD 4
+#define UI_OVERLAY_SCROLL 5
+#define UI_OVERLAY_MAX 6 /**< Max number of overlays. */
+/*@}*/
+
+/**
+ * Cached font strip.
+ * The font drawn with the colors of a text.
+ */
+struct ui_glyph {
+	adv_font_strip* strip; /**< Font strip, 0 if empty. */
+	unsigned bytes_per_pixel; /**< Bytes per pixel of the strip. */
+	const adv_pixel* map; /**< Alpha map, 0 for a two colors strip. */
+	adv_pixel front; /**< Foreground of a two colors strip. */
+	adv_pixel back; /**< Background of a two colors strip. */
+};
+
+/**
+ * Cached overlay.
+ * The rendered image of an user interface element. It's reused until
+ * the content of the element changes.
+ */
+struct ui_overlay {
+	adv_bitmap* flat; /**< Rendered image, 0 if not valid. */
+	int pos_x; /**< X position of the image. */
+	int pos_y; /**< Y position of the image. */
+	unsigned char* key_map; /**< Content of the rendered image. */
+	unsigned key_mac;
+	unsigned key_max;
+	unsigned char* next_map; /**< Content of the current frame. */
+	unsigned next_mac;
+	unsigned next_max;
+};
+
 struct advance_ui_config_context {
 	unsigned help_mac; /**< Number of help entries. */
 	struct help_entry help_map[INPUT_HELP_MAX]; /**< Help map. */
@@ -360,6 +402,14 @@ struct advance_ui_state_context {
 	adv_color_def buffer_def; /**< Color definition of the internal bitmap buffer. */
 
 	struct ui_color_set color_map; /**< Current color mapping. */
+	struct ui_color_set direct_color_map; /**< Current color mapping of the direct update. */
+
+	struct ui_glyph glyph_map[UI_GLYPH_MAX]; /**< Cached font strips of the user interface font. */
+	unsigned glyph_next; /**< Next font strip to replace. */
+
+	struct ui_overlay overlay_map[UI_OVERLAY_MAX]; /**< Cached overlays. */
+	unsigned overlay_render_counter; /**< Number of overlays rendered. */
+	unsigned overlay_copy_counter; /**< Number of overlays reused. */
 };
 
 struct advance_ui_context {
@@ -771,6 +821,8 @@ struct advance_video_state_context {
 	osd_mask_t* palette_dirty_map; /**< If the palette is dirty this is the list of dirty colors. */
 	osd_mask_t palette_dirty_mask; /**< Mask for the last dirty element. */
 	adv_bool palette_dirty_flag; /**< If the current palette dirty, it need to be updated. */
+	unsigned palette_dirty_first; /**< First element of palette_dirty_map that may be set. */
+	unsigned palette_dirty_last; /**< Last element of palette_dirty_map that may be set. */
 	uint32* palette_index32_map; /**< Software palette at 32 bit. */
 	uint16* palette_index16_map; /**< Software palette at 16 bit. */
 	uint8* palette_index8_map; /**< Software palette at 8 bit. */
@@ -987,6 +1039,8 @@ struct advance_global_config_context {
 struct advance_global_state_context {
 	adv_bool is_config_writable; /**< Is the configuration file writable ? */
 	char message_buffer[256]; /**< Next message to be displayed. */
+	target_clock_t launch_clock; /**< Time of the launch request of the game. 0 after the first frame. */
+	target_clock_t launch_delay; /**< Time from the launch request to the first frame. */
 #ifdef USE_LCD
 	adv_lcd* lcd; /**< LCD context. */
 #endif
@@ -84,6 +84,9 @@ static struct fileio_item FILEIO_CONFIG[] = {
 	{ FILETYPE_STATE, "dir_sta", "sta", FILEIO_MODE_SINGLE, 0, 0 },
 	{ FILETYPE_MEMCARD, "dir_memcard", "memcard", FILEIO_MODE_SINGLE, 0, 0 },
 	{ FILETYPE_SCREENSHOT, "dir_snap", "snap", FILEIO_MODE_SINGLE, 0, 0 },
+#ifndef MESS
+	{ FILETYPE_ROMCACHE, "dir_romcache", "romcache", FILEIO_MODE_SINGLE, 0, 0 },
+#endif
 	/* FILETYPE_MOVIE */
 	{ FILETYPE_HISTORY, 0, 0, FILEIO_MODE_FILE, 0, 0 }, /* used for history.dat, mameinfo.dat */
 	{ FILETYPE_CHEAT, 0, 0, FILEIO_MODE_FILE, 0, 0 }, /* used for cheat.dat */
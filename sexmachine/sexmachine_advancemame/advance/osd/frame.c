@@ -473,6 +473,8 @@ static void video_invalidate_color(struct advance_video_context* context)
 	if (!context->state.game_rgb_flag) {
 		unsigned i;
 		context->state.palette_dirty_flag = 1;
+		context->state.palette_dirty_first = 0;
+		context->state.palette_dirty_last = context->state.palette_dirty_total - 1;
 		for (i = 0; i < context->state.palette_dirty_total; ++i)
 			context->state.palette_dirty_map[i] = osd_mask_full;
 	}
@@ -1607,6 +1609,8 @@ static adv_error video_init_color(struct advance_video_context* context, struct
 
 	/* make the palette completly dirty */
 	context->state.palette_dirty_flag = 1;
+	context->state.palette_dirty_first = 0;
+	context->state.palette_dirty_last = context->state.palette_dirty_total - 1;
 	for (i = 0; i < context->state.palette_dirty_total; ++i)
 		context->state.palette_dirty_map[i] = osd_mask_full;
 
@@ -2174,80 +2178,160 @@ static void video_frame_screen(struct advance_video_context* context, struct adv
 	video_frame_put(context, ui_context, bitmap, update_x_get(), update_y_get());
 }
 
+/**
+ * Color converter for a RGB definition.
+ * The channel shifts and masks are computed once for a whole palette update,
+ * instead of for every color.
+ */
+struct video_palette_converter {
+	adv_color_def def;
+	adv_bool rgb_flag;
+	int red_shift;
+	unsigned red_mask;
+	int green_shift;
+	unsigned green_mask;
+	int blue_shift;
+	unsigned blue_mask;
+};
+
+static void video_palette_converter_init(struct video_palette_converter* conv, adv_color_def def_ordinal)
+{
+	union adv_color_def_union def;
+
+	def.ordinal = def_ordinal;
+
+	conv->def = def_ordinal;
+	conv->rgb_flag = def.nibble.type == adv_color_type_rgb;
+	conv->red_shift = rgb_shift_make_from_def(def.nibble.red_len, def.nibble.red_pos);
+	conv->red_mask = rgb_mask_make_from_def(def.nibble.red_len, def.nibble.red_pos);
+	conv->green_shift = rgb_shift_make_from_def(def.nibble.green_len, def.nibble.green_pos);
+	conv->green_mask = rgb_mask_make_from_def(def.nibble.green_len, def.nibble.green_pos);
+	conv->blue_shift = rgb_shift_make_from_def(def.nibble.blue_len, def.nibble.blue_pos);
+	conv->blue_mask = rgb_mask_make_from_def(def.nibble.blue_len, def.nibble.blue_pos);
+}
+
+static inline adv_pixel video_palette_converter_make(const struct video_palette_converter* conv, const adv_color_rgb* c)
+{
+	if (conv->rgb_flag)
+		return rgb_nibble_insert(c->red, conv->red_shift, conv->red_mask)
+			| rgb_nibble_insert(c->green, conv->green_shift, conv->green_mask)
+			| rgb_nibble_insert(c->blue, conv->blue_shift, conv->blue_mask);
+	else
+		return pixel_make_from_def(c->red, c->green, c->blue, conv->def);
+}
+
+/**
+ * Convert a set of colors to a software palette.
+ * \param map Palette of 1, 2 or 4 bytes for each color.
+ * \param bytes_per_pixel Size of the palette entries.
+ * \param base First color of the set.
+ * \param m Mask of the colors to convert, starting from base.
+ */
+static void video_palette_convert(const struct video_palette_converter* conv, void* map, unsigned bytes_per_pixel, const adv_color_rgb* palette_map, unsigned base, osd_mask_t m)
+{
+	unsigned p;
+
+	/* whole set, no bit test */
+	if (m == osd_mask_full) {
+		switch (bytes_per_pixel) {
+		case 4 :
+			for (p = base; p < base + osd_mask_size; ++p)
+				((uint32*)map)[p] = video_palette_converter_make(conv, &palette_map[p]);
+			break;
+		case 2 :
+			for (p = base; p < base + osd_mask_size; ++p)
+				((uint16*)map)[p] = video_palette_converter_make(conv, &palette_map[p]);
+			break;
+		case 1 :
+			for (p = base; p < base + osd_mask_size; ++p)
+				((uint8*)map)[p] = video_palette_converter_make(conv, &palette_map[p]);
+			break;
+		}
+		return;
+	}
+
+	for (p = base; m != 0; m >>= 1, ++p) {
+		if ((m & 1) != 0) {
+			adv_pixel pixel = video_palette_converter_make(conv, &palette_map[p]);
+			switch (bytes_per_pixel) {
+			case 4 : ((uint32*)map)[p] = pixel; break;
+			case 2 : ((uint16*)map)[p] = pixel; break;
+			case 1 : ((uint8*)map)[p] = pixel; break;
+			}
+		}
+	}
+}
+
 static void video_frame_palette(struct advance_video_context* context)
 {
 	if (context->state.palette_dirty_flag) {
+		struct video_palette_converter video_conv;
+		struct video_palette_converter buffer_conv;
+		unsigned bytes_per_pixel;
+		void* palette_index_map;
+		void* buffer_index_map;
+		unsigned buffer_bytes_per_pixel;
+		unsigned last;
 		unsigned i;
 
 		context->state.palette_dirty_flag = 0;
 
-		for (i = 0; i < context->state.palette_dirty_total; ++i) {
-			if (context->state.palette_dirty_map[i]) {
-				unsigned j;
-				unsigned jl;
-				unsigned t;
-				unsigned m;
-
-				m = context->state.palette_dirty_map[i];
-				context->state.palette_dirty_map[i] = 0;
-
-				jl = context->state.palette_total - i * osd_mask_size;
-				if (jl > osd_mask_size)
-					jl = osd_mask_size;
-
-				t = 1;
-				for (j = 0; j < jl; ++j) {
-					if ((m & t) != 0) {
-						unsigned p = i * osd_mask_size + j;
-
-						adv_color_rgb c = context->state.palette_map[p];
-
-						/* update the palette */
-						if (context->state.mode_index == MODE_FLAGS_INDEX_PALETTE8) {
-							/* hardware */
-							/* note: trying to concatenate palette update */
-							/* generate flickering!, one color at time is ok! */
-							video_palette_set(&c, p, 1, 0);
-						} else {
-							/* software */
-							adv_pixel pixel;
-							video_pixel_make(&pixel, c.red, c.green, c.blue);
-
-							/* update only the currently used palette to not overload the memory cache */
-							switch (video_bytes_per_pixel()) {
-							case 4:
-								context->state.palette_index32_map[p] = pixel;
-								break;
-							case 2:
-								context->state.palette_index16_map[p] = pixel;
-								break;
-							case 1:
-								context->state.palette_index8_map[p] = pixel;
-								break;
-							}
-
-							if (video_color_def() != context->state.buffer_def) {
-								pixel = pixel_make_from_def(c.red, c.green, c.blue, context->state.buffer_def);
-								/* update only the 32 bit palette, the others are never used */
-								context->state.buffer_index32_map[p] = pixel;
-							} else {
-								switch (video_bytes_per_pixel()) {
-								case 4:
-									context->state.buffer_index32_map[p] = pixel;
-									break;
-								case 2:
-									context->state.buffer_index16_map[p] = pixel;
-									break;
-								case 1:
-									context->state.buffer_index8_map[p] = pixel;
-									break;
-								}
-							}
-						}
-					}
+		/* only the elements changed since the last frame */
+		last = context->state.palette_dirty_last;
+		if (last >= context->state.palette_dirty_total)
+			last = context->state.palette_dirty_total - 1;
+
+		bytes_per_pixel = video_bytes_per_pixel();
+		switch (bytes_per_pixel) {
+		case 4 : palette_index_map = context->state.palette_index32_map; break;
+		case 2 : palette_index_map = context->state.palette_index16_map; break;
+		default : palette_index_map = context->state.palette_index8_map; break;
+		}
 
-					t <<= 1;
+		/* update only the currently used palette to not overload the memory cache */
+		video_palette_converter_init(&video_conv, video_color_def());
+		if (video_color_def() != context->state.buffer_def) {
+			video_palette_converter_init(&buffer_conv, context->state.buffer_def);
+			/* update only the 32 bit palette, the others are never used */
+			buffer_index_map = context->state.buffer_index32_map;
+			buffer_bytes_per_pixel = 4;
+		} else {
+			buffer_conv = video_conv;
+			buffer_bytes_per_pixel = bytes_per_pixel;
+			switch (bytes_per_pixel) {
+			case 4 : buffer_index_map = context->state.buffer_index32_map; break;
+			case 2 : buffer_index_map = context->state.buffer_index16_map; break;
+			default : buffer_index_map = context->state.buffer_index8_map; break;
+			}
+		}
+
+		for (i = context->state.palette_dirty_first; i <= last && i < context->state.palette_dirty_total; ++i) {
+			osd_mask_t m = context->state.palette_dirty_map[i];
+			unsigned base = i * osd_mask_size;
+
+			if (!m)
+				continue;
+
+			context->state.palette_dirty_map[i] = 0;
+
+			/* the last element is partial */
+			if (i == context->state.palette_dirty_total - 1)
+				m &= context->state.palette_dirty_mask;
+
+			if (context->state.mode_index == MODE_FLAGS_INDEX_PALETTE8) {
+				/* hardware */
+				unsigned p;
+				for (p = base; m != 0; m >>= 1, ++p) {
+					if ((m & 1) != 0) {
+						/* note: trying to concatenate palette update */
+						/* generate flickering!, one color at time is ok! */
+						video_palette_set(&context->state.palette_map[p], p, 1, 0);
+					}
 				}
+			} else {
+				/* software */
+				video_palette_convert(&video_conv, palette_index_map, bytes_per_pixel, context->state.palette_map, base, m);
+				video_palette_convert(&buffer_conv, buffer_index_map, buffer_bytes_per_pixel, context->state.palette_map, base, m);
 			}
 		}
 	}
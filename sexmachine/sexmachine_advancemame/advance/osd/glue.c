@@ -38,6 +38,8 @@
 
 #include "advance.h"
 
+#include "sexmachine.h"
+
 #include <math.h>
 
 #ifndef __MSDOS__
@@ -656,6 +658,22 @@ int mame_game_run(struct advance_context* context, const struct mame_option* adv
 	options.debug_height = advance->debug_height;
 	options.debug_depth = 8;
 	options.controller = 0; /* no controller file to load */
+#ifndef MESS
+	options.verbose = advance->verbose_flag;
+	options.rewind_count = advance->rewind_count;
+	options.rewind_size = advance->rewind_size;
+	options.runahead = advance->runahead;
+	options.rom_cache = advance->rom_cache_flag;
+	options.lazy_gfx = advance->lazy_gfx_flag;
+	options.adpcm_cache_size = advance->adpcm_cache_size;
+	options.chd_cache_size = advance->chd_cache_size;
+	options.draw_bands = advance->draw_bands_flag;
+	options.tilemap_bench = advance->tilemap_bench_flag;
+	options.fm_bench = advance->fm_bench_flag;
+	options.cheat_bench = advance->cheat_bench_flag;
+	options.resample_taps = advance->resample_taps;
+	options.stream_bench = advance->stream_bench_flag;
+#endif
 
 	if (advance->bios_buffer[0] == 0 || strcmp(advance->bios_buffer, "default") == 0)
 		options.bios = 0;
@@ -1225,6 +1243,9 @@ static struct mame_port GLUE_PORT_STD[] = {
 	SU("ui_watch_value", UI_WATCH_VALUE)
 	SU("ui_edit_cheat", UI_EDIT_CHEAT)
 	SU("ui_toggle_crosshair", UI_TOGGLE_CROSSHAIR)
+#ifndef MESS
+	SU("ui_rewind", UI_REWIND)
+#endif
 
 	/* specific of AdvanceMAME */
 	SU("safequit", MAME_PORT_SAFEQUIT)
@@ -1794,6 +1815,9 @@ static unsigned PORT_TYPE_REPORT_DEFAULT[] = {
 	/* IPT_UI_WATCH_VALUE, */
 	/* IPT_UI_EDIT_CHEAT, */
 	IPT_UI_TOGGLE_CROSSHAIR,
+#ifndef MESS
+	IPT_UI_REWIND,
+#endif
 	0
 };
 
@@ -2041,6 +2065,85 @@ unsigned mame_ui_frames_per_second(void)
 	return Machine->drv->frames_per_second;
 }
 
+/**
+ * Get the cost of the last capture in the rewind ring.
+ * \return 0 if the rewind is disabled.
+ */
+adv_bool mame_ui_rewind_info(double* capture_time, unsigned* count)
+{
+#ifdef MESS
+	/* the rewind ring is not available in MESS */
+	return 0;
+#else
+	const state_ring_info* info;
+
+	if (options.rewind_count == 0)
+		return 0;
+
+	info = state_ring_get_info();
+	*capture_time = info->last_capture_time;
+	*count = info->entries;
+
+	return 1;
+#endif
+}
+
+/**
+ * Get the cost of the run-ahead.
+ * \param frames Where to put the number of hidden frames run ahead.
+ * \param frame_time Where to put the extra emulation time of the last displayed frame.
+ * \param fps Where to put the average rate of displayed frames.
+ * \return 0 if the run-ahead is disabled.
+ */
+adv_bool mame_ui_runahead_info(unsigned* frames, double* frame_time, double* fps)
+{
+#ifdef MESS
+	/* the run-ahead is not available in MESS */
+	return 0;
+#else
+	const runahead_info* info = mame_get_runahead_info();
+
+	if (info->frames == 0)
+		return 0;
+
+	*frames = info->frames;
+	*frame_time = info->last_time;
+	if (info->elapsed_time > 0)
+		*fps = info->host_frames / info->elapsed_time;
+	else
+		*fps = 0;
+
+	return 1;
+#endif
+}
+
+/**
+ * Get the effectiveness of the ADPCM sample cache.
+ * \param hit Where to put the percentage of the playbacks served by the cache.
+ * \param used Where to put the memory used in bytes.
+ * \return 0 if the cache is disabled.
+ */
+adv_bool mame_ui_adpcm_info(unsigned* hit, unsigned* used)
+{
+#ifdef MESS
+	/* the ADPCM sample cache is not available in MESS */
+	return 0;
+#else
+	adpcm_cache_stats stats;
+
+	if (!adpcm_cache_get_stats(&stats))
+		return 0;
+
+	if (stats.hits + stats.misses + stats.rejects != 0)
+		*hit = (unsigned)(100.0 * stats.hits / (stats.hits + stats.misses + stats.rejects));
+	else
+		*hit = 0;
+	*used = stats.used;
+
+	return 1;
+#endif
+}
+
 /**
  * Check if a MAME port is active.
  * A port is active if the associated key sequence is pressed.
@@ -2376,7 +2479,12 @@ void osd_update_video_and_audio(mame_display *display)
 
 	/* update the palette */
 	if ((display->changed_flags & GAME_PALETTE_CHANGED) != 0) {
-		osd2_palette(display->game_palette_dirty, display->game_palette, display->game_palette_entries);
+#ifdef MESS
+		/* the MESS core doesn't track the dirty range, scan all the mask */
+		osd2_palette(display->game_palette_dirty, 0, (display->game_palette_entries + osd_mask_size - 1) / osd_mask_size - 1, display->game_palette, display->game_palette_entries);
+#else
+		osd2_palette(display->game_palette_dirty, display->game_palette_dirty_min, display->game_palette_dirty_max, display->game_palette, display->game_palette_entries);
+#endif
 	}
 
 	/* update the area */
@@ -2981,6 +3089,22 @@ static void mess_done(void)
 }
 #endif
 
+static adv_conf_enum_int OPTION_RESAMPLE[] = {
+	{ "linear", 0 },
+	{ "fast", 8 },
+	{ "good", 16 },
+	{ "best", 32 }
+};
+
+static adv_conf_enum_int OPTION_RUNAHEAD[] = {
+	{ "auto", -1 },
+	{ "0", 0 },
+	{ "1", 1 },
+	{ "2", 2 },
+	{ "3", 3 },
+	{ "4", 4 }
+};
+
 static adv_conf_enum_int OPTION_ARTWORK_MAGNIFY[] = {
 	{ "auto", 0 },
 	{ "1", 1 },
@@ -3043,6 +3167,7 @@ adv_error mame_init(struct advance_context* context)
 	conf_bool_register_default(context->cfg, "display_artwork_crop", 1);
 	conf_int_register_enum_default(context->cfg, "display_artwork_magnify", conf_enum(OPTION_ARTWORK_MAGNIFY), 0);
 	conf_bool_register_default(context->cfg, "sound_samples", 1);
+	conf_int_register_enum_default(context->cfg, "sound_resample", conf_enum(OPTION_RESAMPLE), 0);
 
 	conf_bool_register_default(context->cfg, "display_antialias", 1);
 	conf_bool_register_default(context->cfg, "display_translucency", 1);
@@ -3061,6 +3186,19 @@ adv_error mame_init(struct advance_context* context)
 
 	conf_string_register_default(context->cfg, "misc_bios", "default");
 
+	conf_int_register_limit_default(context->cfg, "misc_rewind", 0, 3600, 0);
+	conf_int_register_limit_default(context->cfg, "misc_rewindsize", 1, 256, 16);
+	conf_bool_register_default(context->cfg, "misc_romcache", 0);
+	conf_bool_register_default(context->cfg, "misc_lazygfx", 0);
+	conf_int_register_limit_default(context->cfg, "misc_chdcache", 0, 256, 16);
+	conf_int_register_limit_default(context->cfg, "misc_adpcmcache", 0, 64, 0);
+	conf_int_register_enum_default(context->cfg, "misc_runahead", conf_enum(OPTION_RUNAHEAD), -1);
+	conf_bool_register_default(context->cfg, "misc_drawbands", 0);
+	conf_bool_register_default(context->cfg, "debug_tilemapbench", 0);
+	conf_bool_register_default(context->cfg, "debug_streambench", 0);
+	conf_bool_register_default(context->cfg, "debug_fmbench", 0);
+	conf_bool_register_default(context->cfg, "debug_cheatbench", 0);
+
 #ifdef MESS
 	mess_init(context->cfg);
 #endif
@@ -3079,6 +3217,7 @@ adv_error mame_config_load(adv_conf* cfg_context, struct mame_option* option)
 {
 	char* s;
 	unsigned i, j;
+	int runahead;
 
 	option->artwork_backdrop_flag = conf_bool_get_default(cfg_context, "display_artwork_backdrop");
 	option->artwork_overlay_flag = conf_bool_get_default(cfg_context, "display_artwork_overlay");
@@ -3086,6 +3225,7 @@ adv_error mame_config_load(adv_conf* cfg_context, struct mame_option* option)
 	option->artwork_crop_flag = conf_bool_get_default(cfg_context, "display_artwork_crop");
 	option->artwork_scale = conf_int_get_default(cfg_context, "display_artwork_magnify");
 	option->samples_flag = conf_bool_get_default(cfg_context, "sound_samples");
+	option->resample_taps = conf_int_get_default(cfg_context, "sound_resample");
 
 	option->antialias = conf_bool_get_default(cfg_context, "display_antialias");
 	option->translucency = conf_bool_get_default(cfg_context, "display_translucency");
@@ -3114,6 +3254,25 @@ adv_error mame_config_load(adv_conf* cfg_context, struct mame_option* option)
 
 	sncpy(option->bios_buffer, sizeof(option->bios_buffer), conf_string_get_default(cfg_context, "misc_bios"));
 
+	option->rewind_count = conf_int_get_default(cfg_context, "misc_rewind");
+	option->rewind_size = conf_int_get_default(cfg_context, "misc_rewindsize") * 1024 * 1024;
+	option->rom_cache_flag = conf_bool_get_default(cfg_context, "misc_romcache");
+	option->lazy_gfx_flag = conf_bool_get_default(cfg_context, "misc_lazygfx");
+	option->chd_cache_size = conf_int_get_default(cfg_context, "misc_chdcache") * 1024 * 1024;
+	option->adpcm_cache_size = conf_int_get_default(cfg_context, "misc_adpcmcache") * 1024 * 1024;
+	option->draw_bands_flag = conf_bool_get_default(cfg_context, "misc_drawbands");
+	option->tilemap_bench_flag = conf_bool_get_default(cfg_context, "debug_tilemapbench");
+	option->stream_bench_flag = conf_bool_get_default(cfg_context, "debug_streambench");
+	option->fm_bench_flag = conf_bool_get_default(cfg_context, "debug_fmbench");
+	option->cheat_bench_flag = conf_bool_get_default(cfg_context, "debug_cheatbench");
+
+	/* with auto use the value set with the lightgun calibration of the game */
+	runahead = conf_int_get_default(cfg_context, "misc_runahead");
+	if (runahead < 0)
+		option->runahead = game_runahead;
+	else
+		option->runahead = runahead;
+
 	/* convert the dir separator char to ';'. */
 	/* the cheat system use always this char in all the operating system */
 	for (s = option->cheat_file_buffer; *s; ++s)
@@ -64,11 +64,13 @@ struct mame_option {
 
 	int samplerate;
 	int samples_flag;
+	unsigned resample_taps;
 
 	int vector_width;
 	int vector_height;
 
 	int debug_flag;
+	int verbose_flag;
 	int debug_width;
 	int debug_height;
 
@@ -92,6 +94,19 @@ struct mame_option {
 	adv_bool artwork_crop_flag;
 	int artwork_scale;
 
+	unsigned rewind_count; /**< Frames kept in the rewind ring, 0 disabled. */
+	unsigned rewind_size; /**< Size in bytes of the rewind ring. */
+	unsigned runahead; /**< Hidden frames run ahead of the displayed one, 0 disabled. */
+	adv_bool rom_cache_flag; /**< Cache the loaded ROM and the decoded graphics on disk. */
+	adv_bool lazy_gfx_flag; /**< Decode the graphics elements when first drawn. */
+	unsigned chd_cache_size; /**< Size in bytes of the decompressed hunk cache of every disk. */
+	unsigned adpcm_cache_size; /**< Size in bytes of the decoded ADPCM sample cache, 0 disabled. */
+	adv_bool draw_bands_flag; /**< Draw the elements in parallel horizontal bands. */
+	adv_bool tilemap_bench_flag; /**< Benchmark the tilemap redraw. */
+	adv_bool stream_bench_flag; /**< Log the CPU time of every sound stream. */
+	adv_bool fm_bench_flag; /**< Benchmark and check the silent channels skip of the FM chips. */
+	adv_bool cheat_bench_flag; /**< Benchmark and check the word compare of the cheat search. */
+
 	char savegame_file_buffer[MAME_MAXPATH];
 	char language_file_buffer[MAME_MAXPATH];
 	char record_file_buffer[MAME_MAXPATH];
@@ -251,6 +266,9 @@ void mame_ui_refresh(void);
 void mame_ui_gamma_factor_set(double gamma);
 unsigned char mame_ui_cpu_read(unsigned cpu, unsigned addr);
 unsigned mame_ui_frames_per_second(void);
+adv_bool mame_ui_rewind_info(double* capture_time, unsigned* count);
+adv_bool mame_ui_runahead_info(unsigned* frames, double* frame_time, double* fps);
+adv_bool mame_ui_adpcm_info(unsigned* hit, unsigned* used);
 void mame_ui_input_map(unsigned* pdigital_mac, struct mame_digital_map_entry* digital_map, unsigned digital_max);
 
 /***************************************************************************/
@@ -370,7 +388,7 @@ void osd2_thread_done(void);
 int osd2_video_menu(int selected, unsigned input);
 int osd2_audio_menu(int selected, unsigned input);
 int osd2_frame(const struct osd_bitmap* game, const struct osd_bitmap* debug, const osd_rgb_t* debug_palette, unsigned debug_palette_size, unsigned led, unsigned input, const short* sample_buffer, unsigned sample_count, unsigned knocker);
-void osd2_palette(const osd_mask_t* mask, const osd_rgb_t* palette, unsigned size);
+void osd2_palette(osd_mask_t* mask, unsigned mask_first, unsigned mask_last, const osd_rgb_t* palette, unsigned size);
 void osd2_area(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
 void osd2_save_snapshot(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
 void osd2_info(char* buffer, unsigned size);
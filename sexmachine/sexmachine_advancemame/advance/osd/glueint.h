@@ -52,6 +52,7 @@
 #include "../../src/osdepend.h"
 #include "../../src/ui_text.h"
 #include "../../src/profiler.h"
+#include "../../src/sound/adpcmcache.h"
 
 #endif
 
@@ -37,10 +37,60 @@
 
 #include "advance.h"
 
+/* Option names of the scripts, in the ID order */
+static const char* HARDWARE_SCRIPT_NAME[HARDWARE_SCRIPT_MAX] = {
+	"script_video",
+	"script_emulation",
+	"script_play",
+	"script_led1",
+	"script_led2",
+	"script_led3",
+	"script_coin1",
+	"script_coin2",
+	"script_coin3",
+	"script_coin4",
+	"script_start1",
+	"script_start2",
+	"script_start3",
+	"script_start4",
+	"script_turbo",
+	"script_safequit",
+	"script_event1",
+	"script_event2",
+	"script_event3",
+	"script_event4",
+	"script_event5",
+	"script_event6",
+	"script_event7",
+	"script_event8",
+	"script_event9",
+	"script_event10",
+	"script_event11",
+	"script_event12",
+	"script_event13",
+	"script_event14",
+	"script_knocker"
+};
+
+/* Max number of port writes stored in a frame */
+#define HARDWARE_SCRIPT_PORT_MAX 64
+
+/* Max number of ports with a known value */
+#define HARDWARE_SCRIPT_SHADOW_MAX 16
+
+struct hardware_script_port {
+	int address;
+	unsigned char value;
+};
+
 struct hardware_script_pair {
 	int condition;
-	struct script_cmd* script;
+	struct script_program* program; /**< Compiled script. */
 	struct script_state* state;
+	char* file; /**< File of the script, or 0 if in the configuration. */
+	time_t file_time; /**< Modification time of the file. */
+	target_clock_t run_time; /**< Time spent running the script. */
+	unsigned run_counter; /**< Number of runs. */
 };
 
 struct hardware_script_state {
@@ -64,6 +114,20 @@ struct hardware_script_state {
 	char info_throttle_buffer[256];
 
 	unsigned seed; /**< Random seed. */
+
+	adv_bool reload_flag; /**< If reloading a script, errors are only reported. */
+	unsigned reload_time; /**< Time from the last check of the script files. */
+
+	/* Port writes of the frame, done at the end in the same order */
+	unsigned port_mac;
+	struct hardware_script_port port_map[HARDWARE_SCRIPT_PORT_MAX];
+
+	/* Last values written to the ports */
+	unsigned shadow_mac;
+	struct hardware_script_port shadow_map[HARDWARE_SCRIPT_SHADOW_MAX];
+
+	unsigned port_write_counter; /**< Number of writes done. */
+	unsigned port_skip_counter; /**< Number of writes skipped because not changing the port. */
 };
 
 static struct hardware_script_state STATE;
@@ -78,13 +142,64 @@ void hardware_script_set(int id, const char* script)
 		STATE.text_map[id] = 0;
 }
 
+/* Write all the pending port writes */
+static void hardware_script_port_flush(void)
+{
+	unsigned i;
+
+	for (i = 0; i < STATE.port_mac; ++i) {
+		struct hardware_script_port* port = &STATE.port_map[i];
+		unsigned j;
+
+		target_port_set(port->address, port->value);
+		++STATE.port_write_counter;
+
+		/* keep the last written value */
+		for (j = 0; j < STATE.shadow_mac; ++j)
+			if (STATE.shadow_map[j].address == port->address)
+				break;
+		if (j == STATE.shadow_mac && STATE.shadow_mac < HARDWARE_SCRIPT_SHADOW_MAX)
+			STATE.shadow_map[STATE.shadow_mac++].address = port->address;
+		if (j < STATE.shadow_mac)
+			STATE.shadow_map[j].value = port->value;
+	}
+
+	STATE.port_mac = 0;
+}
+
+/* Get the last value stored for a port. Return 0 if none. */
+static struct hardware_script_port* hardware_script_port_last(int address)
+{
+	int i;
+
+	for (i = STATE.port_mac - 1; i >= 0; --i)
+		if (STATE.port_map[i].address == address)
+			return &STATE.port_map[i];
+
+	for (i = 0; i < STATE.shadow_mac; ++i)
+		if (STATE.shadow_map[i].address == address)
+			return &STATE.shadow_map[i];
+
+	return 0;
+}
+
 /* Port callback */
 unsigned char script_port_read(int address)
 {
-	if (address == 0) {
+	unsigned i;
+
+	if (address == 0)
 		return STATE.kdb_state;
-	} else
-		return target_port_get(address);
+
+	/* the queued writes of the port reach the hardware before reading it */
+	for (i = 0; i < STATE.port_mac; ++i) {
+		if (STATE.port_map[i].address == address) {
+			hardware_script_port_flush();
+			break;
+		}
+	}
+
+	return target_port_get(address);
 }
 
 void script_port_write(int address, unsigned char value)
@@ -118,7 +233,20 @@ void script_port_write(int address, unsigned char value)
 			STATE.kdb_state = value;
 		}
 	} else {
-		target_port_set(address, value);
+		struct hardware_script_port* last = hardware_script_port_last(address);
+
+		/* skip if it doesn't change the port */
+		if (last && last->value == value) {
+			++STATE.port_skip_counter;
+			return;
+		}
+
+		if (STATE.port_mac == HARDWARE_SCRIPT_PORT_MAX)
+			hardware_script_port_flush();
+
+		STATE.port_map[STATE.port_mac].address = address;
+		STATE.port_map[STATE.port_mac].value = value;
+		++STATE.port_mac;
 	}
 }
 
@@ -133,12 +261,6 @@ struct symbol {
 	{ 0, 0 }
 };
 
-/* Evaluate a constant */
-static struct script_value* script_constant_get(union script_arg_extra argextra)
-{
-	return script_value_alloc_num(argextra.value);
-}
-
 /* Evaluate a text variable */
 static struct script_value* script_text_get(union script_arg_extra argextra)
 {
@@ -441,9 +563,112 @@ script_exp_op3fee_evaluator* script_function3_check(const char* sym, union scrip
 /* Parse error callback */
 void script_error(const char* s)
 {
+	if (STATE.reload_flag) {
+		log_std(("ERROR:script: compiling the script: '%s', %s\n", STATE.script_text, s));
+		advance_global_message(&CONTEXT.global, "Script error, %s", s);
+		return;
+	}
+
 	target_err("Error compiling the script: '%s', %s\n", STATE.script_text, s);
 }
 
+/* Load the text of a script file */
+static char* hardware_script_load(const char* file, time_t* file_time)
+{
+	struct stat st;
+	char* text;
+	FILE* f;
+
+	f = fopen(file, "rb");
+	if (!f)
+		return 0;
+
+	if (fstat(fileno(f), &st) != 0) {
+		fclose(f);
+		return 0;
+	}
+
+	text = malloc(st.st_size + 1);
+	if (fread(text, st.st_size, 1, f) != 1 && st.st_size != 0) {
+		free(text);
+		fclose(f);
+		return 0;
+	}
+	text[st.st_size] = 0;
+
+	fclose(f);
+
+	*file_time = st.st_mtime;
+
+	return text;
+}
+
+/* Compile a script */
+static struct script_program* hardware_script_compile(const char* text)
+{
+	struct script_cmd* script;
+	struct script_program* program;
+
+	STATE.script_text = text;
+
+	script = script_parse(text);
+	if (!script)
+		return 0;
+
+	program = script_compile(script);
+
+	/* the tree is not used anymore */
+	script_free(script);
+
+	return program;
+}
+
+/* Reload a script if the file is changed */
+static void hardware_script_reload(unsigned id)
+{
+	struct hardware_script_pair* pair = &STATE.map[id];
+	struct script_program* program;
+	struct stat st;
+	time_t file_time;
+	char* text;
+	target_clock_t start;
+
+	if (stat(pair->file, &st) != 0 || st.st_mtime == pair->file_time)
+		return;
+
+	start = target_clock();
+
+	text = hardware_script_load(pair->file, &file_time);
+	if (!text)
+		return;
+
+	/* don't retry until the next change */
+	pair->file_time = file_time;
+
+	/* restart the lexer, a previous parse may have stopped at an error */
+	script_flush();
+
+	STATE.reload_flag = 1;
+	program = hardware_script_compile(text);
+	STATE.reload_flag = 0;
+
+	free(text);
+
+	if (!program) {
+		log_std(("ERROR:script: %s not reloaded from %s\n", HARDWARE_SCRIPT_NAME[id], pair->file));
+		return;
+	}
+
+	/* restart the script if running */
+	if (!script_run_end(pair->state))
+		script_run_restart(pair->state, program);
+
+	script_program_free(pair->program);
+	pair->program = program;
+
+	log_std(("script: %s reloaded from %s in %g [ms]\n", HARDWARE_SCRIPT_NAME[id], pair->file, (target_clock() - start) * 1000.0 / TARGET_CLOCKS_PER_SEC));
+}
+
 int hardware_script_init(adv_conf* context)
 {
 	conf_string_register_default(context, "script_video", "wait(!event()); set(kdb, 0);");
@@ -487,6 +712,8 @@ int hardware_script_init(adv_conf* context)
 
 	STATE.seed = time(0);
 
+	STATE.reload_flag = 0;
+
 	return 0;
 }
 
@@ -502,22 +729,61 @@ int hardware_script_inner_init(void)
 	assert(!STATE.active_flag);
 
 	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
-		if (STATE.text_map[i]) {
-			STATE.script_text = STATE.text_map[i];
-			STATE.map[i].script = script_parse(STATE.text_map[i]);
-			if (!STATE.map[i].script) {
-				return -1;
+		STATE.map[i].program = 0;
+		STATE.map[i].state = 0;
+		STATE.map[i].file = 0;
+		STATE.map[i].run_time = 0;
+		STATE.map[i].run_counter = 0;
+	}
+
+	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
+		const char* text = STATE.text_map[i];
+		char* file_text = 0;
+
+		if (!text)
+			continue;
+
+		/* the script in a file with @FILE */
+		if (text[0] == '@') {
+			STATE.map[i].file = strdup(file_config_file_home(text + 1));
+			file_text = hardware_script_load(STATE.map[i].file, &STATE.map[i].file_time);
+			if (!file_text) {
+				target_err("Error reading the script file '%s' for '%s'.\n", STATE.map[i].file, HARDWARE_SCRIPT_NAME[i]);
+				goto err;
 			}
-			STATE.map[i].state = script_run_alloc();
-		} else {
-			STATE.map[i].script = 0;
-			STATE.map[i].state = 0;
+			text = file_text;
 		}
+
+		STATE.map[i].program = hardware_script_compile(text);
+
+		free(file_text);
+
+		if (!STATE.map[i].program)
+			goto err;
+
+		STATE.map[i].state = script_run_alloc();
 	}
 
+	STATE.reload_time = 0;
+	STATE.port_mac = 0;
+	STATE.shadow_mac = 0;
+	STATE.port_write_counter = 0;
+	STATE.port_skip_counter = 0;
+
 	STATE.active_flag = 1;
 
 	return 0;
+
+err:
+	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
+		script_program_free(STATE.map[i].program);
+		script_run_free(STATE.map[i].state);
+		free(STATE.map[i].file);
+		STATE.map[i].program = 0;
+		STATE.map[i].state = 0;
+		STATE.map[i].file = 0;
+	}
+	return -1;
 }
 
 void hardware_script_inner_done(void)
@@ -528,10 +794,26 @@ void hardware_script_inner_done(void)
 
 	STATE.active_flag = 0;
 
+	hardware_script_port_flush();
+
+	log_std(("script: port writes %u, skipped %u\n", STATE.port_write_counter, STATE.port_skip_counter));
+
 	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
-		script_free(STATE.map[i].script);
-		script_run_free(STATE.map[i].state);
+		struct hardware_script_pair* pair = &STATE.map[i];
+
+		if (pair->run_counter) {
+			double ms = pair->run_time * 1000.0 / TARGET_CLOCKS_PER_SEC;
+			log_std(("script: %s runs %u, time %g [ms], avg %g [us]\n", HARDWARE_SCRIPT_NAME[i], pair->run_counter, ms, ms * 1000 / pair->run_counter));
+		}
+
+		script_program_free(pair->program);
+		script_run_free(pair->state);
+		free(pair->file);
+		pair->program = 0;
+		pair->state = 0;
+		pair->file = 0;
 		free(STATE.text_map[i]);
+		STATE.text_map[i] = 0;
 	}
 
 	/* free the lex buffer */
@@ -550,27 +832,42 @@ void hardware_script_abort(void)
 /* Start the script */
 void hardware_script_start(int id)
 {
-	if (STATE.map[id].script) {
+	if (STATE.map[id].program) {
 		STATE.map[id].condition = 1;
 		/* start only if not already running */
 		if (script_run_end(STATE.map[id].state))
-			script_run_restart(STATE.map[id].state, STATE.map[id].script);
+			script_run_restart(STATE.map[id].state, STATE.map[id].program);
 	}
 }
 
 void hardware_script_stop(int id)
 {
-	if (STATE.map[id].script) {
+	if (STATE.map[id].program) {
 		STATE.map[id].condition = 0;
 	}
 }
 
 static void hardware_script_idle_single(unsigned id, unsigned time_to_play)
 {
-	if (STATE.map[id].script) {
+	struct hardware_script_pair* pair = &STATE.map[id];
+
+	if (pair->program) {
+		target_clock_t start;
+
+		if (script_run_end(pair->state)) {
+			/* only count the time */
+			script_run(pair->state, time_to_play);
+			return;
+		}
+
+		start = target_clock();
+
 		/* set the global condition flag */
-		STATE.script_condition = STATE.map[id].condition;
-		script_run(STATE.map[id].state, time_to_play);
+		STATE.script_condition = pair->condition;
+		script_run(pair->state, time_to_play);
+
+		pair->run_time += target_clock() - start;
+		++pair->run_counter;
 	}
 }
 
@@ -578,9 +875,22 @@ static void hardware_script_idle_single(unsigned id, unsigned time_to_play)
 void hardware_script_idle(unsigned time_to_play)
 {
 	int i;
+
+	/* check the script files every second */
+	STATE.reload_time += time_to_play;
+	if (STATE.reload_time >= SCRIPT_TIME_UNIT) {
+		STATE.reload_time = 0;
+		for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
+			if (STATE.map[i].file)
+				hardware_script_reload(i);
+		}
+	}
+
 	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
 		hardware_script_idle_single(i, time_to_play);
 	}
+
+	hardware_script_port_flush();
 }
 
 void hardware_script_terminate(int id)
@@ -588,104 +898,17 @@ void hardware_script_terminate(int id)
 	int time_to_play = SCRIPT_TIME_UNIT; /* one second time to flush any delay */
 	hardware_script_stop(id);
 	hardware_script_idle_single(id, time_to_play);
+	hardware_script_port_flush();
 }
 
 int hardware_script_config_load(adv_conf* context)
 {
-	const char* s;
-
-	s = conf_string_get_default(context, "script_video");
-	hardware_script_set(HARDWARE_SCRIPT_VIDEO, s);
-
-	s = conf_string_get_default(context, "script_emulation");
-	hardware_script_set(HARDWARE_SCRIPT_EMULATION, s);
-
-	s = conf_string_get_default(context, "script_play");
-	hardware_script_set(HARDWARE_SCRIPT_PLAY, s);
-
-	s = conf_string_get_default(context, "script_led1");
-	hardware_script_set(HARDWARE_SCRIPT_LED1, s);
-
-	s = conf_string_get_default(context, "script_led2");
-	hardware_script_set(HARDWARE_SCRIPT_LED2, s);
-
-	s = conf_string_get_default(context, "script_led3");
-	hardware_script_set(HARDWARE_SCRIPT_LED3, s);
-
-	s = conf_string_get_default(context, "script_coin1");
-	hardware_script_set(HARDWARE_SCRIPT_COIN1, s);
-
-	s = conf_string_get_default(context, "script_coin2");
-	hardware_script_set(HARDWARE_SCRIPT_COIN2, s);
-
-	s = conf_string_get_default(context, "script_coin3");
-	hardware_script_set(HARDWARE_SCRIPT_COIN3, s);
-
-	s = conf_string_get_default(context, "script_coin4");
-	hardware_script_set(HARDWARE_SCRIPT_COIN4, s);
-
-	s = conf_string_get_default(context, "script_start1");
-	hardware_script_set(HARDWARE_SCRIPT_START1, s);
-
-	s = conf_string_get_default(context, "script_start2");
-	hardware_script_set(HARDWARE_SCRIPT_START2, s);
-
-	s = conf_string_get_default(context, "script_start3");
-	hardware_script_set(HARDWARE_SCRIPT_START3, s);
-
-	s = conf_string_get_default(context, "script_start4");
-	hardware_script_set(HARDWARE_SCRIPT_START4, s);
-
-	s = conf_string_get_default(context, "script_turbo");
-	hardware_script_set(HARDWARE_SCRIPT_TURBO, s);
+	unsigned i;
 
-	s = conf_string_get_default(context, "script_safequit");
-	hardware_script_set(HARDWARE_SCRIPT_SAFEQUIT, s);
-
-	s = conf_string_get_default(context, "script_event1");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT1, s);
-
-	s = conf_string_get_default(context, "script_event2");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT2, s);
-
-	s = conf_string_get_default(context, "script_event3");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT3, s);
-
-	s = conf_string_get_default(context, "script_event4");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT4, s);
-
-	s = conf_string_get_default(context, "script_event5");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT5, s);
-
-	s = conf_string_get_default(context, "script_event6");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT6, s);
-
-	s = conf_string_get_default(context, "script_event7");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT7, s);
-
-	s = conf_string_get_default(context, "script_event8");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT8, s);
-
-	s = conf_string_get_default(context, "script_event9");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT9, s);
-
-	s = conf_string_get_default(context, "script_event10");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT10, s);
-
-	s = conf_string_get_default(context, "script_event11");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT11, s);
-
-	s = conf_string_get_default(context, "script_event12");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT12, s);
-
-	s = conf_string_get_default(context, "script_event13");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT13, s);
-
-	s = conf_string_get_default(context, "script_event14");
-	hardware_script_set(HARDWARE_SCRIPT_EVENT14, s);
-
-	s = conf_string_get_default(context, "script_knocker");
-	hardware_script_set(HARDWARE_SCRIPT_KNOCKER, s);
+	for (i = 0; i < HARDWARE_SCRIPT_MAX; ++i) {
+		const char* s = conf_string_get_default(context, HARDWARE_SCRIPT_NAME[i]);
+		hardware_script_set(i, s);
+	}
 
 	return 0;
 }
@@ -283,7 +283,7 @@ static struct script_value* script_value_add(struct script_value* a, struct scri
 		struct script_value* p = script_value_alloc(SCRIPT_VALUE_TEXT);
 		unsigned la = strlen(a->value.text);
 		unsigned lb = strlen(b->value.text);
-		char* s = malloc(la + lb);
+		char* s = malloc(la + lb + 1);
 
 		memcpy(s, a->value.text, la);
 		memcpy(s + la, b->value.text, lb);
@@ -485,212 +485,589 @@ struct script_cmd* script_cmd_make_op3sec(const char* arg0, struct script_exp* a
 }
 
 /***************************************************************************/
-/* Stack */
-
-static inline int script_run_cursor_empty(const struct script_state* state)
+/* Compile */
+
+/* Bytecode instructions */
+#define SCRIPT_OP_END 0x00 /* end of the script */
+#define SCRIPT_OP_TICK 0x01 /* start of a command, pause if no time to play */
+#define SCRIPT_OP_JMP 0x02 /* jump to arg */
+#define SCRIPT_OP_JZ 0x03 /* jump to arg if a is 0 */
+#define SCRIPT_OP_JNZ 0x04 /* jump to arg if a is not 0 */
+#define SCRIPT_OP_WAIT 0x05 /* continue if a is not 0, otherwise wait the next run from arg */
+#define SCRIPT_OP_JSET 0x06 /* jump to arg if the counter is set */
+#define SCRIPT_OP_CSET 0x07 /* set the counter with a */
+#define SCRIPT_OP_DELAY 0x08 /* wait the time of the counter */
+#define SCRIPT_OP_REPEAT 0x09 /* decrement the counter, or jump to arg if 0 */
+#define SCRIPT_OP_NUM 0x10 /* d = arg */
+#define SCRIPT_OP_TEXT 0x11 /* d = text */
+#define SCRIPT_OP_F0 0x12 /* d = eval() */
+#define SCRIPT_OP_F1 0x13 /* d = eval(a) */
+#define SCRIPT_OP_F2 0x14 /* d = eval(a, b) */
+#define SCRIPT_OP_NOT 0x15 /* d = ~a */
+#define SCRIPT_OP_LNOT 0x16 /* d = !a */
+#define SCRIPT_OP_BOOL 0x17 /* d = a != 0 */
+#define SCRIPT_OP_ADD 0x18 /* d = a + b */
+#define SCRIPT_OP_SUB 0x19 /* d = a - b */
+#define SCRIPT_OP_AND 0x1a /* d = a & b */
+#define SCRIPT_OP_OR 0x1b /* d = a | b */
+#define SCRIPT_OP_XOR 0x1c /* d = a ^ b */
+#define SCRIPT_OP_L 0x1d /* d = a < b */
+#define SCRIPT_OP_G 0x1e /* d = a > b */
+#define SCRIPT_OP_E 0x1f /* d = a == b */
+#define SCRIPT_OP_LE 0x20 /* d = a <= b */
+#define SCRIPT_OP_GE 0x21 /* d = a >= b */
+#define SCRIPT_OP_SL 0x22 /* d = a << b */
+#define SCRIPT_OP_SR 0x23 /* d = a >> b */
+
+union script_code_eval {
+	script_exp_op1f_evaluator* f0;
+	script_exp_op2fe_evaluator* f1;
+	script_exp_op3fee_evaluator* f2;
+	char* text;
+};
+
+struct script_code {
+	unsigned char op;
+	unsigned char d; /* destination register */
+	unsigned char a; /* first source register */
+	unsigned char b; /* second source register */
+	int arg; /* immediate value, or jump target */
+	union script_arg_extra argextra; /* extra value for the evaluator, or counter */
+	union script_code_eval eval; /* evaluator, or text */
+};
+
+struct script_program {
+	unsigned code_mac;
+	unsigned code_max;
+	struct script_code* code_map;
+	unsigned counter_mac; /* number of counters used by delay() and repeat() */
+};
+
+/* Evaluate a constant. It's replaced by the value when compiled. */
+struct script_value* script_constant_get(union script_arg_extra argextra)
 {
-	return state->cursor_mac == 0;
+	return script_value_alloc_num(argextra.value);
 }
 
-static inline struct script_cmd* script_run_cursor_get(struct script_state* state)
+static unsigned script_emit(struct script_program* program, unsigned op, unsigned d, unsigned a, unsigned b, int arg)
 {
-	return state->cursor_map[state->cursor_mac - 1];
-}
+	struct script_code* code;
 
-static inline void script_run_cursor_pop(struct script_state* state)
-{
-	--state->cursor_mac;
-}
+	if (program->code_mac == program->code_max) {
+		program->code_max = program->code_max ? 2 * program->code_max : 64;
+		program->code_map = realloc(program->code_map, program->code_max * sizeof(struct script_code));
+	}
 
-static inline void script_run_cursor_set(struct script_state* state, struct script_cmd* cmd)
-{
-	state->cursor_map[state->cursor_mac - 1] = cmd;
-}
+	code = &program->code_map[program->code_mac];
+	code->op = op;
+	code->d = d;
+	code->a = a;
+	code->b = b;
+	code->arg = arg;
+	code->argextra.ptr = 0;
+	code->eval.text = 0;
 
-static inline void script_run_cursor_push(struct script_state* state, struct script_cmd* cmd)
-{
-	++state->cursor_mac;
-	state->cursor_map[state->cursor_mac - 1] = cmd;
+	return program->code_mac++;
 }
 
-/***************************************************************************/
-/* Commands */
-
-void script_run_next(struct script_state* state)
+/* Emit an instruction using a counter */
+static unsigned script_emit_counter(struct script_program* program, unsigned op, unsigned counter)
 {
-	/* next statement */
-	script_run_cursor_set(state, script_run_cursor_get(state)->next);
-	/* skip if terminated unrolling the stack */
-	while (!script_run_cursor_empty(state) && !script_run_cursor_get(state)) {
-		script_run_cursor_pop(state);
-	}
-}
+	unsigned i = script_emit(program, op, 0, 0, 0, 0);
 
-void script_run_exp(struct script_state* state)
-{
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	struct script_value* value = script_evaluate(cursor->data.op1e.arg0);
-	script_value_free(value);
-	script_run_next(state);
+	program->code_map[i].argextra.value = counter;
+
+	return i;
 }
 
-void script_run_wait(struct script_state* state)
+/* Set the jump target of an instruction at the current position */
+static void script_patch(struct script_program* program, unsigned i)
 {
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	struct script_value* value = script_evaluate(cursor->data.op1e.arg0);
-	int condition = script_value_free_num(value);
-	if (condition) {
-		script_run_next(state);
-	} else {
-		state->time_to_play = 0;
-	}
+	program->code_map[i].arg = program->code_mac;
 }
 
-void script_run_delay(struct script_state* state)
+/* Compile an expression with the result in the register d */
+static int script_compile_exp(struct script_program* program, const struct script_exp* exp, unsigned d)
 {
-	unsigned unit = SCRIPT_TIME_UNIT / SCRIPT_DELAY_UNIT;
+	unsigned op;
+	unsigned j;
 
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	if (!cursor->data.op1ed.value_set) {
-		cursor->data.op1ed.value_set = 1;
-		cursor->data.op1ed.value = script_value_free_num(script_evaluate(cursor->data.op1ed.arg0));
+	/* the operands use the next registers */
+	if (d + 2 > SCRIPT_REG_MAX) {
+		script_error("Expression too complex");
+		return -1;
 	}
 
-	if (state->time_to_play < cursor->data.op1ed.value * unit) {
-		cursor->data.op1ed.value -= state->time_to_play / unit;
-		state->time_to_play = state->time_to_play % unit;
-	} else {
-		state->time_to_play -= cursor->data.op1ed.value * unit;
-		cursor->data.op1ed.value_set = 0;
-		script_run_next(state);
+	switch (exp->type) {
+	case SCRIPT_EXP_VALUE:
+		script_emit(program, SCRIPT_OP_NUM, d, 0, 0, exp->data.op1v.arg0);
+		return 0;
+	case SCRIPT_EXP_VARIABLE:
+		if (exp->data.op1s.eval == &script_constant_get) {
+			script_emit(program, SCRIPT_OP_NUM, d, 0, 0, exp->data.op1s.argextra.value);
+		} else {
+			/* a symbol is a function without arguments */
+			j = script_emit(program, SCRIPT_OP_F0, d, 0, 0, 0);
+			program->code_map[j].eval.f0 = exp->data.op1s.eval;
+			program->code_map[j].argextra = exp->data.op1s.argextra;
+		}
+		return 0;
+	case SCRIPT_EXP_TEXT:
+		j = script_emit(program, SCRIPT_OP_TEXT, d, 0, 0, 0);
+		program->code_map[j].eval.text = strdup(exp->data.op1t.arg0);
+		return 0;
+	case SCRIPT_EXP_F0:
+		j = script_emit(program, SCRIPT_OP_F0, d, 0, 0, 0);
+		program->code_map[j].eval.f0 = exp->data.op1f.eval;
+		program->code_map[j].argextra = exp->data.op1f.argextra;
+		return 0;
+	case SCRIPT_EXP_F1:
+		if (script_compile_exp(program, exp->data.op2fe.arg1, d) != 0)
+			return -1;
+		j = script_emit(program, SCRIPT_OP_F1, d, d, 0, 0);
+		program->code_map[j].eval.f1 = exp->data.op2fe.eval;
+		program->code_map[j].argextra = exp->data.op2fe.argextra;
+		return 0;
+	case SCRIPT_EXP_F2:
+		if (script_compile_exp(program, exp->data.op3fee.arg1, d) != 0)
+			return -1;
+		if (script_compile_exp(program, exp->data.op3fee.arg2, d + 1) != 0)
+			return -1;
+		j = script_emit(program, SCRIPT_OP_F2, d, d, d + 1, 0);
+		program->code_map[j].eval.f2 = exp->data.op3fee.eval;
+		program->code_map[j].argextra = exp->data.op3fee.argextra;
+		return 0;
+	case SCRIPT_EXP_EXPRESSION:
+		return script_compile_exp(program, exp->data.op1e.arg0, d);
+	case SCRIPT_EXP_NOT:
+	case SCRIPT_EXP_LNOT:
+		if (script_compile_exp(program, exp->data.op1e.arg0, d) != 0)
+			return -1;
+		script_emit(program, exp->type == SCRIPT_EXP_NOT ? SCRIPT_OP_NOT : SCRIPT_OP_LNOT, d, d, 0, 0);
+		return 0;
+	case SCRIPT_EXP_LOR:
+	case SCRIPT_EXP_LAND:
+		/* the second operand is evaluated only if required */
+		if (script_compile_exp(program, exp->data.op2ee.arg0, d) != 0)
+			return -1;
+		j = script_emit(program, exp->type == SCRIPT_EXP_LOR ? SCRIPT_OP_JNZ : SCRIPT_OP_JZ, 0, d, 0, 0);
+		if (script_compile_exp(program, exp->data.op2ee.arg1, d) != 0)
+			return -1;
+		script_patch(program, j);
+		script_emit(program, SCRIPT_OP_BOOL, d, d, 0, 0);
+		return 0;
+	case SCRIPT_EXP_ADD: op = SCRIPT_OP_ADD; break;
+	case SCRIPT_EXP_SUB: op = SCRIPT_OP_SUB; break;
+	case SCRIPT_EXP_AND: op = SCRIPT_OP_AND; break;
+	case SCRIPT_EXP_OR: op = SCRIPT_OP_OR; break;
+	case SCRIPT_EXP_XOR: op = SCRIPT_OP_XOR; break;
+	case SCRIPT_EXP_L: op = SCRIPT_OP_L; break;
+	case SCRIPT_EXP_G: op = SCRIPT_OP_G; break;
+	case SCRIPT_EXP_E: op = SCRIPT_OP_E; break;
+	case SCRIPT_EXP_LE: op = SCRIPT_OP_LE; break;
+	case SCRIPT_EXP_GE: op = SCRIPT_OP_GE; break;
+	case SCRIPT_EXP_SL: op = SCRIPT_OP_SL; break;
+	case SCRIPT_EXP_SR: op = SCRIPT_OP_SR; break;
+	default:
+		assert(0);
+		return -1;
 	}
+
+	if (script_compile_exp(program, exp->data.op2ee.arg0, d) != 0)
+		return -1;
+	if (script_compile_exp(program, exp->data.op2ee.arg1, d + 1) != 0)
+		return -1;
+	script_emit(program, op, d, d, d + 1, 0);
+
+	return 0;
 }
 
-void script_run_repeat(struct script_state* state)
+/* Compile a list of commands */
+static int script_compile_cmd(struct script_program* program, const struct script_cmd* cmd)
 {
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	if (!cursor->data.op2ecd.value_set) {
-		cursor->data.op2ecd.value_set = 1;
-		cursor->data.op2ecd.value = script_value_free_num(script_evaluate(cursor->data.op2ecd.arg0));
-	}
-	if (cursor->data.op2ecd.value) {
-		--cursor->data.op2ecd.value;
-		script_run_cursor_push(state, cursor->data.op2ecd.arg1);
-	} else {
-		cursor->data.op2ecd.value_set = 0;
-		script_run_next(state);
+	while (cmd) {
+		unsigned start;
+		unsigned j;
+		unsigned counter;
+
+		/* every command checks the time to play like a step of the script */
+		start = script_emit(program, SCRIPT_OP_TICK, 0, 0, 0, 0);
+
+		switch (cmd->type) {
+		case SCRIPT_CMD_EVALUATE:
+			if (script_compile_exp(program, cmd->data.op1e.arg0, 0) != 0)
+				return -1;
+			break;
+		case SCRIPT_CMD_WAIT:
+			if (script_compile_exp(program, cmd->data.op1e.arg0, 0) != 0)
+				return -1;
+			script_emit(program, SCRIPT_OP_WAIT, 0, 0, 0, start);
+			break;
+		case SCRIPT_CMD_DELAY:
+			/* the delay is evaluated only at the start */
+			counter = program->counter_mac++;
+			j = script_emit_counter(program, SCRIPT_OP_JSET, counter);
+			if (script_compile_exp(program, cmd->data.op1ed.arg0, 0) != 0)
+				return -1;
+			script_emit_counter(program, SCRIPT_OP_CSET, counter);
+			script_patch(program, j);
+			script_emit_counter(program, SCRIPT_OP_DELAY, counter);
+			break;
+		case SCRIPT_CMD_REPEAT:
+			/* the number of repetitions is evaluated only at the start */
+			counter = program->counter_mac++;
+			j = script_emit_counter(program, SCRIPT_OP_JSET, counter);
+			if (script_compile_exp(program, cmd->data.op2ecd.arg0, 0) != 0)
+				return -1;
+			script_emit_counter(program, SCRIPT_OP_CSET, counter);
+			script_patch(program, j);
+			j = script_emit_counter(program, SCRIPT_OP_REPEAT, counter);
+			if (script_compile_cmd(program, cmd->data.op2ecd.arg1) != 0)
+				return -1;
+			script_emit(program, SCRIPT_OP_JMP, 0, 0, 0, start);
+			script_patch(program, j);
+			break;
+		case SCRIPT_CMD_LOOP:
+			if (script_compile_cmd(program, cmd->data.op1c.arg0) != 0)
+				return -1;
+			script_emit(program, SCRIPT_OP_JMP, 0, 0, 0, start);
+			break;
+		case SCRIPT_CMD_INNER:
+			if (script_compile_cmd(program, cmd->data.op1c.arg0) != 0)
+				return -1;
+			break;
+		case SCRIPT_CMD_WHILE:
+		case SCRIPT_CMD_IF:
+			if (script_compile_exp(program, cmd->data.op2ec.arg0, 0) != 0)
+				return -1;
+			j = script_emit(program, SCRIPT_OP_JZ, 0, 0, 0, 0);
+			if (script_compile_cmd(program, cmd->data.op2ec.arg1) != 0)
+				return -1;
+			if (cmd->type == SCRIPT_CMD_WHILE)
+				script_emit(program, SCRIPT_OP_JMP, 0, 0, 0, start);
+			script_patch(program, j);
+			break;
+		default:
+			assert(0);
+			return -1;
+		}
+
+		cmd = cmd->next;
 	}
-}
 
-void script_run_loop(struct script_state* state)
-{
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	script_run_cursor_push(state, cursor->data.op1c.arg0);
+	return 0;
 }
 
-void script_run_inner(struct script_state* state)
+/* Compile the script to bytecode */
+struct script_program* script_compile(const struct script_cmd* script)
 {
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	script_run_cursor_set(state, cursor->next); /* set the next, also if is 0 */
-	script_run_cursor_push(state, cursor->data.op1c.arg0);
-}
+	struct script_program* program = malloc(sizeof(struct script_program));
 
-void script_run_if(struct script_state* state)
-{
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	struct script_value* value = script_evaluate(cursor->data.op2ec.arg0);
-	int condition = script_value_free_num(value);
-	if (condition) {
-		script_run_cursor_set(state, cursor->next); /* set the next, also if is 0 */
-		script_run_cursor_push(state, cursor->data.op2ec.arg1);
-	} else {
-		script_run_next(state);
+	program->code_mac = 0;
+	program->code_max = 0;
+	program->code_map = 0;
+	program->counter_mac = 0;
+
+	if (script_compile_cmd(program, script) != 0) {
+		script_program_free(program);
+		return 0;
 	}
+
+	script_emit(program, SCRIPT_OP_END, 0, 0, 0, 0);
+
+	return program;
 }
 
-void script_run_while(struct script_state* state)
+void script_program_free(struct script_program* program)
 {
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	struct script_value* value = script_evaluate(cursor->data.op2ec.arg0);
-	int condition = script_value_free_num(value);
-	if (condition) {
-		script_run_cursor_push(state, cursor->data.op2ec.arg1);
-	} else {
-		script_run_next(state);
-	}
+	unsigned i;
+
+	if (!program)
+		return;
+
+	for (i = 0; i < program->code_mac; ++i)
+		if (program->code_map[i].op == SCRIPT_OP_TEXT)
+			free(program->code_map[i].eval.text);
+
+	free(program->code_map);
+	free(program);
 }
 
 /***************************************************************************/
 /* Run */
 
 /* Start a script */
-void script_run_restart(struct script_state* state, struct script_cmd* cmd)
+void script_run_restart(struct script_state* state, const struct script_program* program)
 {
-	state->cursor_mac = 1;
-	state->cursor_map[0] = cmd;
+	unsigned i;
+
+	if (state->counter_max < program->counter_mac) {
+		state->counter_max = program->counter_mac;
+		state->counter_map = realloc(state->counter_map, state->counter_max * sizeof(struct script_counter));
+	}
+	for (i = 0; i < program->counter_mac; ++i) {
+		state->counter_map[i].value = 0;
+		state->counter_map[i].value_set = 0;
+	}
+
+	state->program = program;
+	state->pc = 0;
 	state->time_to_play = 0;
 }
 
 struct script_state* script_run_alloc(void)
 {
 	struct script_state* state = malloc(sizeof(struct script_state));
-	state->cursor_mac = 0;
+	state->program = 0;
+	state->pc = 0;
 	state->time_to_play = 0;
+	state->counter_map = 0;
+	state->counter_max = 0;
 	return state;
 }
 
 void script_run_free(struct script_state* state)
 {
+	if (!state)
+		return;
+	free(state->counter_map);
 	free(state);
 }
 
-/* Play a step of the script */
-static void script_run_step(struct script_state* state)
+int script_run_end(const struct script_state* state)
 {
-	struct script_cmd* cursor = script_run_cursor_get(state);
-	switch (cursor->type) {
-	case SCRIPT_CMD_EVALUATE:
-		script_run_exp(state);
-		break;
-	case SCRIPT_CMD_WAIT:
-		script_run_wait(state);
-		break;
-	case SCRIPT_CMD_DELAY:
-		script_run_delay(state);
-		break;
-	case SCRIPT_CMD_LOOP:
-		script_run_loop(state);
-		break;
-	case SCRIPT_CMD_INNER:
-		script_run_inner(state);
-		break;
-	case SCRIPT_CMD_WHILE:
-		script_run_while(state);
-		break;
-	case SCRIPT_CMD_IF:
-		script_run_if(state);
-		break;
-	case SCRIPT_CMD_REPEAT:
-		script_run_repeat(state);
-		break;
-	default:
-		assert(0);
-	}
+	return state->program == 0;
 }
 
-int script_run_end(const struct script_state* state)
+/* Get the numerical value of a register */
+static inline int script_reg_num(const struct script_value* r)
 {
-	return script_run_cursor_empty(state);
+	return r->type == SCRIPT_VALUE_NUM ? r->value.num : 0;
+}
+
+static inline void script_reg_set_num(struct script_value* r, int v)
+{
+	if (r->type == SCRIPT_VALUE_TEXT)
+		free(r->value.text);
+	r->type = SCRIPT_VALUE_NUM;
+	r->value.num = v;
+}
+
+/* Move an allocated value in a register */
+static inline void script_reg_set_value(struct script_value* r, struct script_value* v)
+{
+	if (r->type == SCRIPT_VALUE_TEXT)
+		free(r->value.text);
+	*r = *v;
+	free(v);
+}
+
+/* Move a register in an allocated value */
+static inline struct script_value* script_reg_get_value(struct script_value* r)
+{
+	struct script_value* v = malloc(sizeof(struct script_value));
+	*v = *r;
+	r->type = SCRIPT_VALUE_NUM;
+	r->value.num = 0;
+	return v;
+}
+
+static void script_reg_add(struct script_value* d, struct script_value* a, struct script_value* b)
+{
+	if (a->type == SCRIPT_VALUE_TEXT && b->type == SCRIPT_VALUE_TEXT) {
+		unsigned la = strlen(a->value.text);
+		unsigned lb = strlen(b->value.text);
+		char* s = malloc(la + lb + 1);
+
+		memcpy(s, a->value.text, la);
+		memcpy(s + la, b->value.text, lb);
+		s[la + lb] = 0;
+
+		script_reg_set_num(d, 0);
+		d->type = SCRIPT_VALUE_TEXT;
+		d->value.text = s;
+	} else {
+		script_reg_set_num(d, script_reg_num(a) + script_reg_num(b));
+	}
 }
 
 /* Play the script for the given time */
 void script_run(struct script_state* state, unsigned time_to_play)
 {
 	unsigned unit = SCRIPT_TIME_UNIT / SCRIPT_DELAY_UNIT;
+	struct script_value reg_map[SCRIPT_REG_MAX];
+	const struct script_code* code_map;
+	struct script_counter* counter;
+	unsigned pc;
+	unsigned i;
 
 	state->time_to_play += time_to_play;
-	while (!script_run_cursor_empty(state) && state->time_to_play > unit) {
-		script_run_step(state);
+
+	if (!state->program)
+		return;
+
+	for (i = 0; i < SCRIPT_REG_MAX; ++i)
+		reg_map[i].type = SCRIPT_VALUE_NUM;
+
+	code_map = state->program->code_map;
+	pc = state->pc;
+
+	while (1) {
+		const struct script_code* code = &code_map[pc];
+		struct script_value* d = &reg_map[code->d];
+		struct script_value* a = &reg_map[code->a];
+		struct script_value* b = &reg_map[code->b];
+
+		switch (code->op) {
+		case SCRIPT_OP_END:
+			state->program = 0;
+			goto out;
+		case SCRIPT_OP_TICK:
+			if (state->time_to_play <= unit)
+				goto out;
+			++pc;
+			break;
+		case SCRIPT_OP_JMP:
+			pc = code->arg;
+			break;
+		case SCRIPT_OP_JZ:
+			pc = script_reg_num(a) == 0 ? code->arg : pc + 1;
+			break;
+		case SCRIPT_OP_JNZ:
+			pc = script_reg_num(a) != 0 ? code->arg : pc + 1;
+			break;
+		case SCRIPT_OP_WAIT:
+			if (script_reg_num(a) != 0) {
+				++pc;
+			} else {
+				state->time_to_play = 0;
+				pc = code->arg;
+			}
+			break;
+		case SCRIPT_OP_JSET:
+			pc = state->counter_map[code->argextra.value].value_set ? code->arg : pc + 1;
+			break;
+		case SCRIPT_OP_CSET:
+			counter = &state->counter_map[code->argextra.value];
+			counter->value_set = 1;
+			counter->value = script_reg_num(a);
+			++pc;
+			break;
+		case SCRIPT_OP_DELAY:
+			counter = &state->counter_map[code->argextra.value];
+			if (state->time_to_play < counter->value * unit) {
+				counter->value -= state->time_to_play / unit;
+				state->time_to_play = state->time_to_play % unit;
+				goto out;
+			}
+			state->time_to_play -= counter->value * unit;
+			counter->value_set = 0;
+			++pc;
+			break;
+		case SCRIPT_OP_REPEAT:
+			counter = &state->counter_map[code->argextra.value];
+			if (counter->value) {
+				--counter->value;
+				++pc;
+			} else {
+				counter->value_set = 0;
+				pc = code->arg;
+			}
+			break;
+		case SCRIPT_OP_NUM:
+			script_reg_set_num(d, code->arg);
+			++pc;
+			break;
+		case SCRIPT_OP_TEXT:
+			script_reg_set_num(d, 0);
+			d->type = SCRIPT_VALUE_TEXT;
+			d->value.text = strdup(code->eval.text);
+			++pc;
+			break;
+		case SCRIPT_OP_F0:
+			script_reg_set_value(d, code->eval.f0(code->argextra));
+			++pc;
+			break;
+		case SCRIPT_OP_F1:
+			script_reg_set_value(d, code->eval.f1(script_reg_get_value(a), code->argextra));
+			++pc;
+			break;
+		case SCRIPT_OP_F2:
+			script_reg_set_value(d, code->eval.f2(script_reg_get_value(a), script_reg_get_value(b), code->argextra));
+			++pc;
+			break;
+		case SCRIPT_OP_NOT:
+			script_reg_set_num(d, ~script_reg_num(a));
+			++pc;
+			break;
+		case SCRIPT_OP_LNOT:
+			script_reg_set_num(d, !script_reg_num(a));
+			++pc;
+			break;
+		case SCRIPT_OP_BOOL:
+			script_reg_set_num(d, script_reg_num(a) != 0);
+			++pc;
+			break;
+		case SCRIPT_OP_ADD:
+			script_reg_add(d, a, b);
+			++pc;
+			break;
+		case SCRIPT_OP_SUB:
+			script_reg_set_num(d, script_reg_num(a) - script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_AND:
+			script_reg_set_num(d, script_reg_num(a) & script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_OR:
+			script_reg_set_num(d, script_reg_num(a) | script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_XOR:
+			script_reg_set_num(d, script_reg_num(a) ^ script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_L:
+			script_reg_set_num(d, script_reg_num(a) < script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_G:
+			script_reg_set_num(d, script_reg_num(a) > script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_E:
+			script_reg_set_num(d, script_reg_num(a) == script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_LE:
+			script_reg_set_num(d, script_reg_num(a) <= script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_GE:
+			script_reg_set_num(d, script_reg_num(a) >= script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_SL:
+			script_reg_set_num(d, script_reg_num(a) << script_reg_num(b));
+			++pc;
+			break;
+		case SCRIPT_OP_SR:
+			script_reg_set_num(d, script_reg_num(a) >> script_reg_num(b));
+			++pc;
+			break;
+		default:
+			assert(0);
+			state->program = 0;
+			goto out;
+		}
 	}
-}
 
+out:
+	state->pc = pc;
+
+	/* free the texts left in the registers */
+	for (i = 0; i < SCRIPT_REG_MAX; ++i)
+		if (reg_map[i].type == SCRIPT_VALUE_TEXT)
+			free(reg_map[i].value.text);
+}
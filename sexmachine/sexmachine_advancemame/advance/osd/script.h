@@ -169,6 +169,9 @@ struct script_exp {
 
 struct script_value* script_evaluate(const struct script_exp* exp);
 
+/* Evaluator of the constant symbols */
+struct script_value* script_constant_get(union script_arg_extra argextra);
+
 /* Symbol callback */
 script_exp_op1s_evaluator* script_symbol_check(const char* sym, union script_arg_extra* argextra);
 script_exp_op1f_evaluator* script_function1_check(const char* sym, union script_arg_extra* argextra);
@@ -266,15 +269,33 @@ struct script_cmd* script_cmd_make_op2se(const char* arg0, struct script_exp* ar
 struct script_cmd* script_cmd_make_op2cc(struct script_cmd* arg0, struct script_cmd* arg1);
 struct script_cmd* script_cmd_make_op3sec(const char* arg0, struct script_exp* arg1, struct script_cmd* arg2);
 
+/***************************************************************************/
+/* Program */
+
+/* Max number of registers used to evaluate an expression */
+#define SCRIPT_REG_MAX 32
+
+/* Script compiled to bytecode */
+struct script_program;
+
+struct script_program* script_compile(const struct script_cmd* script);
+void script_program_free(struct script_program* program);
+
 /***************************************************************************/
 /* State */
 
-#define SCRIPT_STATE_STACK_MAX 16
+/* Counter of a delay() or repeat() command */
+struct script_counter {
+	int value;
+	int value_set;
+};
 
 struct script_state {
-	struct script_cmd* cursor_map[SCRIPT_STATE_STACK_MAX];
-	unsigned cursor_mac;
+	const struct script_program* program; /* ==0 if ended */
+	unsigned pc; /* next instruction */
 	unsigned time_to_play;
+	struct script_counter* counter_map;
+	unsigned counter_max;
 };
 
 /* Port callback */
@@ -290,7 +311,7 @@ void script_free(struct script_cmd* script);
 
 struct script_state* script_run_alloc(void);
 void script_run_free(struct script_state* state);
-void script_run_restart(struct script_state* state, struct script_cmd* cmd);
+void script_run_restart(struct script_state* state, const struct script_program* program);
 int script_run_end(const struct script_state* state);
 
 /* Unit time (1 second) for the idle call */
@@ -49,6 +49,18 @@
 
 #include <pthread.h>
 
+/** Max number of threads for osd_parallelize_jobs and osd_parallelize_frame. */
+#define THREAD_JOBS_MAX 8
+
+/** Jobs shared by the threads of osd_parallelize_jobs. */
+struct thread_jobs {
+	pthread_mutex_t mutex; /**< Access mutex. */
+	void (*func)(void*, int); /**< Function to call. */
+	void* arg; /**< Argument of the function to call. */
+	int next; /**< Next job to start. */
+	int count; /**< Number of jobs. */
+};
+
 static int thread_exit; /**< Thread exit requested. */
 static pthread_t thread_id; /**< ID of the companion thread. */
 static int thread_inuse; /**< Reentrant check. */
@@ -57,6 +69,21 @@ static pthread_mutex_t thread_mutex; /**< Access mutex. */
 static void (*thread_func)(void*, int, int); /**< Function to call. */
 static void* thread_arg; /**< Argument of the function to call. */
 
+static pthread_t pool_map[THREAD_JOBS_MAX]; /**< Threads of osd_parallelize_frame. */
+static int pool_max; /**< Number of threads in the pool. */
+static int pool_created; /**< If the pool creation was already tried. */
+static int pool_exit; /**< Pool exit requested. */
+static int pool_inuse; /**< Reentrant check. */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER; /**< Access mutex. */
+static pthread_cond_t pool_start_cond = PTHREAD_COND_INITIALIZER; /**< Start condition. */
+static pthread_cond_t pool_stop_cond = PTHREAD_COND_INITIALIZER; /**< Stop condition. */
+static unsigned pool_generation; /**< Counter of the sets of jobs started. */
+static int pool_running; /**< Threads of the pool still running the current set. */
+static void (*pool_func)(void*, int); /**< Function to call. */
+static void* pool_arg; /**< Argument of the function to call. */
+static int pool_next; /**< Next job to start. */
+static int pool_count; /**< Number of jobs. */
+
 static void* thread_proc(void* arg)
 {
 	pthread_mutex_lock(&thread_mutex);
@@ -106,9 +133,13 @@ int thread_init(void)
 	return 0;
 }
 
+static void pool_done(void);
+
 /** Deinitialize the thread system. */
 void thread_done(void)
 {
+	pool_done();
+
 	pthread_mutex_lock(&thread_mutex);
 	thread_exit = 1;
 	pthread_cond_signal(&thread_cond);
@@ -120,6 +151,263 @@ void thread_done(void)
 	pthread_cond_destroy(&thread_cond);
 }
 
+static void* thread_jobs_proc(void* arg)
+{
+	struct thread_jobs* jobs = arg;
+
+	while (1) {
+		int job;
+
+		/* get the next job */
+		pthread_mutex_lock(&jobs->mutex);
+		job = jobs->next < jobs->count ? jobs->next++ : -1;
+		pthread_mutex_unlock(&jobs->mutex);
+
+		if (job < 0)
+			break;
+
+		jobs->func(jobs->arg, job);
+	}
+
+	return 0;
+}
+
+/**
+ * Run a set of independent jobs on all the processors.
+ * The threads are created at every call, so it should be used only
+ * for long jobs, like the ROM loading.
+ * It isn't related to the main SMP flag because it doesn't run in parallel
+ * with the emulation.
+ */
+void osd_parallelize_jobs(void (*func)(void* arg, int job), void* arg, int count)
+{
+	pthread_t thread_map[THREAD_JOBS_MAX];
+	struct thread_jobs jobs;
+	int thread_max;
+	int i;
+
+	thread_max = 2;
+#ifdef _SC_NPROCESSORS_ONLN
+	thread_max = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (thread_max > THREAD_JOBS_MAX)
+		thread_max = THREAD_JOBS_MAX;
+	if (thread_max > count)
+		thread_max = count;
+
+	if (thread_max <= 1 || pthread_mutex_init(&jobs.mutex, NULL) != 0) {
+		for (i = 0; i < count; ++i)
+			func(arg, i);
+		return;
+	}
+
+	jobs.func = func;
+	jobs.arg = arg;
+	jobs.next = 0;
+	jobs.count = count;
+
+	/* the current thread is one of the workers */
+	for (i = 0; i < thread_max - 1; ++i)
+		if (pthread_create(&thread_map[i], NULL, thread_jobs_proc, &jobs) != 0)
+			break;
+	thread_max = i;
+
+	thread_jobs_proc(&jobs);
+
+	for (i = 0; i < thread_max; ++i)
+		pthread_join(thread_map[i], NULL);
+
+	pthread_mutex_destroy(&jobs.mutex);
+}
+
+/**
+ * Run the jobs of the current set not yet started.
+ * It's called with the pool mutex locked.
+ */
+static void pool_run(void)
+{
+	while (pool_next < pool_count) {
+		int job = pool_next++;
+
+		pthread_mutex_unlock(&pool_mutex);
+		pool_func(pool_arg, job);
+		pthread_mutex_lock(&pool_mutex);
+	}
+}
+
+static void* pool_proc(void* arg)
+{
+	unsigned generation = 0;
+
+	pthread_mutex_lock(&pool_mutex);
+
+	while (1) {
+		/* wait for a new set of jobs */
+		while (generation == pool_generation && !pool_exit)
+			pthread_cond_wait(&pool_start_cond, &pool_mutex);
+
+		if (pool_exit)
+			break;
+
+		generation = pool_generation;
+
+		pool_run();
+
+		/* the caller waits for all the threads, so no set can be missed */
+		if (--pool_running == 0)
+			pthread_cond_signal(&pool_stop_cond);
+	}
+
+	pthread_mutex_unlock(&pool_mutex);
+
+	return 0;
+}
+
+static void pool_init(void)
+{
+	int thread_max;
+	int i;
+
+	pool_created = 1;
+	pool_exit = 0;
+
+	thread_max = 2;
+#ifdef _SC_NPROCESSORS_ONLN
+	thread_max = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (thread_max > THREAD_JOBS_MAX)
+		thread_max = THREAD_JOBS_MAX;
+
+	/* the calling thread is one of the workers */
+	for (i = 0; i < thread_max - 1; ++i)
+		if (pthread_create(&pool_map[i], NULL, pool_proc, 0) != 0)
+			break;
+	pool_max = i;
+}
+
+static void pool_done(void)
+{
+	int i;
+
+	if (pool_max) {
+		pthread_mutex_lock(&pool_mutex);
+		pool_exit = 1;
+		pthread_cond_broadcast(&pool_start_cond);
+		pthread_mutex_unlock(&pool_mutex);
+
+		for (i = 0; i < pool_max; ++i)
+			pthread_join(pool_map[i], NULL);
+	}
+
+	pool_max = 0;
+	pool_created = 0;
+}
+
+/**
+ * Run a set of independent jobs on all the processors.
+ * Like osd_parallelize_jobs, but the threads are created at the first call
+ * and then kept waiting, so it can be used for the short jobs done at
+ * every frame.
+ * It doesn't support reentrant calls, the jobs of a nested call are run
+ * in the current thread.
+ */
+void osd_parallelize_frame(void (*func)(void* arg, int job), void* arg, int count)
+{
+	int i;
+
+	if (!pool_created)
+		pool_init();
+
+	if (pool_max == 0 || pool_inuse || count <= 1) {
+		for (i = 0; i < count; ++i)
+			func(arg, i);
+		return;
+	}
+
+	pool_inuse = 1;
+
+	pthread_mutex_lock(&pool_mutex);
+
+	pool_func = func;
+	pool_arg = arg;
+	pool_next = 0;
+	pool_count = count;
+	pool_running = pool_max;
+	++pool_generation;
+	pthread_cond_broadcast(&pool_start_cond);
+
+	/* the current thread is one of the workers */
+	pool_run();
+
+	while (pool_running)
+		pthread_cond_wait(&pool_stop_cond, &pool_mutex);
+
+	pthread_mutex_unlock(&pool_mutex);
+
+	pool_inuse = 0;
+}
+
+/** Function started by osd_async_begin. */
+struct thread_async {
+	pthread_t id; /**< Thread running the function. */
+	void (*func)(void*); /**< Function to call. */
+	void* arg; /**< Argument of the function to call. */
+};
+
+static void* thread_async_proc(void* arg)
+{
+	struct thread_async* async = arg;
+
+	async->func(async->arg);
+
+	return 0;
+}
+
+/**
+ * Start a function in a new thread.
+ * Like osd_parallelize_jobs it isn't related to the main SMP flag,
+ * the function must access only data not used by the caller
+ * until osd_async_end is called.
+ * \return The handle for osd_async_end, or 0 if the function was
+ * already called in the current thread.
+ */
+void* osd_async_begin(void (*func)(void* arg), void* arg)
+{
+	struct thread_async* async;
+
+	async = malloc(sizeof(struct thread_async));
+	if (!async) {
+		func(arg);
+		return 0;
+	}
+
+	async->func = func;
+	async->arg = arg;
+
+	if (pthread_create(&async->id, NULL, thread_async_proc, async) != 0) {
+		free(async);
+		func(arg);
+		return 0;
+	}
+
+	return async;
+}
+
+/**
+ * Wait the end of a function started with osd_async_begin.
+ */
+void osd_async_end(void* handle)
+{
+	struct thread_async* async = handle;
+
+	if (!async)
+		return;
+
+	pthread_join(async->id, NULL);
+
+	free(async);
+}
+
 void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max)
 {
 	if (!thread_is_active()) {
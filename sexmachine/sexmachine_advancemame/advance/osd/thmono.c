@@ -37,6 +37,32 @@ void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int m
 	func(arg, 0, 1);
 }
 
+void osd_parallelize_jobs(void (*func)(void* arg, int job), void* arg, int count)
+{
+	int i;
+
+	for (i = 0; i < count; ++i)
+		func(arg, i);
+}
+
+void osd_parallelize_frame(void (*func)(void* arg, int job), void* arg, int count)
+{
+	int i;
+
+	for (i = 0; i < count; ++i)
+		func(arg, i);
+}
+
+void* osd_async_begin(void (*func)(void* arg), void* arg)
+{
+	func(arg);
+	return 0;
+}
+
+void osd_async_end(void* handle)
+{
+}
+
 int thread_init(void)
 {
 	return 0;
@@ -46,6 +46,80 @@ static inline adv_bool ui_alpha(adv_color_def color_def)
 	return color_def_type_get(color_def) == adv_color_type_rgb;
 }
 
+/**
+ * Free all the cached font strips.
+ */
+static void ui_glyph_reset(struct advance_ui_context* context)
+{
+	unsigned i;
+
+	for (i = 0; i < UI_GLYPH_MAX; ++i) {
+		adv_font_strip_free(context->state.glyph_map[i].strip);
+		context->state.glyph_map[i].strip = 0;
+	}
+
+	context->state.glyph_next = 0;
+}
+
+/**
+ * Get the font strip of the user interface font with the specified colors.
+ * \param map Alpha map of the text, or 0 for a two colors text.
+ * \param front, back Colors of a two colors text.
+ * \return The font strip, or 0 on error.
+ */
+static adv_font_strip* ui_glyph_get(struct advance_ui_context* context, unsigned bytes_per_pixel, const adv_pixel* map, adv_pixel front, adv_pixel back)
+{
+	struct ui_glyph* glyph;
+	adv_pixel two_map[256];
+	unsigned i;
+
+	for (i = 0; i < UI_GLYPH_MAX; ++i) {
+		glyph = &context->state.glyph_map[i];
+		if (glyph->strip
+			&& glyph->bytes_per_pixel == bytes_per_pixel
+			&& glyph->map == map
+			&& (map != 0 || (glyph->front == front && glyph->back == back)))
+			return glyph->strip;
+	}
+
+	/* replace the oldest */
+	glyph = &context->state.glyph_map[context->state.glyph_next];
+	context->state.glyph_next = (context->state.glyph_next + 1) % UI_GLYPH_MAX;
+
+	adv_font_strip_free(glyph->strip);
+
+	if (!map) {
+		/* same threshold of adv_font_put_char() */
+		for (i = 0; i < 256; ++i)
+			two_map[i] = i >= 64 ? front : back;
+	}
+
+	glyph->strip = adv_font_strip_alloc(context->state.ui_font, bytes_per_pixel, map ? map : two_map);
+	glyph->bytes_per_pixel = bytes_per_pixel;
+	glyph->map = map;
+	glyph->front = front;
+	glyph->back = back;
+
+	return glyph->strip;
+}
+
+static void ui_text_put(struct advance_ui_context* context, adv_bitmap* dst, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
+{
+	adv_font_strip* strip;
+
+	if (ui_alpha(def))
+		strip = ui_glyph_get(context, dst->bytes_per_pixel, map, 0, 0);
+	else
+		strip = ui_glyph_get(context, dst->bytes_per_pixel, 0, cf.p, cb.p);
+
+	if (strip)
+		adv_font_put_string_strip(strip, dst, x, y, begin, end);
+	else if (ui_alpha(def))
+		adv_font_put_string_map(context->state.ui_font, dst, x, y, begin, end, map);
+	else
+		adv_font_put_string(context->state.ui_font, dst, x, y, begin, end, cf.p, cb.p);
+}
+
 static void ui_text_center(struct advance_ui_context* context, adv_bitmap* dst, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
 {
 	int size_x;
@@ -56,10 +130,7 @@ static void ui_text_center(struct advance_ui_context* context, adv_bitmap* dst,
 	pos_x = x - size_x / 2;
 	pos_y = y;
 
-	if (ui_alpha(def))
-		adv_font_put_string_map(context->state.ui_font, dst, pos_x, pos_y, begin, end, map);
-	else
-		adv_font_put_string(context->state.ui_font, dst, pos_x, pos_y, begin, end, cf.p, cb.p);
+	ui_text_put(context, dst, pos_x, pos_y, begin, end, cf, cb, map, def);
 }
 
 static void ui_text_left(struct advance_ui_context* context, adv_bitmap* dst, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
@@ -69,10 +140,7 @@ static void ui_text_left(struct advance_ui_context* context, adv_bitmap* dst, in
 	pos_x = x;
 	pos_y = y;
 
-	if (ui_alpha(def))
-		adv_font_put_string_map(context->state.ui_font, dst, pos_x, pos_y, begin, end, map);
-	else
-		adv_font_put_string(context->state.ui_font, dst, pos_x, pos_y, begin, end, cf.p, cb.p);
+	ui_text_put(context, dst, pos_x, pos_y, begin, end, cf, cb, map, def);
 }
 
 static void ui_text_right(struct advance_ui_context* context, adv_bitmap* dst, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
@@ -85,10 +153,125 @@ static void ui_text_right(struct advance_ui_context* context, adv_bitmap* dst, i
 	pos_x = x - size_x;
 	pos_y = y;
 
+	ui_text_put(context, dst, pos_x, pos_y, begin, end, cf, cb, map, def);
+}
+
+/**
+ * Free the cached image of all the overlays.
+ */
+static void ui_overlay_reset(struct advance_ui_context* context)
+{
+	unsigned i;
+
+	for (i = 0; i < UI_OVERLAY_MAX; ++i) {
+		struct ui_overlay* overlay = &context->state.overlay_map[i];
+		if (overlay->flat) {
+			adv_bitmap_free(overlay->flat);
+			overlay->flat = 0;
+		}
+	}
+}
+
+/**
+ * Add some data to the content of the current frame of an overlay.
+ */
+static void ui_overlay_key(struct ui_overlay* overlay, const void* data, unsigned size)
+{
+	if (overlay->next_mac + size > overlay->next_max) {
+		overlay->next_max = (overlay->next_mac + size) * 2;
+		overlay->next_map = realloc(overlay->next_map, overlay->next_max);
+	}
+
+	memcpy(overlay->next_map + overlay->next_mac, data, size);
+	overlay->next_mac += size;
+}
+
+static void ui_overlay_key_string(struct ui_overlay* overlay, const char* begin, const char* end)
+{
+	unsigned size = end - begin;
+
+	ui_overlay_key(overlay, &size, sizeof(size));
+	ui_overlay_key(overlay, begin, size);
+}
+
+static void ui_overlay_key_color(struct ui_overlay* overlay, struct ui_color color)
+{
+	ui_overlay_key(overlay, &color.p, sizeof(color.p));
+	ui_overlay_key(overlay, &color.f, sizeof(color.f));
+	ui_overlay_key(overlay, &color.b, sizeof(color.b));
+}
+
+/**
+ * Start the content of the current frame of an overlay.
+ */
+static void ui_overlay_begin(struct ui_overlay* overlay, adv_bitmap* dst, adv_color_def def)
+{
+	overlay->next_mac = 0;
+
+	ui_overlay_key(overlay, &dst->size_x, sizeof(dst->size_x));
+	ui_overlay_key(overlay, &dst->size_y, sizeof(dst->size_y));
+	ui_overlay_key(overlay, &def, sizeof(def));
+}
+
+/**
+ * Check if the cached image of an overlay is still valid.
+ * If the content of the current frame is changed the cached image is discarded.
+ * \return If the cached image can be used.
+ */
+static adv_bool ui_overlay_check(struct advance_ui_context* context, struct ui_overlay* overlay)
+{
+	unsigned char* map;
+	unsigned max;
+
+	if (overlay->flat
+		&& overlay->key_mac == overlay->next_mac
+		&& memcmp(overlay->key_map, overlay->next_map, overlay->next_mac) == 0) {
+		++context->state.overlay_copy_counter;
+		return 1;
+	}
+
+	++context->state.overlay_render_counter;
+
+	if (overlay->flat) {
+		adv_bitmap_free(overlay->flat);
+		overlay->flat = 0;
+	}
+
+	/* the current content becomes the key of the image */
+	map = overlay->key_map;
+	max = overlay->key_max;
+	overlay->key_map = overlay->next_map;
+	overlay->key_max = overlay->next_max;
+	overlay->key_mac = overlay->next_mac;
+	overlay->next_map = map;
+	overlay->next_max = max;
+	overlay->next_mac = 0;
+
+	return 0;
+}
+
+/**
+ * Set the rendered image of an overlay.
+ * The bitmap is owned by the overlay.
+ */
+static void ui_overlay_set(struct ui_overlay* overlay, adv_bitmap* flat, int pos_x, int pos_y)
+{
+	overlay->flat = flat;
+	overlay->pos_x = pos_x;
+	overlay->pos_y = pos_y;
+}
+
+/**
+ * Draw the image of an overlay.
+ */
+static void ui_overlay_put(struct advance_ui_context* context, adv_bitmap* dst, struct ui_overlay* overlay, adv_color_def def)
+{
+	adv_bitmap* flat = overlay->flat;
+
 	if (ui_alpha(def))
-		adv_font_put_string_map(context->state.ui_font, dst, pos_x, pos_y, begin, end, map);
+		adv_bitmap_put_alpha(dst, overlay->pos_x, overlay->pos_y, def, flat, 0, 0, flat->size_x, flat->size_y, context->state.buffer_def);
 	else
-		adv_font_put_string(context->state.ui_font, dst, pos_x, pos_y, begin, end, cf.p, cb.p);
+		adv_bitmap_put(dst, overlay->pos_x, overlay->pos_y, flat, 0, 0, flat->size_x, flat->size_y);
 }
 
 static void ui_dft(struct advance_ui_context* context, adv_bitmap* dst, unsigned x, unsigned y, unsigned dx, unsigned dy, double* m, unsigned n, double cut1, double cut2, struct ui_color cf, struct ui_color cb, struct ui_color ct, adv_color_def def)
@@ -143,7 +326,7 @@ static void ui_dft(struct advance_ui_context* context, adv_bitmap* dst, unsigned
 	adv_bitmap_clear(dst, x, y + dy * 3 / 4, dx, 1, ct.f);
 }
 
-static void ui_menu(struct advance_ui_context* context, adv_bitmap* dst, struct ui_menu_entry* menu_map, unsigned menu_mac, int menu_sel, struct ui_color entry_f, struct ui_color entry_b, adv_pixel* entry_map, struct ui_color select_f, struct ui_color select_b, adv_pixel* select_map, struct ui_color title_f, struct ui_color title_b, adv_pixel* title_map, adv_color_def def)
+static void ui_menu(struct advance_ui_context* context, adv_bitmap* dst, struct ui_overlay* overlay, struct ui_menu_entry* menu_map, unsigned menu_mac, int menu_sel, struct ui_color entry_f, struct ui_color entry_b, adv_pixel* entry_map, struct ui_color select_f, struct ui_color select_b, adv_pixel* select_map, struct ui_color title_f, struct ui_color title_b, adv_pixel* title_map, adv_color_def def)
 {
 	int step_x, step_y;
 	int border_x, border_y;
@@ -160,6 +343,35 @@ static void ui_menu(struct advance_ui_context* context, adv_bitmap* dst, struct
 	int down;
 	adv_bitmap* flat;
 
+	ui_overlay_begin(overlay, dst, def);
+	ui_overlay_key(overlay, &menu_mac, sizeof(menu_mac));
+	ui_overlay_key(overlay, &menu_sel, sizeof(menu_sel));
+	for (i = 0; i < menu_mac; ++i) {
+		struct ui_menu_entry* e = &menu_map[i];
+		ui_overlay_key(overlay, &e->type, sizeof(e->type));
+		if (e->type == ui_menu_dft) {
+			ui_overlay_key(overlay, &e->n, sizeof(e->n));
+			ui_overlay_key(overlay, e->m, e->n * sizeof(e->m[0]));
+			ui_overlay_key(overlay, &e->cut1, sizeof(e->cut1));
+			ui_overlay_key(overlay, &e->cut2, sizeof(e->cut2));
+		} else {
+			ui_overlay_key_string(overlay, e->text_buffer, e->text_buffer + strlen(e->text_buffer));
+			if (e->type == ui_menu_option)
+				ui_overlay_key_string(overlay, e->option_buffer, e->option_buffer + strlen(e->option_buffer));
+		}
+	}
+	ui_overlay_key_color(overlay, entry_f);
+	ui_overlay_key_color(overlay, entry_b);
+	ui_overlay_key_color(overlay, select_f);
+	ui_overlay_key_color(overlay, select_b);
+	ui_overlay_key_color(overlay, title_f);
+	ui_overlay_key_color(overlay, title_b);
+
+	if (ui_overlay_check(context, overlay)) {
+		ui_overlay_put(context, dst, overlay, def);
+		return;
+	}
+
 	step_x = adv_font_sizex(context->state.ui_font);
 	step_y = adv_font_sizey(context->state.ui_font);
 
@@ -338,12 +550,8 @@ static void ui_menu(struct advance_ui_context* context, adv_bitmap* dst, struct
 		y += height;
 	}
 
-	if (ui_alpha(def))
-		adv_bitmap_put_alpha(dst, pos_x, pos_y, def, flat, 0, 0, flat->size_x, flat->size_y, context->state.buffer_def);
-	else
-		adv_bitmap_put(dst, pos_x, pos_y, flat, 0, 0, flat->size_x, flat->size_y);
-
-	adv_bitmap_free(flat);
+	ui_overlay_set(overlay, flat, pos_x, pos_y);
+	ui_overlay_put(context, dst, overlay, def);
 }
 
 static adv_bool ui_recognize_title(const char* begin, const char* end)
@@ -371,7 +579,7 @@ static adv_bool ui_recognize_title(const char* begin, const char* end)
 	return 0;
 }
 
-static void ui_scroll(struct advance_ui_context* context, adv_bitmap* dst, char* begin, char* end, unsigned pos, struct ui_color text_f, struct ui_color text_b, adv_pixel* text_map, struct ui_color title_f, struct ui_color title_b, adv_pixel* title_map, adv_color_def def)
+static void ui_scroll(struct advance_ui_context* context, adv_bitmap* dst, struct ui_overlay* overlay, char* begin, char* end, unsigned pos, struct ui_color text_f, struct ui_color text_b, adv_pixel* text_map, struct ui_color title_f, struct ui_color title_b, adv_pixel* title_map, adv_color_def def)
 {
 	unsigned size_r;
 	unsigned size_v;
@@ -385,6 +593,19 @@ static void ui_scroll(struct advance_ui_context* context, adv_bitmap* dst, char*
 	unsigned n;
 	adv_bitmap* flat;
 
+	ui_overlay_begin(overlay, dst, def);
+	ui_overlay_key_string(overlay, begin, end);
+	ui_overlay_key(overlay, &pos, sizeof(pos));
+	ui_overlay_key_color(overlay, text_f);
+	ui_overlay_key_color(overlay, text_b);
+	ui_overlay_key_color(overlay, title_f);
+	ui_overlay_key_color(overlay, title_b);
+
+	if (ui_overlay_check(context, overlay)) {
+		ui_overlay_put(context, dst, overlay, def);
+		return;
+	}
+
 	step_x = adv_font_sizex(context->state.ui_font);
 	step_y = adv_font_sizey(context->state.ui_font);
 
@@ -507,21 +728,29 @@ static void ui_scroll(struct advance_ui_context* context, adv_bitmap* dst, char*
 		++n;
 	}
 
-	if (ui_alpha(def))
-		adv_bitmap_put_alpha(dst, pos_x, pos_y, def, flat, 0, 0, flat->size_x, flat->size_y, context->state.buffer_def);
-	else
-		adv_bitmap_put(dst, pos_x, pos_y, flat, 0, 0, flat->size_x, flat->size_y);
-
-	adv_bitmap_free(flat);
+	ui_overlay_set(overlay, flat, pos_x, pos_y);
+	ui_overlay_put(context, dst, overlay, def);
 }
 
-static void ui_messagebox_center(struct advance_ui_context* context, adv_bitmap* dst, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
+static void ui_messagebox_center(struct advance_ui_context* context, adv_bitmap* dst, struct ui_overlay* overlay, int x, int y, const char* begin, const char* end, struct ui_color cf, struct ui_color cb, adv_pixel* map, adv_color_def def)
 {
 	int border_x, border_y;
 	int size_x, size_y;
 	int pos_x, pos_y;
 	adv_bitmap* flat;
 
+	ui_overlay_begin(overlay, dst, def);
+	ui_overlay_key_string(overlay, begin, end);
+	ui_overlay_key(overlay, &x, sizeof(x));
+	ui_overlay_key(overlay, &y, sizeof(y));
+	ui_overlay_key_color(overlay, cf);
+	ui_overlay_key_color(overlay, cb);
+
+	if (ui_overlay_check(context, overlay)) {
+		ui_overlay_put(context, dst, overlay, def);
+		return;
+	}
+
 	border_x = adv_font_sizex(context->state.ui_font);
 	border_y = adv_font_sizey(context->state.ui_font) / 2;
 
@@ -541,17 +770,10 @@ static void ui_messagebox_center(struct advance_ui_context* context, adv_bitmap*
 	adv_bitmap_box(flat, 0, 0, size_x, size_y, 1, cf.f);
 	adv_bitmap_clear(flat, 1, 1, size_x - 2, size_y - 2, cb.b);
 
-	if (ui_alpha(def))
-		adv_font_put_string_map(context->state.ui_font, flat, border_x, border_y, begin, end, map);
-	else
-		adv_font_put_string(context->state.ui_font, flat, border_x, border_y, begin, end, cf.p, cb.p);
-
-	if (ui_alpha(def))
-		adv_bitmap_put_alpha(dst, pos_x, pos_y, def, flat, 0, 0, flat->size_x, flat->size_y, context->state.buffer_def);
-	else
-		adv_bitmap_put(dst, pos_x, pos_y, flat, 0, 0, flat->size_x, flat->size_y);
+	ui_text_put(context, flat, border_x, border_y, begin, end, cf, cb, map, def);
 
-	adv_bitmap_free(flat);
+	ui_overlay_set(overlay, flat, pos_x, pos_y);
+	ui_overlay_put(context, dst, overlay, def);
 }
 
 /**************************************************************************/
@@ -785,7 +1007,7 @@ static void ui_message_update(struct advance_ui_context* context, adv_bitmap* ds
 		context->state.ui_message_flag = 0;
 	}
 
-	ui_messagebox_center(context, dst, dst->size_x / 2, dst->size_y / 2, context->state.ui_message_buffer, context->state.ui_message_buffer + strlen(context->state.ui_message_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
+	ui_messagebox_center(context, dst, &context->state.overlay_map[UI_OVERLAY_MESSAGE], dst->size_x / 2, dst->size_y / 2, context->state.ui_message_buffer, context->state.ui_message_buffer + strlen(context->state.ui_message_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
 }
 
 #define UI_MAP_MAX 256
@@ -820,6 +1042,7 @@ static void ui_help_update(struct advance_ui_context* context, adv_bitmap* dst,
 	char msg_buffer[256];
 	adv_bitmap* flat;
 	adv_color_def def = color->def;
+	struct ui_overlay* overlay = &context->state.overlay_map[UI_OVERLAY_HELP];
 
 	struct mame_digital_map_entry digital_map[UI_MAP_MAX];
 	unsigned digital_mac;
@@ -832,22 +1055,38 @@ static void ui_help_update(struct advance_ui_context* context, adv_bitmap* dst,
 	pos_x = dst->size_x / 2 - size_x / 2;
 	pos_y = dst->size_y / 8;
 
-	if (ui_alpha(def))
-		flat = adv_bitmap_alloc(size_x, size_y, color_def_bytes_per_pixel_get(context->state.buffer_def));
-	else
-		flat = adv_bitmap_alloc(size_x, size_y, color_def_bytes_per_pixel_get(def));
-
 	pb = 0; /* black on RGB format */
 
-	for (cy = 0; cy < context->state.help_image->size_y; ++cy) {
-		for (cx = 0; cx < context->state.help_image->size_x; ++cx) {
-			adv_pixel c;
-			if ((adv_bitmap_pixel_get(context->state.help_image, cx, cy)) != pb) {
-				c = color->ui_f.f;
-			} else {
-				c = color->ui_b.b;
+	ui_overlay_begin(overlay, dst, def);
+	ui_overlay_key(overlay, &digital_mac, sizeof(digital_mac));
+	ui_overlay_key(overlay, digital_map, digital_mac * sizeof(digital_map[0]));
+	ui_overlay_key_color(overlay, color->ui_f);
+	ui_overlay_key_color(overlay, color->ui_b);
+	ui_overlay_key_color(overlay, color->help_p1);
+	ui_overlay_key_color(overlay, color->help_p2);
+	ui_overlay_key_color(overlay, color->help_p3);
+	ui_overlay_key_color(overlay, color->help_p4);
+	ui_overlay_key_color(overlay, color->help_u);
+
+	if (ui_overlay_check(context, overlay)) {
+		/* only the message has to be computed */
+		flat = 0;
+	} else {
+		if (ui_alpha(def))
+			flat = adv_bitmap_alloc(size_x, size_y, color_def_bytes_per_pixel_get(context->state.buffer_def));
+		else
+			flat = adv_bitmap_alloc(size_x, size_y, color_def_bytes_per_pixel_get(def));
+
+		for (cy = 0; cy < context->state.help_image->size_y; ++cy) {
+			for (cx = 0; cx < context->state.help_image->size_x; ++cx) {
+				adv_pixel c;
+				if ((adv_bitmap_pixel_get(context->state.help_image, cx, cy)) != pb) {
+					c = color->ui_f.f;
+				} else {
+					c = color->ui_b.b;
+				}
+				adv_bitmap_pixel_put(flat, cx, cy, c);
 			}
-			adv_bitmap_pixel_put(flat, cx, cy, c);
 		}
 	}
 
@@ -879,7 +1118,7 @@ static void ui_help_update(struct advance_ui_context* context, adv_bitmap* dst,
 		}
 
 		for (j = 0; j < MAME_INPUT_MAP_MAX && digital_map[i].seq[j] != DIGITAL_SPECIAL_NONE; ++j) {
-			if (!pred_not) {
+			if (flat && !pred_not) {
 				unsigned k;
 				unsigned ckf;
 				unsigned ckb;
@@ -910,20 +1149,17 @@ static void ui_help_update(struct advance_ui_context* context, adv_bitmap* dst,
 		}
 	}
 
-	if (ui_alpha(def))
-		adv_bitmap_put_alpha(dst, pos_x, pos_y, def, flat, 0, 0, flat->size_x, flat->size_y, context->state.buffer_def);
-	else
-		adv_bitmap_put(dst, pos_x, pos_y, flat, 0, 0, flat->size_x, flat->size_y);
-
-	adv_bitmap_free(flat);
+	if (flat)
+		ui_overlay_set(overlay, flat, pos_x, pos_y);
+	ui_overlay_put(context, dst, overlay, def);
 
 	if (msg_buffer[0])
-		ui_messagebox_center(context, dst, dst->size_x / 2, pos_y + size_y + adv_font_sizey(context->state.ui_font) * 2, msg_buffer, msg_buffer + strlen(msg_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
+		ui_messagebox_center(context, dst, &context->state.overlay_map[UI_OVERLAY_HELP_MESSAGE], dst->size_x / 2, pos_y + size_y + adv_font_sizey(context->state.ui_font) * 2, msg_buffer, msg_buffer + strlen(msg_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
 }
 
 static void ui_menu_update(struct advance_ui_context* context, adv_bitmap* dst, struct ui_color_set* color)
 {
-	ui_menu(context, dst, context->state.ui_menu_map, context->state.ui_menu_mac, context->state.ui_menu_sel, color->ui_f, color->ui_b, color->ui_alpha, color->select_f, color->select_b, color->select_alpha, color->title_f, color->title_b, color->title_alpha, color->def);
+	ui_menu(context, dst, &context->state.overlay_map[UI_OVERLAY_MENU], context->state.ui_menu_map, context->state.ui_menu_mac, context->state.ui_menu_sel, color->ui_f, color->ui_b, color->ui_alpha, color->select_f, color->select_b, color->select_alpha, color->title_f, color->title_b, color->title_alpha, color->def);
 
 	free(context->state.ui_menu_map);
 	context->state.ui_menu_map = 0;
@@ -937,14 +1173,14 @@ static void ui_osd_update(struct advance_ui_context* context, adv_bitmap* dst, s
 	pos_x = dst->size_x / 2;
 	pos_y = dst->size_y * 7 / 8;
 
-	ui_messagebox_center(context, dst, pos_x, pos_y, context->state.ui_osd_buffer, context->state.ui_osd_buffer + strlen(context->state.ui_osd_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
+	ui_messagebox_center(context, dst, &context->state.overlay_map[UI_OVERLAY_OSD], pos_x, pos_y, context->state.ui_osd_buffer, context->state.ui_osd_buffer + strlen(context->state.ui_osd_buffer), color->ui_f, color->ui_b, color->ui_alpha, color->def);
 
 	context->state.ui_osd_flag = 0;
 }
 
 static void ui_scroll_update(struct advance_ui_context* context, adv_bitmap* dst, struct ui_color_set* color)
 {
-	ui_scroll(context, dst, context->state.ui_scroll_begin, context->state.ui_scroll_end, context->state.ui_scroll_pos, color->ui_f, color->ui_b, color->ui_alpha, color->title_f, color->title_b, color->title_alpha, color->def);
+	ui_scroll(context, dst, &context->state.overlay_map[UI_OVERLAY_SCROLL], context->state.ui_scroll_begin, context->state.ui_scroll_end, context->state.ui_scroll_pos, color->ui_f, color->ui_b, color->ui_alpha, color->title_f, color->title_b, color->title_alpha, color->def);
 
 	context->state.ui_scroll_flag = 0;
 }
@@ -1148,6 +1384,9 @@ static void ui_setup_color(struct advance_ui_context* context, struct ui_color_s
 	case adv_color_type_rgb:
 	case adv_color_type_yuy2:
 		if (color->def != color_def) {
+			/* the strips use the alpha maps */
+			if (color == &context->state.color_map)
+				ui_glyph_reset(context);
 			ui_color_alpha_set(color->ui_alpha, &map[UI_COLOR_INTERFACE_F], &map[UI_COLOR_INTERFACE_B], buffer_def, translucency);
 			ui_color_alpha_set(color->title_alpha, &map[UI_COLOR_TAG_F], &map[UI_COLOR_TAG_B], buffer_def, translucency);
 			ui_color_alpha_set(color->select_alpha, &map[UI_COLOR_SELECT_F], &map[UI_COLOR_SELECT_B], buffer_def, translucency);
@@ -1223,22 +1462,22 @@ void advance_ui_buffer_update(struct advance_ui_context* context, void* ptr, uns
 void advance_ui_direct_update(struct advance_ui_context* context, void* ptr, unsigned dx, unsigned dy, unsigned dw, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max)
 {
 	adv_bitmap* dst;
-	struct ui_color_set color;
+	struct ui_color_set* color = &context->state.direct_color_map;
 
-	ui_setup_color(context, &color, color_def, palette_map, palette_max);
+	ui_setup_color(context, color, color_def, palette_map, palette_max);
 
 	dst = adv_bitmap_import_rgb(dx, dy, color_def_bytes_per_pixel_get(color_def), 0, 0, ptr, dw);
 
 	if (context->state.ui_direct_slow_flag) {
-		ui_direct_slow_update(context, dst, &color);
+		ui_direct_slow_update(context, dst, color);
 	}
 
 	if (context->state.ui_direct_fast_flag) {
-		ui_direct_fast_update(context, dst, &color);
+		ui_direct_fast_update(context, dst, color);
 	}
 
 	if (context->state.ui_direct_text_flag) {
-		ui_direct_text_update(context, dst, &color);
+		ui_direct_text_update(context, dst, color);
 	}
 
 	adv_bitmap_free(dst);
@@ -1264,6 +1503,12 @@ adv_error advance_ui_init(struct advance_ui_context* context, adv_conf* cfg_cont
 	context->state.ui_font_oriented = 0;
 	context->state.buffer_def = color_def_make_rgb_from_sizelenpos(4, 8, 16, 8, 8, 8, 0); /* BGRA */
 	context->state.color_map.def = 0; /* invalidate the color map */
+	context->state.direct_color_map.def = 0;
+	memset(context->state.glyph_map, 0, sizeof(context->state.glyph_map));
+	context->state.glyph_next = 0;
+	memset(context->state.overlay_map, 0, sizeof(context->state.overlay_map));
+	context->state.overlay_render_counter = 0;
+	context->state.overlay_copy_counter = 0;
 
 	conf_bool_register_default(cfg_context, "debug_speedmark", 0);
 	conf_string_register_multi(cfg_context, "ui_helptag");
@@ -1390,6 +1635,13 @@ adv_error advance_ui_config_load(struct advance_ui_context* context, adv_conf* c
 
 void advance_ui_done(struct advance_ui_context* context)
 {
+	unsigned i;
+
+	for (i = 0; i < UI_OVERLAY_MAX; ++i) {
+		free(context->state.overlay_map[i].key_map);
+		free(context->state.overlay_map[i].next_map);
+	}
+	memset(context->state.overlay_map, 0, sizeof(context->state.overlay_map));
 }
 
 #include "help.dat"
@@ -1399,6 +1651,10 @@ void advance_ui_changefont(struct advance_ui_context* context, unsigned screen_w
 	unsigned sizex;
 	unsigned sizey;
 
+	/* the cached images use the old font */
+	ui_glyph_reset(context);
+	ui_overlay_reset(context);
+
 	adv_font_free(context->state.ui_font);
 	adv_font_free(context->state.ui_font_oriented);
 
@@ -1560,6 +1816,13 @@ adv_error advance_ui_inner_init(struct advance_ui_context* context, adv_conf* cf
 
 void advance_ui_inner_done(struct advance_ui_context* context)
 {
+	log_std(("emu:ui: overlays rendered %u, reused %u\n", context->state.overlay_render_counter, context->state.overlay_copy_counter));
+	context->state.overlay_render_counter = 0;
+	context->state.overlay_copy_counter = 0;
+
+	ui_glyph_reset(context);
+	ui_overlay_reset(context);
+
 	adv_font_free(context->state.ui_font);
 	context->state.ui_font = 0;
 	adv_font_free(context->state.ui_font_oriented);
@@ -456,6 +456,13 @@ static void video_command(struct advance_video_context* context, struct advance_
 		unsigned skip;
 		unsigned rate;
 		unsigned l;
+		double rewind_time;
+		unsigned rewind_count;
+		double runahead_time;
+		double runahead_fps;
+		unsigned runahead_frames;
+		unsigned adpcm_hit;
+		unsigned adpcm_used;
 
 		if (context->state.info_counter) {
 			--context->state.info_counter;
@@ -491,6 +498,20 @@ static void video_command(struct advance_video_context* context, struct advance_
 		if (l >= 11 && isspace(buffer[l - 11]))
 			buffer[l - 11] = ADV_FONT_FIXSPACE;
 
+		/* cost of the rewind capture of the last frame */
+		if (mame_ui_rewind_info(&rewind_time, &rewind_count))
+			snprintf(buffer + l, sizeof(buffer) - l, " - rw %u %.1fms", rewind_count, rewind_time * 1000);
+
+		/* cost of the run-ahead of the last frame, and the frame rate achieved */
+		l = strlen(buffer);
+		if (mame_ui_runahead_info(&runahead_frames, &runahead_time, &runahead_fps))
+			snprintf(buffer + l, sizeof(buffer) - l, " - ra %u %.1fms %.1ffps", runahead_frames, runahead_time * 1000, runahead_fps);
+
+		/* hit rate and memory of the decoded ADPCM samples */
+		l = strlen(buffer);
+		if (mame_ui_adpcm_info(&adpcm_hit, &adpcm_used))
+			snprintf(buffer + l, sizeof(buffer) - l, " - adpcm %u%% %ukB", adpcm_hit, adpcm_used / 1024);
+
 		advance_ui_direct_text(ui_context, buffer);
 
 		hardware_script_info(0, 0, 0, buffer);
@@ -1138,7 +1159,12 @@ void osd2_area(unsigned x1, unsigned y1, unsigned x2, unsigned y2)
 	advance_video_invalidate_pipeline(context);
 }
 
-void osd2_palette(const osd_mask_t* mask, const osd_rgb_t* palette, unsigned size)
+/**
+ * Get the changed colors of the game palette.
+ * Only the colors marked in the mask are copied, and the elements of the
+ * mask from mask_first to mask_last are cleared after the use.
+ */
+void osd2_palette(osd_mask_t* mask, unsigned mask_first, unsigned mask_last, const osd_rgb_t* palette, unsigned size)
 {
 	struct advance_video_context* context = &CONTEXT.video;
 	unsigned dirty_size;
@@ -1169,23 +1195,54 @@ void osd2_palette(const osd_mask_t* mask, const osd_rgb_t* palette, unsigned siz
 		return;
 	}
 
-	context->state.palette_dirty_flag = 1;
-	for (i = 0; i < size; ++i) {
-		context->state.palette_map[i].red = osd_rgb_red(palette[i]);
-		context->state.palette_map[i].green = osd_rgb_green(palette[i]);
-		context->state.palette_map[i].blue = osd_rgb_blue(palette[i]);
-	}
+	if (mask_last >= dirty_size)
+		mask_last = dirty_size - 1;
+
+	/* nothing changed */
+	if (dirty_size == 0 || mask_first > mask_last)
+		return;
+
+	for (i = mask_first; i <= mask_last; ++i) {
+		osd_mask_t m = mask[i];
+		osd_mask_t t;
+		unsigned p;
+
+		if (!m)
+			continue;
+
+		mask[i] = 0;
 
-	if (dirty_size > 0 && dirty_size == context->state.palette_dirty_total) {
 		/* the last element must be masked */
-		for (i = 0; i < dirty_size - 1; ++i) {
-			context->state.palette_dirty_map[i] |= mask[i];
+		if (i == context->state.palette_dirty_total - 1)
+			m &= context->state.palette_dirty_mask;
+		if (i == dirty_size - 1 && size % osd_mask_size != 0)
+			m &= (1U << (size % osd_mask_size)) - 1;
+
+		if (!m)
+			continue;
+
+		/* copy only the changed colors */
+		p = i * osd_mask_size;
+		for (t = m; t != 0; t >>= 1, ++p) {
+			if ((t & 1) != 0) {
+				context->state.palette_map[p].red = osd_rgb_red(palette[p]);
+				context->state.palette_map[p].green = osd_rgb_green(palette[p]);
+				context->state.palette_map[p].blue = osd_rgb_blue(palette[p]);
+			}
 		}
-		context->state.palette_dirty_map[i] |= mask[i] & context->state.palette_dirty_mask;
-	} else {
-		for (i = 0; i < dirty_size; ++i) {
-			context->state.palette_dirty_map[i] |= mask[i];
+
+		/* and convert only them at the next frame */
+		if (!context->state.palette_dirty_flag) {
+			context->state.palette_dirty_flag = 1;
+			context->state.palette_dirty_first = i;
+			context->state.palette_dirty_last = i;
+		} else {
+			if (i < context->state.palette_dirty_first)
+				context->state.palette_dirty_first = i;
+			if (i > context->state.palette_dirty_last)
+				context->state.palette_dirty_last = i;
 		}
+		context->state.palette_dirty_map[i] |= m;
 	}
 }
 
@@ -1284,6 +1341,13 @@ int osd2_frame(const struct osd_bitmap* game, const struct osd_bitmap* debug, co
 
 	adv_bool normal_speed = video_is_normal_speed(&CONTEXT.video);
 
+	/* report the time from the launch request to the first frame */
+	if (CONTEXT.global.state.launch_clock != 0) {
+		CONTEXT.global.state.launch_delay = target_clock() - CONTEXT.global.state.launch_clock;
+		CONTEXT.global.state.launch_clock = 0;
+		log_std(("emu: first frame %g [ms] after the launch request\n", CONTEXT.global.state.launch_delay * 1000.0 / TARGET_CLOCKS_PER_SEC));
+	}
+
 	/* store the current audio video syncronization error measured in sound samples */
 	context->state.av_sync_map[context->state.av_sync_mac] = context->state.latency_diff;
 
@@ -1542,6 +1606,7 @@ adv_error advance_video_init(struct advance_video_context* context, adv_conf* cf
 	conf_string_register_default(cfg_context, "vector_aux_renderer", "none");
 	conf_bool_register_default(cfg_context,   "vector_aux_renderer_dual_display", 1);
 	conf_string_register_default(cfg_context, "vector_aux_renderer_port", "/dev/ttyACM0");
+	conf_bool_register_default(cfg_context,   "vector_aux_renderer_sort", 0);
 
 #ifdef USE_SMP
 	/* SMP always enabled by default */
@@ -1758,7 +1823,7 @@ adv_error advance_video_config_load(struct advance_video_context* context, adv_c
 	if (strcmp(s, "dvg") == 0) {
 		vector_dual_display = conf_bool_get_default(cfg_context, "vector_aux_renderer_dual_display");
 		s = conf_string_get_default(cfg_context, "vector_aux_renderer_port");
-		dvg_init(s, vector_dual_display);
+		dvg_init(s, vector_dual_display, conf_bool_get_default(cfg_context, "vector_aux_renderer_sort"));
 	}
 #endif
 
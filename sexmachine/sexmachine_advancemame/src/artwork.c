@@ -1389,10 +1389,18 @@ static void cmy_blend_intersecting_rect(
 
 static void update_palette_lookup(mame_display *display)
 {
-	int i, j;
+	int i, j, end;
 
-	/* loop over dirty colors in batches of 32 */
-	for (i = 0; i < display->game_palette_entries; i += 32)
+	/* nothing marked since the last update */
+	if (display->game_palette_dirty_min > display->game_palette_dirty_max)
+		return;
+
+	end = (display->game_palette_dirty_max + 1) * 32;
+	if (end > display->game_palette_entries)
+		end = display->game_palette_entries;
+
+	/* loop over dirty colors in batches of 32, only where some bit may be set */
+	for (i = display->game_palette_dirty_min * 32; i < end; i += 32)
 	{
 		UINT32 dirtyflags = display->game_palette_dirty[i / 32];
 		if (dirtyflags)
@@ -56,6 +56,9 @@
 
 #define NO_MATCH					(~0)
 
+#define PREFETCH_MAX_HUNKS			16			/* max number of hunks read ahead at once */
+#define PREFETCH_TRIGGER			2			/* sequential reads that start the read-ahead */
+
 
 
 /*************************************
@@ -103,6 +106,30 @@ struct _metadata_entry
 typedef struct _metadata_entry metadata_entry;
 
 
+struct _hunk_cache_entry
+{
+	UINT8 *					data;			/* decompressed data */
+	UINT32					hunknum;		/* hunk number, or ~0 if empty */
+	UINT32					stamp;			/* time of the last access */
+	UINT8					pending;		/* being filled by the read-ahead */
+	UINT8					prefetched;		/* filled by the read-ahead and not yet used */
+};
+typedef struct _hunk_cache_entry hunk_cache_entry;
+
+
+struct _chd_prefetch
+{
+	struct _chd_file *		chd;			/* file to read */
+	void *					handle;			/* handle of the background job */
+	void					(*end)(void *);	/* function to wait the background job */
+	UINT32					count;			/* number of hunks to read */
+	UINT32					hunknum[PREFETCH_MAX_HUNKS];	/* hunks to read */
+	hunk_cache_entry *		entry[PREFETCH_MAX_HUNKS];		/* cache entries to fill */
+	int						err[PREFETCH_MAX_HUNKS];		/* result of every read */
+};
+typedef struct _chd_prefetch chd_prefetch;
+
+
 struct _chd_file
 {
 	UINT32					cookie;			/* cookie, should equal COOKIE_VALUE */
@@ -129,6 +156,18 @@ struct _chd_file
 	crcmap_entry **			crctable;		/* table of CRC entries */
 
 	UINT32					maxhunk;		/* maximum hunk accessed */
+
+	hunk_cache_entry *		lru;			/* LRU cache of decompressed hunks */
+	UINT8 *					lrudata;		/* data of all the LRU entries */
+	UINT32					lrucount;		/* number of LRU entries */
+	UINT32					lruclock;		/* LRU access counter */
+
+	UINT32					lasthunk;		/* last hunk read */
+	UINT32					sequential;		/* number of sequential reads up to the last hunk */
+	chd_prefetch *			prefetch;		/* read-ahead data */
+	int						prefetching;	/* read-ahead in progress */
+
+	chd_cache_stats			stats;			/* cache statistics */
 };
 
 
@@ -161,6 +200,7 @@ typedef struct _zlib_codec_data zlib_codec_data;
 static chd_interface cur_interface;
 static chd_file *first_file;
 static int last_error;
+static UINT32 cache_bytes;
 
 static const UINT8 nullmd5[CHD_MD5_BYTES] = { 0 };
 static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
@@ -176,6 +216,13 @@ static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 static int validate_header(const chd_header *header);
 static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
 static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum);
+static int init_hunk_lru(chd_file *chd);
+static void free_hunk_lru(chd_file *chd);
+static hunk_cache_entry *find_hunk_lru(chd_file *chd, UINT32 hunknum);
+static hunk_cache_entry *alloc_hunk_lru(chd_file *chd);
+static void prefetch_begin(chd_file *chd, UINT32 hunknum);
+static void prefetch_end(chd_file *chd);
+static void prefetch_sync(chd_file *chd);
 static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
 static int read_header(chd_interface_file *file, chd_header *header);
 static int write_header(chd_interface_file *file, const chd_header *header);
@@ -310,6 +357,20 @@ void chd_save_interface(chd_interface *interface_save)
 
 
 
+/*************************************
+ *
+ *  Hunk cache size
+ *
+ *************************************/
+
+void chd_set_cache_size(UINT32 bytes)
+{
+	/* used by the files opened later; at least one hunk is always cached */
+	cache_bytes = bytes;
+}
+
+
+
 /*************************************
  *
  *  Create a new data file
@@ -574,6 +635,11 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 	chd.cachehunk = ~0;
 	chd.comparehunk = ~0;
 
+	/* allocate the LRU of decompressed hunks */
+	err = init_hunk_lru(&chd);
+	if (err != CHDERR_NONE)
+		SET_ERROR_AND_CLEANUP(err);
+
 	/* allocate the temporary compressed buffer */
 	chd.compressed = malloc(chd.header.hunkbytes);
 	if (!chd.compressed)
@@ -589,6 +655,8 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 	if (!finalchd)
 		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
 	*finalchd = chd;
+	if (finalchd->prefetch)
+		finalchd->prefetch->chd = finalchd;
 
 	/* hook us into the global list */
 	finalchd->cookie = COOKIE_VALUE;
@@ -599,6 +667,7 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 	return finalchd;
 
 cleanup:
+	free_hunk_lru(&chd);
 	if (chd.codecdata)
 		free_codec(&chd);
 	if (chd.compressed)
@@ -630,6 +699,10 @@ void chd_close(chd_file *chd)
 	if (!chd || chd->cookie != COOKIE_VALUE)
 		return;
 
+	/* stop any background access to the file */
+	prefetch_sync(chd);
+	free_hunk_lru(chd);
+
 	/* deinit the codec */
 	if (chd->codecdata)
 		free_codec(chd);
@@ -702,6 +775,9 @@ UINT32 chd_get_metadata(chd_file *chd, UINT32 *metatag, UINT32 metaindex, void *
 	metadata_entry metaentry;
 	UINT32 count;
 
+	/* the file can't be accessed during the read-ahead */
+	prefetch_sync(chd);
+
 	/* if we didn't find it, just return */
 	last_error = find_metadata_entry(chd, *metatag, metaindex, &metaentry);
 	if (last_error != CHDERR_NONE)
@@ -759,6 +835,9 @@ int chd_set_metadata(chd_file *chd, UINT32 metatag, UINT32 metaindex, const void
 	if (chd->header.version < 3)
 		return CHDERR_NOT_SUPPORTED;
 
+	/* the file can't be accessed during the read-ahead */
+	prefetch_sync(chd);
+
 	/* if the disk isn't writeable, punt */
 	if (!(chd->header.flags & CHDFLAGS_IS_WRITEABLE))
 		return CHDERR_FILE_NOT_WRITEABLE;
@@ -854,6 +933,8 @@ int chd_set_metadata(chd_file *chd, UINT32 metatag, UINT32 metaindex, const void
 
 UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 {
+	hunk_cache_entry *entry;
+	chd_file *root;
 	int err;
 
 	last_error = CHDERR_NONE;
@@ -879,16 +960,59 @@ UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 	if (hunknum > chd->maxhunk)
 		chd->maxhunk = hunknum;
 
+	/* if the hunk is being read ahead, wait for it */
+	entry = find_hunk_lru(chd, hunknum);
+	if (!entry && chd->prefetching)
+	{
+		UINT32 i;
+
+		for (i = 0; i < chd->prefetch->count; i++)
+			if (chd->prefetch->hunknum[i] == hunknum)
+			{
+				chd->stats.waits++;
+				prefetch_end(chd);
+				entry = find_hunk_lru(chd, hunknum);
+				break;
+			}
+	}
+
 	/* if the hunk is not cached, load and decompress it */
-	if (chd->cachehunk != hunknum)
+	if (entry)
 	{
-		err = read_hunk_into_cache(chd, hunknum);
+		chd->stats.hits++;
+		if (entry->prefetched)
+		{
+			chd->stats.prefetch_hits++;
+			entry->prefetched = FALSE;
+		}
+	}
+	else
+	{
+		chd->stats.misses++;
+
+		/* the parents may be also read ahead by another file sharing them */
+		for (root = chd; root->parent; root = root->parent) ;
+		prefetch_sync(root);
+
+		entry = alloc_hunk_lru(chd);
+		err = read_hunk_into_memory(chd, hunknum, entry->data);
 		if (err != CHDERR_NONE)
 			SET_ERROR_AND_CLEANUP(err);
+		entry->hunknum = hunknum;
 	}
+	entry->stamp = ++chd->lruclock;
 
 	/* now copy the data from the cache */
-	memcpy(buffer, chd->cache, chd->header.hunkbytes);
+	memcpy(buffer, entry->data, chd->header.hunkbytes);
+
+	/* if the disk is streamed, decompress the next hunks in the background */
+	if (hunknum == chd->lasthunk + 1)
+		chd->sequential++;
+	else
+		chd->sequential = 0;
+	chd->lasthunk = hunknum;
+	if (chd->sequential >= PREFETCH_TRIGGER)
+		prefetch_begin(chd, hunknum + 1);
 	return 1;
 
 cleanup:
@@ -905,6 +1029,7 @@ cleanup:
 
 UINT32 chd_write(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, const void *buffer)
 {
+	hunk_cache_entry *entry;
 	int err;
 
 	last_error = CHDERR_NONE;
@@ -930,10 +1055,18 @@ UINT32 chd_write(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, const void *bu
 	if (hunknum > chd->maxhunk)
 		chd->maxhunk = hunknum;
 
+	/* the file can't be accessed during the read-ahead */
+	prefetch_sync(chd);
+
 	/* then write out the hunk */
 	err = write_hunk_from_memory(chd, hunknum, buffer);
 	if (err != CHDERR_NONE)
 		SET_ERROR_AND_CLEANUP(err);
+
+	/* keep the cached copy up to date */
+	entry = find_hunk_lru(chd, hunknum);
+	if (entry)
+		memcpy(entry->data, buffer, chd->header.hunkbytes);
 	return 1;
 
 cleanup:
@@ -975,6 +1108,25 @@ cleanup:
 
 
 
+/*************************************
+ *
+ *  Return the cache statistics
+ *
+ *************************************/
+
+void chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	/* punt if NULL or invalid */
+	if (!chd || chd->cookie != COOKIE_VALUE)
+		return;
+
+	*stats = chd->stats;
+}
+
+
+
 /*************************************
  *
  *  Set the header
@@ -1422,6 +1574,214 @@ static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum)
 
 
 
+/*************************************
+ *
+ *  Hunk LRU cache
+ *
+ *************************************/
+
+static int init_hunk_lru(chd_file *chd)
+{
+	UINT32 i;
+
+	chd->lrucount = cache_bytes / chd->header.hunkbytes;
+	if (chd->lrucount < 1)
+		chd->lrucount = 1;
+	chd->lasthunk = ~0;
+
+	chd->lru = malloc(chd->lrucount * sizeof(chd->lru[0]));
+	chd->lrudata = malloc(chd->lrucount * chd->header.hunkbytes);
+	if (!chd->lru || !chd->lrudata)
+		return CHDERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < chd->lrucount; i++)
+	{
+		chd->lru[i].data = chd->lrudata + i * chd->header.hunkbytes;
+		chd->lru[i].hunknum = ~0;
+		chd->lru[i].stamp = 0;
+		chd->lru[i].pending = FALSE;
+		chd->lru[i].prefetched = FALSE;
+	}
+
+	/* read ahead only if the cache can hold the hunks in use and the ones ahead */
+	if (cur_interface.async_begin && chd->lrucount >= 4 * PREFETCH_TRIGGER)
+	{
+		chd->prefetch = malloc(sizeof(*chd->prefetch));
+		if (!chd->prefetch)
+			return CHDERR_OUT_OF_MEMORY;
+		memset(chd->prefetch, 0, sizeof(*chd->prefetch));
+	}
+
+	return CHDERR_NONE;
+}
+
+
+static void free_hunk_lru(chd_file *chd)
+{
+	if (chd->prefetch)
+		free(chd->prefetch);
+	if (chd->lrudata)
+		free(chd->lrudata);
+	if (chd->lru)
+		free(chd->lru);
+	chd->prefetch = NULL;
+	chd->lrudata = NULL;
+	chd->lru = NULL;
+}
+
+
+static hunk_cache_entry *find_hunk_lru(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 i;
+
+	for (i = 0; i < chd->lrucount; i++)
+		if (chd->lru[i].hunknum == hunknum)
+			return &chd->lru[i];
+	return NULL;
+}
+
+
+static hunk_cache_entry *alloc_hunk_lru(chd_file *chd)
+{
+	hunk_cache_entry *oldest = NULL;
+	UINT32 i;
+
+	/* take the least recently used entry not being filled */
+	for (i = 0; i < chd->lrucount; i++)
+		if (!chd->lru[i].pending && (!oldest || chd->lru[i].stamp < oldest->stamp))
+			oldest = &chd->lru[i];
+
+	if (oldest)
+	{
+		oldest->hunknum = ~0;
+		oldest->stamp = 0;
+		oldest->prefetched = FALSE;
+	}
+	return oldest;
+}
+
+
+
+/*************************************
+ *
+ *  Hunk read-ahead
+ *
+ *************************************/
+
+static void prefetch_proc(void *param)
+{
+	chd_prefetch *prefetch = param;
+	UINT32 i;
+
+	/* only this thread accesses the file, and the parents, until prefetch_end() */
+	for (i = 0; i < prefetch->count; i++)
+		prefetch->err[i] = read_hunk_into_memory(prefetch->chd, prefetch->hunknum[i], prefetch->entry[i]->data);
+}
+
+
+static void prefetch_begin(chd_file *chd, UINT32 hunknum)
+{
+	chd_prefetch *prefetch = chd->prefetch;
+	UINT32 window, missing, i;
+	chd_file *root;
+
+	if (!prefetch || chd->prefetching)
+		return;
+
+	/* a quarter of the cache at most */
+	window = chd->lrucount / 4;
+	if (window > PREFETCH_MAX_HUNKS)
+		window = PREFETCH_MAX_HUNKS;
+	if (hunknum + window > chd->header.totalhunks)
+		window = chd->header.totalhunks - hunknum;
+
+	/* start only when half of the window is consumed */
+	missing = 0;
+	for (i = 0; i < window; i++)
+		if (!find_hunk_lru(chd, hunknum + i))
+			missing++;
+	if (missing == 0 || missing < window / 2)
+		return;
+
+	/* a read-ahead of another file sharing the same parents must end first */
+	for (root = chd; root->parent; root = root->parent) ;
+	prefetch_sync(root);
+
+	/* reserve the entries */
+	prefetch->count = 0;
+	for (i = 0; i < window; i++)
+		if (!find_hunk_lru(chd, hunknum + i))
+		{
+			hunk_cache_entry *entry = alloc_hunk_lru(chd);
+			if (!entry)
+				break;
+			entry->pending = TRUE;
+			prefetch->hunknum[prefetch->count] = hunknum + i;
+			prefetch->entry[prefetch->count] = entry;
+			prefetch->count++;
+		}
+
+	/* without a thread it runs now, and prefetch_end() only collects the results */
+	chd->prefetching = TRUE;
+	prefetch->end = cur_interface.async_end;
+	prefetch->handle = (*cur_interface.async_begin)(prefetch_proc, prefetch);
+}
+
+
+static void prefetch_end(chd_file *chd)
+{
+	chd_prefetch *prefetch = chd->prefetch;
+	UINT32 i;
+
+	if (!chd->prefetching)
+		return;
+
+	if (prefetch->handle)
+		(*prefetch->end)(prefetch->handle);
+	prefetch->handle = NULL;
+	chd->prefetching = FALSE;
+
+	/* publish the hunks read */
+	for (i = 0; i < prefetch->count; i++)
+	{
+		hunk_cache_entry *entry = prefetch->entry[i];
+
+		entry->pending = FALSE;
+		if (prefetch->err[i] == CHDERR_NONE)
+		{
+			entry->hunknum = prefetch->hunknum[i];
+			entry->stamp = chd->lruclock;
+			entry->prefetched = TRUE;
+			chd->stats.prefetched++;
+		}
+	}
+	prefetch->count = 0;
+}
+
+
+static void prefetch_sync(chd_file *chd)
+{
+	chd_file *curr;
+
+	/* wait for every read-ahead that can access this file, also through a child */
+	for (curr = first_file; curr; curr = curr->next)
+	{
+		chd_file *parent;
+
+		for (parent = curr; parent; parent = parent->parent)
+			if (parent == chd)
+			{
+				prefetch_end(curr);
+				break;
+			}
+	}
+
+	/* the file may be still outside the list, being opened or closed */
+	prefetch_end(chd);
+}
+
+
+
 /*************************************
  *
  *  Hunk write/compress
@@ -165,6 +165,17 @@ struct _chd_header
 typedef struct _chd_header chd_header;
 
 
+struct _chd_cache_stats
+{
+	UINT32	hits;						/* reads served by the hunk cache */
+	UINT32	misses;						/* reads decompressed on request */
+	UINT32	prefetched;					/* hunks decompressed by the read-ahead */
+	UINT32	prefetch_hits;				/* read-ahead hunks used */
+	UINT32	waits;						/* reads that waited for the read-ahead */
+};
+typedef struct _chd_cache_stats chd_cache_stats;
+
+
 typedef struct _chd_exfile chd_exfile;
 typedef struct _chd_interface_file chd_interface_file;
 
@@ -176,6 +187,10 @@ struct _chd_interface
 	UINT32 (*read)(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer);
 	UINT32 (*write)(chd_interface_file *file, UINT64 offset, UINT32 count, const void *buffer);
 	UINT64 (*length)(chd_interface_file *file);
+
+	/* optional, used to read ahead in the background */
+	void *(*async_begin)(void (*func)(void *param), void *param);
+	void (*async_end)(void *handle);
 };
 typedef struct _chd_interface chd_interface;
 
@@ -189,6 +204,7 @@ typedef struct _chd_interface chd_interface;
 
 void chd_set_interface(chd_interface *new_interface);
 void chd_save_interface(chd_interface *interface_save);
+void chd_set_cache_size(UINT32 bytes);
 
 int chd_create(const char *filename, UINT64 logicalbytes, UINT32 hunkbytes, UINT32 compression, chd_file *parent);
 chd_file *chd_open(const char *filename, int writeable, chd_file *parent);
@@ -203,6 +219,7 @@ UINT32 chd_write(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, const void *bu
 
 int chd_get_last_error(void);
 const chd_header *chd_get_header(chd_file *chd);
+void chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats);
 int chd_set_header(const char *filename, const chd_header *header);
 
 int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progress)(const char *, ...));
@@ -395,6 +395,7 @@ is selected
 *******************************************************************************/
 
 #include "driver.h"
+#include "osdepend.h"
 #include "ui_text.h"
 #include "artwork.h"
 #include "machine/eeprom.h"
@@ -757,6 +758,8 @@ struct SearchRegion
 
 	UINT8	* first;
 	UINT8	* last;
+	UINT8	* current;		// snapshot of the memory taken by DoSearch
+	UINT8	currentValid;
 
 	UINT8	* status;
 
@@ -1222,6 +1225,12 @@ static UINT32	SearchSignExtend(SearchInfo * search, UINT32 value);
 static UINT32	ReadSearchOperand(UINT8 type, SearchInfo * search, SearchRegion * region, UINT32 address);
 static UINT32	ReadSearchOperandBit(UINT8 type, SearchInfo * search, SearchRegion * region, UINT32 address);
 static UINT8	DoSearchComparison(SearchInfo * search, UINT32 lhs, UINT32 rhs);
+static UINT8 *	GetSearchOperandBuffer(UINT8 type, SearchRegion * region);
+static UINT32	SearchBytesWord(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual);
+static UINT32	SearchBytesReference(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual);
+static UINT32	CheckSearchBytes(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual);
+static UINT8	DoSearchBytesFast(SearchInfo * search, SearchRegion * region);
+static void		TakeSearchSnapshot(SearchInfo * search, UINT8 take);
 static UINT32	DoSearchComparisonBit(SearchInfo * search, UINT32 lhs, UINT32 rhs);
 //static UINT8  IsRegionOffsetValid(SearchInfo * search, SearchRegion * region, UINT32 offset);
 
@@ -1240,6 +1249,7 @@ static void		DoSearch(SearchInfo * search);
 static UINT8 **	LookupHandlerMemory(UINT8 cpu, UINT32 address, UINT32 * outRelativeAddress);
 
 static UINT32	DoCPURead(UINT8 cpu, UINT32 address, UINT8 bytes, UINT8 swap);
+static UINT32	DoSnapshotRead(UINT8 * buf, UINT32 address, UINT8 bytes, UINT8 swap);
 static UINT32	DoMemoryRead(UINT8 * buf, UINT32 address, UINT8 bytes, UINT8 swap, CPUInfo * info);
 static void		DoCPUWrite(UINT32 data, UINT8 cpu, UINT32 address, UINT8 bytes, UINT8 swap);
 static void		DoMemoryWrite(UINT32 data, UINT8 * buf, UINT32 address, UINT8 bytes, UINT8 swap, CPUInfo * info);
@@ -7827,6 +7837,7 @@ static void DisposeSearchRegions(SearchInfo * info)
 
 			free(region->first);
 			free(region->last);
+			free(region->current);
 			free(region->status);
 			free(region->backupLast);
 			free(region->backupStatus);
@@ -7869,11 +7880,47 @@ static void FillBufferFromRegion(SearchRegion * region, UINT8 * buf)
 {
 	UINT32	offset;
 
-	// ### optimize if needed
+	if(region->targetType == kRegionType_CPU)
+	{
+		// copy the RAM and ROM through direct pointers, only the handlers are read one byte at a time
+		offset = 0;
+
+		while(offset < region->length)
+		{
+			UINT32	address = region->address + offset;
+			offs_t	length;
+			int		byteXor;
+			UINT8	* ptr = memory_get_read_span(region->targetIdx, ADDRESS_SPACE_PROGRAM, address, &length, &byteXor);
+			UINT32	i;
+
+			if(!length || (length > region->length - offset))
+				length = region->length - offset;
+
+			if(!ptr)
+			{
+				for(i = 0; i < length; i++)
+					buf[offset + i] = ReadRegionData(region, offset + i, 1, 0);
+			}
+			else if(!byteXor)
+			{
+				memcpy(&buf[offset], ptr, length);
+			}
+			else
+			{
+				// ptr is the byte of address before the swap within the bus word
+				for(i = 0; i < length; i++)
+					buf[offset + i] = ptr[(INT32)(((address + i) ^ byteXor) - address)];
+			}
 
-	for(offset = 0; offset < region->length; offset++)
+			offset += length;
+		}
+	}
+	else
 	{
-		buf[offset] = ReadRegionData(region, offset, 1, 0);
+		for(offset = 0; offset < region->length; offset++)
+		{
+			buf[offset] = ReadRegionData(region, offset, 1, 0);
+		}
 	}
 }
 
@@ -8101,32 +8148,39 @@ static void AllocateSearchRegions(SearchInfo * info)
 
 		free(region->first);
 		free(region->last);
+		free(region->current);
 		free(region->status);
 		free(region->backupLast);
 		free(region->backupStatus);
 
+		region->currentValid = 0;
+
 		if(region->flags & kRegionFlag_Enabled)
 		{
 			region->first =			malloc(region->length);
 			region->last =			malloc(region->length);
+			region->current =		malloc(region->length);
 			region->status =		malloc(region->length);
 			region->backupLast =	malloc(region->length);
 			region->backupStatus =	malloc(region->length);
 
 			if(	!region->first ||
 				!region->last ||
+				!region->current ||
 				!region->status ||
 				!region->backupLast ||
 				!region->backupStatus)
 			{
 				free(region->first);
 				free(region->last);
+				free(region->current);
 				free(region->status);
 				free(region->backupLast);
 				free(region->backupStatus);
 
 				region->first =			NULL;
 				region->last =			NULL;
+				region->current =		NULL;
 				region->status =		NULL;
 				region->backupLast =	NULL;
 				region->backupStatus =	NULL;
@@ -8138,6 +8192,7 @@ static void AllocateSearchRegions(SearchInfo * info)
 		{
 			region->first =			NULL;
 			region->last =			NULL;
+			region->current =		NULL;
 			region->status =		NULL;
 			region->backupLast =	NULL;
 			region->backupStatus =	NULL;
@@ -8173,6 +8228,7 @@ static void BuildSearchRegions(SearchInfo * info)
 
 				region->first = NULL;
 				region->last = NULL;
+				region->current = NULL;
 				region->status = NULL;
 
 				region->backupLast = NULL;
@@ -8221,6 +8277,7 @@ static void BuildSearchRegions(SearchInfo * info)
 
 						traverse->first = NULL;
 						traverse->last = NULL;
+						traverse->current = NULL;
 						traverse->status = NULL;
 
 						traverse->backupLast = NULL;
@@ -8933,7 +8990,10 @@ static UINT32 ReadSearchOperand(UINT8 type, SearchInfo * search, SearchRegion *
 	switch(type)
 	{
 		case kSearchOperand_Current:
-			value = ReadRegionData(region, address - region->address, kSearchByteIncrementTable[search->bytes], search->swap);
+			if(region->currentValid)
+				value = DoSnapshotRead(region->current, address - region->address, kSearchByteIncrementTable[search->bytes], CPUNeedsSwap(region->targetIdx) ^ search->swap);
+			else
+				value = ReadRegionData(region, address - region->address, kSearchByteIncrementTable[search->bytes], search->swap);
 			break;
 
 		case kSearchOperand_Previous:
@@ -8961,7 +9021,10 @@ static UINT32 ReadSearchOperandBit(UINT8 type, SearchInfo * search, SearchRegion
 	switch(type)
 	{
 		case kSearchOperand_Current:
-			value = ReadRegionData(region, address - region->address, kSearchByteIncrementTable[search->bytes], search->swap);
+			if(region->currentValid)
+				value = DoSnapshotRead(region->current, address - region->address, kSearchByteIncrementTable[search->bytes], CPUNeedsSwap(region->targetIdx) ^ search->swap);
+			else
+				value = ReadRegionData(region, address - region->address, kSearchByteIncrementTable[search->bytes], search->swap);
 			break;
 
 		case kSearchOperand_Previous:
@@ -9222,12 +9285,253 @@ static void UpdateSearch(SearchInfo * search)
 	}
 }
 
+/*-------------------------------------------------
+    GetSearchOperandBuffer - returns the buffer
+    holding an operand for the whole region, or NULL
+    if it has to be read element by element
+-------------------------------------------------*/
+
+static UINT8 * GetSearchOperandBuffer(UINT8 type, SearchRegion * region)
+{
+	switch(type)
+	{
+		case kSearchOperand_Current:
+			if(region->currentValid)
+				return region->current;
+			break;
+
+		case kSearchOperand_Previous:
+			return region->last;
+
+		case kSearchOperand_First:
+			return region->first;
+	}
+
+	return NULL;
+}
+
+/*-------------------------------------------------
+    SearchBytesWord - clears the status of the
+    bytes failing an equal/not equal compare, four
+    bytes at a time; rhsBuf NULL compares to value
+
+    returns the number of remaining candidates
+-------------------------------------------------*/
+
+static UINT32 SearchBytesWord(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual)
+{
+	UINT32	valueWord = value * 0x01010101;
+	UINT32	count = 0;
+	UINT32	j;
+
+	for(j = 0; j + 4 <= length; j += 4)
+	{
+		UINT32	s = *((UINT32 *)&status[j]);
+		UINT32	l, r, x, differ, t;
+
+		// most of the candidates are gone after a few searches
+		if(!s)
+			continue;
+
+		memcpy(&l, &lhsBuf[j], 4);
+
+		if(rhsBuf)
+			memcpy(&r, &rhsBuf[j], 4);
+		else
+			r = valueWord;
+
+		// 0xFF in each byte that differs
+		x = l ^ r;
+		differ = ((((x & 0x7F7F7F7F) + 0x7F7F7F7F) | x) & 0x80808080) >> 7;
+		differ *= 0xFF;
+
+		s &= notEqual ? differ : ~differ;
+
+		*((UINT32 *)&status[j]) = s;
+
+		// count the nonzero status bytes
+		t = (((s & 0x7F7F7F7F) + 0x7F7F7F7F) | s) & 0x80808080;
+		count += ((t >> 7) * 0x01010101) >> 24;
+	}
+
+	count += SearchBytesReference(&status[j], &lhsBuf[j], rhsBuf ? &rhsBuf[j] : NULL, value, length - j, notEqual);
+
+	return count;
+}
+
+/*-------------------------------------------------
+    SearchBytesReference - same as
+    SearchBytesWord, one byte at a time
+-------------------------------------------------*/
+
+static UINT32 SearchBytesReference(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual)
+{
+	UINT32	count = 0;
+	UINT32	j;
+
+	for(j = 0; j < length; j++)
+	{
+		UINT8	r = rhsBuf ? rhsBuf[j] : value;
+
+		if(!status[j])
+			continue;
+
+		if((lhsBuf[j] != r) == notEqual)
+			count++;
+		else
+			status[j] = 0;
+	}
+
+	return count;
+}
+
+/*-------------------------------------------------
+    CheckSearchBytes - runs SearchBytesWord, and
+    SearchBytesReference on a copy of the status,
+    logging their times or the first difference
+
+    returns the result of SearchBytesWord
+-------------------------------------------------*/
+
+static UINT32 CheckSearchBytes(UINT8 * status, UINT8 * lhsBuf, UINT8 * rhsBuf, UINT8 value, UINT32 length, UINT8 notEqual)
+{
+	UINT8	* reference = malloc(length);
+	UINT32	count;
+	UINT32	referenceCount;
+	UINT32	j;
+	cycles_t	wordTime;
+	cycles_t	referenceTime;
+	char	report[256];
+
+	if(!reference)
+		return SearchBytesWord(status, lhsBuf, rhsBuf, value, length, notEqual);
+
+	memcpy(reference, status, length);
+
+	referenceTime = osd_cycles();
+	referenceCount = SearchBytesReference(reference, lhsBuf, rhsBuf, value, length, notEqual);
+	referenceTime = osd_cycles() - referenceTime;
+
+	wordTime = osd_cycles();
+	count = SearchBytesWord(status, lhsBuf, rhsBuf, value, length, notEqual);
+	wordTime = osd_cycles() - wordTime;
+
+	for(j = 0; j < length; j++)
+		if(status[j] != reference[j])
+			break;
+
+	if((j < length) || (count != referenceCount))
+		sprintf(report, "cheat: %u bytes searched, the word compare differs from the byte loop at offset %u, %u results instead of %u\n",
+			length, j, count, referenceCount);
+	else
+		sprintf(report, "cheat: %u bytes searched in %.0f cycles with the word compare, in %.0f cycles with the byte loop (%.2fx), %u results\n",
+			length, (double)wordTime, (double)referenceTime, wordTime ? (double)referenceTime / wordTime : 0.0, count);
+
+	logerror("%s", report);
+	if(options.verbose)
+		printf("%s", report);
+
+	free(reference);
+
+	return count;
+}
+
+/*-------------------------------------------------
+    DoSearchBytesFast - 8 bit equal/not equal
+    search, compares four bytes at a time with the
+    status of the region in place of a result set
+
+    returns 0 if the search has to take the generic
+    path
+-------------------------------------------------*/
+
+static UINT8 DoSearchBytesFast(SearchInfo * search, SearchRegion * region)
+{
+	UINT8	* lhsBuf;
+	UINT8	* rhsBuf;
+	UINT8	notEqual;
+	UINT32	value = 0;
+	UINT32	count;
+
+	if(search->bytes != kSearchSize_8Bit)
+		return 0;
+
+	if(search->comparison == kSearchComparison_EqualTo)
+		notEqual = 0;
+	else if(search->comparison == kSearchComparison_NotEqual)
+		notEqual = 1;
+	else
+		return 0;
+
+	lhsBuf = GetSearchOperandBuffer(search->lhs, region);
+	rhsBuf = GetSearchOperandBuffer(search->rhs, region);
+
+	if(!lhsBuf && !rhsBuf)
+		return 0;
+
+	if(!lhsBuf || !rhsBuf)
+	{
+		// the other operand must be a value, and comparing it to a byte must reduce to comparing its low byte
+		if((search->lhs != kSearchOperand_Value) && (search->rhs != kSearchOperand_Value))
+			return 0;
+
+		if(SearchSignExtend(search, search->value) != SearchSignExtend(search, search->value & 0xFF))
+			return 0;
+
+		value = search->value & 0xFF;
+
+		if(!lhsBuf)
+			lhsBuf = rhsBuf;
+
+		rhsBuf = NULL;
+	}
+
+	if(options.cheat_bench)
+		count = CheckSearchBytes(region->status, lhsBuf, rhsBuf, value, region->length, notEqual);
+	else
+		count = SearchBytesWord(region->status, lhsBuf, rhsBuf, value, region->length, notEqual);
+
+	region->numResults = count;
+	search->numResults += count;
+
+	return 1;
+}
+
+/*-------------------------------------------------
+    TakeSearchSnapshot - copies the memory of the
+    enabled CPU regions for the current operand
+-------------------------------------------------*/
+
+static void TakeSearchSnapshot(SearchInfo * search, UINT8 take)
+{
+	int	i;
+
+	for(i = 0; i < search->regionListLength; i++)
+	{
+		SearchRegion	* region = &search->regionList[i];
+
+		region->currentValid = 0;
+
+		if(	take &&
+			(region->flags & kRegionFlag_Enabled) &&
+			(region->targetType == kRegionType_CPU) &&
+			region->current)
+		{
+			FillBufferFromRegion(region, region->current);
+
+			region->currentValid = 1;
+		}
+	}
+}
+
 static void DoSearch(SearchInfo * search)
 {
 	int	i, j;
 
 	search->numResults = 0;
 
+	TakeSearchSnapshot(search, (search->lhs == kSearchOperand_Current) || (search->rhs == kSearchOperand_Current));
+
 	if(search->bytes == kSearchSize_1Bit)
 	{
 		for(i = 0; i < search->regionListLength; i++)
@@ -9249,6 +9553,15 @@ static void DoSearch(SearchInfo * search)
 				UINT32	address;
 				UINT32	lhs, rhs;
 
+				// skip over runs of discarded candidates a word at a time
+				if(	!(j & 3) &&
+					(j + 4 <= region->length) &&
+					!*((UINT32 *)&region->status[j]))
+				{
+					j += 4 - increment;
+					continue;
+				}
+
 				address = region->address + j;
 
 				if(IsRegionOffsetValidBit(search, region, j))
@@ -9287,11 +9600,25 @@ static void DoSearch(SearchInfo * search)
 				continue;
 			}
 
+			if(	(region->flags & kRegionFlag_Enabled) &&
+				DoSearchBytesFast(search, region))
+			{
+				continue;
+			}
+
 			for(j = 0; j < lastAddress; j += increment)
 			{
 				UINT32	address;
 				UINT32	lhs, rhs;
 
+				if(	!(j & 3) &&
+					(j + 4 <= region->length) &&
+					!*((UINT32 *)&region->status[j]))
+				{
+					j += 4 - increment;
+					continue;
+				}
+
 				address = region->address + j;
 
 				if(IsRegionOffsetValid(search, region, j))
@@ -9312,6 +9639,8 @@ static void DoSearch(SearchInfo * search)
 			}
 		}
 	}
+
+	TakeSearchSnapshot(search, 0);
 }
 
 static UINT8 ** LookupHandlerMemory(UINT8 cpu, UINT32 address, UINT32 * outRelativeAddress)
@@ -9394,6 +9723,26 @@ static UINT32 DoCPURead(UINT8 cpu, UINT32 address, UINT8 bytes, UINT8 swap)
 	return 0;
 }
 
+static UINT32 DoSnapshotRead(UINT8 * buf, UINT32 address, UINT8 bytes, UINT8 swap)
+{
+	// the snapshot holds the bytes in CPU address order, so compose them the same way as DoCPURead
+	UINT32	data = 0;
+	UINT32	i;
+
+	if(swap)
+	{
+		for(i = 0; i < bytes; i++)
+			data |= buf[address + i] << (i * 8);
+	}
+	else
+	{
+		for(i = 0; i < bytes; i++)
+			data |= buf[address + i] << ((bytes - i - 1) * 8);
+	}
+
+	return data;
+}
+
 static UINT32 DoMemoryRead(UINT8 * buf, UINT32 address, UINT8 bytes, UINT8 swap, CPUInfo * info)
 {
 	UINT32	data = 0;
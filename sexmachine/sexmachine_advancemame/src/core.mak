@@ -27,6 +27,7 @@ COREOBJS = \
 	$(OBJ)/cpuint.o \
 	$(OBJ)/cpuintrf.o \
 	$(OBJ)/drawgfx.o \
+	$(OBJ)/drawspan.o \
 	$(OBJ)/driver.o \
 	$(OBJ)/fileio.o \
 	$(OBJ)/harddisk.o \
@@ -42,6 +43,7 @@ COREOBJS = \
 	$(OBJ)/memory.o \
 	$(OBJ)/palette.o \
 	$(OBJ)/png.o \
+	$(OBJ)/romcache.o \
 	$(OBJ)/romload.o \
 	$(OBJ)/sha1.o \
 	$(OBJ)/sound.o \
@@ -57,6 +59,7 @@ COREOBJS = \
 	$(OBJ)/version.o \
 	$(OBJ)/video.o \
 	$(OBJ)/xmlfile.o \
+	$(OBJ)/sound/adpcmcache.o \
 	$(OBJ)/sound/filter.o \
 	$(OBJ)/sound/flt_vol.o \
 	$(OBJ)/sound/flt_rc.o \
@@ -11,8 +11,10 @@
 
 #ifndef DECLARE
 
+#include "osdepend.h"
 #include "driver.h"
 #include "profiler.h"
+#include "drawspan.h"
 
 
 /***************************************************************************
@@ -44,6 +46,38 @@ static UINT8 is_raw[TRANSPARENCY_MODES];
 
 alpha_cache drawgfx_alpha_cache;
 
+/* a set decoded when drawn, one page of gfxdata at a time */
+#define LAZY_PAGE_SIZE			4096
+
+typedef struct _lazy_gfx lazy_gfx;
+struct _lazy_gfx
+{
+	gfx_element *gfx;				/* the set */
+	const UINT8 *src;				/* source data */
+	UINT32 *decoded;				/* bitmap of the decoded characters */
+	UINT32 remaining;				/* characters still to decode */
+};
+
+static lazy_gfx lazy_list[MAX_GFX_ELEMENTS];
+static int lazy_count;
+
+static UINT32 lazy_total_elements;	/* statistics for the log */
+static UINT32 lazy_decoded_elements;
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+static void select_span_kernels(void);
+static void drawgfx_exit(void);
+static void lazy_mark(gfx_element *gfx, UINT32 first, UINT32 count);
+static int defer_gfx(mame_bitmap *dest,const gfx_element *gfx,
+		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
+		const rectangle *clip,int transparency,int transparent_color,
+		int zoom,int scalex,int scaley,mame_bitmap *pri_buffer,UINT32 pri_mask);
+
 
 
 /***************************************************************************
@@ -111,6 +145,11 @@ void drawgfx_init(void)
 		for (byte = 0; byte < 256; byte++)
 			drawgfx_alpha_cache.alpha[lev][byte] = (byte * lev) >> 8;
 	alpha_set_level(255);
+
+	/* pick the fastest span kernels that match the scalar blitters */
+	select_span_kernels();
+
+	add_exit_callback(drawgfx_exit);
 }
 
 
@@ -170,7 +209,7 @@ static void calc_penusage(gfx_element *gfx, int num)
     on a specified layout
 -------------------------------------------------*/
 
-void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl)
+static void decode_element(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl)
 {
 	const UINT32 *xoffset = gl->extxoffs ? gl->extxoffs : gl->xoffset;
 	const UINT32 *yoffset = gl->extyoffs ? gl->extyoffs : gl->yoffset;
@@ -228,6 +267,18 @@ void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *g
 	calc_penusage(gfx, num);
 }
 
+void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl)
+{
+	/* the deferred elements must be drawn with the old data */
+	drawgfx_flush();
+
+	decode_element(gfx, num, src, gl);
+
+	/* the character is now decoded from the new data */
+	if (gfx->flags & GFX_DECODE_LAZY)
+		lazy_mark(gfx, num, 1);
+}
+
 
 
 /***************************************************************************
@@ -270,7 +321,7 @@ gfx_element *allocgfx(const gfx_layout *gl)
 	gfx->total_elements = gl->total;
 	gfx->color_granularity = 1 << gl->planes;
 	if (gfx->color_granularity <= 32)
-		gfx->pen_usage = malloc(gfx->total_elements * sizeof(*gfx->pen_usage));
+		gfx->pen_usage = calloc(gfx->total_elements, sizeof(*gfx->pen_usage));
 
 	/* raw graphics case */
 	if (gl->planeoffset[0] == GFX_RAW)
@@ -292,8 +343,8 @@ gfx_element *allocgfx(const gfx_layout *gl)
 		gfx->line_modulo = gfx->width;
 		gfx->char_modulo = gfx->line_modulo * gfx->height;
 
-		/* allocate memory for the data */
-		gfx->gfxdata = malloc(gfx->total_elements * gfx->char_modulo * sizeof(UINT8));
+		/* allocate memory for the data; zeroed, the characters decoded lazily are blank until drawn */
+		gfx->gfxdata = calloc(gfx->total_elements * gfx->char_modulo, sizeof(UINT8));
 	}
 
 	return gfx;
@@ -329,9 +380,152 @@ void decodegfx(gfx_element *gfx, const UINT8 *src, UINT32 first, UINT32 count)
 	/* otherwise, we get to manually decode */
 	else
 	{
+		drawgfx_flush();
 		for (c = first; c <= last; c++)
-			decodechar(gfx, c, src, &gfx->layout);
+			decode_element(gfx, c, src, &gfx->layout);
+	}
+
+	if (gfx->flags & GFX_DECODE_LAZY)
+		lazy_mark(gfx, first, count);
+}
+
+
+/*-------------------------------------------------
+    decodegfx_lazy - set up a graphics element to
+    be decoded when its characters are first drawn
+-------------------------------------------------*/
+
+void decodegfx_lazy(gfx_element *gfx, const UINT8 *src)
+{
+	lazy_gfx *lazy;
+	UINT32 *decoded = NULL;
+
+	assert(gfx);
+
+	if (lazy_count < MAX_GFX_ELEMENTS)
+		decoded = calloc((gfx->total_elements + 31) / 32, sizeof(*decoded));
+
+	/* without memory decode everything now */
+	if (!decoded)
+	{
+		decodegfx(gfx, src, 0, gfx->total_elements);
+		return;
 	}
+
+	/* the raw graphics get their pointer now, and only the pen usage later */
+	if ((gfx->flags & GFX_DONT_FREE_GFXDATA) && src)
+		gfx->gfxdata = (UINT8 *)src;
+
+	lazy = &lazy_list[lazy_count++];
+	lazy->gfx = gfx;
+	lazy->src = src;
+	lazy->decoded = decoded;
+	lazy->remaining = gfx->total_elements;
+
+	gfx->flags |= GFX_DECODE_LAZY;
+	lazy_total_elements += gfx->total_elements;
+}
+
+
+/*-------------------------------------------------
+    lazy_find - find the lazy state of a graphics
+    element; copies of the structure made by the
+    drivers are not found
+-------------------------------------------------*/
+
+static lazy_gfx *lazy_find(const gfx_element *gfx)
+{
+	int i;
+
+	for (i = 0; i < lazy_count; i++)
+		if (lazy_list[i].gfx == gfx)
+			return &lazy_list[i];
+
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    lazy_remove - forget the lazy state of a
+    graphics element
+-------------------------------------------------*/
+
+static void lazy_remove(lazy_gfx *lazy)
+{
+	lazy->gfx->flags &= ~GFX_DECODE_LAZY;
+	free(lazy->decoded);
+
+	*lazy = lazy_list[--lazy_count];
+}
+
+
+/*-------------------------------------------------
+    lazy_mark - mark a range of characters as
+    decoded
+-------------------------------------------------*/
+
+static void lazy_mark(gfx_element *gfx, UINT32 first, UINT32 count)
+{
+	lazy_gfx *lazy = lazy_find(gfx);
+	UINT32 c;
+
+	if (!lazy)
+		return;
+
+	for (c = first; c < first + count; c++)
+		if (!(lazy->decoded[c / 32] & (1 << (c % 32))))
+		{
+			lazy->decoded[c / 32] |= 1 << (c % 32);
+			lazy->remaining--;
+		}
+
+	if (lazy->remaining == 0)
+		lazy_remove(lazy);
+}
+
+
+/*-------------------------------------------------
+    gfx_element_decode - decode the page of
+    gfxdata holding a character of a lazy set, if
+    not already done
+-------------------------------------------------*/
+
+void gfx_element_decode(const gfx_element *constgfx, UINT32 code)
+{
+	lazy_gfx *lazy = lazy_find(constgfx);
+	gfx_element *gfx;
+	UINT32 first, last, per_page, c;
+
+	if (!lazy)
+		return;
+
+	gfx = lazy->gfx;
+	code %= gfx->total_elements;
+	if (lazy->decoded[code / 32] & (1 << (code % 32)))
+		return;
+
+	/* decode all the characters sharing the page, it is touched anyway */
+	per_page = (gfx->char_modulo && gfx->char_modulo < LAZY_PAGE_SIZE) ? LAZY_PAGE_SIZE / gfx->char_modulo : 1;
+	first = code - code % per_page;
+	last = first + per_page;
+	if (last > gfx->total_elements)
+		last = gfx->total_elements;
+
+	for (c = first; c < last; c++)
+		if (!(lazy->decoded[c / 32] & (1 << (c % 32))))
+		{
+			if (gfx->flags & GFX_DONT_FREE_GFXDATA)
+				calc_penusage(gfx, c);
+			else
+				decode_element(gfx, c, lazy->src, &gfx->layout);
+
+			lazy->decoded[c / 32] |= 1 << (c % 32);
+			lazy->remaining--;
+			lazy_decoded_elements++;
+		}
+
+	if (lazy->remaining == 0)
+		lazy_remove(lazy);
 }
 
 
@@ -345,6 +539,13 @@ void freegfx(gfx_element *gfx)
 	if (gfx == NULL)
 		return;
 
+	if (gfx->flags & GFX_DECODE_LAZY)
+	{
+		lazy_gfx *lazy = lazy_find(gfx);
+		if (lazy)
+			lazy_remove(lazy);
+	}
+
 	/* free our data */
 	if (gfx->layout.extyoffs)
 		free((void *)gfx->layout.extyoffs);
@@ -983,7 +1184,9 @@ void drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,NULL,0);
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,0,0,0,NULL,0))
+		common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,NULL,0);
 	profiler_mark(PROFILER_END);
 }
 
@@ -992,7 +1195,9 @@ void pdrawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color,UINT32 priority_mask)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,priority_bitmap,priority_mask | (1<<31));
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,0,0,0,priority_bitmap,priority_mask | (1<<31)))
+		common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,priority_bitmap,priority_mask | (1<<31));
 	profiler_mark(PROFILER_END);
 }
 
@@ -1001,7 +1206,9 @@ void mdrawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color,UINT32 priority_mask)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,priority_bitmap,priority_mask);
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,0,0,0,priority_bitmap,priority_mask))
+		common_drawgfx(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,priority_bitmap,priority_mask);
 	profiler_mark(PROFILER_END);
 }
 
@@ -1033,6 +1240,8 @@ void copybitmap(mame_bitmap *dest,mame_bitmap *src,int flipx,int flipy,int sx,in
 void copybitmap_remap(mame_bitmap *dest,mame_bitmap *src,int flipx,int flipy,int sx,int sy,
 		const rectangle *clip,int transparency,int transparent_color)
 {
+	drawgfx_flush();
+
 	profiler_mark(PROFILER_COPYBITMAP);
 
 	if (dest->depth == 8)
@@ -1085,6 +1294,7 @@ void copyscrollbitmap_remap(mame_bitmap *dest,mame_bitmap *src,
 	int srcwidth,srcheight,destwidth,destheight;
 	rectangle orig_clip;
 
+	drawgfx_flush();
 
 	if (clip)
 	{
@@ -1320,6 +1530,8 @@ void copyrozbitmap(mame_bitmap *dest,mame_bitmap *src,
 		UINT32 startx,UINT32 starty,int incxx,int incxy,int incyx,int incyy,int wraparound,
 		const rectangle *clip,int transparency,int transparent_color,UINT32 priority)
 {
+	drawgfx_flush();
+
 	profiler_mark(PROFILER_COPYBITMAP);
 
 	/* cheat, the core doesn't support TRANSPARENCY_NONE yet */
@@ -1359,6 +1571,8 @@ void fillbitmap(mame_bitmap *dest,pen_t pen,const rectangle *clip)
 {
 	int sx,sy,ex,ey,y;
 
+	drawgfx_flush();
+
 	sx = 0;
 	ex = dest->width - 1;
 	sy = 0;
@@ -2153,6 +2367,12 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 					}
 				}
 
+				/* unpacked elements go through the span kernels when enabled */
+				if( ex>sx && !(gfx->flags & GFX_PACKED) &&
+					drawspan_zoom8to16(source_base,gfx->line_modulo,sx,ex,sy,ey,x_index_base,y_index,dx,dy,
+							dest_bmp,pri_buffer,transparency,pal,color,transparent_color,pri_mask) )
+					ex = sx;
+
 				if( ex>sx )
 				{ /* skip if inner loop doesn't draw anything */
 					int y;
@@ -3513,8 +3733,10 @@ void drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color,int scalex, int scaley)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
-			clip,transparency,transparent_color,scalex,scaley,NULL,0);
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,1,scalex,scaley,NULL,0))
+		common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
+				clip,transparency,transparent_color,scalex,scaley,NULL,0);
 	profiler_mark(PROFILER_END);
 }
 
@@ -3524,8 +3746,10 @@ void pdrawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		UINT32 priority_mask)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
-			clip,transparency,transparent_color,scalex,scaley,priority_bitmap,priority_mask | (1<<31));
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,1,scalex,scaley,priority_bitmap,priority_mask | (1<<31)))
+		common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
+				clip,transparency,transparent_color,scalex,scaley,priority_bitmap,priority_mask | (1<<31));
 	profiler_mark(PROFILER_END);
 }
 
@@ -3535,8 +3759,10 @@ void mdrawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		UINT32 priority_mask)
 {
 	profiler_mark(PROFILER_DRAWGFX);
-	common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
-			clip,transparency,transparent_color,scalex,scaley,priority_bitmap,priority_mask);
+	gfx_element_prepare(gfx, code);
+	if (!defer_gfx(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,1,scalex,scaley,priority_bitmap,priority_mask))
+		common_drawgfxzoom(dest_bmp,gfx,code,color,flipx,flipy,sx,sy,
+				clip,transparency,transparent_color,scalex,scaley,priority_bitmap,priority_mask);
 	profiler_mark(PROFILER_END);
 }
 
@@ -3561,6 +3787,8 @@ void draw_crosshair(mame_bitmap *bitmap,int x,int y,const rectangle *clip,int pl
 	if (!crosshair_enable)
 		return;
 
+	drawgfx_flush();
+
 	white = get_white_pen();
 
 	for (i = 1;i < 6;i++)
@@ -3603,6 +3831,502 @@ void draw_crosshair(mame_bitmap *bitmap,int x,int y,const rectangle *clip,int pl
 }
 
 
+
+/***************************************************************************
+
+    Deferred drawing
+
+    Between drawgfx_defer_begin() and drawgfx_defer_end() the elements
+    are only recorded, and drawn together when the list is flushed. The
+    list is split in horizontal bands of the destination, and every band
+    draws all the elements in the original order with the clip restricted
+    to its rows, so the bands can be drawn in parallel with the same
+    result of the serial drawing. Any other drawing function flushes the
+    list first. The modes that depend on tables the driver can change
+    between the calls are drawn immediately.
+
+***************************************************************************/
+
+/* maximum number of bands, and minimum rows in a band */
+#define DEFER_BANDS				8
+#define DEFER_BAND_HEIGHT		16
+
+/* lists shorter than this are drawn in the calling thread */
+#define DEFER_PARALLEL_COUNT	16
+
+/* a recorded element */
+typedef struct _deferred_gfx deferred_gfx;
+struct _deferred_gfx
+{
+	const gfx_element *gfx;			/* element to draw */
+	UINT32		code;				/* code of the element */
+	UINT32		color;				/* color of the element */
+	UINT8		flipx;				/* horizontal flip */
+	UINT8		flipy;				/* vertical flip */
+	UINT8		transparency;		/* transparency mode */
+	UINT8		zoom;				/* 1 if drawn with common_drawgfxzoom() */
+	int			sx, sy;				/* position */
+	int			transparent_color;	/* transparent pen or pens */
+	int			scalex, scaley;		/* zoom factors, 16.16 */
+	mame_bitmap *pri_buffer;		/* priority bitmap, or NULL */
+	UINT32		pri_mask;			/* priority mask */
+	rectangle	clip;				/* clip rectangle */
+	int			min_y, max_y;		/* rows that the element can touch */
+};
+
+static int defer_active;				/* recording enabled */
+static mame_bitmap *defer_dest;			/* destination of the recorded elements */
+static int defer_shadow_lowpri;			/* pdrawgfx_shadow_lowpri of the recorded elements */
+static deferred_gfx *defer_list;		/* recorded elements */
+static int defer_count;					/* number of recorded elements */
+static int defer_max;					/* allocated elements */
+static int defer_min_y, defer_max_y;	/* rows touched by the recorded elements */
+static int defer_band_height;			/* rows of every band */
+
+static UINT32 defer_total_gfx;			/* statistics for the log */
+static UINT32 defer_total_lists;
+static UINT32 defer_total_bands;
+
+
+/*-------------------------------------------------
+    defer_gfx - record an element if the deferred
+    drawing is active; returns 0 if the element
+    must be drawn immediately
+-------------------------------------------------*/
+
+static int defer_gfx(mame_bitmap *dest,const gfx_element *gfx,
+		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
+		const rectangle *clip,int transparency,int transparent_color,
+		int zoom,int scalex,int scaley,mame_bitmap *pri_buffer,UINT32 pri_mask)
+{
+	deferred_gfx *cmd;
+	int size;
+
+	if (!defer_active)
+		return 0;
+
+	/* only the modes that don't use the global tables, nor report errors */
+	switch (transparency)
+	{
+		case TRANSPARENCY_NONE:
+		case TRANSPARENCY_PEN:
+		case TRANSPARENCY_PEN_RAW:
+		case TRANSPARENCY_PENS:
+		case TRANSPARENCY_COLOR:
+		case TRANSPARENCY_BLEND_RAW:
+			break;
+
+		case TRANSPARENCY_NONE_RAW:
+		case TRANSPARENCY_PENS_RAW:
+		case TRANSPARENCY_BLEND:
+			if (!zoom || (scalex == 0x10000 && scaley == 0x10000))
+				break;
+			/* fall through */
+
+		default:
+			drawgfx_flush();
+			return 0;
+	}
+
+	if (dest != defer_dest || pdrawgfx_shadow_lowpri != defer_shadow_lowpri)
+	{
+		drawgfx_flush();
+		defer_dest = dest;
+		defer_shadow_lowpri = pdrawgfx_shadow_lowpri;
+	}
+
+	if (defer_count == defer_max)
+	{
+		int max = defer_max ? defer_max * 2 : 256;
+		deferred_gfx *list = realloc(defer_list, max * sizeof(*list));
+
+		if (!list)
+		{
+			drawgfx_flush();
+			return 0;
+		}
+
+		defer_list = list;
+		defer_max = max;
+	}
+
+	cmd = &defer_list[defer_count];
+	cmd->gfx = gfx;
+	cmd->code = code;
+	cmd->color = color;
+	cmd->flipx = flipx;
+	cmd->flipy = flipy;
+	cmd->transparency = transparency;
+	cmd->zoom = zoom;
+	cmd->sx = sx;
+	cmd->sy = sy;
+	cmd->transparent_color = transparent_color;
+	cmd->scalex = scalex;
+	cmd->scaley = scaley;
+	cmd->pri_buffer = pri_buffer;
+	cmd->pri_mask = pri_mask;
+
+	if (clip)
+		cmd->clip = *clip;
+	else
+	{
+		cmd->clip.min_x = 0;
+		cmd->clip.max_x = dest->width - 1;
+		cmd->clip.min_y = 0;
+		cmd->clip.max_y = dest->height - 1;
+	}
+
+	/* rows touched, using the larger size for the swapped elements */
+	size = (gfx->width > gfx->height) ? gfx->width : gfx->height;
+	if (zoom)
+		size = (int)(((UINT64)size * ((scalex > scaley) ? scalex : scaley)) >> 16) + 1;
+
+	cmd->min_y = (sy > cmd->clip.min_y) ? sy : cmd->clip.min_y;
+	cmd->max_y = (sy + size - 1 < cmd->clip.max_y) ? sy + size - 1 : cmd->clip.max_y;
+	if (cmd->min_y < 0)
+		cmd->min_y = 0;
+	if (cmd->max_y >= dest->height)
+		cmd->max_y = dest->height - 1;
+
+	/* nothing to draw */
+	if (cmd->min_y > cmd->max_y)
+		return 1;
+
+	if (defer_count == 0 || cmd->min_y < defer_min_y)
+		defer_min_y = cmd->min_y;
+	if (defer_count == 0 || cmd->max_y > defer_max_y)
+		defer_max_y = cmd->max_y;
+
+	defer_count++;
+	defer_total_gfx++;
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    defer_band - draw the recorded elements
+    touching a band
+-------------------------------------------------*/
+
+static void defer_band(void *param, int band)
+{
+	int top = defer_min_y + band * defer_band_height;
+	int bottom = top + defer_band_height - 1;
+	int i;
+
+	if (bottom > defer_max_y)
+		bottom = defer_max_y;
+
+	for (i = 0; i < defer_count; i++)
+	{
+		const deferred_gfx *cmd = &defer_list[i];
+		rectangle clip;
+
+		if (cmd->max_y < top || cmd->min_y > bottom)
+			continue;
+
+		clip = cmd->clip;
+		if (clip.min_y < top)
+			clip.min_y = top;
+		if (clip.max_y > bottom)
+			clip.max_y = bottom;
+
+		if (cmd->zoom)
+			common_drawgfxzoom(defer_dest,cmd->gfx,cmd->code,cmd->color,cmd->flipx,cmd->flipy,cmd->sx,cmd->sy,
+					&clip,cmd->transparency,cmd->transparent_color,cmd->scalex,cmd->scaley,cmd->pri_buffer,cmd->pri_mask);
+		else
+			common_drawgfx(defer_dest,cmd->gfx,cmd->code,cmd->color,cmd->flipx,cmd->flipy,cmd->sx,cmd->sy,
+					&clip,cmd->transparency,cmd->transparent_color,cmd->pri_buffer,cmd->pri_mask);
+	}
+}
+
+
+/*-------------------------------------------------
+    drawgfx_flush - draw the recorded elements
+-------------------------------------------------*/
+
+void drawgfx_flush(void)
+{
+	int bands;
+
+	if (defer_count == 0)
+		return;
+
+	bands = (defer_max_y - defer_min_y + 1) / DEFER_BAND_HEIGHT;
+	if (bands > DEFER_BANDS)
+		bands = DEFER_BANDS;
+	if (bands < 1 || defer_count < DEFER_PARALLEL_COUNT)
+		bands = 1;
+	defer_band_height = (defer_max_y - defer_min_y + bands) / bands;
+
+	profiler_mark(PROFILER_DRAWGFX);
+	if (bands > 1)
+		osd_parallelize_frame(defer_band, NULL, bands);
+	else
+		defer_band(NULL, 0);
+	profiler_mark(PROFILER_END);
+
+	defer_total_lists++;
+	defer_total_bands += bands;
+	defer_count = 0;
+}
+
+
+/*-------------------------------------------------
+    drawgfx_defer_begin - start recording the
+    elements
+-------------------------------------------------*/
+
+void drawgfx_defer_begin(void)
+{
+	defer_active = 1;
+}
+
+
+/*-------------------------------------------------
+    drawgfx_defer_end - draw the recorded elements
+    and stop recording
+-------------------------------------------------*/
+
+void drawgfx_defer_end(void)
+{
+	drawgfx_flush();
+	defer_active = 0;
+	defer_dest = NULL;
+}
+
+
+/*-------------------------------------------------
+    drawgfx_exit - free the deferred list
+-------------------------------------------------*/
+
+static void drawgfx_exit(void)
+{
+	char report[256];
+
+	if (defer_total_lists)
+	{
+		sprintf(report, "drawgfx: %u elements deferred in %u lists, drawn in %.1f bands on average\n",
+				defer_total_gfx, defer_total_lists, (double)defer_total_bands / defer_total_lists);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+	}
+
+	if (lazy_total_elements)
+	{
+		sprintf(report, "drawgfx: %u of %u graphics elements decoded when drawn\n",
+				lazy_decoded_elements, lazy_total_elements);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+	}
+
+	free(defer_list);
+	defer_list = NULL;
+	defer_count = 0;
+	defer_max = 0;
+	defer_active = 0;
+	defer_dest = NULL;
+	defer_total_gfx = 0;
+	defer_total_lists = 0;
+	defer_total_bands = 0;
+	lazy_total_elements = 0;
+	lazy_decoded_elements = 0;
+}
+
+
+
+/***************************************************************************
+
+    Span kernel selection
+
+***************************************************************************/
+
+#define SPAN_STRESS_WIDTH		256
+#define SPAN_STRESS_HEIGHT		224
+#define SPAN_STRESS_SPRITES		96
+#define SPAN_STRESS_ELEMENTS	8
+#define SPAN_STRESS_SIZE		32
+#define SPAN_STRESS_LOOPS		4
+
+/*-------------------------------------------------
+    span_stress_reset - fill the destination and
+    priority bitmaps with a known pattern
+-------------------------------------------------*/
+
+static void span_stress_reset(mame_bitmap *dest, mame_bitmap *pri, mame_bitmap *copy)
+{
+	int x, y;
+
+	for (y = 0; y < dest->height; y++)
+		for (x = 0; x < dest->width; x++)
+		{
+			((UINT16 *)dest->line[y])[x] = x * 0x0101 + y;
+			((UINT16 *)copy->line[y])[x] = x + y * 0x0101;
+			((UINT8 *)pri->line[y])[x] = ((x * 7 + y * 3) & 0x1f) | (((x + y) % 11 == 0) ? 0x80 : 0x00);
+		}
+}
+
+
+/*-------------------------------------------------
+    span_stress - draw a crowd of sprites through
+    every mode the span kernels handle
+-------------------------------------------------*/
+
+static void span_stress(mame_bitmap *dest, mame_bitmap *pri, mame_bitmap *copy, const gfx_element *gfx)
+{
+	static const int modes[] =
+	{
+		TRANSPARENCY_NONE, TRANSPARENCY_NONE_RAW, TRANSPARENCY_PEN, TRANSPARENCY_PEN_RAW,
+		TRANSPARENCY_PENS, TRANSPARENCY_PENS_RAW
+	};
+	rectangle clip;
+	int i;
+
+	clip.min_x = 8;
+	clip.max_x = dest->width - 9;
+	clip.min_y = 8;
+	clip.max_y = dest->height - 9;
+
+	for (i = 0; i < SPAN_STRESS_SPRITES; i++)
+	{
+		int mode = modes[i % (sizeof(modes) / sizeof(modes[0]))];
+		int code = i % gfx->total_elements;
+		int color = (i / 3) % gfx->total_colors;
+		int flipx = i & 1;
+		int flipy = (i >> 1) & 1;
+		int sx = (i * 37) % (dest->width + SPAN_STRESS_SIZE) - SPAN_STRESS_SIZE;
+		int sy = (i * 53) % (dest->height + SPAN_STRESS_SIZE) - SPAN_STRESS_SIZE;
+		int trans = (mode == TRANSPARENCY_PENS || mode == TRANSPARENCY_PENS_RAW) ? 0x8001 : 0;
+		int colorbase = (mode == TRANSPARENCY_NONE_RAW || mode == TRANSPARENCY_PEN_RAW || mode == TRANSPARENCY_PENS_RAW) ? 0xfe00 - i * 16 : color;
+		mame_bitmap *pri_buffer = (i & 4) ? pri : NULL;
+		UINT32 pri_mask = ((0x5a5a5a5a >> (i & 7)) | 1) | (1 << 31);
+
+		drawgfx_core16(dest,gfx,code,colorbase,flipx,flipy,sx,sy,&clip,mode,trans,pri_buffer,pri_mask);
+
+		/* drawgfxzoom() has no raw opaque or raw masked modes */
+		if (mode == TRANSPARENCY_NONE_RAW || mode == TRANSPARENCY_PENS_RAW)
+			mode = TRANSPARENCY_PEN_RAW;
+		sx = (i * 29) % (dest->width + SPAN_STRESS_SIZE) - SPAN_STRESS_SIZE;
+		sy = (i * 41) % (dest->height + SPAN_STRESS_SIZE) - SPAN_STRESS_SIZE;
+		common_drawgfxzoom(dest,gfx,code,colorbase,flipx,flipy,sx,sy,&clip,mode,trans,
+				0x6000 + (i * 0x1400) % 0x18000,0x9000 + (i * 0x0c00) % 0x10000,pri_buffer,pri_mask);
+	}
+
+	copybitmap_core16(copy,dest,0,0,0,0,NULL,TRANSPARENCY_PEN_RAW,((UINT16 *)dest->line[16])[16]);
+}
+
+
+/*-------------------------------------------------
+    select_span_kernels - check every compiled
+    span kernel set against the scalar blitters
+    and enable the fastest exact one
+-------------------------------------------------*/
+
+static void select_span_kernels(void)
+{
+	const drawspan_kernels *best = NULL;
+	mame_bitmap *bitmap[2][3];
+	UINT16 *old_shadow_table = palette_shadow_table;
+	UINT16 *shadow_table;
+	pen_t colortable[SPAN_STRESS_ELEMENTS * 16];
+	gfx_element gfx;
+	cycles_t scalar_time = 0;
+	cycles_t best_time = 0;
+	char report[256];
+	int i, j, x, y;
+
+	drawspan_active = NULL;
+
+	/* a set of 4bpp sprites with runs of transparent pens */
+	memset(&gfx, 0, sizeof(gfx));
+	gfx.width = SPAN_STRESS_SIZE;
+	gfx.height = SPAN_STRESS_SIZE;
+	gfx.total_elements = SPAN_STRESS_ELEMENTS;
+	gfx.color_granularity = 16;
+	gfx.total_colors = SPAN_STRESS_ELEMENTS;
+	gfx.colortable = colortable;
+	gfx.line_modulo = SPAN_STRESS_SIZE;
+	gfx.char_modulo = SPAN_STRESS_SIZE * SPAN_STRESS_SIZE;
+	gfx.gfxdata = malloc(SPAN_STRESS_ELEMENTS * gfx.char_modulo);
+	shadow_table = malloc(65536 * sizeof(shadow_table[0]));
+	for (i = 0; i < 3 * 2; i++)
+		bitmap[i / 3][i % 3] = bitmap_alloc_depth(SPAN_STRESS_WIDTH, SPAN_STRESS_HEIGHT, (i % 3 == 1) ? 8 : 16);
+	if (!gfx.gfxdata || !shadow_table || !bitmap[0][0] || !bitmap[0][1] || !bitmap[0][2] || !bitmap[1][0] || !bitmap[1][1] || !bitmap[1][2])
+		goto done;
+
+	for (i = 0; i < SPAN_STRESS_ELEMENTS; i++)
+		for (y = 0; y < SPAN_STRESS_SIZE; y++)
+			for (x = 0; x < SPAN_STRESS_SIZE; x++)
+				gfx.gfxdata[i * gfx.char_modulo + y * gfx.line_modulo + x] =
+						((x / 8 + y / 4 + i) % 3 == 0) ? 0 : (x * 3 + y * 5 + i) & 0x0f;
+	for (i = 0; i < SPAN_STRESS_ELEMENTS * 16; i++)
+		colortable[i] = 0x7ff0 + i * 0x00f1;
+	for (i = 0; i < 65536; i++)
+		shadow_table[i] = i ^ 0x5555;
+	palette_shadow_table = shadow_table;
+
+	/* time the scalar blitters */
+	for (i = 0; i < SPAN_STRESS_LOOPS; i++)
+	{
+		cycles_t start;
+
+		span_stress_reset(bitmap[0][0], bitmap[0][1], bitmap[0][2]);
+		start = osd_cycles();
+		span_stress(bitmap[0][0], bitmap[0][1], bitmap[0][2], &gfx);
+		scalar_time += osd_cycles() - start;
+	}
+
+	/* check and time every kernel set */
+	for (j = 0; drawspan_list[j] != NULL; j++)
+	{
+		cycles_t time = 0;
+		int exact = 1;
+
+		drawspan_active = drawspan_list[j];
+		for (i = 0; i < SPAN_STRESS_LOOPS; i++)
+		{
+			cycles_t start;
+
+			span_stress_reset(bitmap[1][0], bitmap[1][1], bitmap[1][2]);
+			start = osd_cycles();
+			span_stress(bitmap[1][0], bitmap[1][1], bitmap[1][2], &gfx);
+			time += osd_cycles() - start;
+		}
+		drawspan_active = NULL;
+
+		for (y = 0; y < SPAN_STRESS_HEIGHT; y++)
+			for (i = 0; i < 3; i++)
+				if (memcmp(bitmap[0][i]->line[y], bitmap[1][i]->line[y], SPAN_STRESS_WIDTH * bitmap[0][i]->depth / 8) != 0)
+					exact = 0;
+
+		sprintf(report, "drawgfx: %s span kernels %s, %u cycles against %u for the scalar blitters\n",
+				drawspan_list[j]->name, exact ? "exact" : "NOT exact", (UINT32)time, (UINT32)scalar_time);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+
+		if (exact && time < scalar_time && (best == NULL || time < best_time))
+		{
+			best = drawspan_list[j];
+			best_time = time;
+		}
+	}
+
+done:
+	palette_shadow_table = old_shadow_table;
+	for (i = 0; i < 3 * 2; i++)
+		if (bitmap[i / 3][i % 3])
+			bitmap_free(bitmap[i / 3][i % 3]);
+	free(shadow_table);
+	free(gfx.gfxdata);
+
+	drawspan_active = best;
+	logerror("drawgfx: using %s\n", best ? best->name : "the scalar blitters");
+}
+
+
 #else /* DECLARE */
 
 /* -------------------- included inline section --------------------- */
@@ -5204,6 +5928,12 @@ DECLARE(drawgfx_core,(
 			}
 		}
 
+		/* unpacked elements on 16bpp bitmaps go through the span kernels when enabled */
+		if (DEPTH == 16 && drawspan_active && !(gfx->flags & GFX_PACKED) &&
+				drawspan_blockmove8to16(sd,sw,sh,sm,ls,ts,flipx,flipy,(UINT16 *)dd,dw,dh,dm,
+						transparency,paldata,color,transparent_color,pribuf,pri_mask,afterdrawmask))
+			return;
+
 		switch (transparency)
 		{
 			case TRANSPARENCY_NONE:
@@ -5424,6 +6154,8 @@ DECLARE(copybitmap_core,(
 				break;
 
 			case TRANSPARENCY_PEN_RAW:
+				if (DEPTH == 16 && !flipx && drawspan_copy16((const UINT16 *)sd,sw,sh,sm,(UINT16 *)dd,dm,transparent_color))
+					break;
 				BLOCKMOVE(NtoN_transpen_noremap,flipx,(sd,sw,sh,sm,dd,dm,transparent_color));
 				break;
 
@@ -5725,6 +6457,8 @@ DECLAREG(draw_scanline, (
 		mame_bitmap *bitmap,int x,int y,int length,
 		const DATA_TYPE *src,pen_t *pens,int transparent_pen),
 {
+	drawgfx_flush();
+
 	/* 8bpp destination */
 	if (bitmap->depth == 8)
 	{
@@ -5868,6 +6602,8 @@ DECLAREG(pdraw_scanline, (
 		mame_bitmap *bitmap,int x,int y,int length,
 		const DATA_TYPE *src,pen_t *pens,int transparent_pen,int pri),
 {
+	drawgfx_flush();
+
 	/* 8bpp destination */
 	if (bitmap->depth == 8)
 	{
@@ -6054,6 +6790,8 @@ DECLAREG(extract_scanline, (
 		mame_bitmap *bitmap,int x,int y,int length,
 		DATA_TYPE *dst),
 {
+	drawgfx_flush();
+
 	/* 8bpp destination */
 	if (bitmap->depth == 8)
 	{
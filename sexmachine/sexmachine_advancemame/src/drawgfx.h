@@ -87,6 +87,7 @@ struct _gfx_element
 #define GFX_PACKED				1	/* two 4bpp pixels are packed in one byte of gfxdata */
 #define GFX_SWAPXY				2	/* characters are mirrored along the top-left/bottom-right diagonal */
 #define GFX_DONT_FREE_GFXDATA	4	/* gfxdata was not malloc()ed, so don't free it on exit */
+#define GFX_DECODE_LAZY			8	/* some characters are decoded only when first drawn */
 
 
 struct _gfx_decode
@@ -158,6 +159,8 @@ void drawgfx_init(void);
 void decodechar(gfx_element *gfx,int num,const unsigned char *src,const gfx_layout *gl);
 gfx_element *allocgfx(const gfx_layout *gl);
 void decodegfx(gfx_element *gfx, const UINT8 *src, UINT32 first, UINT32 count);
+void decodegfx_lazy(gfx_element *gfx, const UINT8 *src);
+void gfx_element_decode(const gfx_element *gfx, UINT32 code);
 void freegfx(gfx_element *gfx);
 void drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
@@ -188,6 +191,14 @@ void extract_scanline8(mame_bitmap *bitmap,int x,int y,int length,UINT8 *dst);
 void extract_scanline16(mame_bitmap *bitmap,int x,int y,int length,UINT16 *dst);
 
 
+/* decode a character of a lazy set before using its pixel data or pen usage */
+INLINE void gfx_element_prepare(const gfx_element *gfx, UINT32 code)
+{
+	if (gfx->flags & GFX_DECODE_LAZY)
+		gfx_element_decode(gfx, code);
+}
+
+
 /* Alpha blending functions */
 INLINE void alpha_set_level(int level)
 {
@@ -277,6 +288,11 @@ void mdrawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color,int scalex,int scaley,
 		UINT32 priority_mask);
 
+/* record the drawgfx() calls and draw them in parallel bands, see drawgfx.c */
+void drawgfx_defer_begin(void);
+void drawgfx_defer_end(void);
+void drawgfx_flush(void);
+
 void drawgfx_toggle_crosshair(void);
 void draw_crosshair(mame_bitmap *bitmap,int x,int y,const rectangle *clip,int player);
 
@@ -0,0 +1,1142 @@
+/***************************************************************************
+
+    drawspan.c
+
+    Vectorized span kernels for the 8bpp to 16bpp element blitters.
+
+    The blitters in drawgfx.c walk the element rows and hand each
+    clipped run of source pens to one of the kernels below, which always
+    run left to right: flipped and zoomed rows are first gathered into a
+    temporary run of pens. Every kernel must produce exactly the same
+    pixels as the scalar blockmove macros; drawgfx_init() checks this
+    and times the kernel sets against the macros before enabling one.
+
+    The portable kernels work on four pens at a time in a longword, and
+    are what the ARMv6 targets get. SSE2 and NEON versions of the hot
+    raw pen kernels are compiled when the compiler targets them.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "drawspan.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DRAWSPAN_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef __SSE2__
+#define DRAWSPAN_SSE2
+#include <emmintrin.h>
+#endif
+
+
+
+/***************************************************************************
+    MACROS
+***************************************************************************/
+
+/* two 16bpp pixels in a longword, a at the lower address */
+#ifdef LSB_FIRST
+#define PAIR(a,b)			((UINT32)(UINT16)(a) | ((UINT32)(UINT16)(b) << 16))
+#else
+#define PAIR(a,b)			(((UINT32)(UINT16)(a) << 16) | (UINT32)(UINT16)(b))
+#endif
+
+/* four pens in a longword, in a fixed order */
+#define QUAD(s)				((UINT32)(s)[0] | ((UINT32)(s)[1] << 8) | ((UINT32)(s)[2] << 16) | ((UINT32)(s)[3] << 24))
+
+/* nonzero if any byte of a longword is zero */
+#define HAS_ZERO_BYTE(x)	(((x) - 0x01010101) & ~(x) & 0x80808080)
+
+/* same test as PEN_IS_OPAQUE in drawgfx.c */
+#define PEN_IS_OPAQUE(c)	((((1 << (c)) & transmask)) == 0)
+
+#define IS_DST_ALIGNED(d)	(((FPTR)(d) & 2) == 0)
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* the parameters shared by all the spans of a blit */
+typedef struct _span_state span_state;
+struct _span_state
+{
+	const pen_t *	paldata;		/* lookup table, or NULL for raw pens */
+	UINT32			colorbase;		/* base of the raw pens */
+	int				transpen;		/* transparent pen, or -1 */
+	UINT32			transmask;		/* mask of the transparent pens, or 0 */
+	UINT32			pmask;			/* priority mask */
+	int				afterdraw;		/* priority marked by pdrawgfx() */
+	int				zoom;			/* use the pdrawgfxzoom() priority rules */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+const drawspan_kernels *drawspan_active;
+
+
+
+/***************************************************************************
+    INLINE FUNCTIONS
+***************************************************************************/
+
+/* two 16bpp pixels as a longword; memcpy avoids the aliasing and alignment
+   rules of a pointer cast, and the compilers make it a single access */
+INLINE UINT32 load_pair(const UINT16 *src)
+{
+	UINT32 pair;
+	memcpy(&pair, src, sizeof(pair));
+	return pair;
+}
+
+
+INLINE void store_pair(UINT16 *dst, UINT32 pair)
+{
+	memcpy(dst, &pair, sizeof(pair));
+}
+
+
+
+/***************************************************************************
+    PORTABLE KERNELS
+***************************************************************************/
+
+/*-------------------------------------------------
+    opaque_raw_generic - colorbase + pen, two
+    pixels per longword store
+-------------------------------------------------*/
+
+static void opaque_raw_generic(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase)
+{
+	/* the pens fit in 8 bits, so only bit 15 of the base can carry out of a pixel */
+	UINT32 base2 = (colorbase & 0xffff) * 0x00010001;
+	UINT32 baselo = base2 & 0x7fff7fff;
+	UINT32 basehi = base2 & 0x80008000;
+
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		*dst++ = colorbase + *src++;
+		count--;
+	}
+	while (count >= 4)
+	{
+		store_pair(&dst[0], (PAIR(src[0], src[1]) + baselo) ^ basehi);
+		store_pair(&dst[2], (PAIR(src[2], src[3]) + baselo) ^ basehi);
+		dst += 4;
+		src += 4;
+		count -= 4;
+	}
+	while (count-- > 0)
+		*dst++ = colorbase + *src++;
+}
+
+
+/*-------------------------------------------------
+    opaque_lut_generic - paldata[pen]
+-------------------------------------------------*/
+
+static void opaque_lut_generic(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata)
+{
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		*dst++ = paldata[*src++];
+		count--;
+	}
+	while (count >= 4)
+	{
+		store_pair(&dst[0], PAIR(paldata[src[0]], paldata[src[1]]));
+		store_pair(&dst[2], PAIR(paldata[src[2]], paldata[src[3]]));
+		dst += 4;
+		src += 4;
+		count -= 4;
+	}
+	while (count-- > 0)
+		*dst++ = paldata[*src++];
+}
+
+
+/*-------------------------------------------------
+    transpen_raw_generic - colorbase + pen,
+    skipping transpen; runs of four transparent
+    or four opaque pens take a single test
+-------------------------------------------------*/
+
+static void transpen_raw_generic(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, int transpen)
+{
+	UINT32 base2 = (colorbase & 0xffff) * 0x00010001;
+	UINT32 baselo = base2 & 0x7fff7fff;
+	UINT32 basehi = base2 & 0x80008000;
+	UINT32 trans4 = transpen * 0x01010101;
+
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		if (*src != transpen) *dst = colorbase + *src;
+		dst++;
+		src++;
+		count--;
+	}
+	while (count >= 4)
+	{
+		UINT32 xod4 = QUAD(src) ^ trans4;
+
+		if (xod4 != 0)
+		{
+			if (!HAS_ZERO_BYTE(xod4))
+			{
+				store_pair(&dst[0], (PAIR(src[0], src[1]) + baselo) ^ basehi);
+				store_pair(&dst[2], (PAIR(src[2], src[3]) + baselo) ^ basehi);
+			}
+			else
+			{
+				if (xod4 & 0x000000ff) dst[0] = colorbase + src[0];
+				if (xod4 & 0x0000ff00) dst[1] = colorbase + src[1];
+				if (xod4 & 0x00ff0000) dst[2] = colorbase + src[2];
+				if (xod4 & 0xff000000) dst[3] = colorbase + src[3];
+			}
+		}
+		dst += 4;
+		src += 4;
+		count -= 4;
+	}
+	while (count-- > 0)
+	{
+		if (*src != transpen) *dst = colorbase + *src;
+		dst++;
+		src++;
+	}
+}
+
+
+/*-------------------------------------------------
+    transpen_lut_generic - paldata[pen], skipping
+    transpen
+-------------------------------------------------*/
+
+static void transpen_lut_generic(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata, int transpen)
+{
+	UINT32 trans4 = transpen * 0x01010101;
+
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		if (*src != transpen) *dst = paldata[*src];
+		dst++;
+		src++;
+		count--;
+	}
+	while (count >= 4)
+	{
+		UINT32 xod4 = QUAD(src) ^ trans4;
+
+		if (xod4 != 0)
+		{
+			if (!HAS_ZERO_BYTE(xod4))
+			{
+				store_pair(&dst[0], PAIR(paldata[src[0]], paldata[src[1]]));
+				store_pair(&dst[2], PAIR(paldata[src[2]], paldata[src[3]]));
+			}
+			else
+			{
+				if (xod4 & 0x000000ff) dst[0] = paldata[src[0]];
+				if (xod4 & 0x0000ff00) dst[1] = paldata[src[1]];
+				if (xod4 & 0x00ff0000) dst[2] = paldata[src[2]];
+				if (xod4 & 0xff000000) dst[3] = paldata[src[3]];
+			}
+		}
+		dst += 4;
+		src += 4;
+		count -= 4;
+	}
+	while (count-- > 0)
+	{
+		if (*src != transpen) *dst = paldata[*src];
+		dst++;
+		src++;
+	}
+}
+
+
+/*-------------------------------------------------
+    transmask_raw_generic - colorbase + pen,
+    skipping the pens in transmask
+-------------------------------------------------*/
+
+static void transmask_raw_generic(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, UINT32 transmask)
+{
+	UINT32 base2 = (colorbase & 0xffff) * 0x00010001;
+	UINT32 baselo = base2 & 0x7fff7fff;
+	UINT32 basehi = base2 & 0x80008000;
+
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		if (PEN_IS_OPAQUE(*src)) *dst = colorbase + *src;
+		dst++;
+		src++;
+		count--;
+	}
+	while (count >= 2)
+	{
+		int opaque0 = PEN_IS_OPAQUE(src[0]);
+		int opaque1 = PEN_IS_OPAQUE(src[1]);
+
+		if (opaque0 && opaque1)
+			store_pair(dst, (PAIR(src[0], src[1]) + baselo) ^ basehi);
+		else
+		{
+			if (opaque0) dst[0] = colorbase + src[0];
+			if (opaque1) dst[1] = colorbase + src[1];
+		}
+		dst += 2;
+		src += 2;
+		count -= 2;
+	}
+	if (count > 0 && PEN_IS_OPAQUE(*src))
+		*dst = colorbase + *src;
+}
+
+
+/*-------------------------------------------------
+    transmask_lut_generic - paldata[pen],
+    skipping the pens in transmask
+-------------------------------------------------*/
+
+static void transmask_lut_generic(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata, UINT32 transmask)
+{
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		if (PEN_IS_OPAQUE(*src)) *dst = paldata[*src];
+		dst++;
+		src++;
+		count--;
+	}
+	while (count >= 2)
+	{
+		int opaque0 = PEN_IS_OPAQUE(src[0]);
+		int opaque1 = PEN_IS_OPAQUE(src[1]);
+
+		if (opaque0 && opaque1)
+			store_pair(dst, PAIR(paldata[src[0]], paldata[src[1]]));
+		else
+		{
+			if (opaque0) dst[0] = paldata[src[0]];
+			if (opaque1) dst[1] = paldata[src[1]];
+		}
+		dst += 2;
+		src += 2;
+		count -= 2;
+	}
+	if (count > 0 && PEN_IS_OPAQUE(*src))
+		*dst = paldata[*src];
+}
+
+
+/*-------------------------------------------------
+    pri_pixel - one pixel under the pdrawgfx()
+    priority rules
+-------------------------------------------------*/
+
+INLINE void pri_pixel(UINT16 *dst, UINT8 *pri, UINT32 n, UINT32 pmask, int afterdraw)
+{
+	if (((1 << (*pri & 0x1f)) & pmask) == 0)
+	{
+		if (*pri & 0x80)
+			*dst = palette_shadow_table[n];
+		else
+			*dst = n;
+	}
+	*pri = (*pri & 0x7f) | afterdraw;
+}
+
+
+/*-------------------------------------------------
+    pri_generic - pdrawgfx() priority rules;
+    runs of four transparent pens are skipped
+    with a single test
+-------------------------------------------------*/
+
+static void pri_generic(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+		int transpen, UINT32 transmask, UINT32 pmask, int afterdraw)
+{
+	UINT32 trans4 = transpen * 0x01010101;
+
+	while (count > 0)
+	{
+		int n = MIN(count, 4);
+		int i;
+
+		if (n < 4 || transpen < 0 || QUAD(src) != trans4)
+			for (i = 0; i < n; i++)
+			{
+				int col = src[i];
+
+				if (col != transpen && (transmask == 0 || PEN_IS_OPAQUE(col)))
+					pri_pixel(&dst[i], &pri[i], paldata ? paldata[col] : colorbase + col, pmask, afterdraw);
+			}
+		dst += n;
+		pri += n;
+		src += n;
+		count -= n;
+	}
+}
+
+
+/*-------------------------------------------------
+    pri_zoom_generic - pdrawgfxzoom() priority
+    rules
+-------------------------------------------------*/
+
+static void pri_zoom_generic(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+		int transpen, UINT32 transmask, UINT32 pmask)
+{
+	UINT32 trans4 = transpen * 0x01010101;
+
+	while (count > 0)
+	{
+		int n = MIN(count, 4);
+		int i;
+
+		if (n < 4 || transpen < 0 || QUAD(src) != trans4)
+			for (i = 0; i < n; i++)
+			{
+				int col = src[i];
+
+				if (col != transpen && (transmask == 0 || PEN_IS_OPAQUE(col)))
+				{
+					if (((1 << pri[i]) & pmask) == 0)
+						dst[i] = paldata ? paldata[col] : colorbase + col;
+					pri[i] = 31;
+				}
+			}
+		dst += n;
+		pri += n;
+		src += n;
+		count -= n;
+	}
+}
+
+
+/*-------------------------------------------------
+    copy_transpen_generic - 16bpp copy skipping
+    transpen, two pixels per longword when the
+    source and destination are aligned alike
+-------------------------------------------------*/
+
+static void copy_transpen_generic(UINT16 *dst, const UINT16 *src, int count, int transpen)
+{
+	if (transpen < 0 || transpen > 0xffff)
+	{
+		memcpy(dst, src, count * sizeof(dst[0]));
+		return;
+	}
+
+	if (!IS_DST_ALIGNED(dst) && count > 0)
+	{
+		if (*src != transpen) *dst = *src;
+		dst++;
+		src++;
+		count--;
+	}
+	if (IS_DST_ALIGNED(src))
+	{
+		UINT32 trans2 = transpen * 0x00010001;
+
+		while (count >= 2)
+		{
+			UINT32 xod2 = load_pair(src) ^ trans2;
+
+			if ((xod2 & 0x0000ffff) && (xod2 & 0xffff0000))
+				store_pair(dst, load_pair(src));
+			else if (xod2 != 0)
+			{
+				if (src[0] != transpen) dst[0] = src[0];
+				if (src[1] != transpen) dst[1] = src[1];
+			}
+			dst += 2;
+			src += 2;
+			count -= 2;
+		}
+	}
+	while (count-- > 0)
+	{
+		if (*src != transpen) *dst = *src;
+		dst++;
+		src++;
+	}
+}
+
+
+static const drawspan_kernels drawspan_generic =
+{
+	"portable",
+	opaque_raw_generic,
+	opaque_lut_generic,
+	transpen_raw_generic,
+	transpen_lut_generic,
+	transmask_raw_generic,
+	transmask_lut_generic,
+	pri_generic,
+	pri_zoom_generic,
+	copy_transpen_generic
+};
+
+
+
+/***************************************************************************
+    SSE2 KERNELS
+***************************************************************************/
+
+#ifdef DRAWSPAN_SSE2
+
+/*-------------------------------------------------
+    opaque_raw_sse2 - sixteen pens per step
+-------------------------------------------------*/
+
+static void opaque_raw_sse2(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i base = _mm_set1_epi16((INT16)colorbase);
+
+	while (count >= 16)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i *)src);
+
+		_mm_storeu_si128((__m128i *)dst, _mm_add_epi16(_mm_unpacklo_epi8(s, zero), base));
+		_mm_storeu_si128((__m128i *)(dst + 8), _mm_add_epi16(_mm_unpackhi_epi8(s, zero), base));
+		dst += 16;
+		src += 16;
+		count -= 16;
+	}
+	if (count > 0)
+		opaque_raw_generic(dst, src, count, colorbase);
+}
+
+
+/*-------------------------------------------------
+    transpen_raw_sse2 - sixteen pens per step,
+    merging the transparent ones from the
+    destination
+-------------------------------------------------*/
+
+static void transpen_raw_sse2(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, int transpen)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i base = _mm_set1_epi16((INT16)colorbase);
+	const __m128i trans = _mm_set1_epi8((INT8)transpen);
+
+	while (count >= 16)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i *)src);
+		__m128i m = _mm_cmpeq_epi8(s, trans);
+		int bits = _mm_movemask_epi8(m);
+
+		if (bits != 0xffff)
+		{
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(s, zero), base);
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(s, zero), base);
+
+			if (bits != 0)
+			{
+				__m128i mlo = _mm_unpacklo_epi8(m, m);
+				__m128i mhi = _mm_unpackhi_epi8(m, m);
+
+				lo = _mm_or_si128(_mm_and_si128(mlo, _mm_loadu_si128((const __m128i *)dst)), _mm_andnot_si128(mlo, lo));
+				hi = _mm_or_si128(_mm_and_si128(mhi, _mm_loadu_si128((const __m128i *)(dst + 8))), _mm_andnot_si128(mhi, hi));
+			}
+			_mm_storeu_si128((__m128i *)dst, lo);
+			_mm_storeu_si128((__m128i *)(dst + 8), hi);
+		}
+		dst += 16;
+		src += 16;
+		count -= 16;
+	}
+	if (count > 0)
+		transpen_raw_generic(dst, src, count, colorbase, transpen);
+}
+
+
+/*-------------------------------------------------
+    transpen_lut_sse2 - sixteen pens tested per
+    step, looked up one at a time
+-------------------------------------------------*/
+
+static void transpen_lut_sse2(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata, int transpen)
+{
+	const __m128i trans = _mm_set1_epi8((INT8)transpen);
+
+	while (count >= 16)
+	{
+		int bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)src), trans));
+
+		if (bits == 0)
+			opaque_lut_generic(dst, src, 16, paldata);
+		else if (bits != 0xffff)
+		{
+			int i;
+
+			for (i = 0; i < 16; i++)
+				if (!(bits & (1 << i)))
+					dst[i] = paldata[src[i]];
+		}
+		dst += 16;
+		src += 16;
+		count -= 16;
+	}
+	if (count > 0)
+		transpen_lut_generic(dst, src, count, paldata, transpen);
+}
+
+
+/*-------------------------------------------------
+    copy_transpen_sse2 - eight pixels per step
+-------------------------------------------------*/
+
+static void copy_transpen_sse2(UINT16 *dst, const UINT16 *src, int count, int transpen)
+{
+	__m128i trans;
+
+	if (transpen < 0 || transpen > 0xffff)
+	{
+		copy_transpen_generic(dst, src, count, transpen);
+		return;
+	}
+
+	trans = _mm_set1_epi16((INT16)transpen);
+	while (count >= 8)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i *)src);
+		__m128i m = _mm_cmpeq_epi16(s, trans);
+		int bits = _mm_movemask_epi8(m);
+
+		if (bits != 0xffff)
+		{
+			if (bits != 0)
+				s = _mm_or_si128(_mm_and_si128(m, _mm_loadu_si128((const __m128i *)dst)), _mm_andnot_si128(m, s));
+			_mm_storeu_si128((__m128i *)dst, s);
+		}
+		dst += 8;
+		src += 8;
+		count -= 8;
+	}
+	if (count > 0)
+		copy_transpen_generic(dst, src, count, transpen);
+}
+
+
+static const drawspan_kernels drawspan_sse2 =
+{
+	"SSE2",
+	opaque_raw_sse2,
+	opaque_lut_generic,
+	transpen_raw_sse2,
+	transpen_lut_sse2,
+	transmask_raw_generic,
+	transmask_lut_generic,
+	pri_generic,
+	pri_zoom_generic,
+	copy_transpen_sse2
+};
+
+#endif
+
+
+
+/***************************************************************************
+    NEON KERNELS
+***************************************************************************/
+
+#ifdef DRAWSPAN_NEON
+
+/*-------------------------------------------------
+    opaque_raw_neon - sixteen pens per step
+-------------------------------------------------*/
+
+static void opaque_raw_neon(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase)
+{
+	const uint16x8_t base = vdupq_n_u16((UINT16)colorbase);
+
+	while (count >= 16)
+	{
+		uint8x16_t s = vld1q_u8(src);
+
+		vst1q_u16(dst, vaddq_u16(vmovl_u8(vget_low_u8(s)), base));
+		vst1q_u16(dst + 8, vaddq_u16(vmovl_u8(vget_high_u8(s)), base));
+		dst += 16;
+		src += 16;
+		count -= 16;
+	}
+	if (count > 0)
+		opaque_raw_generic(dst, src, count, colorbase);
+}
+
+
+/*-------------------------------------------------
+    transpen_raw_neon - sixteen pens per step,
+    merging the transparent ones from the
+    destination
+-------------------------------------------------*/
+
+static void transpen_raw_neon(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, int transpen)
+{
+	const uint16x8_t base = vdupq_n_u16((UINT16)colorbase);
+	const uint8x16_t trans = vdupq_n_u8((UINT8)transpen);
+
+	while (count >= 16)
+	{
+		uint8x16_t s = vld1q_u8(src);
+		uint8x16_t m = vceqq_u8(s, trans);
+		uint64x2_t m64 = vreinterpretq_u64_u8(m);
+		UINT64 all = vgetq_lane_u64(m64, 0) & vgetq_lane_u64(m64, 1);
+		UINT64 any = vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1);
+
+		if (all != ~(UINT64)0)
+		{
+			uint16x8_t lo = vaddq_u16(vmovl_u8(vget_low_u8(s)), base);
+			uint16x8_t hi = vaddq_u16(vmovl_u8(vget_high_u8(s)), base);
+
+			if (any != 0)
+			{
+				uint16x8_t mlo = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_low_u8(m))));
+				uint16x8_t mhi = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_high_u8(m))));
+
+				lo = vbslq_u16(mlo, vld1q_u16(dst), lo);
+				hi = vbslq_u16(mhi, vld1q_u16(dst + 8), hi);
+			}
+			vst1q_u16(dst, lo);
+			vst1q_u16(dst + 8, hi);
+		}
+		dst += 16;
+		src += 16;
+		count -= 16;
+	}
+	if (count > 0)
+		transpen_raw_generic(dst, src, count, colorbase, transpen);
+}
+
+
+/*-------------------------------------------------
+    pri_table_neon - load the 32 entry table of
+    the priorities hidden by pmask
+-------------------------------------------------*/
+
+INLINE uint8x8x4_t pri_table_neon(UINT32 pmask)
+{
+	UINT8 hidden[32];
+	uint8x8x4_t table;
+	int i;
+
+	for (i = 0; i < 32; i++)
+		hidden[i] = ((pmask >> i) & 1) ? 0xff : 0x00;
+	table.val[0] = vld1_u8(&hidden[0]);
+	table.val[1] = vld1_u8(&hidden[8]);
+	table.val[2] = vld1_u8(&hidden[16]);
+	table.val[3] = vld1_u8(&hidden[24]);
+	return table;
+}
+
+
+/*-------------------------------------------------
+    pri_neon - pdrawgfx() priority rules, eight
+    raw pens per step; steps that would draw a
+    shadow go through the portable kernel
+-------------------------------------------------*/
+
+static void pri_neon(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+		int transpen, UINT32 transmask, UINT32 pmask, int afterdraw)
+{
+	uint8x8x4_t table;
+	uint16x8_t base;
+	uint8x8_t trans, after;
+
+	if (paldata != NULL || transmask != 0)
+	{
+		pri_generic(dst, pri, src, count, paldata, colorbase, transpen, transmask, pmask, afterdraw);
+		return;
+	}
+
+	table = pri_table_neon(pmask);
+	base = vdupq_n_u16((UINT16)colorbase);
+	trans = vdup_n_u8((UINT8)transpen);
+	after = vdup_n_u8((UINT8)afterdraw);
+	while (count >= 8)
+	{
+		uint8x8_t s = vld1_u8(src);
+		uint8x8_t draw = (transpen >= 0) ? vmvn_u8(vceq_u8(s, trans)) : vdup_n_u8(0xff);
+
+		if (vget_lane_u64(vreinterpret_u64_u8(draw), 0) != 0)
+		{
+			uint8x8_t p = vld1_u8(pri);
+			uint8x8_t visible = vbic_u8(draw, vtbl4_u8(table, vand_u8(p, vdup_n_u8(0x1f))));
+
+			if (vget_lane_u64(vreinterpret_u64_u8(vand_u8(visible, vtst_u8(p, vdup_n_u8(0x80)))), 0) != 0)
+				pri_generic(dst, pri, src, 8, NULL, colorbase, transpen, 0, pmask, afterdraw);
+			else
+			{
+				uint16x8_t v = vaddq_u16(vmovl_u8(s), base);
+				uint16x8_t m = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(visible)));
+
+				vst1q_u16(dst, vbslq_u16(m, v, vld1q_u16(dst)));
+				vst1_u8(pri, vbsl_u8(draw, vorr_u8(vand_u8(p, vdup_n_u8(0x7f)), after), p));
+			}
+		}
+		dst += 8;
+		pri += 8;
+		src += 8;
+		count -= 8;
+	}
+	if (count > 0)
+		pri_generic(dst, pri, src, count, NULL, colorbase, transpen, 0, pmask, afterdraw);
+}
+
+
+/*-------------------------------------------------
+    pri_zoom_neon - pdrawgfxzoom() priority
+    rules, eight raw pens per step; steps with
+    priorities out of the table go through the
+    portable kernel
+-------------------------------------------------*/
+
+static void pri_zoom_neon(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+		int transpen, UINT32 transmask, UINT32 pmask)
+{
+	uint8x8x4_t table;
+	uint16x8_t base;
+	uint8x8_t trans;
+
+	if (paldata != NULL || transmask != 0)
+	{
+		pri_zoom_generic(dst, pri, src, count, paldata, colorbase, transpen, transmask, pmask);
+		return;
+	}
+
+	table = pri_table_neon(pmask);
+	base = vdupq_n_u16((UINT16)colorbase);
+	trans = vdup_n_u8((UINT8)transpen);
+	while (count >= 8)
+	{
+		uint8x8_t s = vld1_u8(src);
+		uint8x8_t draw = (transpen >= 0) ? vmvn_u8(vceq_u8(s, trans)) : vdup_n_u8(0xff);
+
+		if (vget_lane_u64(vreinterpret_u64_u8(draw), 0) != 0)
+		{
+			uint8x8_t p = vld1_u8(pri);
+
+			if (vget_lane_u64(vreinterpret_u64_u8(vand_u8(draw, vcge_u8(p, vdup_n_u8(32)))), 0) != 0)
+				pri_zoom_generic(dst, pri, src, 8, NULL, colorbase, transpen, 0, pmask);
+			else
+			{
+				uint8x8_t visible = vbic_u8(draw, vtbl4_u8(table, p));
+				uint16x8_t v = vaddq_u16(vmovl_u8(s), base);
+				uint16x8_t m = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(visible)));
+
+				vst1q_u16(dst, vbslq_u16(m, v, vld1q_u16(dst)));
+				vst1_u8(pri, vbsl_u8(draw, vdup_n_u8(31), p));
+			}
+		}
+		dst += 8;
+		pri += 8;
+		src += 8;
+		count -= 8;
+	}
+	if (count > 0)
+		pri_zoom_generic(dst, pri, src, count, NULL, colorbase, transpen, 0, pmask);
+}
+
+
+/*-------------------------------------------------
+    copy_transpen_neon - eight pixels per step
+-------------------------------------------------*/
+
+static void copy_transpen_neon(UINT16 *dst, const UINT16 *src, int count, int transpen)
+{
+	uint16x8_t trans;
+
+	if (transpen < 0 || transpen > 0xffff)
+	{
+		copy_transpen_generic(dst, src, count, transpen);
+		return;
+	}
+
+	trans = vdupq_n_u16((UINT16)transpen);
+	while (count >= 8)
+	{
+		uint16x8_t s = vld1q_u16(src);
+		uint16x8_t m = vceqq_u16(s, trans);
+		uint64x2_t m64 = vreinterpretq_u64_u16(m);
+
+		if ((vgetq_lane_u64(m64, 0) & vgetq_lane_u64(m64, 1)) != ~(UINT64)0)
+			vst1q_u16(dst, vbslq_u16(m, vld1q_u16(dst), s));
+		dst += 8;
+		src += 8;
+		count -= 8;
+	}
+	if (count > 0)
+		copy_transpen_generic(dst, src, count, transpen);
+}
+
+
+static const drawspan_kernels drawspan_neon =
+{
+	"NEON",
+	opaque_raw_neon,
+	opaque_lut_generic,
+	transpen_raw_neon,
+	transpen_lut_generic,
+	transmask_raw_generic,
+	transmask_lut_generic,
+	pri_neon,
+	pri_zoom_neon,
+	copy_transpen_neon
+};
+
+#endif
+
+
+const drawspan_kernels *const drawspan_list[] =
+{
+	&drawspan_generic,
+#ifdef DRAWSPAN_SSE2
+	&drawspan_sse2,
+#endif
+#ifdef DRAWSPAN_NEON
+	&drawspan_neon,
+#endif
+	NULL
+};
+
+
+
+/***************************************************************************
+    BLITTERS
+***************************************************************************/
+
+/*-------------------------------------------------
+    draw_span - draw a run of pens with the
+    kernel matching the blit
+-------------------------------------------------*/
+
+INLINE void draw_span(const drawspan_kernels *k, const span_state *state, UINT16 *dst, UINT8 *pri, const UINT8 *src, int count)
+{
+	if (pri != NULL)
+	{
+		if (state->zoom)
+			(*k->pri_zoom)(dst, pri, src, count, state->paldata, state->colorbase, state->transpen, state->transmask, state->pmask);
+		else
+			(*k->pri)(dst, pri, src, count, state->paldata, state->colorbase, state->transpen, state->transmask, state->pmask, state->afterdraw);
+	}
+	else if (state->transmask != 0)
+	{
+		if (state->paldata)
+			(*k->transmask_lut)(dst, src, count, state->paldata, state->transmask);
+		else
+			(*k->transmask_raw)(dst, src, count, state->colorbase, state->transmask);
+	}
+	else if (state->transpen >= 0)
+	{
+		if (state->paldata)
+			(*k->transpen_lut)(dst, src, count, state->paldata, state->transpen);
+		else
+			(*k->transpen_raw)(dst, src, count, state->colorbase, state->transpen);
+	}
+	else
+	{
+		if (state->paldata)
+			(*k->opaque_lut)(dst, src, count, state->paldata);
+		else
+			(*k->opaque_raw)(dst, src, count, state->colorbase);
+	}
+}
+
+
+/*-------------------------------------------------
+    init_span_state - set up the span parameters
+    of a transparency mode; returns 0 if the mode
+    has no kernel
+-------------------------------------------------*/
+
+static int init_span_state(span_state *state, int transparency, const pen_t *paldata, UINT32 colorbase, int transparent_color)
+{
+	state->paldata = paldata;
+	state->colorbase = colorbase;
+	state->transpen = -1;
+	state->transmask = 0;
+
+	switch (transparency)
+	{
+		case TRANSPARENCY_NONE_RAW:
+			state->paldata = NULL;
+		case TRANSPARENCY_NONE:
+			break;
+
+		case TRANSPARENCY_PEN_RAW:
+			state->paldata = NULL;
+		case TRANSPARENCY_PEN:
+			/* the scalar blitters compare the pens against the whole value */
+			if (transparent_color < 0 || transparent_color > 0xff)
+				return 0;
+			state->transpen = transparent_color;
+			break;
+
+		case TRANSPARENCY_PENS_RAW:
+			state->paldata = NULL;
+		case TRANSPARENCY_PENS:
+			state->transmask = transparent_color;
+			break;
+
+		default:
+			return 0;
+	}
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    drawspan_blockmove8to16 - the kernel version
+    of the blockmove_8toN macros of drawgfx.c
+-------------------------------------------------*/
+
+int drawspan_blockmove8to16(const UINT8 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		int leftskip, int topskip, int flipx, int flipy,
+		UINT16 *dstdata, int dstwidth, int dstheight, int dstmodulo,
+		int transparency, const pen_t *paldata, UINT32 colorbase, int transparent_color,
+		UINT8 *pridata, UINT32 pmask, int afterdraw)
+{
+	const drawspan_kernels *k = drawspan_active;
+	UINT8 temp[DRAWSPAN_MAX];
+	span_state state;
+	int ydir;
+
+	if (k == NULL || !init_span_state(&state, transparency, paldata, colorbase, transparent_color))
+		return 0;
+	state.pmask = pmask;
+	state.afterdraw = afterdraw;
+	state.zoom = 0;
+
+	/* same walk as ADJUST_8 */
+	if (flipy)
+	{
+		dstdata += dstmodulo * (dstheight-1);
+		if (pridata)
+			pridata += dstmodulo * (dstheight-1);
+		srcdata += (srcheight - dstheight - topskip) * srcmodulo;
+		ydir = -1;
+	}
+	else
+	{
+		srcdata += topskip * srcmodulo;
+		ydir = 1;
+	}
+	if (flipx)
+		srcdata += (srcwidth - dstwidth - leftskip);
+	else
+		srcdata += leftskip;
+
+	while (dstheight--)
+	{
+		int x;
+
+		for (x = 0; x < dstwidth; x += DRAWSPAN_MAX)
+		{
+			int count = MIN(dstwidth - x, DRAWSPAN_MAX);
+			const UINT8 *src = srcdata + x;
+
+			/* the kernels run left to right, so reverse the pens of flipped rows */
+			if (flipx)
+			{
+				const UINT8 *s = srcdata + dstwidth - 1 - x;
+				int i;
+
+				for (i = 0; i < count; i++)
+					temp[i] = *s--;
+				src = temp;
+			}
+
+			draw_span(k, &state, dstdata + x, pridata ? pridata + x : NULL, src, count);
+		}
+
+		srcdata += srcmodulo;
+		dstdata += ydir * dstmodulo;
+		if (pridata)
+			pridata += ydir * dstmodulo;
+	}
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    drawspan_zoom8to16 - the kernel version of
+    the 16bpp inner loops of drawgfxzoom()
+-------------------------------------------------*/
+
+int drawspan_zoom8to16(const UINT8 *source_base, int line_modulo,
+		int sx, int ex, int sy, int ey, int x_index_base, int y_index, int dx, int dy,
+		mame_bitmap *dest_bmp, mame_bitmap *pri_buffer,
+		int transparency, const pen_t *paldata, UINT32 colorbase, int transparent_color, UINT32 pmask)
+{
+	const drawspan_kernels *k = drawspan_active;
+	UINT8 temp[DRAWSPAN_MAX];
+	span_state state;
+	int y;
+
+	/* drawgfxzoom() has no raw opaque or raw masked modes */
+	if (k == NULL || transparency == TRANSPARENCY_NONE_RAW || transparency == TRANSPARENCY_PENS_RAW ||
+			!init_span_state(&state, transparency, paldata, colorbase, transparent_color))
+		return 0;
+	state.pmask = pmask;
+	state.afterdraw = 31;
+	state.zoom = 1;
+
+	for (y = sy; y < ey; y++)
+	{
+		const UINT8 *source = source_base + (y_index>>16) * line_modulo;
+		UINT16 *dest = (UINT16 *)dest_bmp->line[y];
+		UINT8 *pri = pri_buffer ? (UINT8 *)pri_buffer->line[y] : NULL;
+		int x, x_index = x_index_base;
+
+		for (x = sx; x < ex; x += DRAWSPAN_MAX)
+		{
+			int count = MIN(ex - x, DRAWSPAN_MAX);
+			int i;
+
+			/* resample the row into a run of pens */
+			for (i = 0; i < count; i++)
+			{
+				temp[i] = source[x_index>>16];
+				x_index += dx;
+			}
+
+			draw_span(k, &state, dest + x, pri ? pri + x : NULL, temp, count);
+		}
+
+		y_index += dy;
+	}
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    drawspan_copy16 - the kernel version of
+    blockmove_NtoN_transpen_noremap16
+-------------------------------------------------*/
+
+int drawspan_copy16(const UINT16 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		UINT16 *dstdata, int dstmodulo, int transpen)
+{
+	const drawspan_kernels *k = drawspan_active;
+
+	if (k == NULL)
+		return 0;
+
+	while (srcheight--)
+	{
+		(*k->copy_transpen)(dstdata, srcdata, srcwidth, transpen);
+		srcdata += srcmodulo;
+		dstdata += dstmodulo;
+	}
+	return 1;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+
+    drawspan.h
+
+    Vectorized span kernels for the 8bpp to 16bpp element blitters.
+
+***************************************************************************/
+
+#ifndef __DRAWSPAN_H__
+#define __DRAWSPAN_H__
+
+#include "mamecore.h"
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+/* longest span handed to a kernel in one call; longer rows are split */
+#define DRAWSPAN_MAX		256
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/*
+    A span is a run of source pens drawn left to right into a 16bpp row.
+    The _raw kernels draw colorbase + pen, the _lut kernels paldata[pen].
+    The priority kernels take paldata == NULL for raw pens, transpen < 0
+    when no single pen is transparent and transmask == 0 when no pen mask
+    applies.
+*/
+typedef struct _drawspan_kernels drawspan_kernels;
+struct _drawspan_kernels
+{
+	const char *name;
+
+	void (*opaque_raw)(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase);
+	void (*opaque_lut)(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata);
+	void (*transpen_raw)(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, int transpen);
+	void (*transpen_lut)(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata, int transpen);
+	void (*transmask_raw)(UINT16 *dst, const UINT8 *src, int count, UINT32 colorbase, UINT32 transmask);
+	void (*transmask_lut)(UINT16 *dst, const UINT8 *src, int count, const pen_t *paldata, UINT32 transmask);
+
+	/* pdrawgfx(): test (1 << (pri & 0x1f)) against pmask, shadow on bit 7, mark (pri & 0x7f) | afterdraw */
+	void (*pri)(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+			int transpen, UINT32 transmask, UINT32 pmask, int afterdraw);
+
+	/* pdrawgfxzoom(): test (1 << pri) against pmask, mark 31 */
+	void (*pri_zoom)(UINT16 *dst, UINT8 *pri, const UINT8 *src, int count, const pen_t *paldata, UINT32 colorbase,
+			int transpen, UINT32 transmask, UINT32 pmask);
+
+	/* copybitmap() 16bpp to 16bpp with a transparent pen */
+	void (*copy_transpen)(UINT16 *dst, const UINT16 *src, int count, int transpen);
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+/* compiled kernel sets, the portable one first, NULL terminated */
+extern const drawspan_kernels *const drawspan_list[];
+
+/* kernel set in use, or NULL to use the scalar blitters */
+extern const drawspan_kernels *drawspan_active;
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+/* draw an unpacked element through the active kernels; returns 0 if the mode isn't handled */
+int drawspan_blockmove8to16(const UINT8 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		int leftskip, int topskip, int flipx, int flipy,
+		UINT16 *dstdata, int dstwidth, int dstheight, int dstmodulo,
+		int transparency, const pen_t *paldata, UINT32 colorbase, int transparent_color,
+		UINT8 *pridata, UINT32 pmask, int afterdraw);
+
+/* draw the clipped rows of a zoomed unpacked element; returns 0 if the mode isn't handled */
+int drawspan_zoom8to16(const UINT8 *source_base, int line_modulo,
+		int sx, int ex, int sy, int ey, int x_index_base, int y_index, int dx, int dy,
+		mame_bitmap *dest_bmp, mame_bitmap *pri_buffer,
+		int transparency, const pen_t *paldata, UINT32 colorbase, int transparent_color, UINT32 pmask);
+
+/* copy a 16bpp block with a transparent pen; returns 0 if not handled */
+int drawspan_copy16(const UINT16 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		UINT16 *dstdata, int dstmodulo, int transpen);
+
+#endif	/* __DRAWSPAN_H__ */
@@ -46,9 +46,11 @@
 #define RAM_FILE				1
 #define ZIPPED_FILE				2
 #define UNLOADED_ZIPPED_FILE	3
+#define DEFERRED_ZIPPED_FILE	4
 
 #define FILEFLAG_OPENREAD		0x0001
 #define FILEFLAG_OPENWRITE		0x0002
+#define FILEFLAG_DEFER_INFLATE	0x0010
 #define FILEFLAG_HASH			0x0100
 #define FILEFLAG_REVERSE_SEARCH	0x0200
 #define FILEFLAG_VERIFY_ONLY	0x0400
@@ -85,6 +87,8 @@ struct _mame_file
 	UINT8		eof;
 	UINT8		type;
 	char		hash[HASH_BUF_SIZE];
+	zip_data *	zipdata;	/* compressed data of a DEFERRED_ZIPPED_FILE */
+	unsigned	hashfuncs;	/* hash functions to compute on completion */
 	int			back_char; /* Buffered char for unget. EOF for empty. */
 };
 
@@ -107,6 +111,7 @@ int mess_ghost_images;
 static mame_file *generic_fopen(int pathtype, const char *gamename, const char *filename, const char *hash, UINT32 flags, osd_file_error *error);
 static const char *get_extension_for_filetype(int filetype);
 static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash);
+static void hash_progress(void *param, const unsigned char *data, unsigned length);
 static chd_interface_file *chd_open_cb(const char *filename, const char *mode);
 static void chd_close_cb(chd_interface_file *file);
 static UINT32 chd_read_cb(chd_interface_file *file, UINT64 offset, UINT32 count, void *buffer);
@@ -125,7 +130,9 @@ static chd_interface mame_chd_interface =
 	chd_close_cb,
 	chd_read_cb,
 	chd_write_cb,
-	chd_length_cb
+	chd_length_cb,
+	osd_async_begin,
+	osd_async_end
 };
 
 
@@ -138,6 +145,7 @@ static chd_interface mame_chd_interface =
 void fileio_init(void)
 {
 	chd_set_interface(&mame_chd_interface);
+	chd_set_cache_size(options.chd_cache_size);
 	add_exit_callback(fileio_exit);
 }
 
@@ -201,6 +209,7 @@ mame_file *mame_fopen_error(const char *gamename, const char *filename, int file
 		case FILETYPE_CTRLR:
 		case FILETYPE_LANGUAGE:
 		case FILETYPE_HIGHSCORE_DB:
+		case FILETYPE_ROMCACHE:
 			return generic_fopen(filetype, NULL, filename, 0, openforwrite ? FILEFLAG_OPENWRITE : FILEFLAG_OPENREAD, error);
 
 		/* game-specific files that live in a single directory */
@@ -326,6 +335,58 @@ mame_file *mame_fopen_rom(const char *gamename, const char *filename, const char
 }
 
 
+/*-------------------------------------------------
+    mame_fopen_rom_deferred - similar to
+    mame_fopen_rom, but for zipped files reads
+    only the compressed data; mame_fcomplete must
+    be called before accessing the file
+-------------------------------------------------*/
+
+mame_file *mame_fopen_rom_deferred(const char *gamename, const char *filename, const char *exphash)
+{
+	return generic_fopen(FILETYPE_ROM, gamename, filename, exphash, FILEFLAG_OPENREAD | FILEFLAG_HASH | FILEFLAG_DEFER_INFLATE, NULL);
+}
+
+
+/*-------------------------------------------------
+    mame_fcomplete - complete the opening of a
+    deferred file, decompressing and hashing the
+    data in a single pass; it doesn't touch any
+    global state, so different files can be
+    completed at the same time from different
+    threads
+-------------------------------------------------*/
+
+int mame_fcomplete(mame_file *file)
+{
+	hash_context *ctx;
+
+	/* nothing to do if the file is already complete */
+	if (file->type != DEFERRED_ZIPPED_FILE)
+		return 0;
+
+	/* one more byte to never allocate 0 bytes */
+	file->data = malloc(file->length + 1);
+	ctx = hash_begin(file->hashfuncs);
+	if (!file->data || !ctx || inflate_zipped_data(file->zipdata, file->data, hash_progress, ctx) != 0)
+	{
+		if (ctx)
+			hash_end(ctx, file->hash);
+		hash_data_clear(file->hash);
+		free(file->data);
+		file->data = NULL;
+		return 1;
+	}
+	hash_end(ctx, file->hash);
+
+	/* from now on it's a normal zipped file */
+	free_zipped_data(file->zipdata);
+	file->zipdata = NULL;
+	file->type = ZIPPED_FILE;
+	return 0;
+}
+
+
 /*-------------------------------------------------
     mame_fclose - closes a file
 -------------------------------------------------*/
@@ -349,6 +410,10 @@ void mame_fclose(mame_file *file)
 			if (file->data)
 				free(file->data);
 			break;
+
+		case DEFERRED_ZIPPED_FILE:
+			free_zipped_data(file->zipdata);
+			break;
 	}
 
 	/* free the file data */
@@ -555,6 +620,7 @@ UINT64 mame_fsize(mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case DEFERRED_ZIPPED_FILE:
 			return file->length;
 	}
 
@@ -1204,6 +1270,31 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 					}
 				}
 
+				/* deferred load case, only the compressed data is read */
+				else if (flags & FILEFLAG_DEFER_INFLATE)
+				{
+					int err;
+
+					/* Try reading the file, and then by CRC as below */
+					err = load_zipped_file_compressed(pathtype, pathindex, name, tempname, &file.zipdata);
+					if (err && hash)
+					{
+						char crcn[9];
+
+						if (hash_data_extract_printable_checksum(hash, HASH_CRC, crcn) != 0)
+							err = load_zipped_file_compressed(pathtype, pathindex, name, crcn, &file.zipdata);
+					}
+
+					if (err == 0)
+					{
+						VPRINTF(("Using (mame_fopen) deferred zip file for %s\n", filename));
+						file.length = file.zipdata->uncompressed_size;
+						file.type = DEFERRED_ZIPPED_FILE;
+						file.hashfuncs = hash_data_used_functions(hash);
+						break;
+					}
+				}
+
 				/* full load case */
 				else
 				{
@@ -1266,6 +1357,17 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 }
 
 
+/*-------------------------------------------------
+    hash_progress - hash the data while it's
+    decompressed
+-------------------------------------------------*/
+
+static void hash_progress(void *param, const unsigned char *data, unsigned length)
+{
+	hash_buffer((hash_context *)param, data, length);
+}
+
+
 /*-------------------------------------------------
     checksum_file - load and checksum a file
 -------------------------------------------------*/
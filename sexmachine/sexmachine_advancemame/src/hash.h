@@ -25,6 +25,9 @@
 //  must respect this size
 #define HASH_BUF_SIZE       256
 
+// State of an incremental hash computation
+typedef struct _hash_context hash_context;
+
 // Get function name of the specified function
 const char* hash_function_name(unsigned int function);
 
@@ -70,6 +73,13 @@ unsigned int hash_data_used_functions(const char* d);
 //  we want the checksum of.
 void hash_compute(char* dst, const unsigned char* data, unsigned long length, unsigned int functions);
 
+// Compute the hash of data received in chunks, for example while it's decompressed. Each context
+//  holds its own state, so different contexts can be used at the same time from different threads.
+//  hash_end() fills the hash data and frees the context.
+hash_context* hash_begin(unsigned int functions);
+void hash_buffer(hash_context* ctx, const void* mem, unsigned long len);
+void hash_end(hash_context* ctx, char* dst);
+
 // Verifies that a hash string is valid
 int hash_verify_string(const char *hash);
 
@@ -248,6 +248,7 @@ enum
 	IPT_UI_WATCH_VALUE,
 	IPT_UI_EDIT_CHEAT,
 	IPT_UI_TOGGLE_CROSSHAIR,
+	IPT_UI_REWIND,
 
 	/* additional OSD-specified UI port types (up to 16) */
 	IPT_OSD_1,
@@ -1474,6 +1474,10 @@ void atarigen_blend_gfx(int gfx0, int gfx1, int mask0, int mask1)
 		UINT8 *c1base = gx1->gfxdata + gx1->char_modulo * c;
 		UINT32 usage = 0;
 
+		/* both characters must be decoded before blending */
+		gfx_element_prepare(gx0, c);
+		gfx_element_prepare(gx1, c);
+
 		/* loop over height */
 		for (y = 0; y < gx0->height; y++)
 		{
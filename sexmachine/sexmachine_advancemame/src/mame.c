@@ -151,6 +151,15 @@ static mame_timer *soft_reset_timer;
 static void (*saveload_schedule_callback)(void);
 static mame_time saveload_schedule_time;
 
+/* in-memory state ring statics */
+static int rewind_pending;
+static UINT32 ring_last_frame;
+
+/* run-ahead statics */
+static UINT8 output_mask = MAME_OUTPUT_ALL;
+static runahead_info runahead;
+static cycles_t runahead_start;
+
 /* error recovery and exiting */
 static callback_item *reset_callback_list;
 static callback_item *pause_callback_list;
@@ -245,6 +254,10 @@ static void free_callback_list(callback_item **cb);
 static void saveload_init(void);
 static void handle_save(void);
 static void handle_load(void);
+static void handle_ring(void);
+static void runahead_init(void);
+static void runahead_exit(void);
+static void handle_runahead(void);
 
 
 static void logfile_callback(const char *buffer);
@@ -322,15 +335,29 @@ int run_game(int game)
 			/* perform a soft reset -- this takes us to the running phase */
 			soft_reset(0);
 
+			/* allocate the in-memory state ring used for rewinding */
+			if (options.rewind_count > 0 && state_ring_init(options.rewind_count, options.rewind_size) != 0)
+				logerror("Unable to allocate the rewind state ring\n");
+			rewind_pending = 0;
+			ring_last_frame = cpu_getcurrentframe();
+
+			/* prepare to run ahead of the displayed frame */
+			runahead_init();
+
 			/* run the CPUs until a reset or exit */
 			hard_reset_pending = FALSE;
 			while ((!hard_reset_pending && !exit_pending) || saveload_pending_file != NULL)
 			{
 				profiler_mark(PROFILER_EXTRA);
 
-				/* execute CPUs if not paused */
+				/* execute CPUs if not paused, a whole frame at a time when running ahead */
 				if (!mame_paused)
-					cpuexec_timeslice();
+				{
+					if (runahead.frames > 0)
+						handle_runahead();
+					else
+						cpuexec_timeslice();
+				}
 
 				/* otherwise, just pump video updates through */
 				else
@@ -343,12 +370,20 @@ int run_game(int game)
 				if (saveload_schedule_callback)
 					(*saveload_schedule_callback)();
 
+				/* capture or rewind the in-memory state ring */
+				else if (options.rewind_count > 0 && !mame_paused)
+					handle_ring();
+
 				profiler_mark(PROFILER_END);
 			}
 
 			/* and out via the exit phase */
 			current_phase = MAME_PHASE_EXIT;
 
+			/* release the state ring and the run-ahead snapshot */
+			state_ring_free();
+			runahead_exit();
+
 			/* stop tracking resources at this level */
 			end_resource_tracking();
 
@@ -541,6 +576,44 @@ void mame_schedule_load(const char *filename)
 }
 
 
+/*-------------------------------------------------
+    mame_schedule_rewind - schedule a restore of
+    the in-memory state captured the given number
+    of frames ago
+-------------------------------------------------*/
+
+void mame_schedule_rewind(int frames)
+{
+	rewind_pending += frames;
+}
+
+
+/*-------------------------------------------------
+    mame_get_output_mask - return which outputs
+    of the frame being emulated reach the user;
+    frames run ahead are emulated with some or
+    all of them suppressed
+-------------------------------------------------*/
+
+int mame_get_output_mask(void)
+{
+	return output_mask;
+}
+
+
+/*-------------------------------------------------
+    mame_get_runahead_info - return the run-ahead
+    statistics
+-------------------------------------------------*/
+
+const runahead_info *mame_get_runahead_info(void)
+{
+	if (runahead.frames > 0)
+		runahead.elapsed_time = (double)(osd_cycles() - runahead_start) / (double)osd_cycles_per_second();
+	return &runahead;
+}
+
+
 /*-------------------------------------------------
     mame_is_scheduled_event_pending - is a
     scheduled event pending?
@@ -1246,6 +1319,73 @@ static void saveload_init(void)
 }
 
 
+/*-------------------------------------------------
+    save_all_tags - save the default tag and the
+    tags of all the CPUs
+-------------------------------------------------*/
+
+static void save_all_tags(void)
+{
+	int cpunum;
+
+	/* write the default tag */
+	state_save_push_tag(0);
+	state_save_save_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* save the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_save_continue();
+		state_save_pop_tag();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    load_all_tags - load the default tag and the
+    tags of all the CPUs
+-------------------------------------------------*/
+
+static void load_all_tags(void)
+{
+	int cpunum;
+
+	/* read tag 0 */
+	state_save_push_tag(0);
+	state_save_load_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* load the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_load_continue();
+		state_save_pop_tag();
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
 /*-------------------------------------------------
     handle_save - attempt to perform a save
 -------------------------------------------------*/
@@ -1277,8 +1417,6 @@ static void handle_save(void)
 	file = mame_fopen(Machine->gamedrv->name, saveload_pending_file, FILETYPE_STATE, 1);
 	if (file)
 	{
-		int cpunum;
-
 		/* write the save state */
 		if (state_save_save_begin(file) != 0)
 		{
@@ -1287,26 +1425,8 @@ static void handle_save(void)
 			goto cancel;
 		}
 
-		/* write the default tag */
-		state_save_push_tag(0);
-		state_save_save_continue();
-		state_save_pop_tag();
-
-		/* loop over CPUs */
-		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-		{
-			cpuintrf_push_context(cpunum);
-
-			/* make sure banking is set */
-			activecpu_reset_banking();
-
-			/* save the CPU data */
-			state_save_push_tag(cpunum + 1);
-			state_save_save_continue();
-			state_save_pop_tag();
-
-			cpuintrf_pop_context();
-		}
+		/* write all the tags */
+		save_all_tags();
 
 		/* finish and close */
 		state_save_save_finish();
@@ -1364,31 +1484,8 @@ static void handle_load(void)
 		/* start loading */
 		if (state_save_load_begin(file) == 0)
 		{
-			int cpunum;
-
-			/* read tag 0 */
-			state_save_push_tag(0);
-			state_save_load_continue();
-			state_save_pop_tag();
-
-			/* loop over CPUs */
-			for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-			{
-				cpuintrf_push_context(cpunum);
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				/* load the CPU data */
-				state_save_push_tag(cpunum + 1);
-				state_save_load_continue();
-				state_save_pop_tag();
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				cpuintrf_pop_context();
-			}
+			/* read all the tags */
+			load_all_tags();
 
 			/* finish and close */
 			state_save_load_finish();
@@ -1407,3 +1504,186 @@ cancel:
 	saveload_pending_file = NULL;
 	saveload_schedule_callback = NULL;
 }
+
+
+/*-------------------------------------------------
+    handle_ring - capture a new state in the
+    in-memory ring at each frame, or rewind to
+    an older one if requested
+-------------------------------------------------*/
+
+static void handle_ring(void)
+{
+	UINT32 frame = cpu_getcurrentframe();
+
+	/* act only once per frame */
+	if (frame == ring_last_frame)
+		return;
+
+	/* anonymous timers can't be saved; wait for the next frame */
+	if (timer_count_anonymous() > 0)
+		return;
+
+	ring_last_frame = frame;
+
+	/* rewind, but never past the oldest state */
+	if (rewind_pending > 0)
+	{
+		int index = rewind_pending;
+
+		rewind_pending = 0;
+		if (index > state_ring_count() - 1)
+			index = state_ring_count() - 1;
+
+		if (index > 0 && state_ring_load_begin(index) == 0)
+		{
+			load_all_tags();
+			state_ring_load_finish();
+
+			/* don't capture again the state just restored */
+			ring_last_frame = cpu_getcurrentframe();
+		}
+		return;
+	}
+
+	if (state_ring_save_begin(frame) == 0)
+	{
+		save_all_tags();
+		state_ring_save_finish();
+	}
+}
+
+
+/*-------------------------------------------------
+    runahead_init - enable the run-ahead if
+    requested and supported by the game
+-------------------------------------------------*/
+
+static void runahead_init(void)
+{
+	memset(&runahead, 0, sizeof(runahead));
+	output_mask = MAME_OUTPUT_ALL;
+
+	if (options.runahead <= 0)
+		return;
+
+	/* the game state must be restored exactly after the hidden frames */
+	if (!(Machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
+	{
+		logerror("Run-ahead disabled, save states are not supported by this game\n");
+		return;
+	}
+
+	runahead.frames = options.runahead;
+	runahead_start = osd_cycles();
+	logerror("Run-ahead of %d frames\n", runahead.frames);
+}
+
+
+/*-------------------------------------------------
+    runahead_exit - report the run-ahead cost and
+    free the snapshot
+-------------------------------------------------*/
+
+static void runahead_exit(void)
+{
+	if (runahead.frames > 0)
+	{
+		const runahead_info *info = mame_get_runahead_info();
+
+		if (info->host_frames > 0 && info->elapsed_time > 0)
+			logerror("Run-ahead of %d frames: %u frames displayed at %.2f fps, %.2f ms of extra emulation per frame, %u frames without snapshot\n",
+					info->frames, info->host_frames, info->host_frames / info->elapsed_time,
+					info->total_time * 1000.0 / info->host_frames, info->missed_frames);
+	}
+
+	state_snapshot_free();
+	runahead.frames = 0;
+	output_mask = MAME_OUTPUT_ALL;
+}
+
+
+/*-------------------------------------------------
+    run_one_frame - execute timeslices until the
+    next frame starts; returns non-zero if stopped
+    early by a pending event
+-------------------------------------------------*/
+
+static int run_one_frame(void)
+{
+	UINT32 frame = cpu_getcurrentframe();
+
+	while (cpu_getcurrentframe() == frame)
+	{
+		if (hard_reset_pending || exit_pending || saveload_schedule_callback || mame_paused)
+			return 1;
+		cpuexec_timeslice();
+	}
+
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    handle_runahead - emulate one displayed frame
+    with the run-ahead: advance a frame keeping
+    only its audio, snapshot the state, run the
+    hidden frames with the current input, display
+    the last one and go back to the snapshot
+-------------------------------------------------*/
+
+static void handle_runahead(void)
+{
+	cycles_t start, real;
+	int i;
+
+	/* the real next frame, heard but not seen */
+	output_mask = MAME_OUTPUT_AUDIO;
+	start = osd_cycles();
+	if (run_one_frame())
+		goto done;
+	real = osd_cycles() - start;
+
+	/* anonymous timers can't be saved; display the next frame without running ahead */
+	start = osd_cycles();
+	if (timer_count_anonymous() > 0 || state_snapshot_save_begin() != 0)
+	{
+		runahead.missed_frames++;
+		output_mask = MAME_OUTPUT_VIDEO;
+		run_one_frame();
+		goto done;
+	}
+	save_all_tags();
+	state_snapshot_save_finish();
+
+	/* the hidden frames, neither heard nor seen */
+	output_mask = 0;
+	for (i = 1; i < runahead.frames; i++)
+		if (run_one_frame())
+			break;
+
+	/* the displayed frame time includes the throttling, account it as the real one */
+	runahead.last_time = (double)(osd_cycles() - start + real) / (double)osd_cycles_per_second();
+
+	/* the displayed frame; its audio is the one mixed for the real frame */
+	if (i == runahead.frames)
+	{
+		output_mask = MAME_OUTPUT_VIDEO;
+		run_one_frame();
+	}
+
+	/* go back to the real frame */
+	start = osd_cycles();
+	if (state_snapshot_load_begin() == 0)
+	{
+		load_all_tags();
+		state_snapshot_load_finish();
+	}
+
+	runahead.last_time += (double)(osd_cycles() - start) / (double)osd_cycles_per_second();
+	runahead.total_time += runahead.last_time;
+	runahead.host_frames++;
+
+done:
+	output_mask = MAME_OUTPUT_ALL;
+}
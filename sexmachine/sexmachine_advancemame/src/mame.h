@@ -103,6 +103,12 @@ enum
 
 extern const char *memory_region_names[REGION_MAX];
 
+/* output masks, see mame_get_output_mask() */
+#define MAME_OUTPUT_AUDIO		0x01
+#define MAME_OUTPUT_VIDEO		0x02
+#define MAME_OUTPUT_ALL			(MAME_OUTPUT_AUDIO | MAME_OUTPUT_VIDEO)
+
+
 /* artwork options */
 #define ARTWORK_USE_ALL			(~0)
 #define ARTWORK_USE_NONE		(0)
@@ -118,6 +124,19 @@ extern const char *memory_region_names[REGION_MAX];
 
 /* description of the currently-running machine */
 typedef struct _running_machine running_machine;
+
+
+/* statistics of the run-ahead execution */
+typedef struct _runahead_info runahead_info;
+struct _runahead_info
+{
+	int				frames;				/* hidden frames run ahead of each displayed one; 0 if inactive */
+	UINT32			host_frames;		/* displayed frames run ahead */
+	UINT32			missed_frames;		/* displayed frames run without the state snapshot */
+	double			last_time;			/* seconds of extra emulation for the last displayed frame */
+	double			total_time;			/* sum of all the above */
+	double			elapsed_time;		/* seconds since the run-ahead start */
+};
 struct _running_machine
 {
 	/* game-related information */
@@ -194,6 +213,7 @@ struct _global_options
 	mame_file *	logfile;		/* handle to file for debug logging */
 
 	int		mame_debug;		/* 1 to enable debugging */
+	int		verbose;		/* 1 to print additional diagnostic information */
 	int		cheat;			/* 1 to enable cheating */
 	int 	gui_host;		/* 1 to tweak some UI-related things for better GUI integration */
 	int 	skip_disclaimer;	/* 1 to skip the disclaimer screen at startup */
@@ -202,6 +222,7 @@ struct _global_options
 
 	int		samplerate;		/* sound sample playback rate, in Hz */
 	int		use_samples;	/* 1 to enable external .wav samples */
+	int		resample_taps;	/* taps of the polyphase stream resampler; 0 for linear interpolation */
 
 	float	brightness;		/* brightness of the display */
 	float	pause_bright;		/* additional brightness when in pause */
@@ -230,6 +251,19 @@ struct _global_options
 
 	const char *controller;	/* controller-specific cfg to load */
 
+	int		rewind_count;	/* number of frames kept in the in-memory state ring; 0 to disable */
+	UINT32	rewind_size;	/* size in bytes of the state ring delta storage */
+	int		runahead;		/* number of hidden frames run ahead of the displayed one; 0 to disable */
+	int		rom_cache;		/* 1 to cache the loaded ROM regions and the decoded graphics on disk */
+	int		lazy_gfx;		/* 1 to decode the graphics elements when first drawn */
+	UINT32	chd_cache_size;	/* size in bytes of the decompressed hunk cache of every disk */
+	UINT32	adpcm_cache_size;	/* size in bytes of the decoded ADPCM sample cache; 0 to disable */
+	int		draw_bands;		/* 1 to record the drawgfx() calls and draw them in parallel bands */
+	int		tilemap_bench;	/* 1 to benchmark the tilemap redraw with the recorded tile changes */
+	int		stream_bench;	/* 1 to log the CPU time spent by every sound stream */
+	int		fm_bench;		/* 1 to replay the FM register writes with and without the silent channels skip */
+	int		cheat_bench;	/* 1 to check and time the word compare of the cheat search against the byte loop */
+
 #ifdef MESS
 	UINT32	ram;
 	struct ImageFile image_files[32];
@@ -299,6 +333,15 @@ void mame_schedule_save(const char *filename);
 /* schedule a load */
 void mame_schedule_load(const char *filename);
 
+/* schedule a restore of the in-memory state ring */
+void mame_schedule_rewind(int frames);
+
+/* get the outputs (MAME_OUTPUT_*) of the frame being emulated */
+int mame_get_output_mask(void);
+
+/* get the statistics of the run-ahead execution */
+const runahead_info *mame_get_runahead_info(void);
+
 /* is a scheduled event pending? */
 int mame_is_scheduled_event_pending(void);
 
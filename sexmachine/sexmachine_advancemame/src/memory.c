@@ -724,6 +724,67 @@ void *memory_get_write_ptr(int cpunum, int spacenum, offs_t offset)
 }
 
 
+/*-------------------------------------------------
+    memory_get_read_span - return the pointer of
+    memory_get_read_ptr() and the number of bytes
+    mapped contiguously from there; with NULL the
+    bytes are read by a handler
+-------------------------------------------------*/
+
+void *memory_get_read_span(int cpunum, int spacenum, offs_t offset, offs_t *length, int *bytexor)
+{
+	addrspace_data *space = &cpudata[cpunum].space[spacenum];
+	handler_data *handler;
+	offs_t address, limit;
+	UINT8 entry;
+
+	/* bytes are stored in host order within a bus word */
+#ifdef LSB_FIRST
+	*bytexor = (cputype_endianness(Machine->drv->cpu[cpunum].cpu_type) == CPU_IS_BE) ? space->dbits / 8 - 1 : 0;
+#else
+	*bytexor = (cputype_endianness(Machine->drv->cpu[cpunum].cpu_type) == CPU_IS_LE) ? space->dbits / 8 - 1 : 0;
+#endif
+
+	/* perform the lookup */
+	offset &= space->mask;
+	entry = space->read.table[LEVEL1_INDEX(offset)];
+	if (entry >= SUBTABLE_BASE)
+		entry = space->read.table[LEVEL2_INDEX(entry, offset)];
+	handler = &space->read.handlers[entry];
+
+	/* a bank ends where its mask wraps, the address space where the space mask does */
+	limit = space->mask - offset;
+	if (entry < STATIC_RAM && handler->mask - ((offset - handler->offset) & handler->mask) < limit)
+		limit = handler->mask - ((offset - handler->offset) & handler->mask);
+
+	/* walk the table while the entry doesn't change, a whole level 1 block at a time when possible */
+	address = offset;
+	while (address - offset < limit)
+	{
+		offs_t next = address + 1;
+		UINT8 l1entry = space->read.table[LEVEL1_INDEX(next)];
+
+		if (l1entry < SUBTABLE_BASE)
+		{
+			if (l1entry != entry)
+				break;
+			next |= (1 << LEVEL2_BITS) - 1;
+		}
+		else if (space->read.table[LEVEL2_INDEX(l1entry, next)] != entry)
+			break;
+
+		address = (next - offset < limit) ? next : offset + limit;
+	}
+	*length = address - offset + 1;
+
+	/* 8-bit case: RAM/ROM */
+	if (entry >= STATIC_RAM)
+		return NULL;
+	offset = (offset - handler->offset) & handler->mask;
+	return &bank_ptr[entry][offset];
+}
+
+
 /*-------------------------------------------------
     memory_get_op_ptr - return a pointer to the
     base of opcode RAM associated with the given
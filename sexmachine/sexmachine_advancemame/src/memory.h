@@ -930,6 +930,7 @@ void 		memory_set_decrypted_region(int cpunum, offs_t start, offs_t end, void *b
 /* ----- return a base pointer to memory ---- */
 void *		memory_get_read_ptr(int cpunum, int spacenum, offs_t offset);
 void *		memory_get_write_ptr(int cpunum, int spacenum, offs_t offset);
+void *		memory_get_read_span(int cpunum, int spacenum, offs_t offset, offs_t *length, int *bytexor);
 void *		memory_get_op_ptr(int cpunum, offs_t offset, int arg);
 
 /* ----- memory banking ----- */
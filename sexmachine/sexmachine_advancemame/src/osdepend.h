@@ -334,6 +334,21 @@ int osd_display_loading_rom_message(const char *name,rom_load_data *romdata);
 /* checks to see if a pointer is bad */
 int osd_is_bad_read_ptr(const void *ptr, size_t size);
 
+/* runs the jobs from 0 to count-1 on all the available processors, in order, */
+/* and returns when all are completed. The jobs must not touch any global state. */
+void osd_parallelize_jobs(void (*func)(void* arg, int job), void* arg, int count);
+
+/* like osd_parallelize_jobs(), but using threads kept waiting between the calls, */
+/* for the short jobs done at every frame */
+void osd_parallelize_frame(void (*func)(void* arg, int job), void* arg, int count);
+
+/* starts a function in a background thread, returning a handle for osd_async_end(). */
+/* If no thread is available the function is called immediately and NULL is returned. */
+void *osd_async_begin(void (*func)(void* arg), void* arg);
+
+/* waits the end of a function started with osd_async_begin() */
+void osd_async_end(void *handle);
+
 /* AdvanceMAME: Specific OSD interface */
 
 /* helpers for artwork */
@@ -49,6 +49,7 @@ UINT16 *palette_shadow_table;
 rgb_t *game_palette;				/* RGB palette as set by the driver */
 static rgb_t *adjusted_palette;		/* actual RGB palette after brightness/gamma adjustments */
 static UINT32 *dirty_palette;
+static UINT32 dirty_palette_min, dirty_palette_max;
 static UINT16 *pen_brightness;
 
 static UINT8 adjusted_palette_dirty;
@@ -127,7 +128,15 @@ INLINE rgb_t adjust_palette_entry(rgb_t entry, int pen_bright)
 
 INLINE void mark_pen_dirty(int pen)
 {
-	dirty_palette[pen / 32] |= 1 << (pen % 32);
+	UINT32 word = pen / 32;
+
+	dirty_palette[word] |= 1 << (pen % 32);
+
+	/* the consumers scan only the words between min and max */
+	if (word < dirty_palette_min)
+		dirty_palette_min = word;
+	if (word > dirty_palette_max)
+		dirty_palette_max = word;
 }
 
 
@@ -521,6 +530,8 @@ static int palette_alloc(void)
 	/* allocate memory for the dirty palette array */
 	dirty_palette = auto_malloc((max_total_colors + 31) / 32 * sizeof(dirty_palette[0]));
 	dirty_palette[(max_total_colors - 1) / 32] = 0; /* initialize all the bits of the last dirty entry */
+	dirty_palette_min = ~0;
+	dirty_palette_max = 0;
 	for (i = 0; i < max_total_colors; i++)
 		mark_pen_dirty(i);
 
@@ -781,8 +792,15 @@ void palette_update_display(mame_display *display)
 		display->game_palette_entries = total_colors_with_ui;
 		display->game_palette_dirty = dirty_palette;
 
+		/* the consumer of the change clears the dirty bits, starting again with an empty range */
 		if (adjusted_palette_dirty)
+		{
 			display->changed_flags |= GAME_PALETTE_CHANGED;
+			display->game_palette_dirty_min = dirty_palette_min;
+			display->game_palette_dirty_max = dirty_palette_max;
+			dirty_palette_min = ~0;
+			dirty_palette_max = 0;
+		}
 	}
 
 	/* direct case: no palette mucking */
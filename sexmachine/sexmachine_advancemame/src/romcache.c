@@ -0,0 +1,500 @@
+/***************************************************************************
+
+    romcache.c
+
+    Persistent cache of the loaded ROM regions and of the decoded
+    graphics.
+
+****************************************************************************
+
+    The first run of a game saves the memory regions, after the
+    post-processing of rom_init() and before any driver init, and the
+    pixel data of the decoded graphics. The next runs read them back,
+    skipping the decompression, the hashing and the decoding.
+
+    Both files start with the same header:
+
+     0.. 7  'MAMECACH'
+     8..    Key (HASH_BUF_SIZE bytes)
+
+    The key is the SHA1 of the build version, the cache format, the
+    game name, the bios selected and the name, length and hash of
+    every ROM file, as found in the zip directory. Any change of the
+    ROM files or of the emulator gives a different key, and the file
+    is silently rebuilt. The magic is written last, so a file left
+    incomplete is never used.
+
+    The region file (GAME.rgn) then has for every region:
+
+     0.. 3  Region type
+     4.. 7  Region flags
+     8.. b  Region length
+     c..end Region data
+
+    The graphics file (GAME.gfx) has for every element:
+
+     0..1f  Index, width, height, total elements, line modulo,
+            char modulo, flags, pen usage present
+    20..end Pixel data followed by the optional pen usage
+
+    All the values are in the native byte order, the key already
+    depends on the build.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "hash.h"
+#include "romcache.h"
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define ROMCACHE_MAGIC			"MAMECACH"
+#define ROMCACHE_VERSION		1
+#define ROMCACHE_HEADER_SIZE	(8 + HASH_BUF_SIZE)
+
+enum
+{
+	GFXINFO_INDEX = 0,
+	GFXINFO_WIDTH,
+	GFXINFO_HEIGHT,
+	GFXINFO_TOTAL,
+	GFXINFO_LINE_MODULO,
+	GFXINFO_CHAR_MODULO,
+	GFXINFO_FLAGS,
+	GFXINFO_PEN_USAGE,
+	GFXINFO_COUNT
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+static int cache_valid;
+static char cache_key[HASH_BUF_SIZE];
+
+static mame_file *gfx_file;
+static int gfx_hits;
+static int gfx_misses;
+static UINT8 gfx_used[MAX_GFX_ELEMENTS];
+static UINT8 gfx_present[MAX_GFX_ELEMENTS];
+static UINT32 gfx_info[MAX_GFX_ELEMENTS][GFXINFO_COUNT];
+static UINT64 gfx_offset[MAX_GFX_ELEMENTS];
+
+
+
+/***************************************************************************
+    IMPLEMENTATION
+***************************************************************************/
+
+/*-------------------------------------------------
+    cache_fopen - open a cache file of the
+    running game
+-------------------------------------------------*/
+
+static mame_file *cache_fopen(const char *extension, int openforwrite)
+{
+	char name[64];
+
+	sprintf(name, "%.32s.%s", Machine->gamedrv->name, extension);
+	return mame_fopen(Machine->gamedrv->name, name, FILETYPE_ROMCACHE, openforwrite);
+}
+
+
+/*-------------------------------------------------
+    cache_read_header - check the header of a
+    cache file against the current key
+-------------------------------------------------*/
+
+static int cache_read_header(mame_file *file)
+{
+	UINT8 header[ROMCACHE_HEADER_SIZE];
+
+	if (mame_fread(file, header, sizeof(header)) != sizeof(header))
+		return 0;
+	return memcmp(header, ROMCACHE_MAGIC, 8) == 0 && memcmp(header + 8, cache_key, HASH_BUF_SIZE) == 0;
+}
+
+
+/*-------------------------------------------------
+    cache_write_header - write the header of a
+    cache file; the magic is written only when
+    the file is complete
+-------------------------------------------------*/
+
+static int cache_write_header(mame_file *file, int complete)
+{
+	UINT8 header[ROMCACHE_HEADER_SIZE];
+
+	memset(header, 0, 8);
+	if (complete)
+		memcpy(header, ROMCACHE_MAGIC, 8);
+	memcpy(header + 8, cache_key, HASH_BUF_SIZE);
+
+	if (mame_fseek(file, 0, SEEK_SET) != 0)
+		return 0;
+	return mame_fwrite(file, header, sizeof(header)) == sizeof(header);
+}
+
+
+/*-------------------------------------------------
+    romcache_init - compute the key of the cache
+    reading only the zip directories
+-------------------------------------------------*/
+
+int romcache_init(const rom_entry *romp, int bios)
+{
+	const rom_entry *region, *rom;
+	UINT32 version = ROMCACHE_VERSION;
+	hash_context *ctx;
+
+	cache_valid = FALSE;
+	if (!options.rom_cache || romp == NULL)
+		return 0;
+
+	ctx = hash_begin(HASH_SHA1);
+	if (!ctx)
+		return 0;
+
+	hash_buffer(ctx, build_version, strlen(build_version) + 1);
+	hash_buffer(ctx, &version, sizeof(version));
+	hash_buffer(ctx, Machine->gamedrv->name, strlen(Machine->gamedrv->name) + 1);
+	hash_buffer(ctx, &bios, sizeof(bios));
+
+	cache_valid = TRUE;
+	for (region = romp; region && cache_valid; region = rom_next_region(region))
+	{
+		/* the disks are opened by the normal loading */
+		if (ROMREGION_ISDISKDATA(region))
+			cache_valid = FALSE;
+
+		else if (ROMREGION_ISROMDATA(region))
+			for (rom = rom_first_file(region); rom && cache_valid; rom = rom_next_file(rom))
+				if (!ROM_GETBIOSFLAGS(rom) || (ROM_GETBIOSFLAGS(rom) == (bios+1))) /* alternate bios sets */
+				{
+					const game_driver *drv;
+					char hash[HASH_BUF_SIZE];
+					unsigned int length = 0;
+					int found = FALSE;
+
+					/* search up the chain through the parents like the loading */
+					for (drv = Machine->gamedrv; !found && drv; drv = driver_get_clone(drv))
+						if (drv->name && *drv->name)
+						{
+							hash_data_copy(hash, ROM_GETHASHDATA(rom));
+							found = (mame_fchecksum(drv->name, ROM_GETNAME(rom), &length, hash) == 0);
+						}
+
+					/* a missing file is accepted only if it was never dumped */
+					if (!found)
+					{
+						if (!hash_data_has_info(ROM_GETHASHDATA(rom), HASH_INFO_NO_DUMP))
+							cache_valid = FALSE;
+						hash_data_clear(hash);
+					}
+
+					hash_buffer(ctx, ROM_GETNAME(rom), strlen(ROM_GETNAME(rom)) + 1);
+					hash_buffer(ctx, &length, sizeof(length));
+					hash_buffer(ctx, hash, strlen(hash) + 1);
+				}
+	}
+
+	hash_end(ctx, cache_key);
+	return cache_valid;
+}
+
+
+/*-------------------------------------------------
+    romcache_load_regions - allocate and fill the
+    regions from the cache
+-------------------------------------------------*/
+
+int romcache_load_regions(const rom_entry *romp)
+{
+	const rom_entry *region;
+	mame_file *file;
+
+	if (!cache_valid)
+		return 0;
+
+	file = cache_fopen("rgn", 0);
+	if (!file)
+		return 0;
+
+	if (!cache_read_header(file))
+	{
+		mame_fclose(file);
+		return 0;
+	}
+
+	for (region = romp; region; region = rom_next_region(region))
+	{
+		int regiontype = ROMREGION_GETTYPE(region);
+		UINT32 info[3];
+
+		/* the layout must match the driver one */
+		if (mame_fread(file, info, sizeof(info)) != sizeof(info)
+			|| info[0] != regiontype || info[1] != ROMREGION_GETFLAGS(region) || info[2] != ROMREGION_GETLENGTH(region))
+			break;
+
+		if (new_memory_region(regiontype, info[2], info[1]) != 0)
+			break;
+
+		if (mame_fread(file, memory_region(regiontype), info[2]) != info[2])
+			break;
+	}
+
+	mame_fclose(file);
+
+	/* on error free what was allocated, and do a normal load */
+	if (region)
+	{
+		logerror("ROM cache: damaged region cache\n");
+		for (region = romp; region; region = rom_next_region(region))
+			free_memory_region(ROMREGION_GETTYPE(region));
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/*-------------------------------------------------
+    romcache_save_regions - save the regions just
+    loaded and post-processed
+-------------------------------------------------*/
+
+void romcache_save_regions(const rom_entry *romp)
+{
+	const rom_entry *region;
+	mame_file *file;
+
+	if (!cache_valid)
+		return;
+
+	file = cache_fopen("rgn", 1);
+	if (!file)
+	{
+		logerror("ROM cache: unable to create the region cache\n");
+		return;
+	}
+
+	if (!cache_write_header(file, FALSE))
+		goto error;
+
+	for (region = romp; region; region = rom_next_region(region))
+	{
+		int regiontype = ROMREGION_GETTYPE(region);
+		UINT32 info[3];
+
+		info[0] = regiontype;
+		info[1] = memory_region_flags(regiontype);
+		info[2] = memory_region_length(regiontype);
+
+		if (mame_fwrite(file, info, sizeof(info)) != sizeof(info))
+			goto error;
+		if (mame_fwrite(file, memory_region(regiontype), info[2]) != info[2])
+			goto error;
+	}
+
+	if (!cache_write_header(file, TRUE))
+		goto error;
+
+	mame_fclose(file);
+	return;
+
+error:
+	logerror("ROM cache: error writing the region cache\n");
+	mame_fclose(file);
+}
+
+
+/*-------------------------------------------------
+    gfx_fill_info - describe a graphics element
+-------------------------------------------------*/
+
+static void gfx_fill_info(UINT32 *info, int index, const gfx_element *gfx)
+{
+	info[GFXINFO_INDEX] = index;
+	info[GFXINFO_WIDTH] = gfx->width;
+	info[GFXINFO_HEIGHT] = gfx->height;
+	info[GFXINFO_TOTAL] = gfx->total_elements;
+	info[GFXINFO_LINE_MODULO] = gfx->line_modulo;
+	info[GFXINFO_CHAR_MODULO] = gfx->char_modulo;
+	info[GFXINFO_FLAGS] = gfx->flags;
+	info[GFXINFO_PEN_USAGE] = (gfx->pen_usage != NULL);
+}
+
+
+/*-------------------------------------------------
+    gfx_data_size - size of the pixel data and
+    of the pen usage of an element
+-------------------------------------------------*/
+
+static UINT32 gfx_data_size(const UINT32 *info)
+{
+	return info[GFXINFO_TOTAL] * info[GFXINFO_CHAR_MODULO];
+}
+
+static UINT32 gfx_pen_usage_size(const UINT32 *info)
+{
+	return info[GFXINFO_PEN_USAGE] ? info[GFXINFO_TOTAL] * sizeof(UINT32) : 0;
+}
+
+
+/*-------------------------------------------------
+    romcache_gfx_begin - open the graphics cache
+    and read its directory
+-------------------------------------------------*/
+
+void romcache_gfx_begin(void)
+{
+	UINT32 info[GFXINFO_COUNT];
+
+	gfx_file = NULL;
+	gfx_hits = 0;
+	gfx_misses = 0;
+	memset(gfx_used, 0, sizeof(gfx_used));
+	memset(gfx_present, 0, sizeof(gfx_present));
+
+	if (!cache_valid)
+		return;
+
+	gfx_file = cache_fopen("gfx", 0);
+	if (!gfx_file)
+		return;
+
+	if (!cache_read_header(gfx_file))
+	{
+		mame_fclose(gfx_file);
+		gfx_file = NULL;
+		return;
+	}
+
+	/* remember where every element starts */
+	while (mame_fread(gfx_file, info, sizeof(info)) == sizeof(info))
+	{
+		UINT32 index = info[GFXINFO_INDEX];
+
+		if (index >= MAX_GFX_ELEMENTS)
+			break;
+
+		memcpy(gfx_info[index], info, sizeof(info));
+		gfx_offset[index] = mame_ftell(gfx_file);
+		gfx_present[index] = TRUE;
+
+		if (mame_fseek(gfx_file, gfx_data_size(info) + gfx_pen_usage_size(info), SEEK_CUR) != 0)
+			break;
+	}
+}
+
+
+/*-------------------------------------------------
+    romcache_gfx_read - read the decoded data of
+    a graphics element
+-------------------------------------------------*/
+
+int romcache_gfx_read(int index, gfx_element *gfx)
+{
+	UINT32 info[GFXINFO_COUNT];
+
+	if (!cache_valid)
+		return 0;
+
+	/* remember it to save it later */
+	gfx_used[index] = TRUE;
+
+	gfx_fill_info(info, index, gfx);
+	if (gfx_file && gfx_present[index] && memcmp(gfx_info[index], info, sizeof(info)) == 0
+		&& mame_fseek(gfx_file, gfx_offset[index], SEEK_SET) == 0
+		&& mame_fread(gfx_file, gfx->gfxdata, gfx_data_size(info)) == gfx_data_size(info)
+		&& (!gfx->pen_usage || mame_fread(gfx_file, gfx->pen_usage, gfx_pen_usage_size(info)) == gfx_pen_usage_size(info)))
+	{
+		gfx_hits++;
+		return 1;
+	}
+
+	gfx_misses++;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    romcache_gfx_forget - exclude a graphics
+    element from the cache written at the end
+-------------------------------------------------*/
+
+void romcache_gfx_forget(int index)
+{
+	/* it missed, but there is nothing new to save */
+	if (gfx_used[index])
+	{
+		gfx_used[index] = FALSE;
+		gfx_misses--;
+	}
+}
+
+
+/*-------------------------------------------------
+    romcache_gfx_end - close the graphics cache,
+    writing it again if it missed something
+-------------------------------------------------*/
+
+void romcache_gfx_end(void)
+{
+	mame_file *file;
+	int i;
+
+	if (gfx_file)
+	{
+		mame_fclose(gfx_file);
+		gfx_file = NULL;
+	}
+
+	if (!cache_valid)
+		return;
+
+	logerror("ROM cache: %d graphics sets read from the cache, %d decoded\n", gfx_hits, gfx_misses);
+	if (gfx_misses == 0)
+		return;
+
+	file = cache_fopen("gfx", 1);
+	if (!file)
+	{
+		logerror("ROM cache: unable to create the graphics cache\n");
+		return;
+	}
+
+	if (!cache_write_header(file, FALSE))
+		goto error;
+
+	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
+		if (gfx_used[i])
+		{
+			gfx_element *gfx = Machine->gfx[i];
+			UINT32 info[GFXINFO_COUNT];
+
+			gfx_fill_info(info, i, gfx);
+			if (mame_fwrite(file, info, sizeof(info)) != sizeof(info))
+				goto error;
+			if (mame_fwrite(file, gfx->gfxdata, gfx_data_size(info)) != gfx_data_size(info))
+				goto error;
+			if (gfx->pen_usage && mame_fwrite(file, gfx->pen_usage, gfx_pen_usage_size(info)) != gfx_pen_usage_size(info))
+				goto error;
+		}
+
+	if (!cache_write_header(file, TRUE))
+		goto error;
+
+	mame_fclose(file);
+	return;
+
+error:
+	logerror("ROM cache: error writing the graphics cache\n");
+	mame_fclose(file);
+}
@@ -0,0 +1,43 @@
+/***************************************************************************
+
+    romcache.h
+
+    Persistent cache of the loaded ROM regions and of the decoded
+    graphics.
+
+***************************************************************************/
+
+#ifndef __ROMCACHE_H__
+#define __ROMCACHE_H__
+
+#include "mamecore.h"
+#include "romload.h"
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+/* compute the key of the cache from the ROM files; returns 0 if the cache can't be used */
+int romcache_init(const rom_entry *romp, int bios);
+
+/* load the post-processed regions from the cache; returns 1 on a hit */
+int romcache_load_regions(const rom_entry *romp);
+
+/* save the post-processed regions after a clean load */
+void romcache_save_regions(const rom_entry *romp);
+
+/* open the decoded graphics cache */
+void romcache_gfx_begin(void);
+
+/* read a decoded graphics element from the cache; returns 1 on a hit */
+int romcache_gfx_read(int index, gfx_element *gfx);
+
+/* don't save a graphics element left undecoded */
+void romcache_gfx_forget(int index);
+
+/* close the decoded graphics cache, saving it if some element was missing */
+void romcache_gfx_end(void);
+
+#endif	/* __ROMCACHE_H__ */
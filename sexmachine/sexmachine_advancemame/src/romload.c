@@ -17,6 +17,7 @@
 #include "harddisk.h"
 #include "artwork.h"
 #include "config.h"
+#include "romcache.h"
 #include <stdarg.h>
 #include <ctype.h>
 
@@ -25,6 +26,23 @@
 
 
 
+/***************************************************************************
+
+    Type definitions
+
+***************************************************************************/
+
+/* ROM file opened before processing the regions */
+typedef struct _rom_preload rom_preload;
+struct _rom_preload
+{
+	const rom_entry *	romp;				/* entry of the file */
+	mame_file *			file;				/* opened file, NULL if not found */
+	int					failed;				/* decompression failed */
+};
+
+
+
 /***************************************************************************
 
     Global variables
@@ -39,6 +57,11 @@ int system_bios;
 
 static int total_rom_load_warnings;
 
+/* files opened in advance */
+static rom_preload *preload_list;
+static int preload_count;
+static int preload_next;
+
 
 
 /***************************************************************************
@@ -469,11 +492,24 @@ static int open_rom_file(rom_load_data *romdata, const rom_entry *romp)
 {
 	const game_driver *drv;
 
-	++romdata->romsloaded;
+	/* use the file opened in advance, unless it failed to decompress */
+	if (preload_next < preload_count && preload_list[preload_next].romp == romp)
+	{
+		rom_preload *preload = &preload_list[preload_next++];
+
+		romdata->file = preload->file;
+		preload->file = NULL;
+		if (!preload->failed)
+			return (romdata->file != NULL);
+	}
+	else
+	{
+		++romdata->romsloaded;
 
-	/* update status display */
-	if (osd_display_loading_rom_message(ROM_GETNAME(romp), romdata))
-       return 0;
+		/* update status display */
+		if (osd_display_loading_rom_message(ROM_GETNAME(romp), romdata))
+		   return 0;
+	}
 
 	/* Attempt reading up the chain through the parents. It automatically also
        attempts any kind of load by checksum supported by the archives. */
@@ -487,6 +523,145 @@ static int open_rom_file(rom_load_data *romdata, const rom_entry *romp)
 }
 
 
+/*-------------------------------------------------
+    preload_rom_files - open all the ROM files,
+    reading only the compressed data of the
+    zipped ones
+-------------------------------------------------*/
+
+static void preload_rom_files(rom_load_data *romdata, const rom_entry *romp)
+{
+	const rom_entry *region, *rom;
+	int count = 0;
+
+	/* count the files to open */
+	for (region = romp; region; region = rom_next_region(region))
+		if (ROMREGION_ISROMDATA(region))
+			for (rom = rom_first_file(region); rom; rom = rom_next_file(rom))
+				count++;
+
+	preload_list = malloc(count * sizeof(preload_list[0]) + 1);
+	preload_count = 0;
+	preload_next = 0;
+	if (!preload_list)
+		return;
+
+	/* open them in the same order of process_rom_entries() */
+	for (region = romp; region; region = rom_next_region(region))
+		if (ROMREGION_ISROMDATA(region))
+			for (rom = rom_first_file(region); rom; rom = rom_next_file(rom))
+				if (!ROM_GETBIOSFLAGS(rom) || (ROM_GETBIOSFLAGS(rom) == (system_bios+1))) /* alternate bios sets */
+				{
+					rom_preload *preload = &preload_list[preload_count];
+					const game_driver *drv;
+
+					++romdata->romsloaded;
+
+					/* update status display */
+					if (osd_display_loading_rom_message(ROM_GETNAME(rom), romdata))
+						return;
+
+					/* search up the chain through the parents like open_rom_file() */
+					debugload("Preloading ROM file: %s\n", ROM_GETNAME(rom));
+					preload->romp = rom;
+					preload->file = NULL;
+					preload->failed = FALSE;
+					for (drv = Machine->gamedrv; !preload->file && drv; drv = driver_get_clone(drv))
+						if (drv->name && *drv->name)
+							preload->file = mame_fopen_rom_deferred(drv->name, ROM_GETNAME(rom), ROM_GETHASHDATA(rom));
+
+					/* count it only when complete, the cleanup walks all the counted entries */
+					preload_count++;
+				}
+}
+
+
+/*-------------------------------------------------
+    complete_rom_file - decompress and hash a
+    preloaded file; called by the worker threads
+-------------------------------------------------*/
+
+static void complete_rom_file(void *arg, int job)
+{
+	rom_preload *preload = ((rom_preload **)arg)[job];
+
+	if (mame_fcomplete(preload->file) != 0)
+		preload->failed = TRUE;
+}
+
+
+/*-------------------------------------------------
+    compare_preload_size - sort the preloaded
+    files from the biggest
+-------------------------------------------------*/
+
+static int CLIB_DECL compare_preload_size(const void *e1, const void *e2)
+{
+	UINT64 size1 = mame_fsize((*(const rom_preload **)e1)->file);
+	UINT64 size2 = mame_fsize((*(const rom_preload **)e2)->file);
+
+	return (size1 < size2) ? 1 : (size1 > size2) ? -1 : 0;
+}
+
+
+/*-------------------------------------------------
+    complete_rom_files - decompress and hash all
+    the preloaded files in parallel; returns the
+    number of files processed
+-------------------------------------------------*/
+
+static int complete_rom_files(void)
+{
+	rom_preload **jobs;
+	int count = 0;
+	int i;
+
+	jobs = malloc(preload_count * sizeof(jobs[0]) + 1);
+	if (!jobs)
+		return 0;
+
+	for (i = 0; i < preload_count; i++)
+		if (preload_list[i].file)
+			jobs[count++] = &preload_list[i];
+
+	/* starting from the biggest the workers end at about the same time */
+	qsort(jobs, count, sizeof(jobs[0]), compare_preload_size);
+	osd_parallelize_jobs(complete_rom_file, jobs, count);
+
+	/* the failed files are opened again later, to report the error */
+	for (i = 0; i < preload_count; i++)
+		if (preload_list[i].failed)
+		{
+			logerror("Unable to decompress ROM file %s\n", ROM_GETNAME(preload_list[i].romp));
+			mame_fclose(preload_list[i].file);
+			preload_list[i].file = NULL;
+		}
+
+	free(jobs);
+	return count;
+}
+
+
+/*-------------------------------------------------
+    free_rom_files - close the preloaded files
+    not used
+-------------------------------------------------*/
+
+static void free_rom_files(void)
+{
+	int i;
+
+	for (i = 0; i < preload_count; i++)
+		if (preload_list[i].file)
+			mame_fclose(preload_list[i].file);
+
+	free(preload_list);
+	preload_list = NULL;
+	preload_count = 0;
+	preload_next = 0;
+}
+
+
 /*-------------------------------------------------
     rom_fread - cheesy fread that fills with
     random data for a NULL file
@@ -934,6 +1109,9 @@ int rom_init(const rom_entry *romp)
 	const rom_entry *regionlist[REGION_MAX];
 	const rom_entry *region;
 	static rom_load_data romdata;
+	cycles_t stage[5];
+	char timing[256];
+	int completed;
 	int regnum;
 
 	/* if no roms, bail */
@@ -953,6 +1131,27 @@ int rom_init(const rom_entry *romp)
 	/* determine the correct biosset to load based on options.bios string */
 	system_bios = determine_bios_rom(Machine->gamedrv->bios);
 
+	/* if the ROM files didn't change since the last run, take the regions from the cache */
+	stage[0] = osd_cycles();
+	if (romcache_init(romp, system_bios) && romcache_load_regions(romp))
+	{
+		sprintf(timing, "ROM loading: read from the cache %.3f s\n", (double)(osd_cycles() - stage[0]) / osd_cycles_per_second());
+		logerror("%s", timing);
+		if (options.verbose)
+			printf("%s", timing);
+
+		total_rom_load_warnings = 0;
+
+		add_exit_callback(rom_exit);
+		return display_rom_load_results(&romdata);
+	}
+
+	/* read all the files first, and then decompress and hash them in parallel */
+	preload_rom_files(&romdata, romp);
+	stage[1] = osd_cycles();
+	completed = complete_rom_files();
+	stage[2] = osd_cycles();
+
 	/* loop until we hit the end */
 	for (region = romp, regnum = 0; region; region = rom_next_region(region), regnum++)
 	{
@@ -964,6 +1163,7 @@ int rom_init(const rom_entry *romp)
 		if (!ROMENTRY_ISREGION(region))
 		{
 			printf("Error: missing ROM_REGION header\n");
+			free_rom_files();
 			return 1;
 		}
 
@@ -971,6 +1171,7 @@ int rom_init(const rom_entry *romp)
 		if (new_memory_region(regiontype, ROMREGION_GETLENGTH(region), ROMREGION_GETFLAGS(region)) != 0)
 		{
 			printf("Error: unable to allocate memory for region %d\n", regiontype);
+			free_rom_files();
 			return 1;
 		}
 
@@ -997,12 +1198,18 @@ int rom_init(const rom_entry *romp)
 		if (ROMREGION_ISROMDATA(region))
 		{
 			if (!process_rom_entries(&romdata, region + 1))
+			{
+				free_rom_files();
 				return 1;
+			}
 		}
 		else if (ROMREGION_ISDISKDATA(region))
 		{
 			if (!process_disk_entries(&romdata, region + 1))
+			{
+				free_rom_files();
 				return 1;
+			}
 		}
 
 		/* add this region to the list */
@@ -1010,7 +1217,10 @@ int rom_init(const rom_entry *romp)
 			regionlist[regiontype] = region;
 	}
 
-	/* post-process the regions */
+	free_rom_files();
+	stage[3] = osd_cycles();
+
+	/* post-process the regions, now that all the data is present */
 	for (regnum = 0; regnum < REGION_MAX; regnum++)
 		if (regionlist[regnum])
 		{
@@ -1019,6 +1229,19 @@ int rom_init(const rom_entry *romp)
 			romdata.regionbase = memory_region(regnum);
 			region_post_process(&romdata, regionlist[regnum]);
 		}
+	stage[4] = osd_cycles();
+
+	/* report the time of each stage */
+	sprintf(timing, "ROM loading: read %.3f s, decompress and hash %.3f s (%d files), copy and verify %.3f s, post-process %.3f s\n",
+			(double)(stage[1] - stage[0]) / osd_cycles_per_second(), (double)(stage[2] - stage[1]) / osd_cycles_per_second(), completed,
+			(double)(stage[3] - stage[2]) / osd_cycles_per_second(), (double)(stage[4] - stage[3]) / osd_cycles_per_second());
+	logerror("%s", timing);
+	if (options.verbose)
+		printf("%s", timing);
+
+	/* only a clean load is cached */
+	if (!romdata.warnings && !romdata.errors)
+		romcache_save_regions(romp);
 
 	/* display the results and exit */
 	total_rom_load_warnings = romdata.warnings;
@@ -1040,6 +1263,21 @@ void rom_exit(void)
 	for (i = 0; i < MAX_MEMORY_REGIONS; i++)
 		free_memory_region(i);
 
+	/* report how the hunk cache performed */
+	for (i = 0; i < sizeof(disk_handle) / sizeof(disk_handle[0]); i++)
+		if (disk_handle[i])
+		{
+			chd_cache_stats stats;
+			char report[256];
+
+			chd_get_cache_stats(disk_handle[i], &stats);
+			sprintf(report, "Disk %d cache: %u hits, %u misses, %u hunks read ahead (%u used, %u waited)\n",
+					i, stats.hits, stats.misses, stats.prefetched, stats.prefetch_hits, stats.waits);
+			logerror("%s", report);
+			if (options.verbose)
+				printf("%s", report);
+		}
+
 	/* close all hard drives */
 	chd_close_all();
 }
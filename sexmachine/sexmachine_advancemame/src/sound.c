@@ -116,6 +116,7 @@ static wav_file *wavfile;
 static void sound_reset(void);
 static void sound_pause(int pause);
 static void sound_exit(void);
+static void log_stream_profile(void);
 static void sound_load(int config_type, xml_data_node *parentnode);
 static void sound_save(int config_type, xml_data_node *parentnode);
 static int start_sound_chips(void);
@@ -261,6 +262,10 @@ static void sound_exit(void)
 }
 #endif /* MAME_DEBUG */
 
+	/* log the CPU time spent by the streams */
+	if (options.stream_bench)
+		log_stream_profile();
+
 	/* stop all the sound chips */
 	for (sndnum = 0; sndnum < MAX_SOUND; sndnum++)
 		if (Machine->drv->sound[sndnum].sound_type != 0)
@@ -278,6 +283,76 @@ static void sound_exit(void)
 
 
 
+/*-------------------------------------------------
+    format_stream_profile - describe the CPU time
+    spent by a stream, and return it as a fraction
+    of the emulated time
+-------------------------------------------------*/
+
+static double format_stream_profile(char *buffer, sound_stream *stream)
+{
+	stream_profile profile;
+	double emulated, update, resample;
+
+	stream_get_profile(stream, &profile);
+	if (profile.samples == 0)
+	{
+		sprintf(buffer, "%d Hz, no samples\n", profile.sample_rate);
+		return 0;
+	}
+
+	emulated = (double)profile.samples / (double)profile.sample_rate;
+	update = profile.update_time / emulated;
+	resample = profile.resample_time / emulated;
+	sprintf(buffer, "%d Hz, update %.2f%%, resample %.2f%%\n", profile.sample_rate, update * 100, resample * 100);
+	return update + resample;
+}
+
+
+/*-------------------------------------------------
+    log_stream_profile - log the CPU time spent
+    by the streams of every chip and speaker
+-------------------------------------------------*/
+
+static void log_stream_profile(void)
+{
+	char report[256];
+	double total = 0;
+	int sndnum, spknum, index;
+
+	for (sndnum = 0; sndnum < totalsnd; sndnum++)
+		for (index = 0; ; index++)
+		{
+			sound_stream *stream = stream_find_by_tag(&sound[sndnum], index);
+			int len;
+
+			if (!stream)
+				break;
+			len = sprintf(report, "Sound chip #%d (%s) stream %d: ", sndnum, sndnum_name(sndnum), index);
+			total += format_stream_profile(report + len, stream);
+			logerror("%s", report);
+			if (options.verbose)
+				printf("%s", report);
+		}
+
+	for (spknum = 0; spknum < totalspeakers; spknum++)
+		if (speaker[spknum].mixer_stream)
+		{
+			int len = sprintf(report, "Speaker \"%s\" mixer: ", speaker[spknum].speaker->tag);
+			total += format_stream_profile(report + len, speaker[spknum].mixer_stream);
+			logerror("%s", report);
+			if (options.verbose)
+				printf("%s", report);
+		}
+
+	sprintf(report, "Sound streams total: %.2f%% of the emulated time\n", total * 100);
+	logerror("%s", report);
+	if (options.verbose)
+		printf("%s", report);
+}
+
+
+
 /***************************************************************************
 
     Initialization Helpers
@@ -712,33 +787,37 @@ void sound_frame_update(void)
 		}
 	}
 
-	/* now downmix the final result */
-	for (sample = 0; sample < samples_this_frame; sample++)
+	/* frames run ahead of the real one are never heard; keep the last result for the OSD */
+	if (mame_get_output_mask() & MAME_OUTPUT_AUDIO)
 	{
-		INT32 samp;
-
-		/* clamp the left side */
-		samp = leftmix[sample];
-		if (samp < -32768)
-			samp = -32768;
-		else if (samp > 32767)
-			samp = 32767;
-		finalmix[sample*2+0] = samp;
-
-		/* clamp the right side */
-		samp = rightmix[sample];
-		if (samp < -32768)
-			samp = -32768;
-		else if (samp > 32767)
-			samp = 32767;
-		finalmix[sample*2+1] = samp;
-	}
+		/* now downmix the final result */
+		for (sample = 0; sample < samples_this_frame; sample++)
+		{
+			INT32 samp;
+
+			/* clamp the left side */
+			samp = leftmix[sample];
+			if (samp < -32768)
+				samp = -32768;
+			else if (samp > 32767)
+				samp = 32767;
+			finalmix[sample*2+0] = samp;
+
+			/* clamp the right side */
+			samp = rightmix[sample];
+			if (samp < -32768)
+				samp = -32768;
+			else if (samp > 32767)
+				samp = 32767;
+			finalmix[sample*2+1] = samp;
+		}
 
-	if (wavfile && !mame_is_paused())
-		wav_add_data_16(wavfile, finalmix, samples_this_frame * 2);
+		if (wavfile && !mame_is_paused())
+			wav_add_data_16(wavfile, finalmix, samples_this_frame * 2);
 
-	/* play the result */
-	samples_this_frame = osd_update_audio_stream(finalmix);
+		/* play the result */
+		samples_this_frame = osd_update_audio_stream(finalmix);
+	}
 
 	/* update the streamer */
 	streams_frame_update();
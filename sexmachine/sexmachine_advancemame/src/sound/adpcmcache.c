@@ -0,0 +1,395 @@
+/***************************************************************************
+
+    adpcmcache.c
+
+    Cache of the ADPCM samples decoded from the sound ROMs.
+
+****************************************************************************
+
+    A sample always starts with the decoder reset, so a playback of
+    the same sample gives the same output while the sound ROM doesn't
+    change. The first playback decodes the sample into an entry, as
+    far as it plays, and the next ones only mix the decoded data.
+
+    Some drivers switch the sample banks copying the data into the
+    sound region, so an entry also keeps a copy of the compressed data
+    it decoded. Every fetch compares it with the ROM, and on a change
+    the entry becomes stale: the voice leaves the cache and decodes
+    the ROM directly, and the next playback creates a new entry.
+
+    An entry is keyed by the address of the compressed data, the
+    number of samples and the decoder. It also stores the decoder
+    step after every sample, so the decoder state at any position can
+    be recovered when a voice leaves the cache in the middle of a
+    sample, for a bank switch or a state save.
+
+    The entries not played by any voice are kept in LRU order and
+    dropped when a new one doesn't fit in the memory budget.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "adpcmcache.h"
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define ADPCM_CACHE_HASH_SIZE	256
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+struct _adpcm_cache_entry
+{
+	adpcm_cache_entry *	next;			/* next entry in the hash bucket */
+	adpcm_cache_entry *	lru_prev;		/* more recently used entry */
+	adpcm_cache_entry *	lru_next;		/* less recently used entry */
+	const UINT8 *		base;			/* compressed data */
+	UINT32				count;			/* total samples */
+	UINT32				decoded;		/* samples decoded so far */
+	UINT32				bytes;			/* memory used by the entry */
+	int					users;			/* voices playing the entry */
+	int					stale;			/* the ROM changed, not in the hash anymore */
+	adpcm_cache_decoder	decode;			/* decoder of the compressed data */
+	adpcm_cache_state	reset;			/* decoder state at the start */
+	adpcm_cache_state	state;			/* decoder state after the decoded samples */
+	INT16 *				pcm;			/* decoded samples */
+	UINT8 *				step;			/* decoder step after every sample */
+	UINT8 *				data;			/* copy of the decoded compressed data */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+static int cache_active;
+static adpcm_cache_entry *cache_hash[ADPCM_CACHE_HASH_SIZE];
+static adpcm_cache_entry *cache_lru_head;
+static adpcm_cache_entry *cache_lru_tail;
+static adpcm_cache_stats cache_stats;
+
+
+
+/***************************************************************************
+    PROTOTYPES
+***************************************************************************/
+
+static void adpcm_cache_exit(void);
+
+
+
+/***************************************************************************
+    IMPLEMENTATION
+***************************************************************************/
+
+/*-------------------------------------------------
+    hash_index - bucket of an entry
+-------------------------------------------------*/
+
+INLINE int hash_index(const UINT8 *base, UINT32 count)
+{
+	return ((UINT32)(FPTR)base ^ ((UINT32)(FPTR)base >> 11) ^ count) % ADPCM_CACHE_HASH_SIZE;
+}
+
+
+/*-------------------------------------------------
+    lru_unlink - remove an entry from the LRU
+    list
+-------------------------------------------------*/
+
+static void lru_unlink(adpcm_cache_entry *entry)
+{
+	if (entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		cache_lru_head = entry->lru_next;
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		cache_lru_tail = entry->lru_prev;
+	entry->lru_prev = entry->lru_next = NULL;
+}
+
+
+/*-------------------------------------------------
+    lru_push - make an entry the most recently
+    used
+-------------------------------------------------*/
+
+static void lru_push(adpcm_cache_entry *entry)
+{
+	entry->lru_prev = NULL;
+	entry->lru_next = cache_lru_head;
+	if (cache_lru_head)
+		cache_lru_head->lru_prev = entry;
+	else
+		cache_lru_tail = entry;
+	cache_lru_head = entry;
+}
+
+
+/*-------------------------------------------------
+    hash_unlink - remove an entry from its hash
+    bucket
+-------------------------------------------------*/
+
+static void hash_unlink(adpcm_cache_entry *entry)
+{
+	adpcm_cache_entry **prev = &cache_hash[hash_index(entry->base, entry->count)];
+
+	while (*prev != entry)
+		prev = &(*prev)->next;
+	*prev = entry->next;
+	entry->next = NULL;
+}
+
+
+/*-------------------------------------------------
+    entry_free - remove an entry from the cache
+-------------------------------------------------*/
+
+static void entry_free(adpcm_cache_entry *entry)
+{
+	if (!entry->stale)
+		hash_unlink(entry);
+
+	lru_unlink(entry);
+
+	cache_stats.used -= entry->bytes;
+	cache_stats.entries--;
+	free(entry);
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_init - set up the cache for the
+    running game
+-------------------------------------------------*/
+
+void adpcm_cache_init(void)
+{
+	/* all the chips share the same cache */
+	if (cache_active)
+		return;
+
+	cache_active = 1;
+	memset(cache_hash, 0, sizeof(cache_hash));
+	cache_lru_head = cache_lru_tail = NULL;
+	memset(&cache_stats, 0, sizeof(cache_stats));
+	cache_stats.size = options.adpcm_cache_size;
+
+	add_exit_callback(adpcm_cache_exit);
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_exit - free all the entries
+-------------------------------------------------*/
+
+static void adpcm_cache_exit(void)
+{
+	if (cache_stats.size != 0)
+	{
+		char report[256];
+
+		sprintf(report, "ADPCM cache: %u hits, %u misses, %u evictions, %u rejected, %u stale, %u kB used\n",
+				cache_stats.hits, cache_stats.misses, cache_stats.evictions, cache_stats.rejects, cache_stats.stales, cache_stats.used / 1024);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+	}
+
+	while (cache_lru_head)
+		entry_free(cache_lru_head);
+
+	cache_active = 0;
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_acquire - get the entry of a
+    sample, creating it if needed
+-------------------------------------------------*/
+
+adpcm_cache_entry *adpcm_cache_acquire(const UINT8 *base, UINT32 count, adpcm_cache_decoder decode, const adpcm_cache_state *reset)
+{
+	adpcm_cache_entry *entry;
+	UINT32 bytes;
+	int hash;
+
+	if (!cache_active || cache_stats.size == 0)
+		return NULL;
+
+	/* look for an existing entry */
+	hash = hash_index(base, count);
+	for (entry = cache_hash[hash]; entry != NULL; entry = entry->next)
+		if (entry->base == base && entry->count == count && entry->decode == decode
+			&& entry->reset.signal == reset->signal && entry->reset.step == reset->step)
+		{
+			lru_unlink(entry);
+			lru_push(entry);
+			entry->users++;
+			cache_stats.hits++;
+			return entry;
+		}
+
+	/* make room dropping the least recently used entries not playing */
+	bytes = sizeof(*entry) + count * (sizeof(INT16) + sizeof(UINT8)) + (count + 1) / 2;
+	if (bytes > cache_stats.size)
+	{
+		cache_stats.rejects++;
+		return NULL;
+	}
+	for (entry = cache_lru_tail; entry != NULL && cache_stats.used + bytes > cache_stats.size; )
+	{
+		adpcm_cache_entry *prev = entry->lru_prev;
+		if (entry->users == 0)
+		{
+			entry_free(entry);
+			cache_stats.evictions++;
+		}
+		entry = prev;
+	}
+	if (cache_stats.used + bytes > cache_stats.size)
+	{
+		cache_stats.rejects++;
+		return NULL;
+	}
+
+	entry = malloc(bytes);
+	if (!entry)
+	{
+		cache_stats.rejects++;
+		return NULL;
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->base = base;
+	entry->count = count;
+	entry->bytes = bytes;
+	entry->users = 1;
+	entry->decode = decode;
+	entry->reset = *reset;
+	entry->state = *reset;
+	entry->pcm = (INT16 *)(entry + 1);
+	entry->step = (UINT8 *)(entry->pcm + count);
+	entry->data = entry->step + count;
+
+	entry->next = cache_hash[hash];
+	cache_hash[hash] = entry;
+	lru_push(entry);
+
+	cache_stats.used += bytes;
+	cache_stats.entries++;
+	cache_stats.misses++;
+	return entry;
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_release - release an entry
+    acquired by a voice
+-------------------------------------------------*/
+
+void adpcm_cache_release(adpcm_cache_entry *entry)
+{
+	assert(entry->users > 0);
+	entry->users--;
+
+	/* nobody can get a stale entry again */
+	if (entry->users == 0 && entry->stale)
+		entry_free(entry);
+}
+
+
+/*-------------------------------------------------
+    entry_decode - decode the samples up to end
+-------------------------------------------------*/
+
+static void entry_decode(adpcm_cache_entry *entry, UINT32 end)
+{
+	if (end > entry->decoded)
+	{
+		UINT32 first = entry->decoded / 2;
+
+		(*entry->decode)(entry->base, entry->decoded, end - entry->decoded, &entry->state,
+				entry->pcm + entry->decoded, entry->step + entry->decoded);
+		memcpy(entry->data + first, entry->base + first, (end + 1) / 2 - first);
+		entry->decoded = end;
+	}
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_fetch - get decoded samples,
+    decoding them if needed
+-------------------------------------------------*/
+
+const INT16 *adpcm_cache_fetch(adpcm_cache_entry *entry, UINT32 sample, UINT32 samples)
+{
+	UINT32 end = sample + samples;
+	UINT32 first = sample / 2;
+	UINT32 last = (end + 1) / 2;
+
+	assert(end <= entry->count);
+
+	if (entry->stale)
+		return NULL;
+
+	/* check the already decoded data against the ROM, the driver may have rewritten it */
+	if (last > (entry->decoded + 1) / 2)
+		last = (entry->decoded + 1) / 2;
+	if (first < last && memcmp(entry->data + first, entry->base + first, last - first) != 0)
+	{
+		hash_unlink(entry);
+		entry->stale = 1;
+		cache_stats.stales++;
+		return NULL;
+	}
+
+	entry_decode(entry, end);
+
+	return entry->pcm + sample;
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_get_state - get the decoder state
+    before a sample
+-------------------------------------------------*/
+
+void adpcm_cache_get_state(adpcm_cache_entry *entry, UINT32 sample, adpcm_cache_state *state)
+{
+	if (sample == 0)
+	{
+		*state = entry->reset;
+		return;
+	}
+
+	entry_decode(entry, sample);
+	state->signal = entry->pcm[sample - 1] >> 4;
+	state->step = entry->step[sample - 1];
+}
+
+
+/*-------------------------------------------------
+    adpcm_cache_get_stats - get the statistics of
+    the cache
+-------------------------------------------------*/
+
+int adpcm_cache_get_stats(adpcm_cache_stats *stats)
+{
+	if (!cache_active || cache_stats.size == 0)
+		return 0;
+
+	*stats = cache_stats;
+	return 1;
+}
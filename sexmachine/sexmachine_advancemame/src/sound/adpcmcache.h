@@ -0,0 +1,76 @@
+/***************************************************************************
+
+    adpcmcache.h
+
+    Cache of the ADPCM samples decoded from the sound ROMs.
+
+***************************************************************************/
+
+#ifndef __ADPCMCACHE_H__
+#define __ADPCMCACHE_H__
+
+#include "mamecore.h"
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* decoder state, the same of the OKIM6295 helpers */
+typedef struct _adpcm_cache_state adpcm_cache_state;
+struct _adpcm_cache_state
+{
+	INT32	signal;
+	INT32	step;
+};
+
+/*
+    Decode samples [sample, sample + samples) of the compressed data at
+    base, advancing state. For every sample it stores the output, that
+    must be the 12-bit signal << 4 as returned by clock_adpcm(), in pcm
+    and the step after it in step.
+*/
+typedef void (*adpcm_cache_decoder)(const UINT8 *base, UINT32 sample, UINT32 samples,
+		adpcm_cache_state *state, INT16 *pcm, UINT8 *step);
+
+typedef struct _adpcm_cache_entry adpcm_cache_entry;
+
+typedef struct _adpcm_cache_stats adpcm_cache_stats;
+struct _adpcm_cache_stats
+{
+	UINT32	size;						/* memory budget in bytes; 0 if disabled */
+	UINT32	used;						/* bytes allocated by the entries */
+	UINT32	entries;					/* samples in the cache */
+	UINT32	hits;						/* playbacks served from the cache */
+	UINT32	misses;						/* playbacks decoded into a new entry */
+	UINT32	evictions;					/* entries dropped to stay in the budget */
+	UINT32	rejects;					/* playbacks not cached, budget exhausted */
+	UINT32	stales;						/* entries dropped for a change of the ROM */
+};
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+/* set up the cache for the running game; call at sound start */
+void adpcm_cache_init(void);
+
+/* get the entry of count samples at base; returns NULL if the cache can't hold it */
+adpcm_cache_entry *adpcm_cache_acquire(const UINT8 *base, UINT32 count, adpcm_cache_decoder decode, const adpcm_cache_state *reset);
+
+/* release an entry acquired by a voice */
+void adpcm_cache_release(adpcm_cache_entry *entry);
+
+/* get the decoded samples [sample, sample + samples), decoding them if needed; returns NULL if the ROM changed */
+const INT16 *adpcm_cache_fetch(adpcm_cache_entry *entry, UINT32 sample, UINT32 samples);
+
+/* get the decoder state before sample */
+void adpcm_cache_get_state(adpcm_cache_entry *entry, UINT32 sample, adpcm_cache_state *state);
+
+/* get the statistics of the cache; returns 0 if it's disabled */
+int adpcm_cache_get_stats(adpcm_cache_stats *stats);
+
+#endif	/* __ADPCMCACHE_H__ */
@@ -51,6 +51,13 @@
 
 #define DISCRETE_DEBUGLOG			(0)
 
+/* per node cost profile, logged when the chip stops */
+#ifdef MAME_DEBUG
+#define DISCRETE_PROFILE			(1)
+#else
+#define DISCRETE_PROFILE			(0)
+#endif
+
 
 
 /*************************************
@@ -59,6 +66,13 @@
  *
  *************************************/
 
+struct discrete_step
+{
+	void (*step)(struct node_description *node);	/* Copy of the node's step function */
+	struct node_description *node;					/* The node to step */
+	cycles_t cycles;								/* Time spent in the step, profile only */
+};
+
 struct discrete_info
 {
 	/* emulation info */
@@ -72,6 +86,11 @@ struct discrete_info
 	struct node_description **indexed_node;
 	struct node_description *node_list;
 
+	/* compiled schedule, the nodes stepped for every sample */
+	int step_count;
+	struct discrete_step *step_list;
+	INT64 profile_samples;
+
 	/* the input streams */
 	int discrete_input_streams;
 	stream_sample_t *input_stream_data[DISCRETE_MAX_OUTPUTS];
@@ -110,6 +129,7 @@ static struct discrete_info *discrete_current_context;
 
 static void init_nodes(struct discrete_info *info, struct discrete_sound_block *block_list);
 static void find_input_nodes(struct discrete_info *info, struct discrete_sound_block *block_list);
+static void compile_nodes(struct discrete_info *info);
 static void setup_output_nodes(struct discrete_info *info);
 static void setup_disc_logs(struct discrete_info *info);
 static void discrete_reset(void *chip);
@@ -339,6 +359,9 @@ static void *discrete_start(int sndindex, int clock, const void *config)
 	/* now go back and find pointers to all input nodes */
 	find_input_nodes(info, intf);
 
+	/* build the schedule of the nodes that change while running */
+	compile_nodes(info);
+
 	/* then set up the output nodes */
 	setup_output_nodes(info);
 
@@ -372,6 +395,25 @@ static void discrete_stop(void *chip)
 		if (info->disc_wav_file[log_num])
 			wav_close(info->disc_wav_file[log_num]);
 
+	if (DISCRETE_PROFILE && info->profile_samples)
+	{
+		cycles_t total = 0;
+		int stepnum;
+
+		for (stepnum = 0; stepnum < info->step_count; stepnum++)
+			total += info->step_list[stepnum].cycles;
+
+		/* report the cost of every node, per sample and as a share of the total */
+		logerror("Discrete %d: %d of %d nodes stepped, %.0f cycles per sample\n", info->sndindex,
+				info->step_count, info->node_count, (double)total / info->profile_samples);
+		for (stepnum = 0; stepnum < info->step_count; stepnum++)
+		{
+			struct discrete_step *entry = &info->step_list[stepnum];
+			logerror("  NODE_%02d %-18s %8.1f cycles %5.1f%%\n", entry->node->node - NODE_START, entry->node->module.name,
+					(double)entry->cycles / info->profile_samples, total ? 100.0 * entry->cycles / total : 0.0);
+		}
+	}
+
 	if (DISCRETE_DEBUGLOG)
 	{
 		/* close the debug log */
@@ -427,6 +469,7 @@ static void discrete_stream_update(void *param, stream_sample_t **inputs, stream
 	int samplenum, nodenum, outputnum;
 	double val;
 	INT16 wave_data_l, wave_data_r;
+	struct discrete_step *entry, *last = info->step_list + info->step_count;
 
 	discrete_current_context = info;
 
@@ -439,14 +482,21 @@ static void discrete_stream_update(void *param, stream_sample_t **inputs, stream
 			*info->input_stream_data[nodenum] = inputs[nodenum][samplenum];
 		}
 
-		/* loop over all nodes */
-		for (nodenum = 0; nodenum < info->node_count; nodenum++)
+		/* step the compiled schedule */
+		if (DISCRETE_PROFILE)
 		{
-			struct node_description *node = info->running_order[nodenum];
-
-			/* Now step the node */
-			if (node->module.step)
-				(*node->module.step)(node);
+			for (entry = info->step_list; entry < last; entry++)
+			{
+				cycles_t start = osd_cycles();
+				(*entry->step)(entry->node);
+				entry->cycles += osd_cycles() - start;
+			}
+			info->profile_samples++;
+		}
+		else
+		{
+			for (entry = info->step_list; entry < last; entry++)
+				(*entry->step)(entry->node);
 		}
 
 		/* Add gain to the output and put into the buffers */
@@ -643,6 +693,75 @@ static void find_input_nodes(struct discrete_info *info, struct discrete_sound_b
 
 
 
+/*************************************
+ *
+ *  Compile the running schedule
+ *
+ *************************************/
+
+static int node_is_constant(struct discrete_info *info, struct node_description *node, const UINT8 *folded)
+{
+	int inputnum;
+
+	/* only the modules without state and reset are plain functions of their inputs */
+	if (!node->module.step || node->module.reset || node->module.contextsize)
+		return 0;
+
+	/* every node input must come from an earlier folded node, so the reset pass sees its final value */
+	for (inputnum = 0; inputnum < node->active_inputs; inputnum++)
+		if (node->input_is_node & (1 << inputnum))
+		{
+			struct node_description *node_ref = info->indexed_node[node->block->input_node[inputnum] - NODE_START];
+			int refnum = node_ref - info->node_list;
+
+			if (refnum >= node - info->node_list || !folded[refnum])
+				return 0;
+		}
+
+	return 1;
+}
+
+
+static void compile_nodes(struct discrete_info *info)
+{
+	UINT8 *folded;
+	int nodenum;
+
+	/* allocate the worst case schedule */
+	info->step_list = auto_malloc(info->node_count * sizeof(info->step_list[0]));
+	memset(info->step_list, 0, info->node_count * sizeof(info->step_list[0]));
+	info->step_count = 0;
+
+	folded = malloc_or_die(info->node_count);
+	memset(folded, 0, info->node_count);
+
+	/* loop over all nodes in running order */
+	for (nodenum = 0; nodenum < info->node_count; nodenum++)
+	{
+		struct node_description *node = info->running_order[nodenum];
+
+		/* the output and log nodes have nothing to step */
+		if (!node->module.step)
+			continue;
+
+		/* constants, and the math on constants only, are evaluated once by the reset */
+		if (node_is_constant(info, node, folded))
+		{
+			folded[nodenum] = 1;
+			continue;
+		}
+
+		info->step_list[info->step_count].step = node->module.step;
+		info->step_list[info->step_count].node = node;
+		info->step_count++;
+	}
+
+	free(folded);
+	discrete_log("discrete_start() - Compiled %d of %d nodes into the schedule", info->step_count, info->node_count);
+}
+
+
+
 /*************************************
  *
  *  Set up the output nodes
@@ -107,6 +107,7 @@
 
 #ifndef __RAINE__
 #include "sndintrf.h"		/* use M.A.M.E. */
+#include "osdepend.h"
 #else
 #include "deftypes.h"		/* use RAINE */
 #include "support.h"		/* use RAINE */
@@ -1251,57 +1252,9 @@ INLINE void advance_eg_channel(FM_OPN *OPN, FM_SLOT *SLOT)
 
 #define volume_calc(OP) ((OP)->vol_out + (AM & (OP)->AMmask))
 
-INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH)
+/* update phase counters AFTER output calculations */
+INLINE void update_phase_lfo_channel(FM_OPN *OPN, FM_CH *CH)
 {
-	unsigned int eg_out;
-
-	UINT32 AM = LFO_AM >> CH->ams;
-
-
-	m2 = c1 = c2 = mem = 0;
-
-	*CH->mem_connect = CH->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
-
-	eg_out = volume_calc(&CH->SLOT[SLOT1]);
-	{
-		INT32 out = CH->op1_out[0] + CH->op1_out[1];
-		CH->op1_out[0] = CH->op1_out[1];
-
-		if( !CH->connect1 ){
-			/* algorithm 5  */
-			mem = c1 = c2 = CH->op1_out[0];
-		}else{
-			/* other algorithms */
-			*CH->connect1 += CH->op1_out[0];
-		}
-
-		CH->op1_out[1] = 0;
-		if( eg_out < ENV_QUIET )	/* SLOT 1 */
-		{
-			if (!CH->FB)
-				out=0;
-
-			CH->op1_out[1] = op_calc1(CH->SLOT[SLOT1].phase, eg_out, (out<<CH->FB) );
-		}
-	}
-
-	eg_out = volume_calc(&CH->SLOT[SLOT3]);
-	if( eg_out < ENV_QUIET )		/* SLOT 3 */
-		*CH->connect3 += op_calc(CH->SLOT[SLOT3].phase, eg_out, m2);
-
-	eg_out = volume_calc(&CH->SLOT[SLOT2]);
-	if( eg_out < ENV_QUIET )		/* SLOT 2 */
-		*CH->connect2 += op_calc(CH->SLOT[SLOT2].phase, eg_out, c1);
-
-	eg_out = volume_calc(&CH->SLOT[SLOT4]);
-	if( eg_out < ENV_QUIET )		/* SLOT 4 */
-		*CH->connect4 += op_calc(CH->SLOT[SLOT4].phase, eg_out, c2);
-
-
-	/* store current MEM */
-	CH->mem_value = mem;
-
-	/* update phase counters AFTER output calculations */
 	if(CH->pms)
 	{
 
@@ -1352,6 +1305,75 @@ INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH)
 	}
 }
 
+static int skip_silent = 1;	/* cleared by the benchmark to calculate all the channels */
+
+INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH)
+{
+	unsigned int eg_out;
+
+	UINT32 AM;
+
+	/* silent channel: vol_out is without AM, so if all the four slots are at
+    or above ENV_QUIET none of them is calculated; with the feedback and the
+    MEM sample settled to zero the output part changes nothing and only the
+    phase counters have to be advanced */
+	if (skip_silent &&
+		CH->SLOT[SLOT1].vol_out >= ENV_QUIET && CH->SLOT[SLOT2].vol_out >= ENV_QUIET &&
+		CH->SLOT[SLOT3].vol_out >= ENV_QUIET && CH->SLOT[SLOT4].vol_out >= ENV_QUIET &&
+		!CH->op1_out[0] && !CH->op1_out[1] && !CH->mem_value)
+	{
+		update_phase_lfo_channel(OPN, CH);
+		return;
+	}
+
+	AM = LFO_AM >> CH->ams;
+
+	m2 = c1 = c2 = mem = 0;
+
+	*CH->mem_connect = CH->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
+
+	eg_out = volume_calc(&CH->SLOT[SLOT1]);
+	{
+		INT32 out = CH->op1_out[0] + CH->op1_out[1];
+		CH->op1_out[0] = CH->op1_out[1];
+
+		if( !CH->connect1 ){
+			/* algorithm 5  */
+			mem = c1 = c2 = CH->op1_out[0];
+		}else{
+			/* other algorithms */
+			*CH->connect1 += CH->op1_out[0];
+		}
+
+		CH->op1_out[1] = 0;
+		if( eg_out < ENV_QUIET )	/* SLOT 1 */
+		{
+			if (!CH->FB)
+				out=0;
+
+			CH->op1_out[1] = op_calc1(CH->SLOT[SLOT1].phase, eg_out, (out<<CH->FB) );
+		}
+	}
+
+	eg_out = volume_calc(&CH->SLOT[SLOT3]);
+	if( eg_out < ENV_QUIET )		/* SLOT 3 */
+		*CH->connect3 += op_calc(CH->SLOT[SLOT3].phase, eg_out, m2);
+
+	eg_out = volume_calc(&CH->SLOT[SLOT2]);
+	if( eg_out < ENV_QUIET )		/* SLOT 2 */
+		*CH->connect2 += op_calc(CH->SLOT[SLOT2].phase, eg_out, c1);
+
+	eg_out = volume_calc(&CH->SLOT[SLOT4]);
+	if( eg_out < ENV_QUIET )		/* SLOT 4 */
+		*CH->connect4 += op_calc(CH->SLOT[SLOT4].phase, eg_out, c2);
+
+
+	/* store current MEM */
+	CH->mem_value = mem;
+
+	update_phase_lfo_channel(OPN, CH);
+}
+
 /* update phase increment and envelope generator */
 INLINE void refresh_fc_eg_slot(FM_SLOT *SLOT , int fc , int kc )
 {
@@ -2007,6 +2029,176 @@ typedef struct
 	FM_CH CH[3];			/* channel state     */
 } YM2203;
 
+#ifndef __RAINE__
+/*  Silent channels benchmark (debug_fmbench option).
+    The register writes to the first chip are recorded for FM_BENCH_SECONDS,
+    starting from a copy of the chip, and then replayed twice on new copies:
+    calculating all the channels, as without the silent channel skip, and
+    skipping the silent ones. The two outputs must be the same.
+    Only the FM registers are replayed, and the copies have no timer and
+    IRQ handlers, so the SSG and the timers of the chip aren't touched.
+*/
+#define FM_BENCH_SECONDS	10
+#define FM_BENCH_CSM		0x100		/* CSM KEY ON from timer A, not a register */
+
+typedef struct
+{
+	UINT32	sample;			/* samples generated before the write */
+	UINT16	r;				/* register, or FM_BENCH_CSM */
+	UINT8	v;				/* value */
+} YM2203BenchWrite;
+
+static YM2203 *bench_chip;			/* chip to benchmark */
+static YM2203 *bench_start;			/* copy of the chip when the recording started */
+static YM2203BenchWrite *bench_list;
+static UINT32 bench_count;
+static UINT32 bench_max;
+static UINT32 bench_samples;		/* samples generated since the recording started */
+static int bench_active;
+
+static void ym2203_bench_free(void)
+{
+	free(bench_start);
+	bench_start = NULL;
+	free(bench_list);
+	bench_list = NULL;
+	bench_count = 0;
+	bench_max = 0;
+	bench_samples = 0;
+}
+
+static void ym2203_bench_record(int r, int v)
+{
+	if (bench_count == bench_max)
+	{
+		UINT32 max = bench_max ? bench_max*2 : 4096;
+		YM2203BenchWrite *list = realloc(bench_list, max*sizeof(YM2203BenchWrite));
+		if (!list)
+		{
+			ym2203_bench_free();
+			bench_active = 0;
+			return;
+		}
+		bench_list = list;
+		bench_max = max;
+	}
+
+	bench_list[bench_count].sample = bench_samples;
+	bench_list[bench_count].r = r;
+	bench_list[bench_count].v = v;
+	bench_count++;
+}
+
+static cycles_t ym2203_bench_replay(FMSAMPLE *buffer)
+{
+	YM2203 *F2203;
+	cycles_t start;
+	UINT32 sample;
+	UINT32 i;
+
+	F2203 = malloc(sizeof(YM2203));
+	if (!F2203)
+		return 0;
+	memcpy(F2203, bench_start, sizeof(YM2203));
+	F2203->OPN.P_CH = F2203->CH;
+	F2203->OPN.ST.Timer_Handler = NULL;
+	F2203->OPN.ST.IRQ_Handler = NULL;
+
+	start = osd_cycles();
+
+	sample = 0;
+	for (i=0; i<=bench_count; i++)
+	{
+		UINT32 end = i<bench_count ? bench_list[i].sample : bench_samples;
+		int r;
+
+		if (end > sample)
+		{
+			YM2203UpdateOne(F2203, buffer + sample, end - sample);
+			sample = end;
+		}
+
+		if (i == bench_count)
+			break;
+		r = bench_list[i].r;
+		if (r == FM_BENCH_CSM)
+			CSMKeyControll(&F2203->CH[2]);
+		else
+		{
+			F2203->REGS[r] = bench_list[i].v;
+			if ((r & 0xf0) == 0x20)
+				OPNWriteMode(&F2203->OPN, r, bench_list[i].v);
+			else
+				OPNWriteReg(&F2203->OPN, r, bench_list[i].v);
+		}
+	}
+
+	start = osd_cycles() - start;
+
+	free(F2203);
+	return start;
+}
+
+/* called at the start of every update of the benchmarked chip */
+static void ym2203_bench_update(YM2203 *F2203, int length)
+{
+	FMSAMPLE *buf;
+	cycles_t all, skip;
+	UINT32 i;
+	char report[256];
+
+	/* start recording */
+	if (!bench_start)
+	{
+		bench_start = malloc(sizeof(YM2203));
+		if (!bench_start)
+		{
+			bench_active = 0;
+			return;
+		}
+		memcpy(bench_start, F2203, sizeof(YM2203));
+		bench_samples = 0;
+	}
+
+	if (bench_samples < FM_BENCH_SECONDS * F2203->OPN.ST.rate)
+	{
+		bench_samples += length;
+		return;
+	}
+
+	/* stop recording while replaying */
+	bench_active = 0;
+
+	buf = malloc(2 * bench_samples * sizeof(FMSAMPLE));
+	if (buf)
+	{
+		skip_silent = 0;
+		all = ym2203_bench_replay(buf);
+		skip_silent = 1;
+		skip = ym2203_bench_replay(buf + bench_samples);
+
+		/* first sample that differs, if any */
+		for (i=0; i<bench_samples; i++)
+			if (buf[i] != buf[bench_samples + i])
+				break;
+
+		sprintf(report, "YM2203: %u writes in %u samples, generated in %.0f cycles with all the channels, in %.0f cycles skipping the silent ones (%.2fx), ",
+			bench_count, bench_samples, (double)all, (double)skip, skip ? (double)all / skip : 0.0);
+		if (i == bench_samples)
+			strcat(report, "same output\n");
+		else
+			sprintf(report + strlen(report), "output differs at sample %u\n", i);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+
+		free(buf);
+	}
+
+	ym2203_bench_free();
+}
+#endif
+
 /* Generate samples for one of the YM2203s */
 void YM2203UpdateOne(void *chip, FMSAMPLE *buffer, int length)
 {
@@ -2016,6 +2208,11 @@ void YM2203UpdateOne(void *chip, FMSAMPLE *buffer, int length)
 	FMSAMPLE *buf = buffer;
 	FM_CH	*cch[3];
 
+#ifndef __RAINE__
+	if (bench_active && F2203 == bench_chip)
+		ym2203_bench_update(F2203, length);
+#endif
+
 	cch[0]   = &F2203->CH[0];
 	cch[1]   = &F2203->CH[1];
 	cch[2]   = &F2203->CH[2];
@@ -2197,6 +2394,15 @@ void * YM2203Init(void *param, int index, int clock, int rate,
 	F2203->OPN.ST.SSG           = ssg;
 	YM2203ResetChip(F2203);
 
+#ifndef __RAINE__
+	/* only the first chip is benchmarked */
+	if (options.fm_bench && !bench_chip)
+	{
+		bench_chip = F2203;
+		bench_active = 1;
+	}
+#endif
+
 #ifdef __STATE_H__
 	YM2203_save_state(F2203, index);
 #endif
@@ -2208,6 +2414,15 @@ void YM2203Shutdown(void *chip)
 {
 	YM2203 *FM2203 = chip;
 
+#ifndef __RAINE__
+	if (FM2203 == bench_chip)
+	{
+		ym2203_bench_free();
+		bench_chip = NULL;
+		bench_active = 0;
+	}
+#endif
+
 	FMCloseTable();
 	free(FM2203);
 }
@@ -2249,6 +2464,11 @@ int YM2203Write(void *chip,int a,UINT8 v)
 			/* write register */
 			OPNWriteReg(OPN,addr,v);
 		}
+#ifndef __RAINE__
+		/* recorded after the update request, that generates the samples before it */
+		if (bench_start && F2203 == bench_chip && addr >= 0x20)
+			ym2203_bench_record(addr, v);
+#endif
 		FM_BUSY_SET(&OPN->ST,1);
 	}
 	return OPN->ST.irq;
@@ -2288,6 +2508,10 @@ int YM2203TimerOver(void *chip,int c)
 		if( F2203->OPN.ST.mode & 0x80 )
 		{	/* CSM mode auto key on */
 			CSMKeyControll( &(F2203->CH[2]) );
+#ifndef __RAINE__
+			if (bench_start && F2203 == bench_chip)
+				ym2203_bench_record(FM_BENCH_CSM, 0);
+#endif
 		}
 	}
 	return F2203->OPN.ST.irq;
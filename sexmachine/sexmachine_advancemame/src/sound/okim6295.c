@@ -26,6 +26,7 @@
 #include "sndintrf.h"
 #include "streams.h"
 #include "okim6295.h"
+#include "adpcmcache.h"
 
 #define MAX_SAMPLE_CHUNK	10000
 
@@ -41,6 +42,8 @@ struct ADPCMVoice
 
 	struct adpcm_state adpcm;/* current ADPCM state */
 	UINT32 volume;			/* output volume */
+
+	adpcm_cache_entry *cache;/* decoded samples, or NULL to decode here */
 };
 
 struct okim6295
@@ -173,6 +176,78 @@ INT16 clock_adpcm(struct adpcm_state *state, UINT8 nibble)
 
 
 
+/**********************************************************************************************
+
+     decode_adpcm -- decode samples for the ADPCM cache
+
+***********************************************************************************************/
+
+static void decode_adpcm(const UINT8 *base, UINT32 sample, UINT32 samples, adpcm_cache_state *state, INT16 *pcm, UINT8 *step)
+{
+	struct adpcm_state adpcm;
+
+	adpcm.signal = state->signal;
+	adpcm.step = state->step;
+
+	while (samples--)
+	{
+		int nibble = base[sample / 2] >> (((sample & 1) << 2) ^ 4);
+
+		*pcm++ = clock_adpcm(&adpcm, nibble);
+		*step++ = adpcm.step;
+		sample++;
+	}
+
+	state->signal = adpcm.signal;
+	state->step = adpcm.step;
+}
+
+
+
+/**********************************************************************************************
+
+     cache_voice -- play the voice from the ADPCM cache, if it can hold the sample
+
+***********************************************************************************************/
+
+static void cache_voice(struct okim6295 *chip, struct ADPCMVoice *voice)
+{
+	struct adpcm_state reset;
+	adpcm_cache_state state;
+
+	/* the entries start with the decoder reset */
+	reset_adpcm(&reset);
+	state.signal = reset.signal;
+	state.step = reset.step;
+
+	voice->cache = adpcm_cache_acquire(chip->region_base + chip->bank_offset + voice->base_offset, voice->count, decode_adpcm, &state);
+}
+
+
+
+/**********************************************************************************************
+
+     uncache_voice -- leave the ADPCM cache, restoring the decoder state
+
+***********************************************************************************************/
+
+static void uncache_voice(struct ADPCMVoice *voice)
+{
+	if (voice->cache)
+	{
+		adpcm_cache_state state;
+
+		adpcm_cache_get_state(voice->cache, voice->sample, &state);
+		voice->adpcm.signal = state.signal;
+		voice->adpcm.step = state.step;
+
+		adpcm_cache_release(voice->cache);
+		voice->cache = NULL;
+	}
+}
+
+
+
 /**********************************************************************************************
 
      generate_adpcm -- general ADPCM decoding routine
@@ -181,8 +256,34 @@ INT16 clock_adpcm(struct adpcm_state *state, UINT8 nibble)
 
 static void generate_adpcm(struct okim6295 *chip, struct ADPCMVoice *voice, INT16 *buffer, int samples)
 {
+	/* if this voice is playing from the cache, mix the decoded samples */
+	if (voice->playing && voice->cache)
+	{
+		int sample = voice->sample;
+		int count = voice->count;
+		int todo = (samples < count - sample) ? samples : count - sample;
+		const INT16 *pcm = adpcm_cache_fetch(voice->cache, sample, todo);
+
+		/* the driver rewrote the sample ROM, continue decoding it here */
+		if (!pcm)
+			uncache_voice(voice);
+		else
+		{
+			samples -= todo;
+			voice->sample = sample + todo;
+			while (todo--)
+				*buffer++ = *pcm++ * voice->volume / 256;
+
+			if (voice->sample >= count)
+			{
+				voice->playing = 0;
+				uncache_voice(voice);
+			}
+		}
+	}
+
 	/* if this voice is active */
-	if (voice->playing)
+	if (voice->playing && !voice->cache)
 	{
 		UINT8 *base = chip->region_base + chip->bank_offset + voice->base_offset;
 		int sample = voice->sample;
@@ -294,6 +395,60 @@ static void adpcm_state_save_register(struct ADPCMVoice *voice, int i)
 	state_save_register_item(buf, i, voice->base_offset);
 }
 
+/* the decoder state of the cached voices is only updated when they leave the cache */
+static void okim6295_presave(void *param)
+{
+	struct okim6295 *info = param;
+	int i;
+
+	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
+		struct ADPCMVoice *voice = &info->voice[i];
+
+		if (voice->cache)
+		{
+			adpcm_cache_state state;
+
+			adpcm_cache_get_state(voice->cache, voice->sample, &state);
+			voice->adpcm.signal = state.signal;
+			voice->adpcm.step = state.step;
+		}
+	}
+}
+
+/* a loaded voice returns in the cache only if its decoder state matches the decoded sample */
+static void okim6295_postload(void *param)
+{
+	struct okim6295 *info = param;
+	int i;
+
+	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
+		struct ADPCMVoice *voice = &info->voice[i];
+		adpcm_cache_state state;
+
+		if (voice->cache)
+		{
+			adpcm_cache_release(voice->cache);
+			voice->cache = NULL;
+		}
+
+		if (!voice->playing || voice->sample >= voice->count)
+			continue;
+
+		cache_voice(info, voice);
+		if (voice->cache)
+		{
+			adpcm_cache_get_state(voice->cache, voice->sample, &state);
+			if (state.signal != voice->adpcm.signal || state.step != voice->adpcm.step)
+			{
+				adpcm_cache_release(voice->cache);
+				voice->cache = NULL;
+			}
+		}
+	}
+}
+
 static void okim6295_state_save_register(struct okim6295 *info, int sndindex)
 {
 	int j;
@@ -305,6 +460,9 @@ static void okim6295_state_save_register(struct okim6295 *info, int sndindex)
 	state_save_register_item(buf, sndindex, info->bank_offset);
 	for (j = 0; j < OKIM6295_VOICES; j++)
 		adpcm_state_save_register(&info->voice[j], sndindex * 4 + j);
+
+	state_save_register_func_presave_ptr(okim6295_presave, info);
+	state_save_register_func_postload_ptr(okim6295_postload, info);
 }
 
 
@@ -325,6 +483,7 @@ static void *okim6295_start(int sndindex, int clock, const void *config)
 	memset(info, 0, sizeof(*info));
 
 	compute_tables();
+	adpcm_cache_init();
 
 	info->command = -1;
 	info->bank_offset = 0;
@@ -362,7 +521,10 @@ static void okim6295_reset(void *chip)
 
 	stream_update(info->stream, 0);
 	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
 		info->voice[i].playing = 0;
+		uncache_voice(&info->voice[i]);
+	}
 }
 
 
@@ -376,7 +538,15 @@ static void okim6295_reset(void *chip)
 void OKIM6295_set_bank_base(int which, int base)
 {
 	struct okim6295 *info = sndti_token(SOUND_OKIM6295, which);
+	int i;
+
 	stream_update(info->stream, 0);
+
+	/* a voice playing across the bank switch continues with the data of the new bank */
+	if (info->bank_offset != base)
+		for (i = 0; i < OKIM6295_VOICES; i++)
+			uncache_voice(&info->voice[i]);
+
 	info->bank_offset = base;
 }
 
@@ -468,6 +638,7 @@ static void OKIM6295_data_w(int num, int data)
 						/* also reset the ADPCM parameters */
 						reset_adpcm(&voice->adpcm);
 						voice->volume = volume_table[data & 0x0f];
+						cache_voice(info, voice);
 					}
 					else
 					{
@@ -479,6 +650,7 @@ static void OKIM6295_data_w(int num, int data)
 				{
 					logerror("OKIM6295:%d requested to play invalid sample %02x\n",num,info->command);
 					voice->playing = 0;
+					uncache_voice(voice);
 				}
 			}
 		}
@@ -509,6 +681,7 @@ static void OKIM6295_data_w(int num, int data)
 				struct ADPCMVoice *voice = &info->voice[i];
 
 				voice->playing = 0;
+				uncache_voice(voice);
 			}
 		}
 	}
@@ -8,6 +8,7 @@
 
 #include "sndintrf.h"
 #include "streams.h"
+#include "osdepend.h"
 #include "ym2151.h"
 
 
@@ -487,6 +488,32 @@ static signed int m2,c1,c2; /* Phase Modulation input for operators 2,3,4 */
 static signed int mem;		/* one sample delay memory */
 
 
+#ifdef USE_MAME_TIMERS
+/* silent channels benchmark, see ym2151_bench_update() */
+#define FM_BENCH_SECONDS	10
+#define FM_BENCH_CSM		0x100		/* CSM KEY ON from timer A, not a register */
+
+typedef struct
+{
+	UINT32	sample;			/* samples generated before the write */
+	UINT16	r;				/* register, or FM_BENCH_CSM */
+	UINT8	v;				/* value */
+} YM2151BenchWrite;
+
+static YM2151 *bench_chip;			/* chip to benchmark */
+static YM2151 *bench_start;			/* copy of the chip when the recording started */
+static YM2151BenchWrite *bench_list;
+static UINT32 bench_count;
+static UINT32 bench_max;
+static UINT32 bench_samples;		/* samples generated since the recording started */
+static int bench_active;
+
+static void ym2151_bench_record(int r, int v);
+static void ym2151_bench_update(YM2151 *chip, int length);
+static void ym2151_bench_free(void);
+#endif
+
+
 /* save output as raw 16-bit sample */
 /* #define SAVE_SAMPLE */
 /* #define SAVE_SEPARATE_CHANNELS */
@@ -792,7 +819,11 @@ static void timer_callback_a (void *param)
 		if ((!oldstate) && (chip->irqhandler)) (*chip->irqhandler)(1);
 	}
 	if (chip->irq_enable & 0x80)
+	{
 		chip->csm_req = 2;		/* request KEY ON / KEY OFF sequence */
+		if (bench_start && chip == bench_chip)
+			ym2151_bench_record(FM_BENCH_CSM, 0);
+	}
 }
 static void timer_callback_b (void *param)
 {
@@ -1012,6 +1043,11 @@ void YM2151WriteReg(void *_chip, int r, int v)
 	r &= 0xff;
 	v &= 0xff;
 
+#ifdef USE_MAME_TIMERS
+	if (bench_start && chip == bench_chip)
+		ym2151_bench_record(r, v);
+#endif
+
 #if 0
 	/* There is no info on what YM2151 really does when busy flag is set */
 	if ( chip->status & 0x80 ) return;
@@ -1480,6 +1516,15 @@ void * YM2151Init(int index, int clock, int rate)
 	PSG->porthandler = NULL;				/* port write handler */
 	init_chip_tables( PSG );
 
+#ifdef USE_MAME_TIMERS
+	/* only the first chip is benchmarked */
+	if (options.fm_bench && !bench_chip)
+	{
+		bench_chip = PSG;
+		bench_active = 1;
+	}
+#endif
+
 	PSG->lfo_timer_add = (1<<LFO_SH) * (clock/64.0) / PSG->sampfreq;
 
 	PSG->eg_timer_add  = (1<<EG_SH)  * (clock/64.0) / PSG->sampfreq;
@@ -1514,6 +1559,15 @@ void YM2151Shutdown(void *_chip)
 {
 	YM2151 *chip = _chip;
 
+#ifdef USE_MAME_TIMERS
+	if (chip == bench_chip)
+	{
+		ym2151_bench_free();
+		bench_chip = NULL;
+		bench_active = 0;
+	}
+#endif
+
 	free (chip);
 
 #ifdef LOG_CYM_FILE
@@ -1640,6 +1694,37 @@ INLINE signed int op_calc1(YM2151Operator * OP, unsigned int env, signed int pm)
 
 #define volume_calc(OP) ((OP)->tl + ((UINT32)(OP)->volume) + (AM & (OP)->AMmask))
 
+/*  A channel is silent when its four operators are in the EG_OFF state
+*   (the volume is then MAX_ATT_INDEX so env is always above ENV_QUIET,
+*   noise included) and the feedback and the delayed MEM sample have
+*   settled to zero. chan_calc() of a silent channel changes nothing and
+*   adds nothing to chanout[], so it can be skipped.
+*   Only a KEY ON brings a channel back; it happens in the register writes,
+*   done between the updates, and in the CSM sequence of advance().
+*/
+static int skip_silent = 1;	/* cleared by the benchmark to calculate all the channels */
+
+INLINE UINT32 active_channels(void)
+{
+	YM2151Operator *op;
+	UINT32 mask = 0;
+	unsigned int chan;
+
+	if (!skip_silent)
+		return 0xff;
+
+	op = &PSG->oper[0];	/* CH 0 M1 */
+	for (chan=0; chan<8; chan++)
+	{
+		if ((op+0)->state != EG_OFF || (op+1)->state != EG_OFF || (op+2)->state != EG_OFF || (op+3)->state != EG_OFF
+			|| op->fb_out_prev || op->fb_out_curr || op->mem_value)
+			mask |= 1 << chan;
+		op+=4;
+	}
+
+	return mask;
+}
+
 INLINE void chan_calc(unsigned int chan)
 {
 	YM2151Operator *op;
@@ -2318,6 +2403,152 @@ INLINE signed int acc_calc(signed int value)
 #endif
 
 
+#ifdef USE_MAME_TIMERS
+/*  Silent channels benchmark (debug_fmbench option).
+*   The register writes to the first chip are recorded for FM_BENCH_SECONDS,
+*   starting from a copy of the chip, and then replayed twice on new copies:
+*   calculating all the channels, as without the silent channel skip, and
+*   skipping the silent ones. The two outputs must be the same.
+*   The copies have no IRQ and port handlers, and the timer registers are
+*   not replayed, so the MAME timers of the chip aren't touched.
+*/
+static void ym2151_bench_record(int r, int v)
+{
+	if (bench_count == bench_max)
+	{
+		UINT32 max = bench_max ? bench_max*2 : 4096;
+		YM2151BenchWrite *list = realloc(bench_list, max*sizeof(YM2151BenchWrite));
+		if (!list)
+		{
+			ym2151_bench_free();
+			bench_active = 0;
+			return;
+		}
+		bench_list = list;
+		bench_max = max;
+	}
+
+	bench_list[bench_count].sample = bench_samples;
+	bench_list[bench_count].r = r;
+	bench_list[bench_count].v = v;
+	bench_count++;
+}
+
+static cycles_t ym2151_bench_replay(SAMP *bufL, SAMP *bufR)
+{
+	YM2151 *chip;
+	SAMP *buffers[2];
+	cycles_t start;
+	UINT32 sample;
+	UINT32 i;
+
+	chip = malloc(sizeof(YM2151));
+	if (!chip)
+		return 0;
+	memcpy(chip, bench_start, sizeof(YM2151));
+	chip->irqhandler = NULL;
+	chip->porthandler = NULL;
+
+	start = osd_cycles();
+
+	sample = 0;
+	for (i=0; i<=bench_count; i++)
+	{
+		UINT32 end = i<bench_count ? bench_list[i].sample : bench_samples;
+
+		if (end > sample)
+		{
+			buffers[0] = bufL + sample;
+			buffers[1] = bufR + sample;
+			YM2151UpdateOne(chip, buffers, end - sample);
+			sample = end;
+		}
+
+		if (i == bench_count)
+			break;
+		if (bench_list[i].r == FM_BENCH_CSM)
+			chip->csm_req = 2;
+		else if (bench_list[i].r != 0x14)	/* IRQ and timers control */
+			YM2151WriteReg(chip, bench_list[i].r, bench_list[i].v);
+	}
+
+	start = osd_cycles() - start;
+
+	free(chip);
+	return start;
+}
+
+static void ym2151_bench_free(void)
+{
+	free(bench_start);
+	bench_start = NULL;
+	free(bench_list);
+	bench_list = NULL;
+	bench_count = 0;
+	bench_max = 0;
+	bench_samples = 0;
+}
+
+/* called at the start of every update of the benchmarked chip */
+static void ym2151_bench_update(YM2151 *chip, int length)
+{
+	SAMP *buf;
+	cycles_t all, skip;
+	UINT32 i;
+	char report[256];
+
+	/* start recording */
+	if (!bench_start)
+	{
+		bench_start = malloc(sizeof(YM2151));
+		if (!bench_start)
+		{
+			bench_active = 0;
+			return;
+		}
+		memcpy(bench_start, chip, sizeof(YM2151));
+		bench_samples = 0;
+	}
+
+	if (bench_samples < FM_BENCH_SECONDS * chip->sampfreq)
+	{
+		bench_samples += length;
+		return;
+	}
+
+	/* stop recording while replaying */
+	bench_active = 0;
+
+	buf = malloc(4 * bench_samples * sizeof(SAMP));
+	if (buf)
+	{
+		skip_silent = 0;
+		all = ym2151_bench_replay(buf, buf + bench_samples);
+		skip_silent = 1;
+		skip = ym2151_bench_replay(buf + 2*bench_samples, buf + 3*bench_samples);
+
+		/* first sample that differs, if any */
+		for (i=0; i<bench_samples; i++)
+			if (buf[i] != buf[2*bench_samples + i] || buf[bench_samples + i] != buf[3*bench_samples + i])
+				break;
+
+		sprintf(report, "YM2151: %u writes in %u samples, generated in %.0f cycles with all the channels, in %.0f cycles skipping the silent ones (%.2fx), ",
+			bench_count, bench_samples, (double)all, (double)skip, skip ? (double)all / skip : 0.0);
+		if (i == bench_samples)
+			strcat(report, "same output\n");
+		else
+			sprintf(report + strlen(report), "output differs at sample %u\n", i);
+		logerror("%s", report);
+		if (options.verbose)
+			printf("%s", report);
+
+		free(buf);
+	}
+
+	ym2151_bench_free();
+}
+#endif
+
 /*  Generate samples for one of the YM2151's
 *
 *   'num' is the number of virtual YM2151
@@ -2329,10 +2560,18 @@ void YM2151UpdateOne(void *chip, SAMP **buffers, int length)
 	int i;
 	signed int outl,outr;
 	SAMP *bufL, *bufR;
+	UINT32 active;
+	UINT32 eg_cnt;
+	UINT32 csm_req;
 
 	bufL = buffers[0];
 	bufR = buffers[1];
 
+#ifdef USE_MAME_TIMERS
+	if (bench_active && chip == bench_chip)
+		ym2151_bench_update(chip, length);
+#endif
+
 	PSG = chip;
 
 #ifdef USE_MAME_TIMERS
@@ -2354,9 +2593,16 @@ void YM2151UpdateOne(void *chip, SAMP **buffers, int length)
 	}
 #endif
 
+	/* the channels can only become silent at an envelope step, so the mask
+    is recomputed there and after a CSM KEY ON */
+	active = active_channels();
+
 	for (i=0; i<length; i++)
 	{
+		eg_cnt = PSG->eg_cnt;
 		advance_eg();
+		if (PSG->eg_cnt != eg_cnt)
+			active = active_channels();
 
 		chanout[0] = 0;
 		chanout[1] = 0;
@@ -2367,21 +2613,21 @@ void YM2151UpdateOne(void *chip, SAMP **buffers, int length)
 		chanout[6] = 0;
 		chanout[7] = 0;
 
-		chan_calc(0);
+		if (active & 0x01) chan_calc(0);
 		SAVE_SINGLE_CHANNEL(0)
-		chan_calc(1);
+		if (active & 0x02) chan_calc(1);
 		SAVE_SINGLE_CHANNEL(1)
-		chan_calc(2);
+		if (active & 0x04) chan_calc(2);
 		SAVE_SINGLE_CHANNEL(2)
-		chan_calc(3);
+		if (active & 0x08) chan_calc(3);
 		SAVE_SINGLE_CHANNEL(3)
-		chan_calc(4);
+		if (active & 0x10) chan_calc(4);
 		SAVE_SINGLE_CHANNEL(4)
-		chan_calc(5);
+		if (active & 0x20) chan_calc(5);
 		SAVE_SINGLE_CHANNEL(5)
-		chan_calc(6);
+		if (active & 0x40) chan_calc(6);
 		SAVE_SINGLE_CHANNEL(6)
-		chan7_calc();
+		if (active & 0x80) chan7_calc();
 		SAVE_SINGLE_CHANNEL(7)
 
 		outl = chanout[0] & PSG->pan[0];
@@ -2433,7 +2679,10 @@ void YM2151UpdateOne(void *chip, SAMP **buffers, int length)
 			}
 		}
 #endif
+		csm_req = PSG->csm_req;
 		advance();
+		if (csm_req == 2)
+			active = active_channels();
 	}
 }
 
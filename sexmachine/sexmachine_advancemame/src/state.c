@@ -18,6 +18,21 @@
     14..17  Signature
     18..end Save game data
 
+    In-memory ring format:
+
+    The ring keeps the most recent full image (same layout as a save
+    file) plus, for each entry, the difference from the entry before
+    it. The image is split in RING_BLOCK_SIZE blocks and only changed
+    blocks are stored, each one as:
+
+     0.. 3  Block number (little endian)
+     4..end Tokens XOR-ing the block, each one starting with a 16-bit
+            little endian word: bit 15 set is a run of unchanged bytes,
+            bit 15 clear is a run of literal XOR bytes that follows
+
+    Restoring an older entry walks back from the newest image applying
+    the XOR deltas, dropping the newer entries on the way.
+
 ***************************************************************************/
 
 #include "driver.h"
@@ -47,6 +62,11 @@
 
 #define TAG_STACK_SIZE		4
 
+#define RING_BLOCK_SIZE		256
+#define RING_RUN_MIN		4
+#define RING_BLOCK_WORST	(4 + RING_BLOCK_SIZE + 4 * (RING_BLOCK_SIZE / (RING_RUN_MIN + 1) + 1))
+#define RING_TOKEN_SKIP		0x8000
+
 /* Available flags */
 enum
 {
@@ -101,6 +121,36 @@ struct _ss_func
 };
 
 
+typedef struct _ss_ring_entry ss_ring_entry;
+struct _ss_ring_entry
+{
+	UINT32			offset;				/* offset of the delta within the arena */
+	UINT32			length;				/* length of the encoded delta */
+	UINT32			frame;				/* frame number at capture time */
+};
+
+
+typedef struct _ss_ring_state ss_ring_state;
+struct _ss_ring_state
+{
+	UINT8 *			arena;				/* preallocated storage for the deltas */
+	UINT32			arena_size;			/* size of the arena */
+	UINT32			head;				/* offset of the next delta in the arena */
+	UINT32			used;				/* bytes used by the stored deltas */
+	ss_ring_entry *	entry;				/* circular list of entries */
+	int				entry_max;			/* size of the entry list */
+	int				first;				/* index of the oldest entry */
+	int				count;				/* number of valid entries */
+	UINT8 *			image;				/* full image of the newest entry */
+	UINT8 *			work;				/* image being captured */
+	UINT8 *			delta;				/* scratch buffer for the encoder */
+	UINT32			image_size;			/* size of the images */
+	UINT32			signature;			/* signature of the images */
+	cycles_t		start;				/* time of the operation in progress */
+	state_ring_info	info;				/* statistics */
+};
+
+
 
 /***************************************************************************
     GLOBALS
@@ -120,6 +170,12 @@ static UINT8 *ss_dump_array;
 static mame_file *ss_dump_file;
 static UINT32 ss_dump_size;
 
+static UINT8 *ss_snapshot;
+static UINT32 ss_snapshot_size;
+static UINT32 ss_snapshot_valid;
+
+static ss_ring_state ss_ring;
+
 #ifdef MESS
 static const char ss_magic_num[8] = { 'M', 'E', 'S', 'S', 'S', 'A', 'V', 'E' };
 #else
@@ -680,6 +736,32 @@ static UINT32 get_signature(void)
 
 
 
+/*-------------------------------------------------
+    write_header - fill in the header of a state
+    image
+-------------------------------------------------*/
+
+static void write_header(UINT8 *header, UINT32 signature)
+{
+	UINT8 flags = 0;
+
+	/* compute the flags */
+#ifndef LSB_FIRST
+	flags |= SS_MSB_FIRST;
+#endif
+
+	memcpy(header, ss_magic_num, 8);
+	header[8] = SAVE_VERSION;
+	header[9] = flags;
+	memset(header+0xa, 0, 10);
+	strcpy((char *)header+0xa, Machine->gamedrv->name);
+
+	/* copy in the signature */
+	*(UINT32 *)&header[0x14] = LITTLE_ENDIANIZE_INT32(signature);
+}
+
+
+
 /***************************************************************************
 
     State file validation
@@ -832,26 +914,10 @@ void state_save_save_continue(void)
 
 void state_save_save_finish(void)
 {
-	UINT32 signature;
-	UINT8 flags = 0;
-
 	TRACE(logerror("Finishing save\n"));
 
-	/* compute the flags */
-#ifndef LSB_FIRST
-	flags |= SS_MSB_FIRST;
-#endif
-
 	/* build up the header */
-	memcpy(ss_dump_array, ss_magic_num, 8);
-	ss_dump_array[8] = SAVE_VERSION;
-	ss_dump_array[9] = flags;
-	memset(ss_dump_array+0xa, 0, 10);
-	strcpy((char *)ss_dump_array+0xa, Machine->gamedrv->name);
-
-	/* copy in the signature */
-	signature = get_signature();
-	*(UINT32 *)&ss_dump_array[0x14] = LITTLE_ENDIANIZE_INT32(signature);
+	write_header(ss_dump_array, get_signature());
 
 	/* write the file */
 	mame_fwrite(ss_dump_file, ss_dump_array, ss_dump_size);
@@ -955,6 +1021,538 @@ void state_save_load_finish(void)
 
 
 
+/***************************************************************************
+
+    In-memory state snapshot
+
+***************************************************************************/
+
+/*-------------------------------------------------
+    state_snapshot_save_begin - begin the capture
+    of the in-memory snapshot
+-------------------------------------------------*/
+
+int state_snapshot_save_begin(void)
+{
+	UINT32 size;
+
+	/* if we have illegal registrations, return an error */
+	if (ss_illegal_regs > 0)
+		return 1;
+
+	/* the buffer is kept from one capture to the next */
+	size = compute_size_and_offsets();
+	if (size != ss_snapshot_size)
+	{
+		free(ss_snapshot);
+		ss_snapshot = malloc(size);
+		ss_snapshot_size = ss_snapshot ? size : 0;
+		if (!ss_snapshot)
+		{
+			logerror("malloc failed in state_snapshot_save_begin\n");
+			return 1;
+		}
+	}
+
+	ss_snapshot_valid = FALSE;
+	ss_dump_array = ss_snapshot;
+	ss_dump_size = size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_snapshot_save_finish - complete the
+    capture of the snapshot
+-------------------------------------------------*/
+
+void state_snapshot_save_finish(void)
+{
+	/* only the flags are needed to restore */
+	write_header(ss_dump_array, 0);
+
+	ss_snapshot_valid = TRUE;
+	ss_dump_array = NULL;
+	ss_dump_size = 0;
+}
+
+
+/*-------------------------------------------------
+    state_snapshot_load_begin - begin the restore
+    of the in-memory snapshot
+-------------------------------------------------*/
+
+int state_snapshot_load_begin(void)
+{
+	if (!ss_snapshot_valid || compute_size_and_offsets() != ss_snapshot_size)
+		return 1;
+
+	ss_dump_array = ss_snapshot;
+	ss_dump_size = ss_snapshot_size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_snapshot_load_finish - complete the
+    restore of the snapshot
+-------------------------------------------------*/
+
+void state_snapshot_load_finish(void)
+{
+	ss_dump_array = NULL;
+	ss_dump_size = 0;
+}
+
+
+/*-------------------------------------------------
+    state_snapshot_free - free the snapshot
+-------------------------------------------------*/
+
+void state_snapshot_free(void)
+{
+	free(ss_snapshot);
+	ss_snapshot = NULL;
+	ss_snapshot_size = 0;
+	ss_snapshot_valid = FALSE;
+}
+
+
+
+/***************************************************************************
+
+    In-memory state ring
+
+***************************************************************************/
+
+/*-------------------------------------------------
+    ring_free_images - free the full images and
+    forget all the entries
+-------------------------------------------------*/
+
+static void ring_free_images(void)
+{
+	free(ss_ring.image);
+	free(ss_ring.work);
+	free(ss_ring.delta);
+	ss_ring.image = NULL;
+	ss_ring.work = NULL;
+	ss_ring.delta = NULL;
+	ss_ring.image_size = 0;
+	ss_ring.count = 0;
+	ss_ring.first = 0;
+	ss_ring.head = 0;
+	ss_ring.used = 0;
+}
+
+
+/*-------------------------------------------------
+    ring_alloc_images - allocate the full images
+    for a given state size
+-------------------------------------------------*/
+
+static int ring_alloc_images(UINT32 size)
+{
+	UINT32 blocks = (size + RING_BLOCK_SIZE - 1) / RING_BLOCK_SIZE;
+
+	ring_free_images();
+
+	ss_ring.image = malloc(size);
+	ss_ring.work = malloc(size);
+	ss_ring.delta = malloc(blocks * RING_BLOCK_WORST);
+	if (!ss_ring.image || !ss_ring.work || !ss_ring.delta)
+	{
+		logerror("malloc failed in ring_alloc_images\n");
+		ring_free_images();
+		return 1;
+	}
+
+	ss_ring.image_size = size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    ring_encode_delta - encode the blocks that
+    differ between two images
+-------------------------------------------------*/
+
+static UINT32 ring_encode_delta(const UINT8 *prev, const UINT8 *cur, UINT32 size, UINT8 *dest, UINT32 *changed)
+{
+	UINT8 *out = dest;
+	UINT32 base;
+
+	*changed = 0;
+
+	for (base = 0; base < size; base += RING_BLOCK_SIZE)
+	{
+		const UINT8 *p = prev + base;
+		const UINT8 *c = cur + base;
+		UINT32 len = size - base < RING_BLOCK_SIZE ? size - base : RING_BLOCK_SIZE;
+		UINT32 block = base / RING_BLOCK_SIZE;
+		UINT32 i;
+
+		/* most blocks don't change from one frame to the next */
+		if (memcmp(p, c, len) == 0)
+			continue;
+
+		(*changed)++;
+		*out++ = block;
+		*out++ = block >> 8;
+		*out++ = block >> 16;
+		*out++ = block >> 24;
+
+		i = 0;
+		while (i < len)
+		{
+			UINT32 start, run;
+
+			/* a long enough run of unchanged bytes, or the tail, is skipped */
+			run = 0;
+			while (i + run < len && p[i + run] == c[i + run])
+				run++;
+			if (run >= RING_RUN_MIN || i + run == len)
+			{
+				*out++ = run;
+				*out++ = (run >> 8) | (RING_TOKEN_SKIP >> 8);
+				i += run;
+				continue;
+			}
+
+			/* otherwise collect literals, absorbing short unchanged runs */
+			start = i;
+			while (i < len)
+			{
+				run = 0;
+				while (i + run < len && run < RING_RUN_MIN && p[i + run] == c[i + run])
+					run++;
+				if (run >= RING_RUN_MIN || i + run == len)
+					break;
+				i += run + 1;
+			}
+
+			*out++ = i - start;
+			*out++ = (i - start) >> 8;
+			for ( ; start < i; start++)
+				*out++ = p[start] ^ c[start];
+		}
+	}
+
+	return out - dest;
+}
+
+
+/*-------------------------------------------------
+    ring_apply_delta - XOR an encoded delta into
+    an image
+-------------------------------------------------*/
+
+static void ring_apply_delta(UINT8 *image, UINT32 size, const UINT8 *src, UINT32 length)
+{
+	const UINT8 *end = src + length;
+
+	while (src < end)
+	{
+		UINT32 block = src[0] | (src[1] << 8) | (src[2] << 16) | (src[3] << 24);
+		UINT32 base = block * RING_BLOCK_SIZE;
+		UINT32 left = size - base < RING_BLOCK_SIZE ? size - base : RING_BLOCK_SIZE;
+		UINT8 *dst = image + base;
+
+		src += 4;
+		while (left > 0)
+		{
+			UINT32 token = src[0] | (src[1] << 8);
+			UINT32 run = token & ~RING_TOKEN_SKIP;
+			src += 2;
+
+			if (!(token & RING_TOKEN_SKIP))
+			{
+				UINT32 i;
+				for (i = 0; i < run; i++)
+					dst[i] ^= src[i];
+				src += run;
+			}
+			dst += run;
+			left -= run;
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    ring_drop_oldest/newest - remove an entry
+    from either end of the ring
+-------------------------------------------------*/
+
+static void ring_drop_oldest(void)
+{
+	ss_ring.used -= ss_ring.entry[ss_ring.first].length;
+	ss_ring.first = (ss_ring.first + 1) % ss_ring.entry_max;
+	ss_ring.count--;
+}
+
+static ss_ring_entry *ring_newest(void)
+{
+	return &ss_ring.entry[(ss_ring.first + ss_ring.count - 1) % ss_ring.entry_max];
+}
+
+
+/*-------------------------------------------------
+    ring_reserve - find room in the arena for a
+    delta of the given length, returning the
+    offset or -1 if it doesn't fit right now
+-------------------------------------------------*/
+
+static INT64 ring_reserve(UINT32 length)
+{
+	UINT32 head = ss_ring.head;
+	UINT32 tail;
+
+	/* an empty arena can restart from the beginning */
+	if (ss_ring.used == 0)
+		return length <= ss_ring.arena_size ? 0 : -1;
+
+	/* the oldest entry marks the end of the free space */
+	tail = ss_ring.entry[ss_ring.first].offset;
+
+	/* data lies in [tail, head): free space is after head, or before tail */
+	if (head > tail)
+	{
+		if (length <= ss_ring.arena_size - head)
+			return head;
+		if (length <= tail)
+			return 0;
+		return -1;
+	}
+
+	/* data wraps around: free space is between head and tail */
+	if (head < tail)
+		return length <= tail - head ? head : -1;
+
+	/* the arena is full */
+	return length == 0 ? head : -1;
+}
+
+
+/*-------------------------------------------------
+    ring_push - store a new entry, evicting old
+    entries as required
+-------------------------------------------------*/
+
+static void ring_push(const UINT8 *delta, UINT32 length, UINT32 frame)
+{
+	ss_ring_entry *entry;
+	INT64 offset;
+
+	/* a delta larger than the arena breaks the chain; restart with this image */
+	if (length > ss_ring.arena_size)
+	{
+		ss_ring.count = 0;
+		ss_ring.used = 0;
+		length = 0;
+	}
+
+	/* make room for the new entry */
+	if (ss_ring.count == ss_ring.entry_max)
+		ring_drop_oldest();
+	while ((offset = ring_reserve(length)) < 0)
+		ring_drop_oldest();
+
+	/* copy the delta in the arena */
+	memcpy(ss_ring.arena + offset, delta, length);
+	ss_ring.head = offset + length;
+	ss_ring.used += length;
+
+	/* append the entry */
+	ss_ring.count++;
+	entry = ring_newest();
+	entry->offset = offset;
+	entry->length = length;
+	entry->frame = frame;
+}
+
+
+/*-------------------------------------------------
+    state_ring_init - allocate the ring with the
+    given number of entries and arena size
+-------------------------------------------------*/
+
+int state_ring_init(int entries, UINT32 arena_size)
+{
+	state_ring_free();
+
+	/* the newest entry doesn't store a delta, so a single entry is useless */
+	if (entries < 2 || arena_size == 0)
+		return 1;
+
+	ss_ring.arena = malloc(arena_size);
+	ss_ring.entry = malloc(entries * sizeof(ss_ring.entry[0]));
+	if (!ss_ring.arena || !ss_ring.entry)
+	{
+		logerror("malloc failed in state_ring_init\n");
+		state_ring_free();
+		return 1;
+	}
+
+	ss_ring.arena_size = arena_size;
+	ss_ring.entry_max = entries;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_ring_free - free the ring
+-------------------------------------------------*/
+
+void state_ring_free(void)
+{
+	ring_free_images();
+	free(ss_ring.arena);
+	free(ss_ring.entry);
+	memset(&ss_ring, 0, sizeof(ss_ring));
+}
+
+
+/*-------------------------------------------------
+    state_ring_count - return the number of
+    states that can be restored
+-------------------------------------------------*/
+
+int state_ring_count(void)
+{
+	return ss_ring.count;
+}
+
+
+/*-------------------------------------------------
+    state_ring_save_begin - begin the capture of
+    a state in the ring
+-------------------------------------------------*/
+
+int state_ring_save_begin(UINT32 frame)
+{
+	UINT32 size;
+
+	/* if we have illegal registrations, or no ring, return an error */
+	if (ss_illegal_regs > 0 || !ss_ring.arena)
+		return 1;
+
+	ss_ring.start = osd_cycles();
+
+	/* a different layout invalidates all the stored entries */
+	size = compute_size_and_offsets();
+	if (size != ss_ring.image_size)
+	{
+		if (ring_alloc_images(size) != 0)
+			return 1;
+		ss_ring.signature = get_signature();
+	}
+
+	/* capture in the work image, the newest one is needed for the delta */
+	ss_ring.info.last_frame = frame;
+	ss_dump_array = ss_ring.work;
+	ss_dump_size = size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_ring_save_finish - encode the captured
+    state and push it in the ring
+-------------------------------------------------*/
+
+void state_ring_save_finish(void)
+{
+	UINT32 length = 0;
+	UINT32 blocks = 0;
+	UINT8 *temp;
+
+	write_header(ss_ring.work, ss_ring.signature);
+
+	/* the delta moves from the new image back to the previous one */
+	if (ss_ring.count > 0)
+		length = ring_encode_delta(ss_ring.work, ss_ring.image, ss_ring.image_size, ss_ring.delta, &blocks);
+	ring_push(ss_ring.delta, length, ss_ring.info.last_frame);
+
+	/* the captured image is now the newest one */
+	temp = ss_ring.image;
+	ss_ring.image = ss_ring.work;
+	ss_ring.work = temp;
+
+	ss_dump_array = NULL;
+	ss_dump_size = 0;
+
+	/* update the statistics */
+	ss_ring.info.last_delta_size = length;
+	ss_ring.info.last_blocks = blocks;
+	ss_ring.info.last_capture_time = (double)(osd_cycles() - ss_ring.start) / (double)osd_cycles_per_second();
+}
+
+
+/*-------------------------------------------------
+    state_ring_load_begin - rebuild the image of
+    the entry the given number of steps back from
+    the newest, dropping the newer entries
+-------------------------------------------------*/
+
+int state_ring_load_begin(int index)
+{
+	if (!ss_ring.image || index < 0 || index >= ss_ring.count)
+		return 1;
+
+	/* the registrations must match the ones used to capture */
+	if (compute_size_and_offsets() != ss_ring.image_size)
+		return 1;
+
+	ss_ring.start = osd_cycles();
+
+	/* walk back applying the deltas */
+	while (index-- > 0)
+	{
+		ss_ring_entry *entry = ring_newest();
+
+		ring_apply_delta(ss_ring.image, ss_ring.image_size, ss_ring.arena + entry->offset, entry->length);
+		ss_ring.head = entry->offset;
+		ss_ring.used -= entry->length;
+		ss_ring.count--;
+	}
+
+	ss_dump_array = ss_ring.image;
+	ss_dump_size = ss_ring.image_size;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_ring_load_finish - complete the restore
+    of a ring entry
+-------------------------------------------------*/
+
+void state_ring_load_finish(void)
+{
+	ss_dump_array = NULL;
+	ss_dump_size = 0;
+
+	ss_ring.info.last_restore_time = (double)(osd_cycles() - ss_ring.start) / (double)osd_cycles_per_second();
+}
+
+
+/*-------------------------------------------------
+    state_ring_get_info - return the statistics
+    of the ring
+-------------------------------------------------*/
+
+const state_ring_info *state_ring_get_info(void)
+{
+	ss_ring.info.entries = ss_ring.count;
+	ss_ring.info.image_size = ss_ring.image_size;
+	ss_ring.info.arena_size = ss_ring.arena_size;
+	ss_ring.info.arena_used = ss_ring.used;
+	return &ss_ring.info;
+}
+
+
+
 /***************************************************************************
 
     Debugging
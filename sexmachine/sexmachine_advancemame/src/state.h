@@ -66,6 +66,26 @@ do {																					\
 
 
 
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _state_ring_info state_ring_info;
+struct _state_ring_info
+{
+	int				entries;			/* number of states held in the ring */
+	UINT32			image_size;			/* size of a full state image */
+	UINT32			arena_size;			/* size of the delta arena */
+	UINT32			arena_used;			/* bytes of the arena holding deltas */
+	UINT32			last_frame;			/* frame of the last capture */
+	UINT32			last_delta_size;	/* encoded size of the last capture */
+	UINT32			last_blocks;		/* blocks changed by the last capture */
+	double			last_capture_time;	/* seconds spent in the last capture */
+	double			last_restore_time;	/* seconds spent in the last restore */
+};
+
+
+
 /***************************************************************************
     FUNCTION PROTOTYPES
 ***************************************************************************/
@@ -106,6 +126,28 @@ void state_save_load_continue(void);
 void state_save_save_finish(void);
 void state_save_load_finish(void);
 
+/* Single in-memory state, used to run ahead and come back */
+int  state_snapshot_save_begin(void);
+void state_snapshot_save_finish(void);
+
+int  state_snapshot_load_begin(void);
+void state_snapshot_load_finish(void);
+
+void state_snapshot_free(void);
+
+/* In-memory ring of delta-compressed states, used for rewind */
+int  state_ring_init(int entries, UINT32 arena_size);
+void state_ring_free(void);
+int  state_ring_count(void);
+
+int  state_ring_save_begin(UINT32 frame);
+void state_ring_save_finish(void);
+
+int  state_ring_load_begin(int index);
+void state_ring_load_finish(void);
+
+const state_ring_info *state_ring_get_info(void);
+
 /* Display function */
 void state_save_dump_registry(void);
 
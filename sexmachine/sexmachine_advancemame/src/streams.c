@@ -34,6 +34,12 @@
 #define FRAC_ONE						(1 << FRAC_BITS)
 #define FRAC_MASK						(FRAC_ONE - 1)
 
+#define RESAMPLE_PHASE_BITS				9
+#define RESAMPLE_PHASES					(1 << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_MAX_TAPS				128
+#define RESAMPLE_MAX_FILTERS			16
+#define RESAMPLE_COEF_BITS				14
+
 
 
 /*************************************
@@ -42,6 +48,15 @@
  *
  *************************************/
 
+struct resample_filter
+{
+	struct resample_filter *next;				/* next filter in the list */
+	UINT32			step_frac;					/* source stepping rate the filter is designed for */
+	int				taps;						/* taps of every phase, a multiple of 4 */
+	INT16 *			coef;						/* RESAMPLE_PHASES + 1 rows of taps coefficients */
+};
+
+
 struct stream_input
 {
 	sound_stream *stream;						/* pointer to the input stream */
@@ -52,6 +67,7 @@ struct stream_input
 	UINT32			resample_in_pos;			/* resample index where next sample will be written */
 	UINT32			resample_out_pos;			/* resample index where next sample will be read */
 	INT16			gain;						/* gain to apply to this input */
+	struct resample_filter *filter;				/* polyphase filter, or NULL for linear interpolation */
 };
 
 
@@ -90,6 +106,11 @@ struct _sound_stream
 	/* callback information */
 	void *			param;
 	stream_callback callback;					/* callback function */
+
+	/* profiling information */
+	UINT64			profile_samples;			/* samples generated */
+	cycles_t		profile_update;				/* time spent in the callback */
+	cycles_t		profile_resample;			/* time spent resampling the inputs */
 };
 
 
@@ -103,6 +124,8 @@ struct _sound_stream
 static sound_stream *stream_head;
 static void *stream_current_tag;
 static int stream_index;
+static struct resample_filter *filter_head;
+static int filter_count;
 
 
 
@@ -114,6 +137,8 @@ static int stream_index;
 
 static void stream_generate_samples(sound_stream *stream, int samples);
 static void resample_input_stream(struct stream_input *input, int samples);
+static void streams_exit(void);
+static void resample_select_filter(struct stream_input *input);
 
 
 
@@ -129,12 +154,36 @@ int streams_init(void)
 	stream_head = NULL;
 	stream_current_tag = NULL;
 	stream_index = 0;
+	filter_head = NULL;
+	filter_count = 0;
 
+	add_exit_callback(streams_exit);
 	return 0;
 }
 
 
 
+/*************************************
+ *
+ *  Shut down the streams engine
+ *
+ *************************************/
+
+static void streams_exit(void)
+{
+	/* free the filter banks */
+	while (filter_head != NULL)
+	{
+		struct resample_filter *filter = filter_head;
+		filter_head = filter->next;
+		free(filter->coef);
+		free(filter);
+	}
+	filter_count = 0;
+}
+
+
+
 /*************************************
  *
  *  Set the current stream tag
@@ -501,6 +550,25 @@ void stream_set_sample_rate(sound_stream *stream, int sample_rate)
 
 
 
+/*************************************
+ *
+ *  Return the CPU time spent by a
+ *  stream
+ *
+ *************************************/
+
+void stream_get_profile(sound_stream *stream, stream_profile *profile)
+{
+	double cycles_per_second = (double)osd_cycles_per_second();
+
+	profile->sample_rate = stream->sample_rate;
+	profile->samples = stream->profile_samples;
+	profile->update_time = (double)stream->profile_update / cycles_per_second;
+	profile->resample_time = (double)stream->profile_resample / cycles_per_second;
+}
+
+
+
 /*************************************
  *
  *  Return a pointer to the output
@@ -554,6 +622,9 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 
 		VPRINTF(("  input %d\n", inputnum));
 
+		/* pick the polyphase filter for the current rates */
+		resample_select_filter(input);
+
 		/* determine the final output position where we need to be to satisfy this request */
 		target_resample_out_pos = input->resample_out_pos + samples;
 
@@ -568,8 +639,13 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 			/* determine where we will be after we process all the needed samples */
 			target_source_frac = input->source_frac + resample_samples_needed * input->step_frac;
 
+			/* the polyphase filter looks half its taps ahead; the source runs ahead of the */
+			/* emulated time by as much, delaying the effect of its register writes */
+			if (input->filter != NULL)
+				target_source_frac += (input->filter->taps / 2) << FRAC_BITS;
+
 			/* if we're undersampling, we need an extra sample for linear interpolation */
-			if (input->step_frac < FRAC_ONE)
+			else if (input->step_frac < FRAC_ONE)
 				target_source_frac += FRAC_ONE;
 
 			/* based on that, we know how many additional source samples we need to generate */
@@ -582,7 +658,14 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 
 			/* now resample */
 			VPRINTF(("    resample_input_stream(%d)\n", resample_samples_needed));
-			resample_input_stream(input, resample_samples_needed);
+			if (options.stream_bench)
+			{
+				cycles_t start = osd_cycles();
+				resample_input_stream(input, resample_samples_needed);
+				stream->profile_resample += osd_cycles() - start;
+			}
+			else
+				resample_input_stream(input, resample_samples_needed);
 			VPRINTF(("    resample_input_stream done\n"));
 		}
 
@@ -601,12 +684,217 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 
 	/* okay, all the inputs are up-to-date ... call the callback */
 	VPRINTF(("  callback(%p, %d)\n", stream, samples));
-	(*stream->callback)(stream->param, stream->input_array, stream->output_array, samples);
+	if (options.stream_bench)
+	{
+		cycles_t start = osd_cycles();
+		(*stream->callback)(stream->param, stream->input_array, stream->output_array, samples);
+		stream->profile_update += osd_cycles() - start;
+		stream->profile_samples += samples;
+	}
+	else
+		(*stream->callback)(stream->param, stream->input_array, stream->output_array, samples);
 	VPRINTF(("  callback done\n"));
 }
 
 
 
+/*************************************
+ *
+ *  Build the polyphase filter bank
+ *  for a source stepping rate
+ *
+ *************************************/
+
+static struct resample_filter *resample_create_filter(UINT32 step_frac)
+{
+	struct resample_filter *filter;
+	double ratio = (double)step_frac / (double)FRAC_ONE;
+	double scale = (ratio > 1.0) ? 1.0 / ratio : 1.0;
+	double cutoff;
+	int taps, phase, tap;
+
+	/* when downsampling the filter stretches to cut below the new Nyquist frequency */
+	taps = (int)ceil(options.resample_taps / scale);
+	taps = (taps + 3) & ~3;
+	if (taps > RESAMPLE_MAX_TAPS)
+		taps = RESAMPLE_MAX_TAPS;
+
+	/* cutoff in cycles per source sample, with a transition band narrowing with the taps */
+	cutoff = 0.5 * (1.0 - 2.0 / options.resample_taps) * scale;
+
+	filter = malloc(sizeof(*filter));
+	if (filter == NULL)
+		return NULL;
+	filter->coef = malloc((RESAMPLE_PHASES + 1) * taps * sizeof(filter->coef[0]));
+	if (filter->coef == NULL)
+	{
+		free(filter);
+		return NULL;
+	}
+	filter->next = NULL;
+	filter->step_frac = step_frac;
+	filter->taps = taps;
+
+	/* one row for every phase, including the end point of the last one */
+	for (phase = 0; phase <= RESAMPLE_PHASES; phase++)
+	{
+		INT16 *coef = &filter->coef[phase * taps];
+		double frac = (double)phase / (double)RESAMPLE_PHASES;
+		double row[RESAMPLE_MAX_TAPS];
+		double sum = 0;
+		int total = 0;
+
+		/* Blackman windowed sinc; tap taps/2-1 is the source sample at or before the position */
+		for (tap = 0; tap < taps; tap++)
+		{
+			double t = (double)(tap - (taps / 2 - 1)) - frac;
+			double x = (t + taps / 2) / taps;
+			double window = 0.42 - 0.5 * cos(2 * M_PI * x) + 0.08 * cos(4 * M_PI * x);
+			double sinc = (t == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+			row[tap] = sinc * window;
+			sum += row[tap];
+		}
+
+		/* normalize to unity gain, moving the rounding error on the nearest tap */
+		for (tap = 0; tap < taps; tap++)
+		{
+			coef[tap] = (INT16)floor(row[tap] / sum * (1 << RESAMPLE_COEF_BITS) + 0.5);
+			total += coef[tap];
+		}
+		coef[taps / 2 - 1 + (phase >= RESAMPLE_PHASES / 2)] += (1 << RESAMPLE_COEF_BITS) - total;
+	}
+
+	VPRINTF(("resample_create_filter(%08X) - %d taps, cutoff %f\n", step_frac, taps, cutoff));
+	return filter;
+}
+
+
+
+/*************************************
+ *
+ *  Pick the polyphase filter of an
+ *  input
+ *
+ *************************************/
+
+static void resample_select_filter(struct stream_input *input)
+{
+	struct resample_filter *filter;
+
+	/* matching rates are copied, and without taps the linear interpolation is used */
+	if (options.resample_taps == 0 || input->step_frac == FRAC_ONE || input->step_frac == 0)
+	{
+		input->filter = NULL;
+		return;
+	}
+
+	/* most of the time the rates haven't changed */
+	if (input->filter != NULL && input->filter->step_frac == input->step_frac)
+		return;
+
+	/* the inputs with the same rates share the filter */
+	for (filter = filter_head; filter != NULL; filter = filter->next)
+		if (filter->step_frac == input->step_frac)
+		{
+			input->filter = filter;
+			return;
+		}
+
+	/* a stream sweeping its rate falls back to the linear interpolation */
+	input->filter = NULL;
+	if (filter_count == RESAMPLE_MAX_FILTERS)
+		return;
+
+	filter = resample_create_filter(input->step_frac);
+	if (filter != NULL)
+	{
+		filter->next = filter_head;
+		filter_head = filter;
+		filter_count++;
+		input->filter = filter;
+	}
+}
+
+
+
+/*************************************
+ *
+ *  Polyphase resampling
+ *
+ *************************************/
+
+INLINE int resample_phase(UINT32 pos)
+{
+	return ((pos & FRAC_MASK) + (1 << (FRAC_BITS - RESAMPLE_PHASE_BITS - 1))) >> (FRAC_BITS - RESAMPLE_PHASE_BITS);
+}
+
+
+INLINE INT32 resample_convolve(const stream_sample_t *source, const INT16 *coef, int taps)
+{
+	INT64 sum0 = 0, sum1 = 0;
+	int tap;
+
+	/* two independent accumulators, four taps at a time */
+	for (tap = 0; tap < taps; tap += 4)
+	{
+		sum0 += (INT64)source[tap + 0] * coef[tap + 0] + (INT64)source[tap + 1] * coef[tap + 1];
+		sum1 += (INT64)source[tap + 2] * coef[tap + 2] + (INT64)source[tap + 3] * coef[tap + 3];
+	}
+
+	return (INT32)((sum0 + sum1 + (1 << (RESAMPLE_COEF_BITS - 1))) >> RESAMPLE_COEF_BITS);
+}
+
+
+static UINT32 resample_polyphase(const struct resample_filter *filter, stream_sample_t *dest, const stream_sample_t *source,
+		UINT32 pos, UINT32 step, INT16 gain, int samples)
+{
+	int taps = filter->taps;
+	int back = taps / 2 - 1;
+
+	/* integer downsampling: the phase never changes */
+	if ((step & FRAC_MASK) == 0 && (pos >> FRAC_BITS) >= back)
+	{
+		const INT16 *coef = &filter->coef[resample_phase(pos) * taps];
+		const stream_sample_t *src = source + (pos >> FRAC_BITS) - back;
+		int stride = step >> FRAC_BITS;
+
+		pos += step * samples;
+		while (samples--)
+		{
+			*dest++ = (resample_convolve(src, coef, taps) * gain) >> 8;
+			src += stride;
+		}
+		return pos;
+	}
+
+	while (samples--)
+	{
+		int ipos = pos >> FRAC_BITS;
+		const INT16 *coef = &filter->coef[resample_phase(pos) * taps];
+		INT32 sample;
+
+		if (ipos >= back)
+			sample = resample_convolve(source + ipos - back, coef, taps);
+
+		/* at the start of the buffer there is no history: repeat the oldest sample */
+		else
+		{
+			stream_sample_t edge[RESAMPLE_MAX_TAPS];
+			int tap;
+
+			for (tap = 0; tap < taps; tap++)
+				edge[tap] = source[(ipos - back + tap < 0) ? 0 : ipos - back + tap];
+			sample = resample_convolve(edge, coef, taps);
+		}
+
+		*dest++ = (sample * gain) >> 8;
+		pos += step;
+	}
+	return pos;
+}
+
+
+
 /*************************************
  *
  *  Resample an input stream into the
@@ -638,6 +926,13 @@ static void resample_input_stream(struct stream_input *input, int samples)
 		}
 	}
 
+	/* polyphase filter, for both directions */
+	else if (input->filter != NULL)
+	{
+		pos = resample_polyphase(input->filter, dest, source, pos, step, gain, samples);
+		dest += samples;
+	}
+
 	/* input is undersampled: use linear interpolation */
 	else if (step < FRAC_ONE)
 	{
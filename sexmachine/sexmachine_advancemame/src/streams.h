@@ -18,6 +18,16 @@ typedef struct _sound_stream sound_stream;
 
 typedef void (*stream_callback)(void *param, stream_sample_t **inputs, stream_sample_t **outputs, int samples);
 
+/* CPU time spent by a stream, collected with options.stream_bench */
+typedef struct _stream_profile stream_profile;
+struct _stream_profile
+{
+	int		sample_rate;		/* current sample rate */
+	UINT64	samples;			/* samples generated */
+	double	update_time;		/* seconds spent generating the samples */
+	double	resample_time;		/* seconds spent resampling the inputs */
+};
+
 int streams_init(void);
 void streams_set_tag(void *streamtag);
 void streams_frame_update(void);
@@ -35,5 +45,6 @@ int stream_get_outputs(sound_stream *stream);
 void stream_set_input_gain(sound_stream *stream, int input, float gain);
 void stream_set_output_gain(sound_stream *stream, int output, float gain);
 void stream_set_sample_rate(sound_stream *stream, int sample_rate);
+void stream_get_profile(sound_stream *stream, stream_profile *profile);
 
 #endif
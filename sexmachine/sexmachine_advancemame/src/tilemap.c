@@ -34,6 +34,16 @@
 #define SWAP(X,Y) { UINT32 temp=X; X=Y; Y=temp; }
 #define MAX_TILESIZE 64
 
+/* dirty tiles needed to redraw them all before drawing the layer */
+#define TILEMAP_BATCH_MIN		64
+
+/* dirty tiles needed to split the redraw between the processors, and parts of the split */
+#define TILEMAP_PARALLEL_MIN	256
+#define TILEMAP_PARALLEL_JOBS	8
+
+/* frames of tile changes recorded for the benchmark */
+#define TILEMAP_BENCH_FRAMES	600
+
 #define TILE_FLAG_DIRTY	(0x80)
 
 typedef enum { eWHOLLY_TRANSPARENT, eWHOLLY_OPAQUE, eMASKED } trans_t;
@@ -76,7 +86,7 @@ struct _tilemap
 
 	UINT32 *pPenToPixel[4];
 
-	UINT8 (*draw_tile)( tilemap *tmap, UINT32 col, UINT32 row, UINT32 flags );
+	UINT8 (*draw_tile)( tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags );
 
 	INT32 cached_scroll_rows, cached_scroll_cols;
 	INT32 *cached_rowscroll, *cached_colscroll;
@@ -91,6 +101,10 @@ struct _tilemap
 	UINT8 all_tiles_dirty;
 	UINT8 all_tiles_clean;
 
+	/* one bit for every cached tile to redraw, scanned a word at a time */
+	UINT32 *dirty_bits;
+	UINT32 num_dirty;
+
 	/* cached color data */
 	mame_bitmap *pixmap;
 	UINT32 pixmap_pitch_line;
@@ -115,6 +129,36 @@ tile_data				tile_info;
 typedef void (*blitmask_t)( void *dest, const void *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode );
 typedef void (*blitopaque_t)( void *dest, const void *source, int count, UINT8 *pri, UINT32 pcode );
 
+/* a dirty tile ready to be redrawn, see tilemap_update_dirty() */
+typedef struct
+{
+	tile_data info;
+	UINT32 cached_indx;
+	UINT32 x0, y0;
+	UINT32 flags;
+} dirty_tile;
+
+static dirty_tile *		dirty_list;
+static UINT32			dirty_list_max;
+static UINT32			dirty_list_count;
+static tilemap *		dirty_tmap;
+
+/* a recorded tile change, see tilemap_bench_record() */
+enum { BENCH_TILE, BENCH_ALL, BENCH_UPDATE };
+
+typedef struct
+{
+	tilemap *tmap;
+	UINT32 type;
+	UINT32 memory_offset;
+} bench_event;
+
+static bench_event *	bench_list;
+static UINT32			bench_count;
+static UINT32			bench_max;
+static int				bench_active;
+static int				bench_first_frame;
+
 /* the following parameters are constant across tilemap_draw calls */
 static struct
 {
@@ -140,6 +184,8 @@ static void recalculate_scroll( tilemap *tmap );
 static void install_draw_handlers( tilemap *tmap );
 
 static void update_tile_info( tilemap *tmap, UINT32 cached_indx, UINT32 cached_col, UINT32 cached_row );
+static void tilemap_update_dirty( tilemap *tmap, int all );
+static void tilemap_bench_record( tilemap *tmap, UINT32 type, UINT32 memory_offset );
 
 /***********************************************************************************/
 
@@ -358,15 +404,44 @@ static void pit( void *dest, const void *source, const UINT8 *pMask, int mask, i
 
 /***********************************************************************************/
 
+/*
+    The 16bpp blends handle 4 pixels at a time. The priority bytes are
+    updated a word at a time, and the transparency bytes of 4 pixels are
+    tested together, so runs all drawn or all skipped need a single test.
+*/
+
+#define PRI_SPLAT(x)	((UINT32)((x) & 0xff) * 0x01010101)
+
+/* nonzero if any byte of the word is zero */
+#define PRI_HAS_ZERO(x)	(((x) - 0x01010101) & ~(x) & 0x80808080)
+
+INLINE void pri_blend( UINT8 *pri, int count, UINT32 pcode )
+{
+	UINT32 keep = PRI_SPLAT(pcode >> 8);
+	UINT32 code = PRI_SPLAT(pcode);
+	int i = 0;
+
+	for( ; i<count && ((FPTR)(pri+i) & 3); i++ )
+		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+	for( ; i+4<=count; i+=4 )
+		*(UINT32 *)(pri+i) = (*(UINT32 *)(pri+i) & keep) | code;
+	for( ; i<count; i++ )
+		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+}
+
+/* returns the transparency bytes of 4 pixels, xored so the pixels to draw are zero */
+INLINE UINT32 pri_select( const UINT8 *pMask, UINT32 mask4, UINT32 value4 )
+{
+	UINT32 m;
+	memcpy( &m, pMask, 4 );
+	return (m & mask4) ^ value4;
+}
+
 #ifndef pdo16
 static void pdo16( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
 {
-	int i;
 	memcpy( dest,source,count*sizeof(UINT16) );
-	for( i=0; i<count; i++ )
-	{
-		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
-	}
+	pri_blend( pri, count, pcode );
 }
 #endif
 
@@ -378,8 +453,8 @@ static void pdo16pal( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri,
 	for( i=0; i<count; i++ )
 	{
 		dest[i] = source[i] + pal;
-		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
 	}
+	pri_blend( pri, count, pcode );
 }
 #endif
 
@@ -450,9 +525,46 @@ static void npdo32( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, U
 #ifndef pdt16
 static void pdt16( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
 {
-	int i;
+	UINT32 mask4 = PRI_SPLAT(mask);
+	UINT32 value4 = PRI_SPLAT(value);
+	UINT32 keep = PRI_SPLAT(pcode >> 8);
+	UINT32 code = PRI_SPLAT(pcode);
+	int i = 0;
 
-	for( i=0; i<count; i++ )
+	/* align the priority map for the word access */
+	for( ; i<count && ((FPTR)(pri+i) & 3); i++ )
+	{
+		if( (pMask[i]&mask)==value )
+		{
+			dest[i] = source[i];
+			pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+	}
+
+	for( ; i+4<=count; i+=4 )
+	{
+		UINT32 m = pri_select( pMask+i, mask4, value4 );
+
+		if( m == 0 )
+		{
+			memcpy( dest+i, source+i, 4*sizeof(UINT16) );
+			*(UINT32 *)(pri+i) = (*(UINT32 *)(pri+i) & keep) | code;
+		}
+		else if( PRI_HAS_ZERO(m) )
+		{
+			int j;
+			for( j=i; j<i+4; j++ )
+			{
+				if( (pMask[j]&mask)==value )
+				{
+					dest[j] = source[j];
+					pri[j] = (pri[j] & (pcode >> 8)) | pcode;
+				}
+			}
+		}
+	}
+
+	for( ; i<count; i++ )
 	{
 		if( (pMask[i]&mask)==value )
 		{
@@ -466,10 +578,38 @@ static void pdt16( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int m
 #ifndef pdt16pal
 static void pdt16pal( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
 {
+	UINT32 mask4 = PRI_SPLAT(mask);
+	UINT32 value4 = PRI_SPLAT(value);
 	int pal = pcode >> 16;
-	int i;
+	int i = 0;
 
-	for( i=0; i<count; i++ )
+	for( ; i+4<=count; i+=4 )
+	{
+		UINT32 m = pri_select( pMask+i, mask4, value4 );
+
+		if( m == 0 )
+		{
+			dest[i] = source[i] + pal;
+			dest[i+1] = source[i+1] + pal;
+			dest[i+2] = source[i+2] + pal;
+			dest[i+3] = source[i+3] + pal;
+			pri_blend( pri+i, 4, pcode );
+		}
+		else if( PRI_HAS_ZERO(m) )
+		{
+			int j;
+			for( j=i; j<i+4; j++ )
+			{
+				if( (pMask[j]&mask)==value )
+				{
+					dest[j] = source[j] + pal;
+					pri[j] = (pri[j] & (pcode >> 8)) | pcode;
+				}
+			}
+		}
+	}
+
+	for( ; i<count; i++ )
 	{
 		if( (pMask[i]&mask)==value )
 		{
@@ -483,9 +623,28 @@ static void pdt16pal( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, in
 #ifndef pdt16np
 static void pdt16np( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
 {
-	int i;
+	UINT32 mask4 = PRI_SPLAT(mask);
+	UINT32 value4 = PRI_SPLAT(value);
+	int i = 0;
 
-	for( i=0; i<count; i++ )
+	for( ; i+4<=count; i+=4 )
+	{
+		UINT32 m = pri_select( pMask+i, mask4, value4 );
+
+		if( m == 0 )
+			memcpy( dest+i, source+i, 4*sizeof(UINT16) );
+		else if( PRI_HAS_ZERO(m) )
+		{
+			int j;
+			for( j=i; j<i+4; j++ )
+			{
+				if( (pMask[j]&mask)==value )
+					dest[j] = source[j];
+			}
+		}
+	}
+
+	for( ; i<count; i++ )
 	{
 		if( (pMask[i]&mask)==value )
 			dest[i] = source[i];
@@ -661,12 +820,12 @@ static void npbt32( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int
 #define DECLARE(function,args,body) static void function##32BPP args body
 #include "tilemap.c"
 
-#define PAL_INIT const pen_t *pPalData = tile_info.pal_data
+#define PAL_INIT const pen_t *pPalData = info->pal_data
 #define PAL_GET(pen) pPalData[pen]
 #define TRANSP(f) f ## _ind
 #include "tilemap.c"
 
-#define PAL_INIT int palBase = tile_info.pal_data - Machine->remapped_colortable
+#define PAL_INIT int palBase = info->pal_data - Machine->remapped_colortable
 #define PAL_GET(pen) (palBase + (pen))
 #define TRANSP(f) f ## _raw
 #include "tilemap.c"
@@ -731,6 +890,9 @@ int tilemap_init( void )
 	screen_height	= Machine->drv->screen_height;
 	first_tilemap	= NULL;
 
+	bench_active	= options.tilemap_bench;
+	bench_first_frame = -1;
+
 	priority_bitmap = bitmap_alloc_depth( screen_width, screen_height, -8 );
 	if( priority_bitmap )
 	{
@@ -752,6 +914,15 @@ void tilemap_exit( void )
 		first_tilemap = next;
 	}
 	bitmap_free( priority_bitmap );
+
+	free( dirty_list );
+	dirty_list = NULL;
+	dirty_list_max = 0;
+	free( bench_list );
+	bench_list = NULL;
+	bench_count = 0;
+	bench_max = 0;
+	bench_active = 0;
 }
 
 /***********************************************************************************/
@@ -812,6 +983,7 @@ tilemap *tilemap_create(
 
 		tmap->transparency_data = malloc( num_tiles );
 		tmap->transparency_data_row = malloc( sizeof(UINT8 *)*num_rows );
+		tmap->dirty_bits = calloc( (num_tiles+31)/32, sizeof(UINT32) );
 
 		tmap->pixmap = bitmap_alloc_depth( tmap->cached_width, tmap->cached_height, -16 );
 		tmap->transparency_bitmap = bitmap_alloc_depth( tmap->cached_width, tmap->cached_height, -8 );
@@ -821,6 +993,7 @@ tilemap *tilemap_create(
 			tmap->pixmap &&
 			tmap->transparency_data &&
 			tmap->transparency_data_row &&
+			tmap->dirty_bits &&
 			tmap->transparency_bitmap &&
 			(mappings_create( tmap )==0) )
 		{
@@ -837,6 +1010,7 @@ tilemap *tilemap_create(
 			install_draw_handlers( tmap );
 			mappings_update( tmap );
 			memset( tmap->transparency_data, TILE_FLAG_DIRTY, num_tiles );
+			tmap->all_tiles_dirty = 1;
 			tmap->next = first_tilemap;
 			first_tilemap = tmap;
 			if( PenToPixel_Init( tmap ) == 0 )
@@ -904,6 +1078,7 @@ static void tilemap_dispose( tilemap *tmap )
 	free( tmap->cached_colscroll );
 	free( tmap->transparency_data );
 	free( tmap->transparency_data_row );
+	free( tmap->dirty_bits );
 	bitmap_free( tmap->transparency_bitmap );
 	bitmap_free( tmap->pixmap );
 	mappings_dispose( tmap );
@@ -972,7 +1147,18 @@ void tilemap_mark_tile_dirty( tilemap *tmap, int memory_offset )
 		int cached_indx = tmap->memory_offset_to_cached_indx[memory_offset];
 		if( cached_indx>=0 )
 		{
+			UINT32 *word = &tmap->dirty_bits[cached_indx>>5];
+			UINT32 bit = 1 << (cached_indx&31);
+
+			if( bench_active )
+				tilemap_bench_record( tmap, BENCH_TILE, memory_offset );
+
 			tmap->transparency_data[cached_indx] = TILE_FLAG_DIRTY;
+			if( !(*word & bit) )
+			{
+				*word |= bit;
+				tmap->num_dirty++;
+			}
 			tmap->all_tiles_clean = 0;
 		}
 	}
@@ -991,6 +1177,9 @@ void tilemap_mark_all_tiles_dirty( tilemap *tmap )
 	}
 	else
 	{
+		if( bench_active )
+			tilemap_bench_record( tmap, BENCH_ALL, 0 );
+
 		tmap->all_tiles_dirty = 1;
 		tmap->all_tiles_clean = 0;
 	}
@@ -1004,9 +1193,17 @@ static void update_tile_info( tilemap *tmap, UINT32 cached_indx, UINT32 col, UIN
 	UINT32 y0;
 	UINT32 memory_offset;
 	UINT32 flags;
+	UINT32 *word = &tmap->dirty_bits[cached_indx>>5];
+	UINT32 bit = 1 << (cached_indx&31);
 
 profiler_mark(PROFILER_TILEMAP_UPDATE);
 
+	if( *word & bit )
+	{
+		*word &= ~bit;
+		tmap->num_dirty--;
+	}
+
 	memory_offset = tmap->cached_indx_to_memory_offset[cached_indx];
 	tmap->tile_get_info( memory_offset );
 	flags = tile_info.flags;
@@ -1014,45 +1211,272 @@ profiler_mark(PROFILER_TILEMAP_UPDATE);
 	x0 = tmap->cached_tile_width*col;
 	y0 = tmap->cached_tile_height*row;
 
-	tmap->transparency_data[cached_indx] = tmap->draw_tile(tmap,x0,y0,flags );
+	tmap->transparency_data[cached_indx] = tmap->draw_tile(tmap,&tile_info,x0,y0,flags );
 
 profiler_mark(PROFILER_END);
 }
 
-mame_bitmap *tilemap_get_pixmap( tilemap * tmap )
+/***********************************************************************************/
+
+/* draw a part of the dirty list, it can run on any processor */
+static void draw_dirty_job( void *param, int job )
 {
-	UINT32 cached_indx = 0;
-	UINT32 row,col;
+	tilemap *tmap = dirty_tmap;
+	UINT32 first = dirty_list_count*job/TILEMAP_PARALLEL_JOBS;
+	UINT32 last = dirty_list_count*(job+1)/TILEMAP_PARALLEL_JOBS;
+	UINT32 i;
 
-	if (!tmap)
-		return 0;
+	for( i=first; i<last; i++ )
+	{
+		const dirty_tile *tile = &dirty_list[i];
+		tmap->transparency_data[tile->cached_indx] = tmap->draw_tile( tmap, &tile->info, tile->x0, tile->y0, tile->flags );
+	}
+}
 
-	if (tmap->all_tiles_clean == 0)
+/*
+    Redraws the dirty tiles of the cached pixmap. The dirty bits are
+    scanned a word at a time, and the callbacks of the driver are called
+    in order, since they use the global tile_info. The tiles are then drawn
+    from the collected info, in parallel when they are many. With few dirty
+    tiles, and all == 0, the visible ones are left to the lazy update done
+    while drawing the layer.
+*/
+static void tilemap_update_dirty( tilemap *tmap, int all )
+{
+	UINT32 words = (tmap->num_tiles+31)/32;
+	UINT32 count = 0;
+	UINT32 w;
+
+	/* if the whole map is dirty, mark it as such */
+	if( tmap->all_tiles_dirty )
 	{
-profiler_mark(PROFILER_TILEMAP_DRAW);
+		memset( tmap->transparency_data, TILE_FLAG_DIRTY, tmap->num_tiles );
+		memset( tmap->dirty_bits, 0xff, words*sizeof(UINT32) );
+		if( tmap->num_tiles & 31 )
+			tmap->dirty_bits[words-1] = (1 << (tmap->num_tiles & 31)) - 1;
+		tmap->num_dirty = tmap->num_tiles;
+		tmap->all_tiles_dirty = 0;
+	}
 
-		/* if the whole map is dirty, mark it as such */
-		if (tmap->all_tiles_dirty)
+	if( tmap->num_dirty == 0 || (!all && tmap->num_dirty < TILEMAP_BATCH_MIN) )
+		return;
+
+	if( dirty_list_max < tmap->num_tiles )
+	{
+		dirty_tile *list = realloc( dirty_list, tmap->num_tiles*sizeof(dirty_tile) );
+		if( list )
 		{
-			memset( tmap->transparency_data, TILE_FLAG_DIRTY, tmap->num_tiles );
-			tmap->all_tiles_dirty = 0;
+			dirty_list = list;
+			dirty_list_max = tmap->num_tiles;
 		}
+	}
 
-		memset( &tile_info, 0x00, sizeof(tile_info) ); /* initialize defaults */
+profiler_mark(PROFILER_TILEMAP_UPDATE);
+
+	for( w=0; w<words; w++ )
+	{
+		UINT32 bits = tmap->dirty_bits[w];
+		UINT32 cached_indx = w*32;
+
+		if( bits == 0 )
+			continue;
+
+		for( ; bits; bits >>= 1, cached_indx++ )
+		{
+			UINT32 col, row, flags;
+
+			if( !(bits & 1) )
+				continue;
+
+			col = cached_indx % tmap->num_cached_cols;
+			row = cached_indx / tmap->num_cached_cols;
+
+			/* without memory for the list draw the tile immediately */
+			if( dirty_list_max < tmap->num_tiles )
+			{
+				update_tile_info( tmap, cached_indx, col, row );
+				continue;
+			}
+
+			tmap->tile_get_info( tmap->cached_indx_to_memory_offset[cached_indx] );
+			flags = tile_info.flags;
+
+			dirty_list[count].info = tile_info;
+			dirty_list[count].cached_indx = cached_indx;
+			dirty_list[count].x0 = tmap->cached_tile_width*col;
+			dirty_list[count].y0 = tmap->cached_tile_height*row;
+			dirty_list[count].flags = (flags&0xfc)|tmap->logical_flip_to_cached_flip[flags&0x3];
+			count++;
+		}
+
+		tmap->dirty_bits[w] = 0;
+	}
+
+	tmap->num_dirty = 0;
+
+	dirty_tmap = tmap;
+	dirty_list_count = count;
+	if( count >= TILEMAP_PARALLEL_MIN )
+		osd_parallelize_frame( draw_dirty_job, NULL, TILEMAP_PARALLEL_JOBS );
+	else
+	{
+		int job;
+		for( job=0; job<TILEMAP_PARALLEL_JOBS; job++ )
+			draw_dirty_job( NULL, job );
+	}
+
+profiler_mark(PROFILER_END);
+}
+
+/***********************************************************************************/
+
+/* records the tile changes until enough frames are collected, then runs the benchmark */
+static void tilemap_bench_record( tilemap *tmap, UINT32 type, UINT32 memory_offset )
+{
+	if( bench_first_frame < 0 )
+		bench_first_frame = cpu_getcurrentframe();
+
+	if( bench_count == bench_max )
+	{
+		UINT32 max = bench_max ? bench_max*2 : 65536;
+		bench_event *list = realloc( bench_list, max*sizeof(bench_event) );
+		if( !list )
+		{
+			bench_active = 0;
+			return;
+		}
+		bench_list = list;
+		bench_max = max;
+	}
+
+	bench_list[bench_count].tmap = tmap;
+	bench_list[bench_count].type = type;
+	bench_list[bench_count].memory_offset = memory_offset;
+	bench_count++;
+}
+
+/* replays the recorded tile changes, redrawing with the serial walk or with the dirty list */
+static cycles_t tilemap_bench_replay( int batch, UINT32 *tiles )
+{
+	cycles_t start;
+	tilemap *tmap;
+	UINT32 i;
+
+	/* start from clean tilemaps */
+	for( tmap=first_tilemap; tmap; tmap=tmap->next )
+	{
+		tmap->all_tiles_dirty = 1;
+		memset( &tile_info, 0x00, sizeof(tile_info) );
 		tile_info.user_data = tmap->user_data;
+		tilemap_update_dirty( tmap, 1 );
+	}
+
+	*tiles = 0;
+	start = osd_cycles();
 
-		/* walk over cached rows/cols (better to walk screen coords) */
-		for( row=0; row<tmap->num_cached_rows; row++ )
+	for( i=0; i<bench_count; i++ )
+	{
+		const bench_event *event = &bench_list[i];
+
+		tmap = event->tmap;
+		switch( event->type )
 		{
-			for( col=0; col<tmap->num_cached_cols; col++ )
+		case BENCH_TILE:
+			tilemap_mark_tile_dirty( tmap, event->memory_offset );
+			break;
+
+		case BENCH_ALL:
+			tilemap_mark_all_tiles_dirty( tmap );
+			break;
+
+		case BENCH_UPDATE:
+			memset( &tile_info, 0x00, sizeof(tile_info) );
+			tile_info.user_data = tmap->user_data;
+			if( tmap->all_tiles_dirty )
+				*tiles += tmap->num_tiles;
+			else
+				*tiles += tmap->num_dirty;
+			if( batch )
+				tilemap_update_dirty( tmap, 1 );
+			else
 			{
-				if( tmap->transparency_data[cached_indx] == TILE_FLAG_DIRTY )
+				UINT32 cached_indx = 0;
+				UINT32 row, col;
+
+				if( tmap->all_tiles_dirty )
 				{
-					update_tile_info( tmap, cached_indx, col, row );
+					memset( tmap->transparency_data, TILE_FLAG_DIRTY, tmap->num_tiles );
+					tmap->all_tiles_dirty = 0;
 				}
-				cached_indx++;
-			} /* next col */
-		} /* next row */
+
+				for( row=0; row<tmap->num_cached_rows; row++ )
+					for( col=0; col<tmap->num_cached_cols; col++ )
+					{
+						if( tmap->transparency_data[cached_indx] == TILE_FLAG_DIRTY )
+							update_tile_info( tmap, cached_indx, col, row );
+						cached_indx++;
+					}
+			}
+			break;
+		}
+	}
+
+	return osd_cycles() - start;
+}
+
+/* called before the tilemap is drawn */
+static void tilemap_bench_update( tilemap *tmap )
+{
+	cycles_t serial, batch;
+	UINT32 tiles;
+	char report[256];
+	int frames;
+
+	tilemap_bench_record( tmap, BENCH_UPDATE, 0 );
+
+	frames = cpu_getcurrentframe() - bench_first_frame;
+	if( frames < TILEMAP_BENCH_FRAMES || !bench_active )
+		return;
+
+	/* stop recording while replaying */
+	bench_active = 0;
+
+	serial = tilemap_bench_replay( 0, &tiles );
+	batch = tilemap_bench_replay( 1, &tiles );
+
+	sprintf( report, "tilemap: %d frames, %u tiles redrawn in %.0f cycles with the serial walk, in %.0f cycles with the dirty list (%.2fx)\n",
+		frames, tiles, (double)serial, (double)batch, batch ? (double)serial / batch : 0.0 );
+	logerror( "%s", report );
+	if( options.verbose )
+		printf( "%s", report );
+
+	/* the tilemaps are redrawn with the current state */
+	tilemap_mark_all_tiles_dirty( ALL_TILEMAPS );
+
+	free( bench_list );
+	bench_list = NULL;
+	bench_count = 0;
+	bench_max = 0;
+}
+
+/***********************************************************************************/
+
+mame_bitmap *tilemap_get_pixmap( tilemap * tmap )
+{
+	if (!tmap)
+		return 0;
+
+	if (tmap->all_tiles_clean == 0)
+	{
+profiler_mark(PROFILER_TILEMAP_DRAW);
+
+		if( bench_active )
+			tilemap_bench_update( tmap );
+
+		memset( &tile_info, 0x00, sizeof(tile_info) ); /* initialize defaults */
+		tile_info.user_data = tmap->user_data;
+
+		tilemap_update_dirty( tmap, 1 );
 
 		tmap->all_tiles_clean = 1;
 
@@ -1185,6 +1609,9 @@ void tilemap_draw_primask( mame_bitmap *dest, const rectangle *cliprect, tilemap
 	const int *rowscroll, *colscroll;
 	int left, right, top, bottom;
 
+	/* the deferred elements are drawn before the layer */
+	drawgfx_flush();
+
 profiler_mark(PROFILER_TILEMAP_DRAW);
 	if( tmap->enable )
 	{
@@ -1218,13 +1645,16 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 		memset( &tile_info, 0x00, sizeof(tile_info) );
 		tile_info.user_data = tmap->user_data;
 
-		/* if the whole map is dirty, mark it as such */
-		if (tmap->all_tiles_dirty)
+		if( bench_active )
 		{
-			memset( tmap->transparency_data, TILE_FLAG_DIRTY, tmap->num_tiles );
-			tmap->all_tiles_dirty = 0;
+			tilemap_bench_update( tmap );
+			memset( &tile_info, 0x00, sizeof(tile_info) );
+			tile_info.user_data = tmap->user_data;
 		}
 
+		/* redraw the dirty tiles together if they are many */
+		tilemap_update_dirty( tmap, 0 );
+
 		/* priority_bitmap_pitch_row is tmap-specific */
 		priority_bitmap_pitch_row = priority_bitmap_pitch_line*tmap->cached_tile_height;
 
@@ -1511,6 +1941,8 @@ void tilemap_draw_roz_primask( mame_bitmap *dest,const rectangle *cliprect,tilem
 		int wraparound,
 		UINT32 flags, UINT32 priority, UINT32 priority_mask )
 {
+	drawgfx_flush();
+
 	if( (incxx == 1<<16) && !incxy & !incyx && (incyy == 1<<16) && wraparound )
 	{
 		tilemap_set_scrollx( tmap, 0, startx >> 16 );
@@ -2150,18 +2582,18 @@ DECLARE( draw, (tilemap *tmap, int xpos, int ypos, int mask, int value ),
  * in that tile have the same masked transparency value.
  */
 
-static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel;
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2170,7 +2602,7 @@ static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32
 	UINT32 x;
 	UINT32 y;
 	UINT32 pen;
-	UINT8 *pBitmask = tile_info.mask_data;
+	UINT8 *pBitmask = info->mask_data;
 	UINT32 bitoffs;
 	int bWhollyOpaque;
 	int bWhollyTransparent;
@@ -2248,18 +2680,18 @@ static UINT8 TRANSP(HandleTransparencyBitmask)(tilemap *tmap, UINT32 x0, UINT32
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2348,18 +2780,18 @@ static UINT8 TRANSP(HandleTransparencyColor)(tilemap *tmap, UINT32 x0, UINT32 y0
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 code_opaque = code_transparent | TILE_FLAG_FG_OPAQUE;
 	UINT32 tx;
 	UINT32 ty;
@@ -2446,16 +2878,16 @@ static UINT8 TRANSP(HandleTransparencyPen)(tilemap *tmap, UINT32 x0, UINT32 y0,
 	return (bWhollyOpaque || bWhollyTransparent)?0:TILE_FLAG_FG_OPAQUE;
 }
 
-static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
 	UINT32 tx;
 	UINT32 ty;
@@ -2465,8 +2897,8 @@ static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y
 	UINT32 y;
 	UINT32 pen;
 	UINT32 penbit = tmap->transparent_pen;
-	UINT32 code_front = tile_info.priority | TILE_FLAG_FG_OPAQUE;
-	UINT32 code_back = tile_info.priority | TILE_FLAG_BG_OPAQUE;
+	UINT32 code_front = info->priority | TILE_FLAG_FG_OPAQUE;
+	UINT32 code_back = info->priority | TILE_FLAG_BG_OPAQUE;
 	int code;
 	int and_flags = ~0;
 	int or_flags = 0;
@@ -2526,18 +2958,18 @@ static UINT8 TRANSP(HandleTransparencyPenBit)(tilemap *tmap, UINT32 x0, UINT32 y
 	return or_flags ^ and_flags;
 }
 
-static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_transparent = tile_info.priority;
+	UINT32 code_transparent = info->priority;
 	UINT32 tx;
 	UINT32 ty;
 	UINT32 data;
@@ -2612,18 +3044,18 @@ static UINT8 TRANSP(HandleTransparencyPens)(tilemap *tmap, UINT32 x0, UINT32 y0,
 	return and_flags ^ or_flags;
 }
 
-static UINT8 TRANSP(HandleTransparencyNone)(tilemap *tmap, UINT32 x0, UINT32 y0, UINT32 flags)
+static UINT8 TRANSP(HandleTransparencyNone)(tilemap *tmap, const tile_data *info, UINT32 x0, UINT32 y0, UINT32 flags)
 {
 	UINT32 tile_width = tmap->cached_tile_width;
 	UINT32 tile_height = tmap->cached_tile_height;
 	mame_bitmap *pixmap = tmap->pixmap;
 	mame_bitmap *transparency_bitmap = tmap->transparency_bitmap;
-	int pitch = tile_width + tile_info.skip;
+	int pitch = tile_width + info->skip;
 	PAL_INIT;
 	UINT32 *pPenToPixel = tmap->pPenToPixel[flags&(TILE_FLIPY|TILE_FLIPX)];
-	const UINT8 *pPenData = tile_info.pen_data;
+	const UINT8 *pPenData = info->pen_data;
 	const UINT8 *pSource;
-	UINT32 code_opaque = tile_info.priority;
+	UINT32 code_opaque = info->priority;
 	UINT32 tx;
 	UINT32 ty;
 	UINT32 data;
@@ -75,6 +75,7 @@ extern tile_data tile_info;
 #define SET_TILE_INFO(GFX,CODE,COLOR,FLAGS) { \
 	const gfx_element *gfx = Machine->gfx[(GFX)]; \
 	int _code = (CODE) % gfx->total_elements; \
+	gfx_element_prepare(gfx, _code); \
 	tile_info.tile_number = _code; \
 	tile_info.pen_data = gfx->gfxdata + _code*gfx->char_modulo; \
 	tile_info.pal_data = &gfx->colortable[gfx->color_granularity * (COLOR)]; \
@@ -24,6 +24,7 @@ int	gUnzipQuiet = 0;		/* flag controls error messages */
 #define ERROR_UNSUPPORTED "The format of this zipfile is not supported, please recompress it"
 
 #define INFLATE_INPUT_BUFFER_MAX 16384
+#define INFLATE_OUTPUT_CHUNK_MAX 65536
 
 /* Print a error message */
 void errormsg(const char* extmsg, const char* usermsg, const char* zipname) {
@@ -561,14 +562,12 @@ int readcompresszip(zip_file* zip, zip_entry* ent, char* data) {
 	return 0;
 }
 
-/* Read UNcompressed data
-   out:
-    data UNcompressed data
+/* Check if the entry can be decompressed
    return:
     ==0 success
     <0 error
 */
-int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
+static int supportzip(zip_file* zip, zip_entry* ent) {
 	if (ent->compression_method == 0x0000) {
 		/* file is not compressed, simply stored */
 
@@ -578,7 +577,7 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 			return -3;
 		}
 
-		return readcompresszip(zip,ent,data);
+		return 0;
 	} else if (ent->compression_method == 0x0008) {
 		/* file is compressed using "Deflate" method */
 		if (ent->version_needed_to_extract > 0x14) {
@@ -596,6 +595,28 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 			return -2;
 		}
 
+		return 0;
+	} else {
+		errormsg("Compression method unsupported", ERROR_UNSUPPORTED, zip->zip);
+		return -2;
+	}
+}
+
+/* Read UNcompressed data
+   out:
+    data UNcompressed data
+   return:
+    ==0 success
+    <0 error
+*/
+int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
+	int err = supportzip(zip,ent);
+	if (err!=0)
+		return err;
+
+	if (ent->compression_method == 0x0000) {
+		return readcompresszip(zip,ent,data);
+	} else {
 		/* read compressed data */
 		if (seekcompresszip(zip,ent)!=0) {
 			return -1;
@@ -609,9 +630,85 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 		}
 
 		return 0;
-	} else {
-		errormsg("Compression method unsupported", ERROR_UNSUPPORTED, zip->zip);
-		return -2;
+	}
+}
+
+/* Inflate data in memory
+   in:
+   in_data compressed data, with one extra dummy byte at the end
+   in_size size of the compressed data
+   out_size size of decompressed data
+   progress called with every block of data inflated, if not 0
+   out:
+   out_data buffer for decompressed data
+   return:
+   ==0 ok
+*/
+static int inflate_memory(const unsigned char* in_data, unsigned in_size, unsigned char* out_data, unsigned out_size, void (*progress)(void*, const unsigned char*, unsigned), void* param)
+{
+	int err;
+	unsigned done;
+	z_stream d_stream; /* decompression stream */
+
+	memset(&d_stream, 0, sizeof(d_stream));
+
+	/* the dummy byte is required to get Z_STREAM_END, see inflate_file() */
+	d_stream.next_in = (unsigned char*)in_data;
+	d_stream.avail_in = in_size + 1;
+
+	err = inflateInit2(&d_stream, -MAX_WBITS);
+	if (err != Z_OK)
+		return -1;
+
+	/* inflate a chunk at time, to process it while still in the cache */
+	done = 0;
+	for (;;)
+	{
+		unsigned produced;
+
+		d_stream.next_out = out_data + done;
+		d_stream.avail_out = MIN(out_size - done, INFLATE_OUTPUT_CHUNK_MAX);
+
+		err = inflate(&d_stream, Z_NO_FLUSH);
+
+		produced = d_stream.next_out - (out_data + done);
+		if (progress && produced)
+			progress(param, out_data + done, produced);
+		done += produced;
+
+		if (err == Z_STREAM_END)
+			break;
+		if (err != Z_OK || (produced == 0 && done == out_size))
+		{
+			inflateEnd(&d_stream);
+			return -1;
+		}
+	}
+
+	if (inflateEnd(&d_stream) != Z_OK)
+		return -1;
+
+	if (done != out_size || d_stream.avail_in > 1)
+		return -1;
+
+	return 0;
+}
+
+int inflate_zipped_data(const zip_data* zdata, unsigned char* buf, void (*progress)(void* param, const unsigned char* data, unsigned length), void* param) {
+	if (zdata->compression_method == 0x0000) {
+		memcpy(buf, zdata->data, zdata->uncompressed_size);
+		if (progress && zdata->uncompressed_size)
+			progress(param, buf, zdata->uncompressed_size);
+		return 0;
+	}
+
+	return inflate_memory(zdata->data, zdata->compressed_size, buf, zdata->uncompressed_size, progress, param);
+}
+
+void free_zipped_data(zip_data* zdata) {
+	if (zdata) {
+		free(zdata->data);
+		free(zdata);
 	}
 }
 
@@ -813,6 +910,67 @@ int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfi
 	return -1;
 }
 
+/* Pass the path to the zipfile and the name of the file within the zipfile.
+   zdata will be set to the compressed data of that zipped file, to be
+   decompressed later with inflate_zipped_data(). */
+int /* error */ load_zipped_file_compressed (int pathtype, int pathindex, const char* zipfile, const char* filename, zip_data** zdata) {
+	zip_file* zip;
+	zip_entry* ent;
+
+	zip = cache_openzip(pathtype, pathindex, zipfile);
+	if (!zip)
+		return -1;
+
+	while (readzip(zip)) {
+		/* NS981003: support for "load by CRC" */
+		char crc[9];
+
+		ent = &(zip->ent);
+
+		sprintf(crc,"%08x",ent->crc32);
+		if (equal_filename(ent->name, filename) ||
+				(ent->crc32 && !strcmp(crc, filename)))
+		{
+			zip_data* z;
+
+			if (supportzip(zip, ent)!=0) {
+				cache_suspendzip(zip);
+				return -1;
+			}
+
+			/* one more byte for the inflate dummy byte */
+			z = (zip_data*)malloc(sizeof(zip_data));
+			if (z)
+				z->data = (UINT8*)malloc(ent->compressed_size + 1);
+			if (!z || !z->data) {
+				if (!gUnzipQuiet)
+					printf("load_zipped_file_compressed(): Unable to allocate %d bytes of RAM\n",ent->compressed_size + 1);
+				free(z);
+				cache_closezip(zip);
+				return -1;
+			}
+
+			z->compressed_size = ent->compressed_size;
+			z->uncompressed_size = ent->uncompressed_size;
+			z->compression_method = ent->compression_method;
+			z->data[z->compressed_size] = 0;
+
+			if (readcompresszip(zip, ent, (char*)z->data)!=0) {
+				free_zipped_data(z);
+				cache_closezip(zip);
+				return -1;
+			}
+
+			*zdata = z;
+			cache_suspendzip(zip);
+			return 0;
+		}
+	}
+
+	cache_suspendzip(zip);
+	return -1;
+}
+
 /*  Pass the path to the zipfile and the name of the file within the zipfile.
     sum will be set to the CRC-32 of that zipped file. */
 /*  The caller can preset sum to the expected checksum to enable "load by CRC" */
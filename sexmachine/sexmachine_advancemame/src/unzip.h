@@ -132,9 +132,39 @@ int readcompresszip(zip_file* zip, zip_entry* ent, char* data);
 */
 int readuncompresszip(zip_file* zip, zip_entry* ent, char* data);
 
+/* Compressed data of a zip entry, read in memory to be inflated later */
+struct _zip_data
+{
+	UINT8*	data; /* compressed data */
+	UINT32	compressed_size;
+	UINT32	uncompressed_size;
+	UINT16	compression_method;
+};
+typedef struct _zip_data zip_data;
+
+/* Inflate the data read by load_zipped_file_compressed()
+   in:
+     zdata compressed data
+     progress called with every block of data inflated, if not 0
+   out:
+     buf buffer for data, zdata.uncompressed_size UINT8s allocated by the caller
+   return:
+     ==0 success
+     <0 error
+   note:
+     It doesn't access the zip file or any global state, so it can
+     be called at the same time from different threads
+*/
+int inflate_zipped_data(const zip_data* zdata, unsigned char* buf, void (*progress)(void* param, const unsigned char* data, unsigned length), void* param);
+
+/* Free the data read by load_zipped_file_compressed() */
+void free_zipped_data(zip_data* zdata);
+
 /* public functions */
 int /* error */ load_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename,
 	unsigned char **buf, unsigned int *length);
+int /* error */ load_zipped_file_compressed (int pathtype, int pathindex, const char *zipfile, const char *filename,
+	zip_data **zdata);
 int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum);
 
 void unzip_cache_clear(void);
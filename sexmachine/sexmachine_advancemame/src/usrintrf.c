@@ -1389,6 +1389,11 @@ static void handle_keys(mame_bitmap *bitmap)
 	/* toggle crosshair display */
 	if (input_ui_pressed(IPT_UI_TOGGLE_CROSSHAIR))
 		drawgfx_toggle_crosshair();
+
+	/* step back in the rewind ring; each repeat goes back more frames */
+	/* than the ones emulated in the meantime */
+	if (options.rewind_count > 0 && input_ui_pressed_repeat(IPT_UI_REWIND, 1))
+		mame_schedule_rewind(4);
 }
 
 
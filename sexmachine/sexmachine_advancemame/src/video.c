@@ -14,6 +14,7 @@
 #include "artwork.h"
 #include "profiler.h"
 #include "png.h"
+#include "romcache.h"
 #include "vidhrdw/vector.h"
 
 #if defined(MAME_DEBUG) && !defined(NEW_DEBUGGER)
@@ -407,6 +408,9 @@ static void decode_graphics(const gfx_decode *gfxdecodeinfo)
 		if (Machine->gfx[i])
 			totalgfx += Machine->gfx[i]->total_elements;
 
+	/* the elements already decoded in a previous run are read from the cache */
+	romcache_gfx_begin();
+
 	/* loop over all elements */
 	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
 		if (Machine->gfx[i])
@@ -418,6 +422,22 @@ static void decode_graphics(const gfx_decode *gfxdecodeinfo)
 				gfx_element *gfx = Machine->gfx[i];
 				int j;
 
+				/* the raw graphics point into the region and are never cached */
+				if (!(gfx->flags & GFX_DONT_FREE_GFXDATA) && romcache_gfx_read(i, gfx))
+				{
+					curgfx += gfx->total_elements;
+					continue;
+				}
+
+				/* decode the characters when first drawn; an incomplete set can't be cached */
+				if (options.lazy_gfx)
+				{
+					romcache_gfx_forget(i);
+					decodegfx_lazy(gfx, region_base + gfxdecodeinfo[i].start);
+					curgfx += gfx->total_elements;
+					continue;
+				}
+
 				/* now decode the actual graphics */
 				for (j = 0; j < gfx->total_elements; j += 1024)
 				{
@@ -432,6 +452,8 @@ static void decode_graphics(const gfx_decode *gfxdecodeinfo)
 			else
 				memset(Machine->gfx[i]->gfxdata, 0, Machine->gfx[i]->char_modulo * Machine->gfx[i]->total_elements);
 		}
+
+	romcache_gfx_end();
 }
 
 
@@ -642,7 +664,11 @@ void force_partial_update(int scanline)
 	if (clip.min_y <= clip.max_y)
 	{
 		profiler_mark(PROFILER_VIDEO);
+		if (options.draw_bands)
+			drawgfx_defer_begin();
 		(*Machine->drv->video_update)(0, scrbitmap[0], &clip);
+		if (options.draw_bands)
+			drawgfx_defer_end();
 		performance.partial_updates_this_frame++;
 		profiler_mark(PROFILER_END);
 	}
@@ -800,25 +826,29 @@ void updatescreen(void)
 	/* update sound */
 	sound_frame_update();
 
-	/* if we're not skipping this frame, draw the screen */
-	if (!osd_skip_this_frame())
+	/* frames run ahead of the displayed one never reach the screen */
+	if (mame_get_output_mask() & MAME_OUTPUT_VIDEO)
 	{
-		profiler_mark(PROFILER_VIDEO);
-		draw_screen();
-		profiler_mark(PROFILER_END);
-	}
+		/* if we're not skipping this frame, draw the screen */
+		if (!osd_skip_this_frame())
+		{
+			profiler_mark(PROFILER_VIDEO);
+			draw_screen();
+			profiler_mark(PROFILER_END);
+		}
 
-	/* the user interface must be called between vh_update() and osd_update_video_and_audio(), */
-	/* to allow it to overlay things on the game display. We must call it even */
-	/* if the frame is skipped, to keep a consistent timing. */
-	ui_update_and_render(artwork_get_ui_bitmap());
+		/* the user interface must be called between vh_update() and osd_update_video_and_audio(), */
+		/* to allow it to overlay things on the game display. We must call it even */
+		/* if the frame is skipped, to keep a consistent timing. */
+		ui_update_and_render(artwork_get_ui_bitmap());
 
-	/* update our movie recording state */
-	if (!mame_is_paused())
-		record_movie_frame(scrbitmap[0]);
+		/* update our movie recording state */
+		if (!mame_is_paused())
+			record_movie_frame(scrbitmap[0]);
 
-	/* blit to the screen */
-	update_video_and_audio();
+		/* blit to the screen */
+		update_video_and_audio();
+	}
 
 	/* call the end-of-frame callback */
 	if (Machine->drv->video_eof && !mame_is_paused())
@@ -49,6 +49,8 @@ struct _mame_display
 	const rgb_t *	game_palette;				/* points to game's adjusted palette */
 	UINT32			game_palette_entries;		/* number of palette entries in game's palette */
 	UINT32 *		game_palette_dirty;			/* points to game's dirty palette bitfield */
+	UINT32			game_palette_dirty_min;		/* first word of the bitfield that may be dirty */
+	UINT32			game_palette_dirty_max;		/* last word of the bitfield that may be dirty */
 	rectangle 		game_visible_area;			/* the game's visible area */
 	float			game_refresh_rate;			/* refresh rate */
 	void *			vector_dirty_pixels;		/* points to X,Y pairs of dirty vector pixels */
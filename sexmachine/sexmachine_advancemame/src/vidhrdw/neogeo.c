@@ -505,6 +505,7 @@ static void NeoMVSDrawGfxLine(UINT16 **line,const gfx_element *gfx,
 	code %= no_of_tiles;
 
 	/* Check for total transparency, no need to draw */
+	gfx_element_prepare(gfx, code);
 	if ((gfx->pen_usage[code] & ~1) == 0)
 		return;
 
@@ -769,6 +770,7 @@ static void neogeo_draw_s_layer(mame_bitmap *bitmap, const rectangle *cliprect)
 					}
 
 
+					gfx_element_prepare(gfx, byte1);
 					if ((pen_usage[byte1] & ~1) == 0) continue;
 
 					drawgfx(bitmap,gfx,
@@ -790,6 +792,7 @@ static void neogeo_draw_s_layer(mame_bitmap *bitmap, const rectangle *cliprect)
 					int byte2 = byte1 >> 12;
 					byte1 = byte1 & 0xfff;
 
+					gfx_element_prepare(gfx, byte1);
 					if ((pen_usage[byte1] & ~1) == 0) continue;
 
 					drawgfx(bitmap,gfx,
@@ -2359,6 +2359,7 @@ static void stv_vdp2_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 			transmask = transparent_color;
 		}
 
+		gfx_element_prepare(gfx, code);
 		if ((gfx->pen_usage[code] & ~transmask) == 0)
 			/* character is totally transparent, no need to draw */
 			return;
@@ -399,6 +399,7 @@ static int system1_draw_fg(mame_bitmap *bitmap,int priority)
 			}
 
 			code %= Machine->gfx[0]->total_elements;
+			gfx_element_prepare(Machine->gfx[0], code);
 			if (Machine->gfx[0]->pen_usage[code] & ~1)
 			{
 				drawn = 1;
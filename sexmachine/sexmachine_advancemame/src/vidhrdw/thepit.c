@@ -195,7 +195,9 @@ static void drawtiles(mame_bitmap *bitmap,int priority)
 	if (priority == 1)
 	{
 		/* find the space character */
-		while (Machine->gfx[0]->pen_usage[spacechar] & ~1) spacechar++;
+		gfx_element_prepare(Machine->gfx[0], spacechar);
+		while (Machine->gfx[0]->pen_usage[spacechar] & ~1)
+			gfx_element_prepare(Machine->gfx[0], ++spacechar);
 	}
 
 